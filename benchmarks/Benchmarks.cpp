@@ -0,0 +1,828 @@
+// ============================================================================
+// Benchmarks.cpp
+// 性能基准
+// 每个性能相关的改动对应一个基准函数，在离屏平台上也可运行（-platform offscreen）
+// ============================================================================
+
+#include "view/TextLayoutEngine.h"
+#include "view/DocumentView.h"
+#include "view/BlinkClock.h"
+#include "view/Cursor.h"
+#include "view/TileCache.h"
+#include "view/TileRenderer.h"
+#include "view/MathLayoutEngine.h"
+#include "view/FormulaLayoutCache.h"
+#include "controller/DocumentController.h"
+#include "core/Document.h"
+#include "core/MathNode.h"
+#include "core/MathTokenizer.h"
+#include "core/SymbolTrie.h"
+#include "core/MathExpression.h"
+#include "core/UndoStack.h"
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include <QThreadPool>
+#include <QEventLoop>
+#include <QTimer>
+
+/**
+ * @class Benchmarks
+ * @brief 性能基准
+ */
+class Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 后台整形的数据：段落数
+     */
+    void backgroundShaping_data();
+
+    /**
+     * @brief 后台整形整篇文档的吞吐量
+     */
+    void backgroundShaping();
+
+    /**
+     * @brief 重新排版停顿的数据：段落数
+     */
+    void reflowEventLoopStall_data();
+
+    /**
+     * @brief 整篇重新排版期间GUI线程事件循环的最长停顿（应小于一帧）
+     */
+    void reflowEventLoopStall();
+
+    /**
+     * @brief 在1万段落的文档中拖动选择，每帧移动一次选择终点并重绘视口
+     */
+    void selectionDrag();
+
+    /**
+     * @brief 单次编辑耗时的数据：编辑类型（输入字符、回车、改变行高）、段落数
+     */
+    void editWithSceneRect_data();
+
+    /**
+     * @brief 单次编辑（含场景矩形更新和其后段落的移动）的GUI线程耗时，不应随段落项数量增长
+     */
+    void editWithSceneRect();
+
+    /**
+     * @brief 空闲唤醒次数的数据：光标数量、是否暂停
+     */
+    void idleCursorWakeups_data();
+
+    /**
+     * @brief 空闲时光标闪烁每秒唤醒GUI线程的次数，应与光标数量无关，暂停后为0
+     */
+    void idleCursorWakeups();
+
+    /**
+     * @brief 滚动帧耗时的数据：是否启用瓦片缓存
+     */
+    void scrollFrame_data();
+
+    /**
+     * @brief 滚动一帧（移动滚动条并重绘视口）的耗时，比较瓦片贴图与逐段落绘制
+     */
+    void scrollFrame();
+
+    /**
+     * @brief 并行光栅化的数据：工作线程数
+     */
+    void tileRasterization_data();
+
+    /**
+     * @brief 快速滚动时新露出的三屏瓦片全部光栅化完成的耗时，比较单线程与多线程
+     */
+    void tileRasterization();
+
+    /**
+     * @brief 公式页面绘制的数据：是否缓存显示列表
+     */
+    void formulaPagePaint_data();
+
+    /**
+     * @brief 绘制含500个内联公式的页面，比较回放缓存的显示列表与每次重新记录
+     */
+    void formulaPagePaint();
+
+    /**
+     * @brief 补全查询的数据：是否模糊匹配
+     */
+    void symbolLookup_data();
+
+    /**
+     * @brief 单次补全查询的延迟，轮流查询完整符号表中每个命令名的前缀
+     */
+    void symbolLookup();
+
+    /**
+     * @brief 表达式求值的数据：是否批量求值
+     */
+    void expressionEvaluation_data();
+
+    /**
+     * @brief 对100万个x值求 x^2 + 1/(x+2)，比较逐点求值与按列批量求值
+     */
+    void expressionEvaluation();
+
+    /**
+     * @brief 1000次大段粘贴的耗时，并报告撤销历史占用的内存和磁盘日志大小
+     */
+    void largePasteUndoMemory();
+
+    /**
+     * @brief 删除大文档90%内容的数据：段落数
+     */
+    void deleteLargeRange_data();
+
+    /**
+     * @brief 一次删除跨越大量段落的选择（段落列表只移动一次尾部）
+     */
+    void deleteLargeRange();
+
+    /**
+     * @brief 对100k段落的整篇选择设置粗体（每段最多拆分两次Run，整段批量处理）
+     */
+    void formatLargeRange();
+
+    /**
+     * @brief 公式按键重新排版的数据：是否在每次按键后撤销
+     */
+    void formulaKeystrokeRelayout_data();
+
+    /**
+     * @brief 在2001个节点的公式中逐键输入（及撤销）并重新排版，只访问光标所在的祖先链和Row
+     */
+    void formulaKeystrokeRelayout();
+
+    /**
+     * @brief 一个事务中的1万次编辑：视图只收到一次变化信号，撤销也只发出一次
+     */
+    void transactionEdits();
+};
+
+namespace {
+
+/**
+ * @brief 生成整形用的段落文本快照
+ * @param count 段落数
+ * @param texts 输出：段落文本
+ * @param stamps 输出：内容戳
+ */
+void makeParagraphTexts(int count, QVector<QString> *texts, QVector<quint64> *stamps)
+{
+    texts->fill(QStringLiteral("The quick brown fox jumps over the lazy dog, 敏捷的棕色狐狸跳过了懒狗 0123456789"), count);
+    stamps->resize(count);
+    for (int i = 0; i < count; i++)
+        (*stamps)[i] = i + 1;
+}
+
+/**
+ * @brief 用给定数量的普通文本段落填充文档
+ * @param document 文档
+ * @param count 段落数
+ */
+void fillDocument(Document *document, int count)
+{
+    Paragraph paragraph;
+    paragraph.insertText(0, QStringLiteral("The quick brown fox jumps over the lazy dog, 敏捷的棕色狐狸跳过了懒狗 0123456789"));
+    for (int i = 0; i < count; i++)
+        document->addParagraph(paragraph);
+}
+
+/**
+ * @brief 显示视图并等待整篇文档排版完成
+ * @param view 文档视图
+ * @return 是否在超时前完成
+ */
+bool showAndLayout(DocumentView *view)
+{
+    view->resize(800, 600);
+    view->show();
+    if (!QTest::qWaitForWindowExposed(view))
+        return false;
+    // 排版引擎是视图的子对象，等它提交完所有批次
+    TextLayoutEngine *engine = view->findChild<TextLayoutEngine *>();
+    return QTest::qWaitFor([view, engine]() {
+        return !view->layoutScheduler()->hasPendingLayout() && !engine->isBusy();
+    }, 120000);
+}
+
+/**
+ * @brief 构造一个带上下标和分式的公式：x_i^2 + 1/n
+ * @param n 分母
+ * @return 公式
+ */
+QSharedPointer<MathObject> makeFormula(int n)
+{
+    MathNode *script = MathNode::create(MathNode::Script);
+    script->child(0)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("x")));
+    script->child(1)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("i")));
+    script->child(2)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("2")));
+    MathNode *fraction = MathNode::create(MathNode::Fraction);
+    fraction->child(0)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("1")));
+    fraction->child(1)->appendChild(new MathNode(MathNode::Symbol, QString::number(n)));
+
+    MathNode *root = new MathNode(MathNode::Row);
+    root->appendChild(script);
+    root->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("+")));
+    root->appendChild(fraction);
+    return QSharedPointer<MathObject>(new MathObject(root));
+}
+
+} // namespace
+
+void Benchmarks::backgroundShaping_data()
+{
+    QTest::addColumn<int>("paragraphs");
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+}
+
+void Benchmarks::backgroundShaping()
+{
+    QFETCH(int, paragraphs);
+    QVector<QString> texts;
+    QVector<quint64> stamps;
+    makeParagraphTexts(paragraphs, &texts, &stamps);
+    TextLayoutEngine engine;
+    QFont font("Microsoft YaHei", 12);
+
+    QBENCHMARK {
+        QSignalSpy finished(&engine, &TextLayoutEngine::layoutFinished);
+        engine.requestLayout(texts, stamps, QVector<QVector<InlineObject>>(),
+                             QVector<QVector<QTextLayout::FormatRange>>(), font);
+        QVERIFY(finished.wait(120000));
+    }
+}
+
+void Benchmarks::reflowEventLoopStall_data()
+{
+    QTest::addColumn<int>("paragraphs");
+    QTest::newRow("100k") << 100000;
+}
+
+void Benchmarks::reflowEventLoopStall()
+{
+    QFETCH(int, paragraphs);
+    QVector<QString> texts;
+    QVector<quint64> stamps;
+    makeParagraphTexts(paragraphs, &texts, &stamps);
+    TextLayoutEngine engine;
+    QFont font("Microsoft YaHei", 12);
+
+    // 零间隔定时器在每个事件循环周期触发一次，相邻两次的最长间隔即输入事件最多等待的时间
+    QElapsedTimer clock;
+    qint64 last = 0;
+    qint64 longest = 0;
+    QTimer ticker;
+    ticker.setInterval(0);
+    connect(&ticker, &QTimer::timeout, this, [&]() {
+        qint64 now = clock.nsecsElapsed();
+        longest = qMax(longest, now - last);
+        last = now;
+    });
+
+    QSignalSpy finished(&engine, &TextLayoutEngine::layoutFinished);
+    clock.start();
+    ticker.start();
+    engine.requestLayout(texts, stamps, QVector<QVector<InlineObject>>(),
+                         QVector<QVector<QTextLayout::FormatRange>>(), font);
+    QVERIFY(finished.wait(120000));
+    ticker.stop();
+
+    QTest::setBenchmarkResult(longest / 1e6, QTest::WalltimeMilliseconds);
+}
+
+void Benchmarks::selectionDrag()
+{
+    Document document;
+    fillDocument(&document, 10000);
+    DocumentView view;
+    view.setDocument(&document);
+    QVERIFY(showAndLayout(&view));
+
+    // 选择终点在可见的行之间来回移动，只重绘选择覆盖层，不触发重新排版
+    int passes = view.layoutScheduler()->layoutPassCount();
+    int line = 0;
+    QBENCHMARK {
+        line = (line + 1) % 20;
+        view.setSelection(Selection({0, 3}, {line, 10}));
+        view.viewport()->repaint();
+    }
+    QCOMPARE(view.layoutScheduler()->layoutPassCount(), passes);
+}
+
+void Benchmarks::editWithSceneRect_data()
+{
+    QTest::addColumn<QString>("edit");
+    QTest::addColumn<int>("paragraphs");
+    const QStringList edits = {QStringLiteral("insert"), QStringLiteral("enter"), QStringLiteral("height")};
+    for (const QString &edit : edits)
+    {
+        QTest::newRow(qPrintable(edit + QStringLiteral(" 1k"))) << edit << 1000;
+        QTest::newRow(qPrintable(edit + QStringLiteral(" 10k"))) << edit << 10000;
+        QTest::newRow(qPrintable(edit + QStringLiteral(" 100k"))) << edit << 100000;
+    }
+}
+
+void Benchmarks::editWithSceneRect()
+{
+    QFETCH(QString, edit);
+    QFETCH(int, paragraphs);
+    Document document;
+    fillDocument(&document, paragraphs);
+    DocumentController controller;
+    controller.setDocument(&document);
+    DocumentView view;
+    view.setDocument(&document);
+    connect(&controller, &DocumentController::paragraphsChanged, &view, &DocumentView::applyParagraphChanges);
+    QVERIFY(showAndLayout(&view));
+    TextLayoutEngine *engine = view.findChild<TextLayoutEngine *>();
+
+    // 高于默认行高的5×5矩阵：插入后所在段落变高，其后的段落整体下移，撤销后移回
+    MathNode *matrix = MathNode::createMatrix(5, 5);
+    for (int i = 0; i < matrix->childCount(); i++)
+        matrix->child(i)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("x")));
+    MathNode *root = new MathNode(MathNode::Row);
+    root->appendChild(matrix);
+    QSharedPointer<MathObject> formula(new MathObject(root));
+
+    // 在视口之外的文档中部编辑并立即执行布局（整形交给后台，这里只计GUI线程的部分）
+    Selection::Position position = {paragraphs / 2, 0};
+    QBENCHMARK {
+        if (edit == QLatin1String("enter"))
+        {
+            controller.splitParagraph(position);
+            view.layoutScheduler()->flush();
+        }
+        else if (edit == QLatin1String("height"))
+        {
+            // 行高在排版结果提交时变化，等待这一段落的结果到达
+            controller.insertFormula(position, formula);
+            view.layoutScheduler()->flush();
+            QVERIFY(QTest::qWaitFor([engine]() { return !engine->isBusy(); }));
+            controller.undo();
+            view.layoutScheduler()->flush();
+            QVERIFY(QTest::qWaitFor([engine]() { return !engine->isBusy(); }));
+        }
+        else
+        {
+            controller.insertText(position, QStringLiteral("x"));
+            view.layoutScheduler()->flush();
+        }
+    }
+
+    // 只有视口附近的段落项被放置，其余段落项不随编辑移动
+    int placed = 0;
+    const QList<QGraphicsItem *> items = view.scene()->items();
+    for (const QGraphicsItem *item : items)
+    {
+        if (!item->parentItem() && item->isVisible())
+            placed++;
+    }
+    qInfo("placed top-level items: %d of %d paragraphs", placed, document.paragraphCount());
+    QVERIFY(placed < 200);
+}
+
+void Benchmarks::idleCursorWakeups_data()
+{
+    QTest::addColumn<int>("cursors");
+    QTest::addColumn<bool>("suspended");
+    QTest::newRow("1 cursor") << 1 << false;
+    QTest::newRow("16 cursors") << 16 << false;
+    QTest::newRow("16 cursors suspended") << 16 << true;
+}
+
+void Benchmarks::idleCursorWakeups()
+{
+    QFETCH(int, cursors);
+    QFETCH(bool, suspended);
+
+    // 闪烁时钟只在应用处于活动状态时运行，需要一个已激活的窗口
+    QGraphicsScene scene(0, 0, 800, 600);
+    QGraphicsView view(&scene);
+    view.show();
+    view.activateWindow();
+    QVERIFY(QTest::qWaitForWindowActive(&view));
+
+    QVector<Cursor *> items;
+    for (int i = 0; i < cursors; i++)
+    {
+        Cursor *cursor = new Cursor();
+        scene.addItem(cursor);
+        cursor->setAlignedPos(QPointF(10, 10 + i * 30));
+        cursor->show();
+        cursor->startBlinking();
+        cursor->setSuspended(suspended);
+        items.append(cursor);
+    }
+
+    // 统计一段空闲时间内的时钟唤醒次数和每次重绘的区域
+    qRegisterMetaType<QList<QRectF>>("QList<QRectF>");
+    QSignalSpy wakeups(BlinkClock::instance(), &BlinkClock::phaseChanged);
+    QSignalSpy repaints(&scene, &QGraphicsScene::changed);
+    const int idleMs = 3000;
+    QTest::qWait(idleMs);
+
+    qreal largestArea = 0;
+    for (const QList<QVariant> &arguments : repaints)
+    {
+        const QList<QRectF> rects = arguments.at(0).value<QList<QRectF>>();
+        for (const QRectF &rect : rects)
+            largestArea = qMax(largestArea, rect.width() * rect.height());
+    }
+    qInfo("largest repainted rect: %.0f px^2", largestArea);
+
+    qDeleteAll(items);
+    QTest::setBenchmarkResult(wakeups.count() * 1000.0 / idleMs, QTest::Events);
+}
+
+void Benchmarks::scrollFrame_data()
+{
+    QTest::addColumn<bool>("tiles");
+    QTest::newRow("tile cache") << true;
+    QTest::newRow("paragraph items") << false;
+}
+
+void Benchmarks::scrollFrame()
+{
+    QFETCH(bool, tiles);
+    Document document;
+    fillDocument(&document, 10000);
+    DocumentView view;
+    view.setTileCacheEnabled(tiles);
+    view.setDocument(&document);
+    QVERIFY(showAndLayout(&view));
+
+    // 在前几屏之间往复滚动，瓦片第一轮之后都已缓存
+    QScrollBar *scrollBar = view.verticalScrollBar();
+    const int step = 40;
+    const int range = qMin(scrollBar->maximum(), 4 * view.viewport()->height());
+    int value = 0;
+    QBENCHMARK {
+        value = (value + step) % range;
+        scrollBar->setValue(value);
+        view.viewport()->repaint();
+    }
+}
+
+void Benchmarks::tileRasterization_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("worker pool") << qMax(1, QThread::idealThreadCount() - 1);
+}
+
+void Benchmarks::tileRasterization()
+{
+    QFETCH(int, threads);
+
+    // 三屏高的区域，每行一个已整形的段落
+    ParagraphLayout layout = TextLayoutEngine::shapeParagraph(
+        QStringLiteral("The quick brown fox jumps over the lazy dog, 敏捷的棕色狐狸跳过了懒狗 0123456789"),
+        QFont("Microsoft YaHei", 12));
+    const QRectF region(0, 0, 1024, 1800);
+    QVector<TileParagraph> paragraphs;
+    for (qreal y = 10; y < region.bottom(); y += layout.height)
+    {
+        TileParagraph paragraph;
+        paragraph.position = QPointF(10, y);
+        paragraph.glyphRuns = layout.glyphRuns;
+        paragraph.height = layout.height;
+        paragraphs.append(paragraph);
+    }
+
+    TileCache cache;
+    const QVector<QPoint> tiles = cache.tilesIntersecting(region);
+    TileRenderer renderer;
+    renderer.findChild<QThreadPool *>()->setMaxThreadCount(threads);
+
+    QBENCHMARK {
+        int done = 0;
+        QEventLoop loop;
+        QMetaObject::Connection connection = connect(&renderer, &TileRenderer::tileReady, &loop, [&]() {
+            if (++done == tiles.size())
+                loop.quit();
+        });
+        for (const QPoint &tile : tiles)
+        {
+            QRectF rect = cache.tileRect(tile);
+            QVector<TileParagraph> visible;
+            for (const TileParagraph &paragraph : paragraphs)
+            {
+                if (paragraph.position.y() < rect.bottom() && paragraph.position.y() + paragraph.height > rect.top())
+                    visible.append(paragraph);
+            }
+            renderer.request(tile, rect, 1.0, visible, -tile.y());
+        }
+        loop.exec();
+        disconnect(connection);
+    }
+}
+
+void Benchmarks::formulaPagePaint_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::newRow("cached display lists") << true;
+    QTest::newRow("recorded per paint") << false;
+}
+
+void Benchmarks::formulaPagePaint()
+{
+    QFETCH(bool, cached);
+
+    // 500个公式，其中结构相同的公式（分母相同）共享显示列表
+    QVector<QSharedPointer<MathObject>> formulas;
+    for (int i = 0; i < 500; i++)
+        formulas.append(makeFormula(i % 50 + 1));
+    FormulaLayoutCache cache;
+    MathLayoutEngine engine(cached ? &cache : nullptr);
+    engine.setFormat(Format(QFont("Cambria Math", 12)));
+    for (const QSharedPointer<MathObject> &formula : formulas)
+        engine.layoutFormula(formula.data());
+
+    // 一页：10列 × 50行
+    QImage page(1000, 1500, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        page.fill(Qt::white);
+        QPainter painter(&page);
+        for (int i = 0; i < formulas.size(); i++)
+        {
+            QSharedPointer<const FormulaDisplayList> displayList = engine.displayList(formulas.at(i).data());
+            displayList->paint(&painter, QPointF(10 + (i % 10) * 100, 30 + (i / 10) * 30));
+        }
+    }
+}
+
+void Benchmarks::symbolLookup_data()
+{
+    QTest::addColumn<bool>("fuzzy");
+    QTest::newRow("prefix") << false;
+    QTest::newRow("fuzzy") << true;
+}
+
+void Benchmarks::symbolLookup()
+{
+    QFETCH(bool, fuzzy);
+    const SymbolTrie *trie = SymbolTrie::shared();
+
+    // 查询串：每个命令名的前三个字符，模糊查询时把最后一个字符换掉模拟输错
+    QStringList queries;
+    const QVector<SymbolCompletion> entries = trie->complete(QString(), trie->size());
+    for (const SymbolCompletion &entry : entries)
+    {
+        QString query = entry.name.left(3);
+        if (fuzzy && !query.isEmpty())
+            query[query.length() - 1] = QLatin1Char('q');
+        queries.append(query);
+    }
+    QVERIFY(!queries.isEmpty());
+
+    int i = 0;
+    QBENCHMARK {
+        const QString &query = queries.at(i++ % queries.size());
+        QVector<SymbolCompletion> completions = fuzzy ? trie->fuzzyComplete(query, 10) : trie->complete(query, 10);
+        Q_UNUSED(completions);
+    }
+}
+
+void Benchmarks::expressionEvaluation_data()
+{
+    QTest::addColumn<bool>("batch");
+    QTest::newRow("per point") << false;
+    QTest::newRow("batch") << true;
+}
+
+void Benchmarks::expressionEvaluation()
+{
+    QFETCH(bool, batch);
+
+    // x^2 + 1/(x+2)
+    MathNode *root = new MathNode(MathNode::Row);
+    MathNode *square = MathNode::create(MathNode::Script);
+    square->child(0)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("x")));
+    square->child(2)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("2")));
+    MathNode *fraction = MathNode::create(MathNode::Fraction);
+    fraction->child(0)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("1")));
+    fraction->child(1)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("x")));
+    fraction->child(1)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("+")));
+    fraction->child(1)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("2")));
+    root->appendChild(square);
+    root->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("+")));
+    root->appendChild(fraction);
+    MathObject formula(root);
+    QSharedPointer<const MathExpression> expression = MathExpression::compile(formula.root());
+    QVERIFY(expression && expression->isValid());
+
+    const int count = 1000000;
+    QVector<double> xs(count);
+    for (int i = 0; i < count; i++)
+        xs[i] = -10 + 20.0 * i / count;
+    QVector<double> results(count);
+
+    QBENCHMARK {
+        if (batch)
+        {
+            expression->evaluate(QVector<const double *>() << xs.constData(), count, results.data());
+        }
+        else
+        {
+            QVector<double> values(1);
+            for (int i = 0; i < count; i++)
+            {
+                values[0] = xs.at(i);
+                results[i] = expression->evaluate(values);
+            }
+        }
+    }
+    QCOMPARE(results.at(count / 2), 0.5);
+}
+
+void Benchmarks::largePasteUndoMemory()
+{
+    Document document;
+    document.addParagraph(Paragraph());
+    DocumentController controller;
+    controller.setDocument(&document);
+    UndoStack *undoStack = controller.undoStack();
+    undoStack->setMemoryBudget(16 * 1024 * 1024);
+
+    // 每次粘贴64K个字符（约128KB文本），1000次共约128MB
+    const QString chunk(64 * 1024, QLatin1Char('x'));
+    const int pastes = 1000;
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < pastes; i++)
+        {
+            controller.insertText({0, 0}, chunk);
+            undoStack->breakCoalescing();
+        }
+    }
+    qInfo("undo steps: %d, in memory: %lld KB, journal: %lld KB", undoStack->count(),
+          undoStack->memoryUsage() / 1024, undoStack->journalSize() / 1024);
+    QVERIFY(undoStack->memoryUsage() <= undoStack->memoryBudget());
+
+    // 最旧的步骤仍然可以撤销
+    while (controller.canUndo())
+        controller.undo();
+    QCOMPARE(document.paragraph(0).length(), 0);
+}
+
+void Benchmarks::deleteLargeRange_data()
+{
+    QTest::addColumn<int>("paragraphs");
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void Benchmarks::deleteLargeRange()
+{
+    QFETCH(int, paragraphs);
+
+    Document document;
+    fillDocument(&document, paragraphs);
+    DocumentController controller;
+    controller.setDocument(&document);
+
+    // 从第5%段落中间删除到第95%段落中间
+    const int first = paragraphs / 20;
+    const int last = paragraphs - paragraphs / 20;
+    Selection selection({first, 2}, {last, 2});
+    QBENCHMARK_ONCE {
+        controller.deleteText(selection);
+    }
+    QCOMPARE(document.paragraphCount(), paragraphs - (last - first));
+}
+
+void Benchmarks::formatLargeRange()
+{
+    const int paragraphs = 100000;
+    Document document;
+    fillDocument(&document, paragraphs);
+    DocumentController controller;
+    controller.setDocument(&document);
+    int changes = 0;
+    connect(&controller, &DocumentController::paragraphsChanged, this, [&changes]() { changes++; });
+
+    // 选择从第一段中间到最后一段中间，首尾两段各拆分一次，其余段落整段处理
+    Format bold;
+    bold.setBold(true);
+    Selection selection({0, 4}, {paragraphs - 1, 9});
+    QBENCHMARK_ONCE {
+        controller.applyFormat(selection, bold);
+    }
+    QCOMPARE(changes, 1);
+    QCOMPARE(document.paragraph(0).runCount(), 2);
+    QCOMPARE(document.paragraph(paragraphs / 2).runCount(), 1);
+    QVERIFY(document.paragraph(paragraphs / 2).run(0).format() == bold);
+    QCOMPARE(document.paragraph(paragraphs - 1).runCount(), 2);
+}
+
+void Benchmarks::formulaKeystrokeRelayout_data()
+{
+    QTest::addColumn<bool>("undo");
+    QTest::newRow("keystroke") << false;
+    QTest::newRow("keystroke + undo") << true;
+}
+
+void Benchmarks::formulaKeystrokeRelayout()
+{
+    QFETCH(bool, undo);
+
+    // 400个分式并排，共2001个节点
+    const int fractions = 400;
+    MathNode *root = new MathNode(MathNode::Row);
+    for (int i = 0; i < fractions; i++)
+    {
+        MathNode *fraction = MathNode::create(MathNode::Fraction);
+        fraction->child(0)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("1")));
+        fraction->child(1)->appendChild(new MathNode(MathNode::Symbol, QString::number(i % 10)));
+        root->appendChild(fraction);
+    }
+    QSharedPointer<MathObject> formula(new MathObject(root));
+    QCOMPARE(root->nodeCount(), 2001);
+    Paragraph paragraph;
+    paragraph.insertFormula(0, formula);
+    Document document;
+    document.addParagraph(paragraph);
+    DocumentController controller;
+    controller.setDocument(&document);
+    MathTokenizer tokenizer;
+    MathLayoutEngine engine;
+    engine.setFormat(Format(QFont("Cambria Math", 12)));
+    engine.layoutFormula(formula.data());
+
+    // 每次访问的节点数减去光标所在Row的子节点数，应只剩根、分式和分子三个节点
+    int maxVisited = 0;
+    int maxComposed = 0;
+    int i = 0;
+    QBENCHMARK {
+        // 轮流在各分式的分子末尾输入
+        MathNode *numerator = root->child(i++ % fractions)->child(0);
+        Selection::Position position = {0, 0, MathPosition::fromNode(numerator, numerator->childCount())};
+        Selection::Position cursor = position;
+        QVector<MathEdit> edits;
+        tokenizer.setEditLog(&edits);
+        cursor.math = tokenizer.input(root, position.math, QLatin1Char('a'));
+        tokenizer.setEditLog(nullptr);
+        controller.updateFormula(position, edits, cursor, QStringLiteral("a"));
+        engine.layoutFormula(formula.data());
+        maxVisited = qMax(maxVisited, engine.visitedNodeCount() - numerator->childCount());
+        maxComposed = qMax(maxComposed, engine.composedNodeCount());
+        if (undo)
+        {
+            controller.undo();
+            engine.layoutFormula(formula.data());
+            maxVisited = qMax(maxVisited, engine.visitedNodeCount() - numerator->childCount());
+            maxComposed = qMax(maxComposed, engine.composedNodeCount());
+        }
+    }
+    qInfo("keystrokes: %d, visited beyond caret row: %d, composed: %d", i, maxVisited, maxComposed);
+    QVERIFY(maxVisited <= 3);
+    // 新符号、分子、分式和根
+    QVERIFY(maxComposed <= 4);
+}
+
+void Benchmarks::transactionEdits()
+{
+    // 隔段编辑，各处区间互不相邻，不会被合并为一处
+    const int edits = 10000;
+    Document document;
+    fillDocument(&document, edits * 2);
+    DocumentController controller;
+    controller.setDocument(&document);
+    DocumentView view;
+    view.setDocument(&document);
+    connect(&controller, &DocumentController::paragraphsChanged, &view, &DocumentView::applyParagraphChanges);
+    int notifications = 0;
+    int changes = 0;
+    connect(&controller, &DocumentController::paragraphsChanged, this,
+            [&notifications, &changes](const QVector<ParagraphSplice> &list) {
+                notifications++;
+                changes = list.size();
+            });
+    QVERIFY(showAndLayout(&view));
+
+    QBENCHMARK_ONCE {
+        EditTransaction transaction(&controller);
+        for (int i = 0; i < edits; i++)
+            controller.insertText({i * 2, 0}, QStringLiteral("x"));
+    }
+    QCOMPARE(notifications, 1);
+    QCOMPARE(changes, edits);
+    QCOMPARE(controller.undoStack()->count(), 1);
+
+    notifications = 0;
+    controller.undo();
+    QCOMPARE(notifications, 1);
+    QCOMPARE(changes, edits);
+    QVERIFY(showAndLayout(&view));
+}
+
+QTEST_MAIN(Benchmarks)
+#include "Benchmarks.moc"
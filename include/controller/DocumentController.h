@@ -9,6 +9,7 @@
 
 #include "core/Document.h"
 #include "core/Selection.h"
+#include "core/UndoStack.h"
 #include <QObject>
 
 /**
@@ -17,6 +18,11 @@
  * 
  * 负责处理文档的增删改查操作，是模型和视图之间的桥梁。
  * 提供了文本插入、删除、替换，段落插入、删除、合并等操作。
+ * 每个编辑操作在执行期间打开文档的变化记录，结束时把记录到的段落区间替换作为一步压入撤销栈；
+ * 由其他编辑操作组合而成的操作（如替换）只在最外层压栈，因此只产生一个撤销步骤。
+ * 变化信号也只在最外层发出：记录中重叠或相邻的区间已合并，全部区间放在一个列表中发出一次paragraphsChanged，
+ * 之后发出一次documentChanged。beginTransaction()和commitTransaction()（或EditTransaction）把任意多个编辑操作
+ * 包在同一个最外层中，脚本或批量替换的成千上万次修改只触发一次重新排版和一个撤销步骤。
  */
 class DocumentController : public QObject
 {
@@ -59,6 +65,48 @@ public:
      * @param text 替换的文本
      */
     void replaceText(const Selection &selection, const QString &text);
+
+    /**
+     * @brief 在指定位置插入公式
+     * @param position 插入位置
+     * @param formula 公式对象
+     */
+    void insertFormula(const Selection::Position &position, const QSharedPointer<MathObject> &formula);
+
+    /**
+     * @brief 在指定位置插入交叉引用
+     * @param position 插入位置
+     * @param label 所引用公式的标签
+     */
+    void insertReference(const Selection::Position &position, const QString &label);
+
+    /**
+     * @brief 在指定位置插入函数图像
+     * @param position 插入位置
+     * @param plot 函数图像对象
+     */
+    void insertPlot(const Selection::Position &position, const QSharedPointer<PlotObject> &plot);
+
+    /**
+     * @brief 设置公式是否带编号及其标签
+     * 修改前后的公式快照作为一个撤销步骤；
+     * 只重新排版公式所在段落；其他段落中编号和引用的变化由视图按编号索引重绘
+     * @param position 公式所在位置
+     * @param numbered 是否带编号
+     * @param label 标签，为空表示没有标签
+     */
+    void setEquationNumbered(const Selection::Position &position, bool numbered, const QString &label = QString());
+
+    /**
+     * @brief 通知公式的表达式树已被直接编辑（如公式输入），把编辑记录作为一个撤销步骤并重新排版
+     * 给出输入的文本时按连续输入处理，与同一公式中紧接着的输入合并为一步
+     * @param position 编辑前的光标位置（指向公式）
+     * @param edits 表达式树的区间替换（按执行顺序），为空时不做任何事
+     * @param cursor 编辑后的光标位置
+     * @param text 输入的文本
+     */
+    void updateFormula(const Selection::Position &position, const QVector<MathEdit> &edits,
+                       const Selection::Position &cursor, const QString &text = QString());
     
     /**
      * @brief 在指定位置插入段落
@@ -72,8 +120,15 @@ public:
      */
     void deleteParagraph(int paragraphIndex);
     
+    /**
+     * @brief 在指定位置拆分段落（回车）
+     * @param position 拆分位置
+     */
+    void splitParagraph(const Selection::Position &position);
+
     /**
      * @brief 合并指定段落和下一段落
+     * 下一段落的Run连同格式接在末尾
      * @param paragraphIndex 要合并的段落索引
      */
     void mergeParagraphs(int paragraphIndex);
@@ -84,6 +139,56 @@ public:
      * @param format 要应用的格式
      */
     void applyFormat(const Selection &selection, const Format &format);
+
+    /**
+     * @brief 开始一个批量编辑事务（可嵌套）
+     * 事务中的编辑立即修改文档，但变化信号和撤销步骤推迟到最外层的commitTransaction()
+     * @param cursor 事务开始前的光标位置，撤销后恢复；为{-1, -1}时取事务中第一个编辑操作的光标位置
+     */
+    void beginTransaction(const Selection::Position &cursor = {-1, -1});
+
+    /**
+     * @brief 提交批量编辑事务
+     * 最外层提交时把事务中的全部修改作为一个撤销步骤压栈，并发出一次合并后的变化信号
+     * @param cursor 事务结束后的光标位置，重做后恢复；为{-1, -1}时取事务中最后一个编辑操作的光标位置
+     */
+    void commitTransaction(const Selection::Position &cursor = {-1, -1});
+
+    /**
+     * @brief 检查是否处于编辑事务中
+     * @return 是否处于编辑事务中
+     */
+    bool inTransaction() const;
+
+    /**
+     * @brief 撤销一步
+     * @return 撤销后的光标位置，无法撤销时返回{-1, -1}
+     */
+    Selection::Position undo();
+
+    /**
+     * @brief 重做一步
+     * @return 重做后的光标位置，无法重做时返回{-1, -1}
+     */
+    Selection::Position redo();
+
+    /**
+     * @brief 检查是否可以撤销
+     * @return 是否可以撤销
+     */
+    bool canUndo() const;
+
+    /**
+     * @brief 检查是否可以重做
+     * @return 是否可以重做
+     */
+    bool canRedo() const;
+
+    /**
+     * @brief 获取撤销栈（用于设置内存预算、打断输入合并等）
+     * @return 撤销栈
+     */
+    UndoStack *undoStack();
     
 signals:
     /**
@@ -92,11 +197,130 @@ signals:
      */
     void documentChanged();
     
+    /**
+     * @brief 段落范围变化信号
+     * 一次编辑（或事务、撤销、重做）中的全部段落区间替换，按应用顺序排列，
+     * 视图据此一次同步段落项，只重新排版受影响的段落。
+     * @param changes 段落区间替换
+     */
+    void paragraphsChanged(const QVector<ParagraphSplice> &changes);
+
+    /**
+     * @brief 撤销栈状态变化信号
+     * 压栈、撤销、重做或清空撤销栈后发出，用于更新撤销和重做菜单项
+     */
+    void undoStateChanged();
+    
 private:
+    /**
+     * @brief 开始一个编辑操作（可嵌套，只有最外层记录）
+     * @param cursor 编辑前的光标位置（取最先给出的有效位置）
+     */
+    void beginEdit(const Selection::Position &cursor);
+
+    /**
+     * @brief 结束一个编辑操作，最外层结束时把记录到的变化作为一步压入撤销栈并发出变化信号
+     * @param cursor 编辑后的光标位置（取最后给出的有效位置）
+     * @param kind 步骤类型
+     * @param text 输入的文本（仅连续输入）
+     */
+    void endEdit(const Selection::Position &cursor, EditCommand::Kind kind = EditCommand::Edit,
+                 const QString &text = QString());
+
+    /**
+     * @brief 通知一个段落在原处被修改（段落的值不变，如公式编号、表达式树）
+     * 编辑操作中由变化记录合并到最外层统一通知，否则立即发出变化信号
+     * @param paragraphIndex 段落索引
+     */
+    void paragraphTouched(int paragraphIndex);
+
+    /**
+     * @brief 把公式的原处修改记为一处变化
+     * 表达式树、编号和标签都没有变化时只通知重新排版，不产生撤销步骤
+     * @param position 编辑前的光标位置（指向公式）
+     * @param change 公式的修改
+     * @param cursor 编辑后的光标位置
+     * @param text 输入的文本，非空时记为连续输入
+     */
+    void recordFormulaChange(const Selection::Position &position, const FormulaChange &change,
+                             const Selection::Position &cursor, const QString &text = QString());
+
+    /**
+     * @brief 获取一个步骤的段落区间替换在应用时的位置和段落数
+     * @param command 编辑步骤
+     * @param undo 是否为撤销（按相反顺序，交换被替换和替换后的段落数）
+     * @return 段落区间替换
+     */
+    static QVector<ParagraphSplice> splices(const EditCommand &command, bool undo);
+
+    /**
+     * @brief 把光标位置限制在文档范围内
+     * @param position 光标位置
+     * @return 有效的光标位置
+     */
+    Selection::Position clampedPosition(const Selection::Position &position) const;
+
     /**
      * @brief 当前文档
      */
     Document *m_document;
+
+    /**
+     * @brief 撤销栈
+     */
+    UndoStack m_undoStack;
+
+    /**
+     * @brief 编辑操作的嵌套深度
+     */
+    int m_editDepth;
+
+    /**
+     * @brief 正在记录的编辑步骤
+     */
+    EditCommand m_pendingCommand;
+};
+
+/**
+ * @class EditTransaction
+ * @brief 批量编辑事务的作用域守卫
+ *
+ * 构造时调用beginTransaction()，析构时调用commitTransaction()，
+ * 提前返回或抛出异常时事务也一定被提交，不会让文档控制器停留在事务中。
+ */
+class EditTransaction
+{
+public:
+    /**
+     * @brief 构造函数，开始事务
+     * @param controller 文档控制器
+     * @param cursor 事务开始前的光标位置，为{-1, -1}时取事务中第一个编辑操作的光标位置
+     */
+    explicit EditTransaction(DocumentController *controller, const Selection::Position &cursor = {-1, -1});
+
+    /**
+     * @brief 析构函数，提交事务
+     */
+    ~EditTransaction();
+
+    /**
+     * @brief 设置事务结束后的光标位置（提交时使用）
+     * @param cursor 光标位置
+     */
+    void setCursor(const Selection::Position &cursor);
+
+private:
+    Q_DISABLE_COPY(EditTransaction)
+
+    /**
+     * @brief 文档控制器
+     */
+    DocumentController *m_controller;
+
+    /**
+     * @brief 事务结束后的光标位置
+     */
+    Selection::Position m_cursor;
 };
 
 #endif // DOCUMENTCONTROLLER_H
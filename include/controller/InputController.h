@@ -9,6 +9,8 @@
 
 #include "DocumentController.h"
 #include "SelectionController.h"
+#include "core/MathTokenizer.h"
+#include "core/SymbolTrie.h"
 #include <QObject>
 #include <QInputMethodEvent>
 #include <QKeyEvent>
@@ -85,8 +87,59 @@ public:
      * @brief 更新输入法状态
      */
     void updateInputMethod();
+
+    /**
+     * @brief 获取当前的命令补全候选
+     * @return 补全候选
+     */
+    QVector<SymbolCompletion> completions() const;
+
+signals:
+    /**
+     * @brief 命令补全候选变化的信号（在公式中输入\命令时，每次按键更新）
+     * @param completions 补全候选，为空表示关闭补全
+     */
+    void completionsChanged(const QVector<SymbolCompletion> &completions);
     
 private:
+    /**
+     * @brief 计算按方向键或Tab后的光标位置
+     * 光标在公式中时按表达式树结构移动，越过公式边界后回到段落文本
+     * @param position 当前位置
+     * @param key 按键
+     * @return 新位置
+     */
+    Selection::Position movedPosition(const Selection::Position &position, int key) const;
+
+    /**
+     * @brief 在公式中输入文本（逐字符交给公式输入词法分析器）
+     * @param position 光标位置（必须位于公式内）
+     * @param text 输入的文本
+     * @return 输入后的光标位置
+     */
+    Selection::Position insertMathText(const Selection::Position &position, const QString &text);
+
+    /**
+     * @brief 结束光标处尚未完成的公式命令
+     * @param position 光标位置
+     * @return 结束后的光标位置
+     */
+    Selection::Position flushMathInput(const Selection::Position &position);
+
+    /**
+     * @brief 接受一个补全候选，结束正在输入的命令
+     * @param position 光标位置
+     * @param index 候选的索引
+     * @return 结束后的光标位置
+     */
+    Selection::Position acceptCompletion(const Selection::Position &position, int index);
+
+    /**
+     * @brief 按正在输入的命令名更新补全候选
+     */
+    void updateCompletions();
+
+
     /**
      * @brief 文档控制器
      */
@@ -106,6 +159,21 @@ private:
      * @brief 组合文本（输入法输入过程中的临时文本）
      */
     QString m_composingText;
+
+    /**
+     * @brief 公式输入词法分析器（词法状态保存在光标处）
+     */
+    MathTokenizer m_mathTokenizer;
+
+    /**
+     * @brief 当前的命令补全候选
+     */
+    QVector<SymbolCompletion> m_completions;
+
+    /**
+     * @brief 补全候选的最大条数
+     */
+    static const int COMPLETION_LIMIT = 8;
 };
 
 #endif // INPUTCONTROLLER_H
@@ -8,15 +8,46 @@
 #define DOCUMENT_H
 
 #include "Paragraph.h"
+#include "EquationIndex.h"
 #include <QVector>
 #include <QString>
 
+struct ParagraphChange;
+
+/**
+ * @struct ParagraphSplice
+ * @brief 一处段落区间替换的位置和段落数
+ *
+ * 从first开始的removed个段落被替换为inserted个段落，段落内的编辑表示为removed == inserted == 1。
+ * 一次编辑的全部替换按执行顺序组成列表，每一处都以前面各处替换之后的段落索引表示。
+ */
+struct ParagraphSplice
+{
+    /**
+     * @brief 变化的起始段落
+     */
+    int first = 0;
+
+    /**
+     * @brief 被替换的段落数
+     */
+    int removed = 0;
+
+    /**
+     * @brief 替换后的段落数
+     */
+    int inserted = 0;
+};
+
 /**
  * @class Document
  * @brief 文档类
  * 
  * 表示整个文档，包含多个段落，提供文档的增删改查操作。
  * 是文档模型的核心类，管理文档的所有内容。
+ * 文档同时维护带编号公式的编号索引，每个修改段落的操作只更新受影响段落在索引中的节点。
+ * 设置变化记录后，每个修改段落的操作都把被修改的段落区间在修改前后的内容追加到记录中，
+ * 撤销栈据此得到一次编辑的增量；相邻操作落在同一区间内时合并为一处替换。
  */
 class Document
 {
@@ -45,7 +76,29 @@ public:
      * @param position 要删除的段落位置
      */
     void removeParagraph(int position);
+
+    /**
+     * @brief 删除一段连续的段落
+     * 段落列表只移动一次尾部，编号索引整段拆出，代价为O(count + 尾部段落数)
+     * @param first 首个段落的索引
+     * @param count 段落数
+     */
+    void removeParagraphs(int first, int count);
     
+    /**
+     * @brief 在指定位置拆分段落
+     * 位置之后的内容连同格式移入紧随其后的新段落
+     * @param paragraphIndex 段落索引
+     * @param position 拆分位置
+     */
+    void splitParagraph(int paragraphIndex, int position);
+
+    /**
+     * @brief 把指定段落和下一段落合并为一个段落
+     * @param paragraphIndex 段落索引
+     */
+    void mergeParagraphs(int paragraphIndex);
+
     /**
      * @brief 获取指定位置的段落
      * @param position 段落位置
@@ -67,6 +120,16 @@ public:
      * @param format 文本格式，默认为默认格式
      */
     void insertText(int paragraphIndex, int position, const QString &text, const Format &format = Format());
+
+    /**
+     * @brief 在指定位置插入公式
+     * @param paragraphIndex 段落索引
+     * @param position 插入位置
+     * @param formula 公式对象
+     * @param format 公式格式，默认为默认格式
+     */
+    void insertFormula(int paragraphIndex, int position, const QSharedPointer<MathObject> &formula,
+                       const Format &format = Format());
     
     /**
      * @brief 删除指定位置的文本
@@ -75,6 +138,76 @@ public:
      * @param length 删除长度
      */
     void removeText(int paragraphIndex, int position, int length);
+
+    /**
+     * @brief 在指定位置插入交叉引用
+     * @param paragraphIndex 段落索引
+     * @param position 插入位置
+     * @param label 所引用公式的标签
+     * @param format 引用格式，默认为默认格式
+     */
+    void insertReference(int paragraphIndex, int position, const QString &label, const Format &format = Format());
+
+    /**
+     * @brief 在指定位置插入函数图像
+     * @param paragraphIndex 段落索引
+     * @param position 插入位置
+     * @param plot 函数图像对象
+     * @param format 格式，默认为默认格式
+     */
+    void insertPlot(int paragraphIndex, int position, const QSharedPointer<PlotObject> &plot,
+                    const Format &format = Format());
+
+    /**
+     * @brief 设置一段文本的格式
+     * 首尾段落在区间两端拆分Run，中间的段落整段设置；整个区间记录为一处变化
+     * 不设格式驻留表：各Run保存同一个Format的副本，其中的QFont隐式共享，字体数据只有一份
+     * @param firstParagraph 起始段落
+     * @param firstPosition 起始段落中的起始位置
+     * @param lastParagraph 结束段落
+     * @param lastPosition 结束段落中的结束位置（不含）
+     * @param format 格式
+     */
+    void applyFormat(int firstParagraph, int firstPosition, int lastParagraph, int lastPosition,
+                     const Format &format);
+
+    /**
+     * @brief 设置公式是否带编号及其标签
+     * @param paragraphIndex 段落索引
+     * @param position 公式在段落中的位置
+     * @param numbered 是否带编号
+     * @param label 标签（供交叉引用），为空表示没有标签
+     */
+    void setEquationNumbered(int paragraphIndex, int position, bool numbered, const QString &label = QString());
+
+    /**
+     * @brief 获取公式编号索引
+     * @return 公式编号索引
+     */
+    const EquationIndex &equationIndex() const;
+
+    /**
+     * @brief 替换一段连续的段落
+     * 撤销和重做通过它恢复段落区间；数量相同的部分原位替换，只有差额部分需要插入或删除
+     * @param first 首个段落的索引
+     * @param count 被替换的段落数
+     * @param paragraphs 新的段落
+     */
+    void replaceParagraphs(int first, int count, const QVector<Paragraph> &paragraphs);
+
+    /**
+     * @brief 设置变化记录
+     * @param changes 接收段落区间替换的列表，为nullptr时停止记录
+     */
+    void setChangeLog(QVector<ParagraphChange> *changes);
+
+    /**
+     * @brief 记录一个段落在原处被修改
+     * 公式编号、表达式树等在共享对象上原处修改，段落的值不变；
+     * 变化记录打开时把该段落记为一处前后相同的替换，使其随同一批修改一起通知视图重新排版
+     * @param paragraphIndex 段落索引
+     */
+    void markParagraphChanged(int paragraphIndex);
     
     /**
      * @brief 获取整个文档的文本
@@ -88,10 +221,35 @@ public:
     void clear();
     
 private:
+    /**
+     * @brief 开始记录一处变化：保存区间修改前的段落
+     * @param first 首个段落的索引
+     * @param count 将被修改的段落数
+     * @return 变化在记录中的序号，不记录时返回-1
+     */
+    int beginChange(int first, int count);
+
+    /**
+     * @brief 结束记录一处变化：保存区间修改后的段落，并尝试与上一处变化合并
+     * @param change beginChange()返回的序号
+     * @param count 修改后区间的段落数
+     */
+    void endChange(int change, int count);
+
     /**
      * @brief 段落列表
      */
     QVector<Paragraph> m_paragraphs;
+
+    /**
+     * @brief 公式编号索引（与段落列表一一对应）
+     */
+    EquationIndex m_equations;
+
+    /**
+     * @brief 变化记录（为nullptr时不记录）
+     */
+    QVector<ParagraphChange> *m_changes;
 };
 
 #endif // DOCUMENT_H
@@ -0,0 +1,254 @@
+// ============================================================================
+// EquationIndex.h
+// 公式编号索引类的头文件
+// 按段落顺序维护带编号的公式，公式的编号即其在文档中的次序，插入删除只需O(log n)
+// ============================================================================
+
+#ifndef EQUATIONINDEX_H
+#define EQUATIONINDEX_H
+
+#include <QVector>
+#include <QMultiHash>
+#include <QString>
+
+class MathObject;
+
+/**
+ * @class EquationIndex
+ * @brief 公式编号索引类
+ *
+ * 以段落为元素的隐式树堆（按段落次序排列，不存段落索引），每个节点记录本段落中
+ * 带编号的公式和子树中的公式总数。公式的编号就是它之前的公式数加一：
+ * 从公式所在节点沿父节点链向上累加左侧子树的公式数即可得到，复杂度O(log n)。
+ * 插入、删除段落或修改一个段落的公式只改动一条路径上的计数，
+ * 不需要重新遍历文档为之后的公式重新编号。
+ * 标签到公式的映射用哈希表维护，交叉引用在绘制时按标签查询编号。
+ * 同一公式对象可能同时出现在多个段落中（段落按值复制时共享公式），因此每处出现都按
+ * （段落, 序号）单独登记：删除或修改其中一个段落不影响其他段落中的登记，
+ * 各处的编号按段落句柄和序号查询。
+ */
+class EquationIndex
+{
+public:
+    /**
+     * @brief 构造函数
+     * 创建一个空索引
+     */
+    EquationIndex();
+
+    /**
+     * @brief 在指定位置插入一个段落
+     * @param index 段落索引
+     * @param equations 段落中带编号的公式（按出现顺序）
+     */
+    void insertParagraph(int index, const QVector<const MathObject *> &equations);
+
+    /**
+     * @brief 删除指定位置的段落
+     * @param index 段落索引
+     */
+    void removeParagraph(int index);
+
+    /**
+     * @brief 删除一段连续的段落
+     * 整段区间一次拆出，代价为O(log n + count)
+     * @param index 首个段落的索引
+     * @param count 段落数
+     */
+    void removeParagraphs(int index, int count);
+
+    /**
+     * @brief 设置一个段落中带编号的公式
+     * @param index 段落索引
+     * @param equations 段落中带编号的公式（按出现顺序）
+     */
+    void setEquations(int index, const QVector<const MathObject *> &equations);
+
+    /**
+     * @brief 清空索引
+     */
+    void clear();
+
+    /**
+     * @brief 获取段落数
+     * @return 段落数
+     */
+    int paragraphCount() const;
+
+    /**
+     * @brief 获取带编号的公式总数
+     * @return 公式总数
+     */
+    int count() const;
+
+    /**
+     * @brief 获取指定段落之前的公式数
+     * @param index 段落索引
+     * @return 公式数
+     */
+    int equationsBefore(int index) const;
+
+    /**
+     * @brief 获取段落的句柄
+     * 句柄在段落存在期间保持不变，其他段落的增删不影响它，用于按位置查询编号
+     * @param index 段落索引
+     * @return 句柄，越界时返回-1
+     */
+    int handle(int index) const;
+
+    /**
+     * @brief 按段落句柄和公式在段落中的序号获取编号
+     * @param handle 段落句柄
+     * @param slot 公式在段落的带编号公式中的序号
+     * @return 编号（从1开始），句柄已失效或序号越界时返回0
+     */
+    int numberAt(int handle, int slot) const;
+
+    /**
+     * @brief 获取公式的编号
+     * 公式对象出现在多个段落中时返回最靠前一处的编号，各处的编号用numberAt()查询
+     * @param formula 公式对象
+     * @return 编号（从1开始），公式未编号时返回0
+     */
+    int number(const MathObject *formula) const;
+
+    /**
+     * @brief 获取标签所指公式的编号
+     * @param label 标签
+     * @return 编号（从1开始），标签不存在时返回0
+     */
+    int number(const QString &label) const;
+
+    /**
+     * @brief 获取带有指定标签的公式
+     * 只返回当前标签仍与之相同的公式（共享的公式在另一段落中被就地改名后，旧的登记不再匹配）
+     * @param label 标签
+     * @return 公式对象，标签不存在时返回nullptr
+     */
+    const MathObject *equation(const QString &label) const;
+
+    /**
+     * @brief 获取修订号
+     * 任何可能改变编号的修改都会递增修订号，视图据此判断是否需要重绘编号
+     * @return 修订号
+     */
+    quint64 revision() const;
+
+private:
+    /**
+     * @struct Node
+     * @brief 树堆节点（一个段落）
+     */
+    struct Node
+    {
+        int left = -1;       ///< 左子节点
+        int right = -1;      ///< 右子节点
+        int parent = -1;     ///< 父节点
+        quint32 priority = 0; ///< 堆优先级（随机）
+        int size = 1;        ///< 子树中的段落数
+        int sum = 0;         ///< 子树中的公式数
+        QVector<const MathObject *> equations; ///< 本段落中带编号的公式
+        QVector<QString> labels; ///< 登记时各公式的标签（注销时按此查找，不再访问公式对象）
+    };
+
+    /**
+     * @brief 分配一个节点
+     * @param equations 段落中带编号的公式
+     * @return 节点索引
+     */
+    int allocate(const QVector<const MathObject *> &equations);
+
+    /**
+     * @brief 重新计算节点的子树统计并修正子节点的父指针
+     * @param node 节点索引
+     */
+    void pull(int node);
+
+    /**
+     * @brief 按段落数把子树分成两部分
+     * @param node 子树根节点
+     * @param count 左侧部分的段落数
+     * @param left 输出：左侧子树
+     * @param right 输出：右侧子树
+     */
+    void split(int node, int count, int *left, int *right);
+
+    /**
+     * @brief 合并两棵子树（左侧的段落全部在右侧之前）
+     * @param left 左侧子树
+     * @param right 右侧子树
+     * @return 合并后的根节点
+     */
+    int merge(int left, int right);
+
+    /**
+     * @brief 查找指定段落的节点
+     * @param index 段落索引
+     * @return 节点索引，越界时返回-1
+     */
+    int nodeAt(int index) const;
+
+    /**
+     * @brief 登记节点中的公式及其标签
+     * @param node 节点索引
+     */
+    void registerEquations(int node);
+
+    /**
+     * @brief 注销节点中的公式及其标签
+     * 按登记时保存的标签注销，公式对象此时可能已被修改或释放
+     * @param node 节点索引
+     */
+    void unregisterEquations(int node);
+
+    /**
+     * @brief 获取子树的段落数
+     * @param node 节点索引
+     * @return 段落数
+     */
+    int sizeOf(int node) const;
+
+    /**
+     * @brief 获取子树的公式数
+     * @param node 节点索引
+     * @return 公式数
+     */
+    int sumOf(int node) const;
+
+    /**
+     * @brief 节点池
+     */
+    QVector<Node> m_nodes;
+
+    /**
+     * @brief 空闲节点
+     */
+    QVector<int> m_free;
+
+    /**
+     * @brief 根节点
+     */
+    int m_root;
+
+    /**
+     * @brief 公式到所在节点的映射（每处出现一项，共享的公式有多项）
+     */
+    QMultiHash<const MathObject *, int> m_nodeOf;
+
+    /**
+     * @brief 标签到公式的映射（每处出现一项，共享的公式有多项）
+     */
+    QMultiHash<QString, const MathObject *> m_labels;
+
+    /**
+     * @brief 随机数状态（xorshift）
+     */
+    quint32 m_seed;
+
+    /**
+     * @brief 修订号
+     */
+    quint64 m_revision;
+};
+
+#endif // EQUATIONINDEX_H
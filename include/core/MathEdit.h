@@ -0,0 +1,78 @@
+// ============================================================================
+// MathEdit.h
+// 公式编辑记录的头文件
+// 以Row中一段子节点的替换记录表达式树的一次修改，撤销重做时在原处替换回来
+// ============================================================================
+
+#ifndef MATHEDIT_H
+#define MATHEDIT_H
+
+#include "core/MathPosition.h"
+#include <QVector>
+#include <QSharedPointer>
+
+class MathNode;
+
+/**
+ * @struct MathEdit
+ * @brief 表达式树的一次区间替换
+ *
+ * 记录position所在Row中从position.offset()开始的removed.size()个子节点被替换为inserted中的节点。
+ * 两侧只保存被替换的子树的副本，代价与被替换的节点数成正比，与公式的大小无关。
+ * 撤销和重做在原处替换子节点，未涉及的子树（及其排版缓存）保持不变。
+ */
+struct MathEdit
+{
+    /**
+     * @brief 被替换的区间在Row中的起点
+     */
+    MathPosition position;
+
+    /**
+     * @brief 被删除的子树（副本，不会被修改）
+     */
+    QVector<QSharedPointer<const MathNode>> removed;
+
+    /**
+     * @brief 插入的子树（副本，不会被修改）
+     */
+    QVector<QSharedPointer<const MathNode>> inserted;
+
+    /**
+     * @brief 记录替换前的状态：保存Row中将被替换的子节点
+     * @param row 所在的Row
+     * @param index 区间起点
+     * @param count 将被替换的子节点数
+     * @return 编辑记录（inserted为空，替换完成后调用finish）
+     */
+    static MathEdit capture(const MathNode *row, int index, int count);
+
+    /**
+     * @brief 记录替换后的状态：保存Row中新插入的子节点
+     * @param row 所在的Row
+     * @param count 插入的子节点数
+     */
+    void finish(const MathNode *row, int count);
+
+    /**
+     * @brief 撤销这次替换
+     * @param root 公式根节点
+     * @return 是否成功（位置不再有效时返回false且不修改表达式树）
+     */
+    bool undo(MathNode *root) const;
+
+    /**
+     * @brief 重做这次替换
+     * @param root 公式根节点
+     * @return 是否成功（位置不再有效时返回false且不修改表达式树）
+     */
+    bool redo(MathNode *root) const;
+
+    /**
+     * @brief 获取记录中保存的节点总数（用于估计内存）
+     * @return 节点数
+     */
+    int nodeCount() const;
+};
+
+#endif // MATHEDIT_H
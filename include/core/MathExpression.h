@@ -0,0 +1,192 @@
+// ============================================================================
+// MathExpression.h
+// 可求值表达式类的头文件
+// 把公式的表达式树编译为紧凑的栈式字节码，支持单点求值和按列批量求值
+// ============================================================================
+
+#ifndef MATHEXPRESSION_H
+#define MATHEXPRESSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QSharedPointer>
+
+class MathNode;
+
+/**
+ * @class MathExpression
+ * @brief 可求值表达式类
+ *
+ * 从公式根节点编译：识别数字、变量（单个字母，可带下标，如x_1）、常数π和e、
+ * 四则运算与隐式乘法、分式、根式、乘方、绝对值（|…|定界符）和常用函数（sin、ln等）。
+ * Row中含有"="时只编译最后一个"="右侧的部分，因此"y=x^2"可以直接求值。
+ * 编译时折叠常量子表达式，结果是一段后缀字节码，求值不再访问表达式树。
+ *
+ * 批量求值按列输入变量值，每次处理一个固定大小的块：每条指令对整个块执行一个
+ * 无分支的内层循环，中间结果保存在按块排列的栈中，编译器可以把这些循环向量化，
+ * 指令分派的开销也被块内的所有元素分摊。
+ * 编译结果不可变，可在线程间共享；compile()按公式的结构哈希缓存编译结果。
+ */
+class MathExpression
+{
+public:
+    /**
+     * @brief 构造函数
+     * 编译表达式树（不经过缓存）
+     * @param root 公式根节点
+     */
+    explicit MathExpression(const MathNode *root);
+
+    /**
+     * @brief 编译表达式树，结构相同的公式共享同一份编译结果
+     * 须在修改表达式树的线程中调用（结构哈希由节点惰性计算）
+     * @param root 公式根节点
+     * @return 编译结果，root为nullptr时返回空指针
+     */
+    static QSharedPointer<const MathExpression> compile(const MathNode *root);
+
+    /**
+     * @brief 检查是否编译成功
+     * @return 是否可以求值
+     */
+    bool isValid() const;
+
+    /**
+     * @brief 获取编译错误
+     * @return 错误信息，编译成功时为空
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 获取变量名（按首次出现的顺序，即求值时各列的顺序）
+     * @return 变量名列表
+     */
+    QStringList variables() const;
+
+    /**
+     * @brief 获取变量的序号
+     * @param name 变量名
+     * @return 序号，不含该变量时返回-1
+     */
+    int variableIndex(const QString &name) const;
+
+    /**
+     * @brief 检查表达式是否为常量（不含变量）
+     * @return 是否为常量
+     */
+    bool isConstant() const;
+
+    /**
+     * @brief 单点求值
+     * @param values 各变量的值（与variables()顺序一致）
+     * @return 结果，表达式无效或变量值不足时返回NaN
+     */
+    double evaluate(const QVector<double> &values = QVector<double>()) const;
+
+    /**
+     * @brief 按列批量求值
+     * @param columns 各变量的值数组（与variables()顺序一致，每个数组至少有count项）
+     * @param count 求值点数
+     * @param results 输出：count个结果，无效时全部为NaN
+     */
+    void evaluate(const QVector<const double *> &columns, int count, double *results) const;
+
+    /**
+     * @brief 获取字节码的指令数
+     * @return 指令数
+     */
+    int instructionCount() const;
+
+    /**
+     * @enum Opcode
+     * @brief 字节码操作码
+     */
+    enum Opcode
+    {
+        Constant,   ///< 压入常量（操作数为常量序号）
+        Variable,   ///< 压入变量（操作数为变量序号）
+        Add,        ///< 加
+        Subtract,   ///< 减
+        Multiply,   ///< 乘
+        Divide,     ///< 除
+        Power,      ///< 乘方
+        Negate,     ///< 取负
+        Abs,        ///< 绝对值
+        Sqrt,       ///< 平方根
+        Exp,        ///< 指数
+        Ln,         ///< 自然对数
+        Log10,      ///< 常用对数
+        Sin,        ///< 正弦
+        Cos,        ///< 余弦
+        Tan,        ///< 正切
+        Asin,       ///< 反正弦
+        Acos,       ///< 反余弦
+        Atan,       ///< 反正切
+        Sinh,       ///< 双曲正弦
+        Cosh,       ///< 双曲余弦
+        Tanh        ///< 双曲正切
+    };
+
+    /**
+     * @brief 计算一元操作
+     * @param op 操作码
+     * @param a 操作数
+     * @return 结果
+     */
+    static double apply(Opcode op, double a);
+
+    /**
+     * @brief 计算二元操作
+     * @param op 操作码
+     * @param a 左操作数
+     * @param b 右操作数
+     * @return 结果
+     */
+    static double apply(Opcode op, double a, double b);
+
+    /**
+     * @brief 批量求值时每块的元素数
+     */
+    static constexpr int BLOCK_SIZE = 256;
+
+private:
+    /**
+     * @struct Instruction
+     * @brief 一条字节码指令
+     */
+    struct Instruction
+    {
+        Opcode op = Constant; ///< 操作码
+        int operand = 0;      ///< 操作数（常量或变量序号）
+    };
+
+    friend class MathExpressionCompiler;
+
+    /**
+     * @brief 指令序列（后缀顺序）
+     */
+    QVector<Instruction> m_code;
+
+    /**
+     * @brief 常量表
+     */
+    QVector<double> m_constants;
+
+    /**
+     * @brief 变量名
+     */
+    QStringList m_variables;
+
+    /**
+     * @brief 求值所需的最大栈深度
+     */
+    int m_stackDepth;
+
+    /**
+     * @brief 编译错误
+     */
+    QString m_error;
+};
+
+#endif // MATHEXPRESSION_H
@@ -0,0 +1,117 @@
+// ============================================================================
+// MathNavigator.h
+// 公式光标导航类的头文件
+// 在表达式树上按结构移动光标：左右进出槽位、上下在分子分母和角标间切换、Tab在矩阵单元格间跳转
+// ============================================================================
+
+#ifndef MATHNAVIGATOR_H
+#define MATHNAVIGATOR_H
+
+#include "core/MathPosition.h"
+
+class MathNode;
+
+/**
+ * @class MathNavigator
+ * @brief 公式光标导航类
+ *
+ * 所有移动都直接在表达式树上进行：从当前Row出发，只访问其所在结构节点和祖先链，
+ * 复杂度为O(深度)，与公式的总节点数无关。
+ * 左右移动按槽位顺序进出结构（根式先根指数后被开方数），空的可选槽位（空角标、空根指数）
+ * 被跳过；上下移动在分子与分母、基础与角标、根指数与被开方数、矩阵相邻行之间切换。
+ * 移动越过公式边界时返回无效位置，由调用者把光标移到公式外的文本中。
+ */
+class MathNavigator
+{
+public:
+    /**
+     * @brief 获取公式的起始位置
+     * @param root 根节点
+     * @return 位置
+     */
+    static MathPosition start(const MathNode *root);
+
+    /**
+     * @brief 获取公式的结束位置
+     * @param root 根节点
+     * @return 位置
+     */
+    static MathPosition end(const MathNode *root);
+
+    /**
+     * @brief 向左移动一步
+     * @param root 根节点
+     * @param position 当前位置
+     * @return 新位置，越过公式左边界时返回无效位置
+     */
+    static MathPosition moveLeft(const MathNode *root, const MathPosition &position);
+
+    /**
+     * @brief 向右移动一步
+     * @param root 根节点
+     * @param position 当前位置
+     * @return 新位置，越过公式右边界时返回无效位置
+     */
+    static MathPosition moveRight(const MathNode *root, const MathPosition &position);
+
+    /**
+     * @brief 向上移动到上方的槽位
+     * @param root 根节点
+     * @param position 当前位置
+     * @return 新位置，上方没有槽位时返回无效位置
+     */
+    static MathPosition moveUp(const MathNode *root, const MathPosition &position);
+
+    /**
+     * @brief 向下移动到下方的槽位
+     * @param root 根节点
+     * @param position 当前位置
+     * @return 新位置，下方没有槽位时返回无效位置
+     */
+    static MathPosition moveDown(const MathNode *root, const MathPosition &position);
+
+    /**
+     * @brief 移动到所在矩阵的下一个单元格（最后一个单元格之后移出矩阵）
+     * @param root 根节点
+     * @param position 当前位置
+     * @return 新位置，不在矩阵中时返回无效位置
+     */
+    static MathPosition nextCell(const MathNode *root, const MathPosition &position);
+
+    /**
+     * @brief 移动到所在矩阵的上一个单元格（第一个单元格之前移出矩阵）
+     * @param root 根节点
+     * @param position 当前位置
+     * @return 新位置，不在矩阵中时返回无效位置
+     */
+    static MathPosition previousCell(const MathNode *root, const MathPosition &position);
+
+private:
+    /**
+     * @brief 按槽位顺序查找相邻的可进入槽位
+     * @param node 结构节点
+     * @param index 当前槽位索引，-1表示从结构之外进入
+     * @param forward 是否向后查找
+     * @return 槽位索引，没有时返回-1
+     */
+    static int adjacentSlot(const MathNode *node, int index, bool forward);
+
+    /**
+     * @brief 查找垂直方向上相邻的槽位
+     * @param node 结构节点
+     * @param index 当前槽位索引
+     * @param up 是否向上
+     * @return 槽位索引，没有时返回-1
+     */
+    static int verticalSlot(const MathNode *node, int index, bool up);
+
+    /**
+     * @brief 离开当前槽位：进入同一结构的相邻槽位，或移到结构之外
+     * @param row 当前槽位
+     * @param forward 是否向后
+     * @return 新位置，已在根节点时返回无效位置
+     */
+    static MathPosition leaveSlot(const MathNode *row, bool forward);
+};
+
+#endif // MATHNAVIGATOR_H
@@ -0,0 +1,352 @@
+// ============================================================================
+// MathNode.h
+// 数学表达式节点类的头文件
+// 表示公式的表达式树，节点缓存子树的结构哈希
+// ============================================================================
+
+#ifndef MATHNODE_H
+#define MATHNODE_H
+
+#include <QString>
+#include <QVector>
+#include <QSharedPointer>
+#include <QSet>
+
+struct FormulaLayout;
+
+/**
+ * @struct MathBox
+ * @brief 数学排版盒子
+ *
+ * TeX风格的盒子度量：以基线为原点，ascent向上、descent向下。
+ */
+struct MathBox
+{
+    /**
+     * @brief 宽度
+     */
+    qreal width = 0;
+
+    /**
+     * @brief 基线以上的高度
+     */
+    qreal ascent = 0;
+
+    /**
+     * @brief 基线以下的深度
+     */
+    qreal descent = 0;
+
+    /**
+     * @brief 斜体校正（上标需要额外右移的距离）
+     */
+    qreal italicCorrection = 0;
+
+    /**
+     * @brief 获取总高度
+     * @return ascent + descent
+     */
+    qreal height() const { return ascent + descent; }
+
+    /**
+     * @brief 比较两个盒子是否相等
+     * @param other 另一个盒子
+     * @return 是否相等
+     */
+    bool operator==(const MathBox &other) const {
+        return width == other.width && ascent == other.ascent
+               && descent == other.descent && italicCorrection == other.italicCorrection;
+    }
+
+    /**
+     * @brief 比较两个盒子是否不相等
+     * @param other 另一个盒子
+     * @return 是否不相等
+     */
+    bool operator!=(const MathBox &other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @class MathNode
+ * @brief 数学表达式节点类
+ *
+ * 公式由节点树表示，每个节点拥有其子节点并记录父节点。
+ * 各类型节点的子节点约定如下：
+ * - Row：任意数量的子节点，水平排列
+ * - Symbol：无子节点，text为符号或标识符
+ * - Fraction：[分子Row, 分母Row]
+ * - Script：[底数Row, 下标Row, 上标Row]，空Row表示没有该角标
+ * - Radical：[被开方数Row, 根指数Row]，空Row表示平方根
+ * - Delimited：[内容Row]，text为左右两个定界符（如"()"）
+ * - Matrix：rows × columns个单元格Row，按行存储，text为各列对齐方式
+ *   （'l'/'c'/'r'循环使用，如align环境为"rl"，空表示居中）
+ *
+ * 节点缓存子树的结构哈希，任何修改都会沿父节点链作废祖先的哈希，
+ * 因此未修改的子树再次查询哈希的代价为O(1)。
+ * 节点还缓存自身的排版结果和盒子（由视图层的排版引擎设置）：修改会把本节点标记为
+ * 内容已变化，并沿祖先链标记排版已过期，排版引擎只需重新访问这条祖先链。
+ * 每个节点记录自上次排版后过期的子节点，内容未变的节点只需重新排版这些子节点。
+ */
+class MathNode
+{
+public:
+    /**
+     * @enum Type
+     * @brief 节点类型
+     */
+    enum Type
+    {
+        Row,        ///< 水平序列
+        Symbol,     ///< 符号
+        Fraction,   ///< 分式
+        Script,     ///< 上下标
+        Radical,    ///< 根式
+        Delimited,  ///< 定界符（括号）
+        Matrix      ///< 矩阵
+    };
+
+    /**
+     * @brief 构造函数
+     * 不创建子节点，需要固定子节点的类型请使用create()
+     * @param type 节点类型
+     * @param text 节点文本（符号内容或定界符）
+     */
+    MathNode(Type type, const QString &text = QString());
+
+    /**
+     * @brief 析构函数
+     * 删除所有子节点
+     */
+    ~MathNode();
+
+    /**
+     * @brief 创建节点并补齐该类型固定的子节点（空Row）
+     * @param type 节点类型（矩阵请使用createMatrix）
+     * @param text 节点文本
+     * @return 新节点
+     */
+    static MathNode *create(Type type, const QString &text = QString());
+
+    /**
+     * @brief 创建矩阵节点，所有单元格为空Row
+     * @param rows 行数
+     * @param columns 列数
+     * @param alignment 各列对齐方式
+     * @return 新节点
+     */
+    static MathNode *createMatrix(int rows, int columns, const QString &alignment = QString());
+
+    /**
+     * @brief 深拷贝子树（不复制排版缓存，新节点需要重新排版）
+     * @return 新节点（调用者取得所有权）
+     */
+    MathNode *clone() const;
+
+    /**
+     * @brief 获取节点类型
+     * @return 节点类型
+     */
+    Type type() const;
+
+    /**
+     * @brief 获取节点文本
+     * @return 节点文本
+     */
+    QString text() const;
+
+    /**
+     * @brief 设置节点文本
+     * @param text 节点文本
+     */
+    void setText(const QString &text);
+
+    /**
+     * @brief 获取父节点
+     * @return 父节点，根节点返回nullptr
+     */
+    MathNode *parent() const;
+
+    /**
+     * @brief 获取本节点在父节点中的索引（O(1)）
+     * @return 索引，根节点返回-1
+     */
+    int indexInParent() const;
+
+    /**
+     * @brief 获取子节点数量
+     * @return 子节点数量
+     */
+    int childCount() const;
+
+    /**
+     * @brief 获取子节点
+     * @param index 子节点索引
+     * @return 子节点
+     */
+    MathNode *child(int index) const;
+
+    /**
+     * @brief 插入子节点（取得所有权）
+     * @param index 插入位置
+     * @param child 子节点，不能已有父节点
+     */
+    void insertChild(int index, MathNode *child);
+
+    /**
+     * @brief 追加子节点（取得所有权）
+     * @param child 子节点
+     */
+    void appendChild(MathNode *child);
+
+    /**
+     * @brief 取出子节点（交出所有权）
+     * @param index 子节点索引
+     * @return 子节点
+     */
+    MathNode *takeChild(int index);
+
+    /**
+     * @brief 删除子节点
+     * @param index 子节点索引
+     */
+    void removeChild(int index);
+
+    /**
+     * @brief 获取矩阵列数
+     * @return 列数（非矩阵节点为0）
+     */
+    int columns() const;
+
+    /**
+     * @brief 获取矩阵行数
+     * @return 行数（非矩阵节点为0）
+     */
+    int rows() const;
+
+    /**
+     * @brief 获取结构哈希
+     * 由类型、文本和子节点哈希组合而成，结构相同的子树哈希相同
+     * @return 结构哈希
+     */
+    quint64 hash() const;
+
+    /**
+     * @brief 获取子树节点总数
+     * @return 节点数（包括自身）
+     */
+    int nodeCount() const;
+
+    /**
+     * @brief 获取缓存的排版结果
+     * @return 排版结果，尚未排版时为空
+     */
+    QSharedPointer<const FormulaLayout> layout() const;
+
+    /**
+     * @brief 获取缓存的盒子
+     * @return 盒子度量
+     */
+    MathBox box() const;
+
+    /**
+     * @brief 设置排版结果（由排版引擎调用），同时清除过期标记
+     * @param layout 排版结果
+     * @param box 盒子度量
+     */
+    void setLayout(const QSharedPointer<const FormulaLayout> &layout, const MathBox &box);
+
+    /**
+     * @brief 检查排版是否过期（本节点或其子孙在上次排版后被修改）
+     * @return 是否过期
+     */
+    bool isLayoutDirty() const;
+
+    /**
+     * @brief 检查本节点自身的内容（文本、子节点列表）是否在上次排版后被修改
+     * @return 是否已变化
+     */
+    bool isContentChanged() const;
+
+    /**
+     * @brief 获取自上次排版后排版过期的子节点
+     * 本节点内容已变化时子节点列表本身可能已改变，此时应重新排版全部子节点
+     * @return 过期的子节点
+     */
+    const QSet<MathNode *> &dirtyChildren() const;
+
+protected:
+    /**
+     * @brief 本节点内容变化，作废本节点及所有祖先的缓存
+     */
+    void invalidate();
+
+private:
+    /**
+     * @brief 节点类型
+     */
+    Type m_type;
+
+    /**
+     * @brief 节点文本
+     */
+    QString m_text;
+
+    /**
+     * @brief 父节点
+     */
+    MathNode *m_parent;
+
+    /**
+     * @brief 在父节点中的索引
+     */
+    int m_index;
+
+    /**
+     * @brief 子节点（拥有所有权）
+     */
+    QVector<MathNode *> m_children;
+
+    /**
+     * @brief 矩阵列数
+     */
+    int m_columns;
+
+    /**
+     * @brief 缓存的结构哈希
+     */
+    mutable quint64 m_hash;
+
+    /**
+     * @brief 结构哈希是否有效
+     */
+    mutable bool m_hashValid;
+
+    /**
+     * @brief 缓存的排版结果
+     */
+    QSharedPointer<const FormulaLayout> m_layout;
+
+    /**
+     * @brief 缓存的盒子
+     */
+    MathBox m_box;
+
+    /**
+     * @brief 排版是否过期
+     */
+    bool m_layoutDirty;
+
+    /**
+     * @brief 自身内容是否已变化
+     */
+    bool m_contentChanged;
+
+    /**
+     * @brief 自上次排版后排版过期的子节点
+     */
+    QSet<MathNode *> m_dirtyChildren;
+};
+
+#endif // MATHNODE_H
@@ -0,0 +1,110 @@
+// ============================================================================
+// MathObject.h
+// 公式对象类的头文件
+// 嵌入段落中的一个公式，拥有表达式树的根节点
+// ============================================================================
+
+#ifndef MATHOBJECT_H
+#define MATHOBJECT_H
+
+#include "core/MathNode.h"
+#include "core/MathExpression.h"
+#include <QChar>
+#include <QString>
+
+/**
+ * @class MathObject
+ * @brief 公式对象类
+ *
+ * 表示段落中的一个公式。公式在段落文本中占一个对象替换字符（U+FFFC），
+ * 由Run以共享指针的形式持有，根节点为一个Row。
+ * 带编号的公式由文档的公式编号索引统计次序，编号不保存在公式中；
+ * 公式插入文档后，编号和标签应通过Document::setEquationNumbered修改，以保持索引一致。
+ */
+class MathObject
+{
+public:
+    /**
+     * @brief 构造函数
+     * 创建一个空公式（根节点为空Row）
+     */
+    MathObject();
+
+    /**
+     * @brief 构造函数
+     * @param root 根节点（取得所有权），为nullptr时创建空Row
+     */
+    explicit MathObject(MathNode *root);
+
+    /**
+     * @brief 析构函数
+     */
+    ~MathObject();
+
+    /**
+     * @brief 获取根节点
+     * @return 根节点
+     */
+    MathNode *root() const;
+
+    /**
+     * @brief 获取公式的结构哈希
+     * @return 结构哈希
+     */
+    quint64 hash() const;
+
+    /**
+     * @brief 获取公式编译后的可求值表达式（按结构哈希缓存，公式未修改时不重新编译）
+     * @return 可求值表达式
+     */
+    QSharedPointer<const MathExpression> expression() const;
+
+    /**
+     * @brief 检查公式是否带编号
+     * @return 是否带编号
+     */
+    bool isNumbered() const;
+
+    /**
+     * @brief 设置公式是否带编号
+     * @param numbered 是否带编号
+     */
+    void setNumbered(bool numbered);
+
+    /**
+     * @brief 获取公式的标签（供交叉引用）
+     * @return 标签，没有标签时为空
+     */
+    QString label() const;
+
+    /**
+     * @brief 设置公式的标签
+     * @param label 标签
+     */
+    void setLabel(const QString &label);
+
+    /**
+     * @brief 公式在段落文本中占用的字符
+     */
+    static const QChar ReplacementCharacter;
+
+private:
+    Q_DISABLE_COPY(MathObject)
+
+    /**
+     * @brief 根节点
+     */
+    MathNode *m_root;
+
+    /**
+     * @brief 是否带编号
+     */
+    bool m_numbered;
+
+    /**
+     * @brief 标签
+     */
+    QString m_label;
+};
+
+#endif // MATHOBJECT_H
@@ -0,0 +1,104 @@
+// ============================================================================
+// MathPosition.h
+// 公式内位置类的头文件
+// 以从根节点到所在Row的子节点索引路径加Row内偏移表示公式中的光标位置
+// ============================================================================
+
+#ifndef MATHPOSITION_H
+#define MATHPOSITION_H
+
+#include <QVector>
+
+class MathNode;
+
+/**
+ * @class MathPosition
+ * @brief 公式内位置类
+ *
+ * 光标在公式中总是位于某个Row的两个子节点之间。位置由根节点到该Row的
+ * 子节点索引路径和Row内的偏移组成，路径长度即嵌套深度。
+ * 解析路径和由节点构造位置都只沿祖先链走一遍，复杂度为O(深度)，不需要把公式线性化。
+ * 路径只保存索引，不持有节点指针，公式结构修改后旧位置会解析失败而不会悬空。
+ */
+class MathPosition
+{
+public:
+    /**
+     * @brief 构造函数
+     * 创建一个无效位置（不在公式中）
+     */
+    MathPosition();
+
+    /**
+     * @brief 构造函数
+     * @param path 从根节点到所在Row的子节点索引路径（根Row为空路径）
+     * @param offset Row内的偏移（0到子节点数）
+     */
+    MathPosition(const QVector<int> &path, int offset);
+
+    /**
+     * @brief 由Row节点和偏移构造位置（O(深度)）
+     * @param row 所在的Row节点
+     * @param offset Row内的偏移
+     * @return 位置，row为空时返回无效位置
+     */
+    static MathPosition fromNode(const MathNode *row, int offset);
+
+    /**
+     * @brief 获取子节点索引路径
+     * @return 路径
+     */
+    const QVector<int> &path() const;
+
+    /**
+     * @brief 获取Row内的偏移
+     * @return 偏移
+     */
+    int offset() const;
+
+    /**
+     * @brief 获取嵌套深度
+     * @return 路径长度
+     */
+    int depth() const;
+
+    /**
+     * @brief 检查位置是否有效
+     * @return 是否有效
+     */
+    bool isValid() const;
+
+    /**
+     * @brief 在给定的表达式树中解析所在的Row（O(深度)）
+     * @param root 根节点
+     * @return Row节点，路径或偏移不再有效时返回nullptr
+     */
+    MathNode *row(const MathNode *root) const;
+
+    /**
+     * @brief 比较两个位置是否相等
+     * @param other 另一个位置
+     * @return 是否相等
+     */
+    bool operator==(const MathPosition &other) const;
+
+    /**
+     * @brief 比较两个位置是否不等
+     * @param other 另一个位置
+     * @return 是否不等
+     */
+    bool operator!=(const MathPosition &other) const;
+
+private:
+    /**
+     * @brief 子节点索引路径
+     */
+    QVector<int> m_path;
+
+    /**
+     * @brief Row内的偏移（-1表示无效位置）
+     */
+    int m_offset;
+};
+
+#endif // MATHPOSITION_H
@@ -0,0 +1,170 @@
+// ============================================================================
+// MathTokenizer.h
+// 公式输入词法分析器类的头文件
+// 在光标处增量识别LaTeX快捷输入（\alpha、\frac、^、_），直接转换为表达式树编辑
+// ============================================================================
+
+#ifndef MATHTOKENIZER_H
+#define MATHTOKENIZER_H
+
+#include "core/MathEdit.h"
+#include "core/MathPosition.h"
+#include <QString>
+#include <QChar>
+
+class MathNode;
+
+/**
+ * @class MathTokenizer
+ * @brief 公式输入词法分析器类
+ *
+ * 逐字符处理公式中的键盘输入。普通字符直接插入为符号节点；反斜杠开始一个命令记号，
+ * 其后的字母先作为符号节点插入（用户能看到正在输入的命令），命令结束时只把这一段
+ * 记号窗口中的节点替换为对应的符号或结构；^和_把光标前的节点包进上下标结构。
+ *
+ * 词法状态（命令记号在Row中的起点和已输入的命令名）保存在光标处，只要下一次输入
+ * 仍从上次结束的光标位置开始就能继续；光标移动或公式被其他途径修改后状态自动作废，
+ * 已插入的字符保留为普通符号。每次按键只访问光标所在Row中的记号窗口和祖先链，
+ * 与公式的总长度无关，从不重新解析整个公式。
+ * 设置了编辑记录时，每次修改都以Row中一段子节点的替换登记下来，供撤销栈在原处还原。
+ */
+class MathTokenizer
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    MathTokenizer();
+
+    /**
+     * @brief 处理一个输入字符并修改表达式树
+     * @param root 公式根节点
+     * @param caret 光标位置
+     * @param character 输入字符
+     * @return 输入后的光标位置，光标位置无效时返回无效位置且不修改表达式树
+     */
+    MathPosition input(MathNode *root, const MathPosition &caret, QChar character);
+
+    /**
+     * @brief 结束尚未完成的命令记号（光标离开前调用，如按下方向键）
+     * @param root 公式根节点
+     * @param caret 光标位置
+     * @return 结束后的光标位置，没有未完成的记号时原样返回
+     */
+    MathPosition flush(MathNode *root, const MathPosition &caret);
+
+    /**
+     * @brief 以补全选中的命令结束正在输入的命令
+     * @param root 公式根节点
+     * @param caret 光标位置
+     * @param name 选中的命令名
+     * @return 结束后的光标位置，没有未完成的记号时原样返回
+     */
+    MathPosition completeCommand(MathNode *root, const MathPosition &caret, const QString &name);
+
+    /**
+     * @brief 丢弃词法状态（已插入的字符保留为普通符号）
+     */
+    void reset();
+
+    /**
+     * @brief 设置编辑记录，之后的修改按执行顺序追加到其中
+     * @param edits 编辑记录，为nullptr时不记录
+     */
+    void setEditLog(QVector<MathEdit> *edits);
+
+    /**
+     * @brief 检查是否正在输入命令
+     * @return 是否有未完成的命令记号
+     */
+    bool isPending() const;
+
+    /**
+     * @brief 获取正在输入的命令名（用于补全）
+     * @return 命令名，不在命令中时返回空字符串
+     */
+    QString pendingCommand() const;
+
+    /**
+     * @brief 查找命令对应的符号
+     * @param name 命令名（不含反斜杠）
+     * @return 符号文本，不是符号命令时返回空字符串（符号表由SymbolTrie提供）
+     */
+    static QString symbolForCommand(const QString &name);
+
+private:
+    /**
+     * @brief 在光标处处理一个字符（不在命令记号中）
+     * @param row 光标所在的Row
+     * @param offset Row内的偏移
+     * @param character 输入字符
+     * @return 新的光标位置
+     */
+    MathPosition insertCharacter(MathNode *row, int offset, QChar character);
+
+    /**
+     * @brief 结束命令记号：把记号窗口中的节点替换为命令的结果
+     * @param row 光标所在的Row
+     * @param offset 记号窗口的结束偏移（光标位置）
+     * @param terminator 结束命令的字符（命令名为空时作为转义字符本身）
+     * @param consumed 输出：结束字符是否已被命令消耗
+     * @return 新的光标位置
+     */
+    MathPosition finishCommand(MathNode *row, int offset, QChar terminator, bool *consumed);
+
+    /**
+     * @brief 把光标前的节点包进上下标结构并进入角标槽位
+     * @param row 光标所在的Row
+     * @param offset Row内的偏移
+     * @param slot 角标槽位（1为下标，2为上标）
+     * @return 新的光标位置
+     */
+    MathPosition attachScript(MathNode *row, int offset, int slot);
+
+    /**
+     * @brief 开始一次Row区间替换：设置了编辑记录时保存将被替换的子节点
+     * @param row 所在的Row
+     * @param index 区间起点
+     * @param count 将被替换的子节点数
+     */
+    void beginReplace(const MathNode *row, int index, int count);
+
+    /**
+     * @brief 结束一次Row区间替换：保存新插入的子节点并登记到编辑记录
+     * @param row 所在的Row
+     * @param count 插入的子节点数
+     */
+    void endReplace(const MathNode *row, int count);
+
+    /**
+     * @brief 词法状态所属的公式根节点
+     */
+    const MathNode *m_root;
+
+    /**
+     * @brief 上一次输入结束时的光标位置（状态只在此处有效）
+     */
+    MathPosition m_caret;
+
+    /**
+     * @brief 命令记号（反斜杠）在Row中的偏移，-1表示不在命令中
+     */
+    int m_tokenStart;
+
+    /**
+     * @brief 已输入的命令名
+     */
+    QString m_command;
+
+    /**
+     * @brief 编辑记录（不拥有）
+     */
+    QVector<MathEdit> *m_edits;
+
+    /**
+     * @brief 正在进行的Row区间替换
+     */
+    MathEdit m_edit;
+};
+
+#endif // MATHTOKENIZER_H
@@ -87,6 +87,97 @@ public:
      * @param length 删除长度
      */
     void removeText(int position, int length);
+
+    /**
+     * @brief 在指定位置插入公式
+     * @param position 插入位置（基于段落文本的字符位置）
+     * @param formula 公式对象
+     * @param format 公式格式
+     */
+    void insertFormula(int position, const QSharedPointer<MathObject> &formula, const Format &format = Format());
+
+    /**
+     * @brief 在指定位置插入交叉引用
+     * @param position 插入位置（基于段落文本的字符位置）
+     * @param label 所引用公式的标签
+     * @param format 引用格式
+     */
+    void insertReference(int position, const QString &label, const Format &format = Format());
+
+    /**
+     * @brief 在指定位置插入函数图像
+     * @param position 插入位置（基于段落文本的字符位置）
+     * @param plot 函数图像对象
+     * @param format 格式
+     */
+    void insertPlot(int position, const QSharedPointer<PlotObject> &plot, const Format &format = Format());
+
+    /**
+     * @brief 在指定位置把段落一分为二
+     * 位置之后的Run（至多拆开一个文本Run）移入新段落，格式和公式等对象原样保留，代价为O(Run数)
+     * @param position 拆分位置（基于段落文本的字符位置）
+     * @return 位置之后的部分，本段落只保留位置之前的部分
+     */
+    Paragraph split(int position);
+
+    /**
+     * @brief 把另一个段落接在本段落末尾
+     * 直接追加对方的Run，不重新拼接文本；衔接处两个格式相同的文本Run合并为一个
+     * @param next 接在末尾的段落
+     */
+    void merge(const Paragraph &next);
+
+    /**
+     * @brief 截取段落的一部分
+     * 区间内的Run原样复制（文本隐式共享），至多拆开首尾两个文本Run
+     * @param position 起始位置
+     * @param length 长度，负数表示到段落末尾
+     * @return 截取的部分
+     */
+    Paragraph mid(int position, int length = -1) const;
+
+    /**
+     * @brief 计算与另一个段落开头相同的部分的长度（文本、格式和对象都相同）
+     * @param other 另一个段落
+     * @return 相同前缀的字符数
+     */
+    int commonPrefixLength(const Paragraph &other) const;
+
+    /**
+     * @brief 计算与另一个段落末尾相同的部分的长度（文本、格式和对象都相同）
+     * @param other 另一个段落
+     * @return 相同后缀的字符数
+     */
+    int commonSuffixLength(const Paragraph &other) const;
+
+    /**
+     * @brief 设置一段文本的格式
+     * 在区间两端各至多拆开一个Run，区间内的Run共用同一个格式，之后与相邻的同格式文本Run合并
+     * @param start 起始位置
+     * @param end 结束位置（不含）
+     * @param format 格式
+     */
+    void applyFormat(int start, int end, const Format &format);
+
+    /**
+     * @brief 设置整个段落的格式
+     * 不需要拆分Run，所有Run共用同一个格式后合并相邻的文本Run
+     * @param format 格式
+     */
+    void applyFormat(const Format &format);
+
+    /**
+     * @brief 获取段落中带编号的公式（供文档的公式编号索引使用）
+     * @return 带编号的公式（按出现顺序）
+     */
+    QVector<const MathObject *> numberedFormulas() const;
+
+    /**
+     * @brief 获取指定字符位置上的公式
+     * @param position 字符位置
+     * @return 公式对象，该位置不是公式时返回空指针
+     */
+    QSharedPointer<MathObject> formulaAt(int position) const;
     
     /**
      * @brief 获取段落长度
@@ -95,6 +186,20 @@ public:
     int length() const;
     
 private:
+    /**
+     * @brief 在指定位置拆分Run
+     * @param position 段落内的字符位置
+     * @return 从该位置开始的Run的索引（位置在末尾时为Run数量）
+     */
+    int splitRunAt(int position);
+
+    /**
+     * @brief 合并区间内相邻的同格式文本Run
+     * @param from 首个Run的索引
+     * @param to 末尾Run之后的索引
+     */
+    void coalesceRuns(int from, int to);
+
     /**
      * @brief Run列表
      */
@@ -0,0 +1,109 @@
+// ============================================================================
+// PlotObject.h
+// 函数图像对象类的头文件
+// 嵌入段落中的一个内联函数图像，绘制某个公式y=f(x)在给定区间上的图像
+// ============================================================================
+
+#ifndef PLOTOBJECT_H
+#define PLOTOBJECT_H
+
+#include "core/MathObject.h"
+#include <QSharedPointer>
+#include <QString>
+
+/**
+ * @class PlotObject
+ * @brief 函数图像对象类
+ *
+ * 与公式一样在段落文本中占一个对象替换字符，由Run以共享指针的形式持有。
+ * 图像绘制的函数是一个公式（可以与段落中的公式共享同一个对象），
+ * 自变量为公式中名为x的变量，公式只有一个变量时使用该变量。
+ * 模型只保存初始区间和宽度，平移缩放是视图状态，不修改文档。
+ */
+class PlotObject
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param function 函数公式
+     * @param xMin 区间左端
+     * @param xMax 区间右端
+     * @param width 图像宽度（像素）
+     */
+    PlotObject(const QSharedPointer<MathObject> &function, double xMin = -10, double xMax = 10,
+               int width = DEFAULT_WIDTH);
+
+    /**
+     * @brief 获取函数公式
+     * @return 函数公式
+     */
+    QSharedPointer<MathObject> function() const;
+
+    /**
+     * @brief 获取区间左端
+     * @return 区间左端
+     */
+    double xMin() const;
+
+    /**
+     * @brief 获取区间右端
+     * @return 区间右端
+     */
+    double xMax() const;
+
+    /**
+     * @brief 设置区间
+     * @param xMin 区间左端
+     * @param xMax 区间右端（不大于xMin时忽略）
+     */
+    void setRange(double xMin, double xMax);
+
+    /**
+     * @brief 获取图像宽度
+     * @return 宽度（像素）
+     */
+    int width() const;
+
+    /**
+     * @brief 设置图像宽度
+     * @param width 宽度（像素）
+     */
+    void setWidth(int width);
+
+    /**
+     * @brief 获取自变量名
+     * @param expression 函数编译后的表达式
+     * @return 自变量名，表达式为常量或有多个变量（无法确定自变量）时返回空字符串
+     */
+    static QString argument(const MathExpression &expression);
+
+    /**
+     * @brief 默认宽度（像素）
+     */
+    static const int DEFAULT_WIDTH = 160;
+
+private:
+    Q_DISABLE_COPY(PlotObject)
+
+    /**
+     * @brief 函数公式
+     */
+    QSharedPointer<MathObject> m_function;
+
+    /**
+     * @brief 区间左端
+     */
+    double m_xMin;
+
+    /**
+     * @brief 区间右端
+     */
+    double m_xMax;
+
+    /**
+     * @brief 图像宽度
+     */
+    int m_width;
+};
+
+#endif // PLOTOBJECT_H
@@ -9,6 +9,10 @@
 
 #include "Format.h"
 #include <QString>
+#include <QSharedPointer>
+
+class MathObject;
+class PlotObject;
 
 /**
  * @class Run
@@ -16,6 +20,9 @@
  * 
  * 表示具有相同格式的文本片段。
  * 是段落的基本组成单位，包含文本内容和格式信息。
+ * 公式Run持有一个公式对象，文本固定为一个对象替换字符（U+FFFC）。
+ * 交叉引用Run保存所引用公式的标签，同样占一个对象替换字符，编号在绘制时查询。
+ * 函数图像Run持有一个函数图像对象，同样占一个对象替换字符。
  */
 class Run
 {
@@ -32,6 +39,72 @@ public:
      * @param format 文本格式，默认为默认格式
      */
     Run(const QString &text, const Format &format = Format());
+
+    /**
+     * @brief 构造函数
+     * 创建一个公式Run
+     * @param formula 公式对象
+     * @param format 公式格式，默认为默认格式
+     */
+    Run(const QSharedPointer<MathObject> &formula, const Format &format = Format());
+
+    /**
+     * @brief 构造函数
+     * 创建一个函数图像Run
+     * @param plot 函数图像对象
+     * @param format 格式，默认为默认格式
+     */
+    Run(const QSharedPointer<PlotObject> &plot, const Format &format = Format());
+
+    /**
+     * @brief 创建一个交叉引用Run
+     * @param label 所引用公式的标签
+     * @param format 引用格式，默认为默认格式
+     * @return 交叉引用Run
+     */
+    static Run reference(const QString &label, const Format &format = Format());
+
+    /**
+     * @brief 检查是否为公式Run
+     * @return 是否为公式
+     */
+    bool isFormula() const;
+
+    /**
+     * @brief 获取公式对象
+     * @return 公式对象，文本Run返回空指针
+     */
+    QSharedPointer<MathObject> formula() const;
+
+    /**
+     * @brief 检查是否为交叉引用Run
+     * @return 是否为交叉引用
+     */
+    bool isReference() const;
+
+    /**
+     * @brief 获取交叉引用的标签
+     * @return 标签，非交叉引用Run返回空字符串
+     */
+    QString reference() const;
+
+    /**
+     * @brief 检查是否为函数图像Run
+     * @return 是否为函数图像
+     */
+    bool isPlot() const;
+
+    /**
+     * @brief 获取函数图像对象
+     * @return 函数图像对象，非函数图像Run返回空指针
+     */
+    QSharedPointer<PlotObject> plot() const;
+
+    /**
+     * @brief 检查是否为占一个替换字符的对象Run（公式、交叉引用或函数图像）
+     * @return 是否为对象
+     */
+    bool isObject() const;
     
     /**
      * @brief 获取文本内容
@@ -95,6 +168,21 @@ private:
      * @brief 文本格式
      */
     Format m_format;
+
+    /**
+     * @brief 公式对象（仅公式Run）
+     */
+    QSharedPointer<MathObject> m_formula;
+
+    /**
+     * @brief 所引用公式的标签（仅交叉引用Run）
+     */
+    QString m_reference;
+
+    /**
+     * @brief 函数图像对象（仅函数图像Run）
+     */
+    QSharedPointer<PlotObject> m_plot;
 };
 
 #endif // RUN_H
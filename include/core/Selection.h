@@ -7,6 +7,8 @@
 #ifndef SELECTION_H
 #define SELECTION_H
 
+#include "core/MathPosition.h"
+
 /**
  * @class Selection
  * @brief 选择类
@@ -34,6 +36,11 @@ public:
          * @brief 段落内的位置
          */
         int position;
+
+        /**
+         * @brief 公式内的位置（position指向公式的替换字符时有效，否则为无效位置）
+         */
+        MathPosition math;
         
         /**
          * @brief 比较两个位置是否相等
@@ -41,7 +48,7 @@ public:
          * @return 是否相等
          */
         bool operator==(const Position &other) const {
-            return paragraph == other.paragraph && position == other.position;
+            return paragraph == other.paragraph && position == other.position && math == other.math;
         }
         
         /**
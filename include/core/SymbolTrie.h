@@ -0,0 +1,177 @@
+// ============================================================================
+// SymbolTrie.h
+// 命令符号字典树类的头文件
+// 紧凑存储公式命令名及其符号，支持精确查找、按权重排序的前缀补全和模糊补全
+// ============================================================================
+
+#ifndef SYMBOLTRIE_H
+#define SYMBOLTRIE_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @struct SymbolCompletion
+ * @brief 一条补全候选
+ */
+struct SymbolCompletion
+{
+    /**
+     * @brief 命令名（不含反斜杠）
+     */
+    QString name;
+
+    /**
+     * @brief 命令对应的符号，结构命令（如frac）为空
+     */
+    QString symbol;
+
+    /**
+     * @brief 编辑距离（前缀补全为0）
+     */
+    int distance = 0;
+
+    /**
+     * @brief 权重（越大越常用）
+     */
+    int weight = 0;
+};
+
+/**
+ * @class SymbolTrie
+ * @brief 命令符号字典树类
+ *
+ * 节点保存在一个连续数组中，子节点以按字符排序的兄弟链表相连，每个节点记录子树中的
+ * 最大权重。前缀补全按子树最大权重做最优优先搜索，只展开能进入前k名的分支，
+ * 不必枚举整个子树；模糊补全在树上逐层计算编辑距离的一行，超出允许距离的分支立即剪掉。
+ * 内置符号表在首次使用时一次性建树，之后用户宏可以继续插入。
+ */
+class SymbolTrie
+{
+public:
+    /**
+     * @brief 构造函数
+     * 创建一个空字典树
+     */
+    SymbolTrie();
+
+    /**
+     * @brief 获取全应用共享的字典树（已载入内置符号表）
+     * @return 字典树
+     */
+    static SymbolTrie *shared();
+
+    /**
+     * @brief 插入或更新一个命令
+     * @param name 命令名（不含反斜杠）
+     * @param symbol 命令对应的符号，结构命令为空
+     * @param weight 权重（越大越常用）
+     */
+    void insert(const QString &name, const QString &symbol, int weight = 0);
+
+    /**
+     * @brief 检查命令是否存在
+     * @param name 命令名
+     * @return 是否存在
+     */
+    bool contains(const QString &name) const;
+
+    /**
+     * @brief 精确查找命令对应的符号
+     * @param name 命令名
+     * @return 符号，不存在或为结构命令时返回空字符串
+     */
+    QString symbol(const QString &name) const;
+
+    /**
+     * @brief 前缀补全
+     * @param prefix 已输入的前缀
+     * @param limit 最多返回的条数
+     * @return 以prefix开头的命令，按权重从高到低排列
+     */
+    QVector<SymbolCompletion> complete(const QString &prefix, int limit) const;
+
+    /**
+     * @brief 模糊补全
+     * @param pattern 已输入的文本
+     * @param limit 最多返回的条数
+     * @param maxEdits 允许的最大编辑距离
+     * @return 某个前缀与pattern的编辑距离不超过maxEdits的命令，按距离、权重排列
+     */
+    QVector<SymbolCompletion> fuzzyComplete(const QString &pattern, int limit, int maxEdits = 1) const;
+
+    /**
+     * @brief 补全：先取前缀补全，不足limit条时用模糊补全补足
+     * @param text 已输入的文本
+     * @param limit 最多返回的条数
+     * @return 补全候选
+     */
+    QVector<SymbolCompletion> lookup(const QString &text, int limit) const;
+
+    /**
+     * @brief 获取命令数
+     * @return 命令数
+     */
+    int size() const;
+
+    /**
+     * @brief 获取节点数
+     * @return 节点数
+     */
+    int nodeCount() const;
+
+private:
+    /**
+     * @struct Node
+     * @brief 字典树节点
+     */
+    struct Node
+    {
+        ushort character = 0;   ///< 进入本节点的字符
+        int firstChild = -1;    ///< 第一个子节点
+        int nextSibling = -1;   ///< 下一个兄弟节点（按字符升序）
+        int entry = -1;         ///< 在本节点结束的命令，-1表示没有
+        int best = -1;          ///< 子树中命令的最大权重
+    };
+
+    /**
+     * @struct Entry
+     * @brief 一个命令
+     */
+    struct Entry
+    {
+        QString name;    ///< 命令名
+        QString symbol;  ///< 符号
+        int weight = 0;  ///< 权重
+    };
+
+    /**
+     * @brief 查找字符串对应的节点
+     * @param text 字符串
+     * @return 节点索引，不存在时返回-1
+     */
+    int findNode(const QString &text) const;
+
+    /**
+     * @brief 按权重取若干子树和单个命令中的前若干个命令
+     * @param nodes 子树根节点
+     * @param entries 单个命令的索引
+     * @param limit 最多取的条数
+     * @param distance 写入候选的编辑距离
+     * @param results 结果（追加）
+     */
+    void collect(const QVector<int> &nodes, const QVector<int> &entries, int limit, int distance,
+                 QVector<SymbolCompletion> *results) const;
+
+    /**
+     * @brief 节点数组（0为根节点）
+     */
+    QVector<Node> m_nodes;
+
+    /**
+     * @brief 命令数组
+     */
+    QVector<Entry> m_entries;
+};
+
+#endif // SYMBOLTRIE_H
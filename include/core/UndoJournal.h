@@ -0,0 +1,82 @@
+// ============================================================================
+// UndoJournal.h
+// 撤销日志类的头文件
+// 把较旧或较大的撤销步骤压缩后追加到磁盘上的临时文件，回放时通过内存映射读取
+// ============================================================================
+
+#ifndef UNDOJOURNAL_H
+#define UNDOJOURNAL_H
+
+#include "core/Run.h"
+#include <QVector>
+#include <QByteArray>
+#include <QTemporaryFile>
+
+struct ParagraphChange;
+
+/**
+ * @class UndoJournal
+ * @brief 撤销日志类
+ *
+ * 只追加写入的临时文件：每个溢出的撤销步骤序列化为一条压缩记录，记录的偏移和长度由步骤自己保存。
+ * 文本Run连同格式写入文件；公式、交叉引用和函数图像Run共享内存中的对象，
+ * 不写入文件，而是留在步骤的对象表中，记录里只保存其序号。
+ * 回放时把记录所在的文件区域映射到内存再解压，不需要额外的读缓冲。
+ * 文件在第一次写入时创建，对象析构时删除。
+ */
+class UndoJournal
+{
+public:
+    /**
+     * @brief 构造函数
+     * 创建一个空日志（不创建文件）
+     */
+    UndoJournal();
+
+    /**
+     * @brief 追加一条记录
+     * @param changes 段落区间替换
+     * @param objects 输出：记录中引用的对象Run
+     * @param offset 输出：记录在文件中的偏移
+     * @param size 输出：记录的长度
+     * @return 是否写入成功
+     */
+    bool write(const QVector<ParagraphChange> &changes, QVector<Run> *objects, qint64 *offset, qint64 *size);
+
+    /**
+     * @brief 读取一条记录
+     * @param offset 记录在文件中的偏移
+     * @param size 记录的长度
+     * @param objects 记录中引用的对象Run
+     * @param changes 输出：段落区间替换
+     * @return 是否读取成功
+     */
+    bool read(qint64 offset, qint64 size, const QVector<Run> &objects, QVector<ParagraphChange> *changes);
+
+    /**
+     * @brief 清空日志（截断文件）
+     */
+    void clear();
+
+    /**
+     * @brief 获取日志文件的大小
+     * @return 字节数
+     */
+    qint64 size() const;
+
+private:
+    Q_DISABLE_COPY(UndoJournal)
+
+    /**
+     * @brief 按需创建临时文件
+     * @return 文件是否可用
+     */
+    bool open();
+
+    /**
+     * @brief 日志文件
+     */
+    QTemporaryFile m_file;
+};
+
+#endif // UNDOJOURNAL_H
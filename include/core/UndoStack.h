@@ -0,0 +1,373 @@
+// ============================================================================
+// UndoStack.h
+// 撤销栈类的头文件
+// 以段落区间的替换记录每次编辑的增量，支持撤销重做、连续输入合并和内存预算，较旧的步骤溢出到磁盘日志
+// ============================================================================
+
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+#include "core/Paragraph.h"
+#include "core/MathObject.h"
+#include "core/MathEdit.h"
+#include "core/Selection.h"
+#include "core/UndoJournal.h"
+#include <QVector>
+#include <QString>
+
+class Document;
+
+/**
+ * @struct ParagraphChange
+ * @brief 一处段落区间的替换
+ *
+ * 记录从first开始的before.size()个段落被替换为after中的段落。
+ * 入栈时去掉首段开头和末段末尾未变化的部分：before和after只保存被删除和插入的片段，
+ * 首个片段接在首段的offset处，末个片段之后是末段长为suffix的未变化部分。
+ * 因此在长段落中输入一个字符只记录这一个字符，一次变化的代价只与被修改的内容有关。
+ */
+struct ParagraphChange
+{
+    /**
+     * @brief 首个段落的索引
+     */
+    int first = 0;
+
+    /**
+     * @brief 首段开头未变化的字符数（首个片段之前的部分）
+     */
+    int offset = 0;
+
+    /**
+     * @brief 末段末尾未变化的字符数（末个片段之后的部分）
+     */
+    int suffix = 0;
+
+    /**
+     * @brief 变化前的段落（入栈后为被删除的片段）
+     */
+    QVector<Paragraph> before;
+
+    /**
+     * @brief 变化后的段落（入栈后为插入的片段）
+     */
+    QVector<Paragraph> after;
+};
+
+/**
+ * @struct FormulaChange
+ * @brief 一个公式在原处的修改
+ *
+ * 公式的表达式树、编号和标签在共享的公式对象上原处修改，段落的值不变，段落区间替换无法还原；
+ * 因此按执行顺序记录表达式树的区间替换和修改前后的编号、标签，撤销和重做时在原处替换回来。
+ * 记录的代价只与被替换的节点数有关，与公式的大小无关；未涉及的子树保留排版缓存。
+ */
+struct FormulaChange
+{
+    /**
+     * @brief 被修改的公式对象
+     */
+    QSharedPointer<MathObject> formula;
+
+    /**
+     * @brief 表达式树的区间替换（按执行顺序）
+     */
+    QVector<MathEdit> edits;
+
+    /**
+     * @brief 修改前是否带编号
+     */
+    bool numberedBefore = false;
+
+    /**
+     * @brief 修改后是否带编号
+     */
+    bool numberedAfter = false;
+
+    /**
+     * @brief 修改前的标签
+     */
+    QString labelBefore;
+
+    /**
+     * @brief 修改后的标签
+     */
+    QString labelAfter;
+};
+
+/**
+ * @struct EditCommand
+ * @brief 一个撤销步骤
+ *
+ * 由一次编辑产生的若干段落区间替换组成，撤销时按相反顺序恢复before，重做时按原顺序换回after。
+ * 原处修改的公式另行记录表达式树的替换，先于段落区间恢复，段落重新登记编号时即得到恢复后的编号和标签。
+ */
+struct EditCommand
+{
+    /**
+     * @enum Kind
+     * @brief 步骤类型
+     */
+    enum Kind
+    {
+        Edit,   ///< 一般编辑
+        Typing  ///< 连续输入（可与相邻的输入合并）
+    };
+
+    /**
+     * @brief 步骤类型
+     */
+    Kind kind = Edit;
+
+    /**
+     * @brief 段落区间替换（按执行顺序）
+     */
+    QVector<ParagraphChange> changes;
+
+    /**
+     * @brief 原处修改的公式（按执行顺序，始终留在内存中）
+     */
+    QVector<FormulaChange> formulas;
+
+    /**
+     * @brief 输入的文本（仅连续输入，用于判断单词边界）
+     */
+    QString text;
+
+    /**
+     * @brief 编辑前的光标位置（撤销后恢复）
+     */
+    Selection::Position cursorBefore = {-1, -1};
+
+    /**
+     * @brief 编辑后的光标位置（重做后恢复）
+     */
+    Selection::Position cursorAfter = {-1, -1};
+
+    /**
+     * @brief 估计占用的内存（字节），入栈时计算
+     */
+    qint64 cost = 0;
+
+    /**
+     * @brief 溢出到磁盘日志后记录的偏移，负数表示段落区间替换仍在内存中
+     */
+    qint64 journalOffset = -1;
+
+    /**
+     * @brief 溢出到磁盘日志后记录的长度
+     */
+    qint64 journalSize = 0;
+
+    /**
+     * @brief 溢出后仍留在内存中的对象Run（公式等共享对象不写入日志）
+     */
+    QVector<Run> objects;
+};
+
+/**
+ * @class UndoStack
+ * @brief 撤销栈类
+ *
+ * 保存编辑步骤的增量而不是文档副本：每一步只记录段落区间中被删除和插入的片段，
+ * 撤销和重做的代价与该步修改的段落数成正比（段落数量不变时与文档长度无关）。
+ * 连续输入按单词合并：同一段落中紧接着上一次输入的位置继续输入时并入上一步，
+ * 上一步以空白结尾而本次以非空白开头时另起一步，因此每个单词连同其后的空格为一步；
+ * 公式中的连续输入同样合并，表达式树的替换追加到上一步。
+ * 各步骤的内存按片段长度和Run数估计，总量超过预算时把最旧的步骤（最近的若干步除外）
+ * 压缩后溢出到只追加的磁盘日志，内存中只留下记录的位置；超过大步骤阈值的步骤入栈时直接溢出。
+ * 撤销或重做溢出的步骤时从日志中映射读取，读取结果用完即丢弃，内存始终受预算约束。
+ * 日志不可用（如临时目录不可写）时退化为丢弃最旧的步骤。
+ */
+class UndoStack
+{
+public:
+    /**
+     * @brief 构造函数
+     * 创建一个空撤销栈
+     */
+    UndoStack();
+
+    /**
+     * @brief 压入一个步骤
+     * 丢弃所有可重做的步骤，把各处替换压缩为片段；能与栈顶合并的连续输入直接并入栈顶
+     * @param command 编辑步骤
+     */
+    void push(const EditCommand &command);
+
+    /**
+     * @brief 检查是否可以撤销
+     * @return 是否可以撤销
+     */
+    bool canUndo() const;
+
+    /**
+     * @brief 检查是否可以重做
+     * @return 是否可以重做
+     */
+    bool canRedo() const;
+
+    /**
+     * @brief 撤销一步
+     * @param document 文档
+     * @return 被撤销的步骤，无法撤销时返回nullptr（指针在下一次修改撤销栈前有效）
+     */
+    const EditCommand *undo(Document *document);
+
+    /**
+     * @brief 重做一步
+     * @param document 文档
+     * @return 被重做的步骤，无法重做时返回nullptr（指针在下一次修改撤销栈前有效）
+     */
+    const EditCommand *redo(Document *document);
+
+    /**
+     * @brief 禁止下一次输入与栈顶合并（光标移动、输入法提交等处调用）
+     */
+    void breakCoalescing();
+
+    /**
+     * @brief 获取步骤数（含可重做的步骤）
+     * @return 步骤数
+     */
+    int count() const;
+
+    /**
+     * @brief 获取当前位置（可撤销的步骤数）
+     * @return 当前位置
+     */
+    int index() const;
+
+    /**
+     * @brief 设置内存预算
+     * @param bytes 字节数
+     */
+    void setMemoryBudget(qint64 bytes);
+
+    /**
+     * @brief 获取内存预算
+     * @return 字节数
+     */
+    qint64 memoryBudget() const;
+
+    /**
+     * @brief 获取各步骤估计占用的内存
+     * @return 字节数
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief 获取磁盘日志的大小
+     * @return 字节数
+     */
+    qint64 journalSize() const;
+
+    /**
+     * @brief 清空撤销栈
+     */
+    void clear();
+
+    /**
+     * @brief 估计一个步骤占用的内存
+     * @param command 编辑步骤
+     * @return 字节数
+     */
+    static qint64 estimateCost(const EditCommand &command);
+
+    /**
+     * @brief 默认的内存预算（字节）
+     */
+    static const qint64 DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+    /**
+     * @brief 大步骤阈值（字节），超过的步骤入栈时直接溢出到磁盘日志
+     */
+    static const qint64 LARGE_STEP_COST = 8 * 1024 * 1024;
+
+    /**
+     * @brief 优先留在内存中的最近步骤数（大步骤或仅这些步骤就超出预算时同样溢出）
+     */
+    static const int RECENT_STEPS = 16;
+
+private:
+    /**
+     * @brief 去掉替换首尾未变化的部分，只留下被删除和插入的片段
+     * @param change 段落区间替换（before和after为完整段落）
+     */
+    static void compact(ParagraphChange *change);
+
+    /**
+     * @brief 在文档中应用一处替换：把from换成to，首尾未变化的部分取自文档当前的段落
+     * @param document 文档
+     * @param change 段落区间替换
+     * @param from 文档中当前的片段
+     * @param to 替换后的片段
+     */
+    static void apply(Document *document, const ParagraphChange &change,
+                      const QVector<Paragraph> &from, const QVector<Paragraph> &to);
+
+    /**
+     * @brief 尝试把连续输入并入栈顶
+     * @param command 编辑步骤
+     * @return 是否已合并
+     */
+    bool coalesce(const EditCommand &command);
+
+    /**
+     * @brief 按内存预算把步骤溢出到磁盘日志
+     * 先溢出最旧的步骤，仍超出预算时从最大的开始溢出最近的步骤；
+     * 只有日志不可用时才丢弃最旧的步骤（至少保留最新的一步）
+     */
+    void trim();
+
+    /**
+     * @brief 把一个步骤溢出到磁盘日志
+     * @param index 步骤序号
+     * @return 是否已溢出
+     */
+    bool spill(int index);
+
+    /**
+     * @brief 获取步骤的段落区间替换（溢出的步骤从日志读入）
+     * @param index 步骤序号
+     * @return 步骤，读取失败时返回nullptr
+     */
+    const EditCommand *load(int index);
+
+    /**
+     * @brief 编辑步骤
+     */
+    QVector<EditCommand> m_commands;
+
+    /**
+     * @brief 当前位置，之前的步骤可撤销，之后的可重做
+     */
+    int m_index;
+
+    /**
+     * @brief 内存预算
+     */
+    qint64 m_budget;
+
+    /**
+     * @brief 各步骤估计占用的内存
+     */
+    qint64 m_usage;
+
+    /**
+     * @brief 下一次输入是否可以与栈顶合并
+     */
+    bool m_coalescing;
+
+    /**
+     * @brief 磁盘日志
+     */
+    UndoJournal m_journal;
+
+    /**
+     * @brief 从日志读入的步骤（撤销或重做溢出的步骤时使用，下一次读入时覆盖）
+     */
+    EditCommand m_loaded;
+};
+
+#endif // UNDOSTACK_H
@@ -0,0 +1,113 @@
+// ============================================================================
+// BlinkClock.h
+// 光标闪烁时钟类的头文件
+// 全应用共享的闪烁时钟，统一驱动所有光标的闪烁
+// ============================================================================
+
+#ifndef BLINKCLOCK_H
+#define BLINKCLOCK_H
+
+#include <QObject>
+#include <QSet>
+
+class QTimer;
+
+/**
+ * @class BlinkClock
+ * @brief 光标闪烁时钟类
+ *
+ * 全应用共享一个定时器，所有正在闪烁的光标同步切换可见性。
+ * 没有正在闪烁的光标、或应用处于非活动状态时定时器停止，
+ * 空闲的编辑器不会产生周期性唤醒。
+ */
+class BlinkClock : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 获取全局闪烁时钟
+     * @return 闪烁时钟（以QCoreApplication为父对象）
+     */
+    static BlinkClock *instance();
+
+    /**
+     * @brief 注册一个正在闪烁的光标
+     * @param cursor 光标对象
+     */
+    void addCursor(const QObject *cursor);
+
+    /**
+     * @brief 注销一个光标
+     * @param cursor 光标对象
+     */
+    void removeCursor(const QObject *cursor);
+
+    /**
+     * @brief 重新开始一个周期（光标立即显示，例如输入或移动光标后）
+     */
+    void restart();
+
+    /**
+     * @brief 当前是否处于可见相位
+     * @return 是否可见
+     */
+    bool isVisiblePhase() const;
+
+signals:
+    /**
+     * @brief 闪烁相位变化信号
+     * @param visible 光标是否可见
+     */
+    void phaseChanged(bool visible);
+
+private slots:
+    /**
+     * @brief 定时器触发，切换相位
+     */
+    void onTimeout();
+
+    /**
+     * @brief 应用状态变化，非活动时暂停
+     * @param state 应用状态
+     */
+    void onApplicationStateChanged(Qt::ApplicationState state);
+
+private:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    BlinkClock(QObject *parent = nullptr);
+
+    /**
+     * @brief 根据光标数量和应用状态启动或停止定时器
+     */
+    void updateTimer();
+
+    /**
+     * @brief 共享定时器
+     */
+    QTimer *m_timer;
+
+    /**
+     * @brief 正在闪烁的光标
+     */
+    QSet<const QObject *> m_cursors;
+
+    /**
+     * @brief 当前相位是否可见
+     */
+    bool m_visiblePhase;
+
+    /**
+     * @brief 应用是否处于活动状态
+     */
+    bool m_applicationActive;
+
+    /**
+     * @brief 默认闪烁间隔（毫秒），系统未提供光标闪烁时间时使用
+     */
+    static const int DEFAULT_INTERVAL = 500;
+};
+
+#endif // BLINKCLOCK_H
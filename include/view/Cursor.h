@@ -9,7 +9,6 @@
 
 #include "core/Selection.h"
 #include <QGraphicsItem>
-#include <QTimer>
 #include <QObject>
 #include <QRectF>
 #include <QPainter>
@@ -20,6 +19,8 @@
  * 
  * 表示文档中的光标，负责显示和管理光标状态。
  * 继承自QObject和QGraphicsItem，支持闪烁功能。
+ * 闪烁由全应用共享的BlinkClock驱动，光标几何在构造时计算一次并缓存，
+ * 每次闪烁只重绘光标自身对齐到像素的矩形。
  */
 class Cursor : public QObject, public QGraphicsItem
 {
@@ -31,6 +32,12 @@ public:
      * @param graphicsParent 图形父对象
      */
     Cursor(QObject *parent = nullptr, QGraphicsItem *graphicsParent = nullptr);
+
+    /**
+     * @brief 析构函数
+     * 从闪烁时钟注销
+     */
+    ~Cursor();
     
     /**
      * @brief 设置光标位置
@@ -43,6 +50,12 @@ public:
      * @return 光标位置
      */
     Selection::Position position() const;
+
+    /**
+     * @brief 设置光标在场景中的坐标（对齐到整像素）
+     * @param point 场景坐标
+     */
+    void setAlignedPos(const QPointF &point);
     
     /**
      * @brief 显示光标
@@ -69,6 +82,13 @@ public:
      * @brief 停止闪烁
      */
     void stopBlinking();
+
+    /**
+     * @brief 暂停或恢复光标（视图失去焦点或被隐藏时暂停）
+     * 暂停期间光标不显示，也不参与闪烁时钟
+     * @param suspended 是否暂停
+     */
+    void setSuspended(bool suspended);
     
     /**
      * @brief 获取光标边界
@@ -86,9 +106,10 @@ public:
     
 private slots:
     /**
-     * @brief 切换光标可见性（用于闪烁）
+     * @brief 闪烁相位变化
+     * @param visible 是否可见
      */
-    void toggleVisibility();
+    void onBlinkPhaseChanged(bool visible);
     
 private:
     /**
@@ -102,14 +123,25 @@ private:
     bool m_visible;
     
     /**
-     * @brief 闪烁定时器
+     * @brief 是否处于闪烁状态
      */
-    QTimer *m_blinkTimer;
-    
+    bool m_blinking;
+
+    /**
+     * @brief 是否已暂停
+     */
+    bool m_suspended;
+
+    /**
+     * @brief 缓存的光标高度（整像素）
+     */
+    qreal m_height;
+
     /**
-     * @brief 闪烁间隔（毫秒）
+     * @brief 设置可见性，仅在变化时重绘
+     * @param visible 是否可见
      */
-    static const int BLINK_INTERVAL = 500; // 闪烁间隔（毫秒）
+    void setCaretVisible(bool visible);
 };
 
 #endif // CURSOR_H
@@ -10,14 +10,32 @@
 #include "core/Document.h"
 #include "core/Selection.h"
 #include "view/Cursor.h"
+#include "view/TextLayoutEngine.h"
+#include "view/LayoutScheduler.h"
+#include "view/TileCache.h"
+#include "view/FormulaLayoutCache.h"
+#include "view/MathLayoutEngine.h"
+#include "view/ParagraphTops.h"
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QMouseEvent>
 #include <QKeyEvent>
+#include <QResizeEvent>
 #include <QPoint>
 #include <QVariant>
-#include <QGraphicsTextItem>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QInputMethodEvent>
 #include <QPointF>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+
+class ParagraphItem;
+class SelectionItem;
+class PreeditItem;
+class TileRenderer;
+class PlotSampler;
 
 /**
  * @class DocumentView
@@ -68,10 +86,39 @@ public:
     
     /**
      * @brief 更新布局
-     * 重新计算文档的布局
+     * 立即执行挂起的布局（通常由布局调度器在事件循环空闲时调用）
      */
     void updateLayout();
     
+    /**
+     * @brief 调度布局
+     * 标记需要重新排版的段落，布局在下一个事件循环周期中合并执行
+     * @param first 第一个段落索引
+     * @param last 最后一个段落索引，-1表示到文档末尾
+     */
+    void scheduleLayout(int first = 0, int last = -1);
+    
+    /**
+     * @brief 应用段落范围变化
+     * 同步段落图形项并标记受影响的段落，布局延迟到下一个事件循环周期
+     * @param first 变化的起始段落
+     * @param removed 被替换的段落数
+     * @param inserted 替换后的段落数
+     */
+    void applyParagraphChange(int first, int removed, int inserted);
+
+    /**
+     * @brief 按顺序应用一次编辑中的全部段落范围变化
+     * @param changes 段落区间替换（每一处以前面各处替换之后的段落索引表示）
+     */
+    void applyParagraphChanges(const QVector<ParagraphSplice> &changes);
+    
+    /**
+     * @brief 获取布局调度器
+     * @return 布局调度器
+     */
+    LayoutScheduler *layoutScheduler() const;
+    
     /**
      * @brief 确保光标可见
      * 调整视图以确保光标在可见区域内
@@ -88,14 +135,41 @@ public:
     /**
      * @brief 显示组合文本
      * @param text 组合文本
+     * @param attributes 输入法属性（文本格式、预编辑光标等）
      */
-    void showComposingText(const QString &text);
+    void showComposingText(const QString &text,
+                           const QList<QInputMethodEvent::Attribute> &attributes = QList<QInputMethodEvent::Attribute>());
     
     /**
      * @brief 隐藏组合文本
      */
     void hideComposingText();
 
+    /**
+     * @brief 启用或禁用瓦片缓存
+     * 启用时文档文本光栅化到瓦片中，在前景层贴图；禁用时由段落图形项直接绘制
+     * @param enabled 是否启用
+     */
+    void setTileCacheEnabled(bool enabled);
+
+    /**
+     * @brief 检查瓦片缓存是否启用
+     * @return 是否启用
+     */
+    bool isTileCacheEnabled() const;
+
+    /**
+     * @brief 获取瓦片缓存（用于设置字节预算和查看命中统计）
+     * @return 瓦片缓存
+     */
+    TileCache *tileCache() const;
+
+    /**
+     * @brief 获取数学排版引擎（用于设置公式格式和查看增量排版统计）
+     * @return 数学排版引擎
+     */
+    MathLayoutEngine *mathLayoutEngine() const;
+
 signals:
     /**
      * @brief 鼠标位置变化信号
@@ -141,6 +215,30 @@ protected:
      * @return 查询结果
      */
     QVariant inputMethodQuery(Qt::InputMethodQuery query) const override;
+
+    /**
+     * @brief 滚动内容
+     * 取消已滚出视口的瓦片请求
+     * @param dx 水平滚动量
+     * @param dy 垂直滚动量
+     */
+    void scrollContentsBy(int dx, int dy) override;
+
+    /**
+     * @brief 视口大小变化
+     * 放置新进入视口附近的段落项
+     * @param event 大小变化事件
+     */
+    void resizeEvent(QResizeEvent *event) override;
+
+    /**
+     * @brief 绘制前景
+     * 启用瓦片缓存时，在此贴出与暴露区域相交的瓦片；因编辑失效的瓦片同步重绘，
+     * 新露出的瓦片交给后台线程绘制，完成前显示占位
+     * @param painter 画笔
+     * @param rect 暴露区域（场景坐标）
+     */
+    void drawForeground(QPainter *painter, const QRectF &rect) override;
     
 public:
     /**
@@ -156,8 +254,147 @@ public:
      * @return 点坐标
      */
     QPointF pointFromPosition(const Selection::Position &position) const;
+    
+    /**
+     * @brief 获取段落所在行的矩形（场景坐标）
+     * @param paragraph 段落索引
+     * @return 行矩形，宽度为段落文本宽度
+     */
+    QRectF paragraphRect(int paragraph) const;
+    
+    /**
+     * @brief 获取场景Y坐标所在的段落
+     * @param y 场景Y坐标
+     * @return 段落索引（已限制在有效范围内）
+     */
+    int paragraphAt(qreal y) const;
+
+private slots:
+    /**
+     * @brief 提交一批后台排版结果
+     * @param first 第一个段落的索引
+     * @param layouts 排版结果
+     */
+    void onLayoutsReady(int first, const QVector<ParagraphLayout> &layouts);
+
+    /**
+     * @brief 合成一个后台光栅化完成的瓦片
+     * @param tile 瓦片坐标
+     * @param image 瓦片图像
+     */
+    void onTileReady(const QPoint &tile, const QImage &image);
 
 private:
+    /**
+     * @brief 根据文档范围更新场景矩形
+     * 文档范围由最大行宽和段落顶部偏移索引得到，代价为O(log n)，与场景中的图形项数量无关
+     */
+    void updateSceneRect();
+
+    /**
+     * @brief 指定段落之后的内容整体移动后调用：作废其下方的瓦片并重新放置视口附近的段落项
+     * 偏移由段落顶部偏移索引给出，不逐段计算，也不移动视口附近以外的段落项
+     * @param from 第一个移动的段落
+     */
+    void repositionParagraphs(int from);
+
+    /**
+     * @brief 按段落顶部偏移索引放置视口及其上下各一屏内的段落项，其余段落项隐藏
+     * 代价只与视口附近的段落数有关；段落项在进入这一范围时才被移动到正确的位置
+     */
+    void placeParagraphItems();
+
+    /**
+     * @brief 获取段落顶部相对内容顶部的偏移
+     * 尚无段落项的段落按默认行高外推
+     * @param paragraph 段落索引
+     * @return 偏移
+     */
+    qreal paragraphTop(int paragraph) const;
+
+    /**
+     * @brief 获取段落所占的高度（不小于默认行高）
+     * @param paragraph 段落索引
+     * @return 高度
+     */
+    qreal paragraphHeight(int paragraph) const;
+    
+    /**
+     * @brief 记录一个段落宽度
+     * @param width 段落宽度
+     */
+    void trackParagraphWidth(qreal width);
+    
+    /**
+     * @brief 移除一个段落宽度的记录
+     * @param width 段落宽度
+     */
+    void untrackParagraphWidth(qreal width);
+    
+    /**
+     * @brief 获取已提交且未过期的段落排版结果
+     * @param paragraph 段落索引
+     * @return 排版结果，不可用时返回nullptr
+     */
+    const ParagraphLayout *committedLayout(int paragraph) const;
+
+    /**
+     * @brief 重绘可见区域中的公式编号和交叉引用
+     * 编号索引的修订号变化时调用；编号位数变化导致预留宽度改变时改为整篇重新排版
+     */
+    void updateEquationNumbers();
+
+    /**
+     * @brief 获取为编号（含括号）预留的宽度
+     * @return 宽度
+     */
+    qreal numberWidth() const;
+
+    /**
+     * @brief 设置为编号预留的位数，并重新计算预留宽度
+     * @param digits 位数
+     */
+    void setNumberDigits(int digits);
+    
+    /**
+     * @brief 为指定范围的段落分配新的内容戳，使其等待重新排版
+     * @param first 第一个段落索引
+     * @param last 最后一个段落索引
+     */
+    void invalidateParagraphs(int first, int last);
+    
+    /**
+     * @brief 创建段落图形项并加入场景
+     * @return 新的段落图形项
+     */
+    ParagraphItem *createParagraphItem();
+    
+    /**
+     * @brief 从场景中移除并销毁段落图形项
+     * @param item 段落图形项
+     */
+    void destroyParagraphItem(ParagraphItem *item);
+
+    /**
+     * @brief 作废段落图形项所覆盖的瓦片并请求重绘
+     * 范围由段落顶部偏移索引给出，段落项本身不必已放置
+     * @param paragraph 段落索引
+     */
+    void invalidateTiles(int paragraph);
+
+    /**
+     * @brief 作废与矩形重叠的瓦片并请求重绘
+     * 组合文本所在的段落位于光标处，其段落项已放置，直接使用其场景矩形
+     * @param rect 场景矩形
+     */
+    void invalidateTiles(const QRectF &rect);
+
+    /**
+     * @brief 收集与矩形相交的段落快照，用于光栅化瓦片
+     * @param rect 场景矩形
+     * @return 段落快照
+     */
+    QVector<TileParagraph> tileParagraphs(const QRectF &rect) const;
     
     /**
      * @brief 更新输入法
@@ -166,10 +403,13 @@ private:
     
     /**
      * @brief 绘制组合文本
+     * 在光标处内联显示：光标所在段落项裁剪到光标处，其后文本与组合文本一起由预编辑层重排
      * @param text 组合文本
+     * @param attributes 输入法属性
      * @param position 位置
      */
-    void drawComposingText(const QString &text, const Selection::Position &position);
+    void drawComposingText(const QString &text, const QList<QInputMethodEvent::Attribute> &attributes,
+                           const Selection::Position &position);
     
     /**
      * @brief 清除组合文本
@@ -187,6 +427,82 @@ private:
      */
     Document *m_document;
     
+    /**
+     * @brief 后台排版引擎
+     */
+    TextLayoutEngine *m_layoutEngine;
+    
+    /**
+     * @brief 布局调度器
+     */
+    LayoutScheduler *m_layoutScheduler;
+    
+    /**
+     * @brief 段落图形项（与文档段落一一对应）
+     */
+    QVector<ParagraphItem *> m_paragraphItems;
+    
+    /**
+     * @brief 等待排版结果的段落项（按内容戳索引，不受段落索引变化影响）
+     */
+    QHash<quint64, ParagraphItem *> m_pendingItems;
+    
+    /**
+     * @brief 下一个可用的内容戳
+     */
+    quint64 m_nextStamp;
+    
+    /**
+     * @brief 需要重新定位的第一个段落（-1表示无）
+     */
+    int m_positionsDirtyFrom;
+
+    /**
+     * @brief 段落顶部偏移索引（与段落项一一对应，保存各段落的高度）
+     * 段落高度随其中最高的内联对象变化，定位、点击测试和可见范围都在此索引上以O(log n)查询
+     */
+    ParagraphTops m_paragraphTops;
+
+    /**
+     * @brief 已放置的段落项（视口及其上下各一屏内，可见且位于正确的位置）
+     */
+    QVector<ParagraphItem *> m_placedItems;
+    
+    /**
+     * @brief 段落宽度计数（有序，最后一个键即为最大行宽）
+     */
+    QMap<qreal, int> m_paragraphWidths;
+    
+    /**
+     * @brief 文本瓦片缓存
+     */
+    TileCache *m_tileCache;
+
+    /**
+     * @brief 后台瓦片渲染器
+     */
+    TileRenderer *m_tileRenderer;
+
+    /**
+     * @brief 是否启用瓦片缓存
+     */
+    bool m_tileCacheEnabled;
+
+    /**
+     * @brief 公式排版缓存（结构相同的子树共享排版结果）
+     */
+    FormulaLayoutCache *m_formulaLayoutCache;
+
+    /**
+     * @brief 数学排版引擎
+     */
+    MathLayoutEngine *m_mathLayoutEngine;
+
+    /**
+     * @brief 等待排版结果的段落中的公式（按内容戳索引，提交时放入段落项）
+     */
+    QHash<quint64, QVector<QSharedPointer<MathObject>>> m_pendingFormulas;
+
     /**
      * @brief 当前选择
      */
@@ -197,6 +513,11 @@ private:
      */
     Cursor *m_cursor;
     
+    /**
+     * @brief 选择高亮覆盖层
+     */
+    SelectionItem *m_selectionItem;
+    
     /**
      * @brief 是否正在选择
      */
@@ -208,14 +529,54 @@ private:
     Selection::Position m_selectionStart;
     
     /**
-     * @brief 组合文本项
+     * @brief 预编辑层（常驻场景，组合期间显示）
+     */
+    PreeditItem *m_preeditItem;
+    
+    /**
+     * @brief 组合期间被裁剪的段落项
      */
-    QGraphicsTextItem *m_composingTextItem;
+    ParagraphItem *m_preeditParagraphItem;
     
     /**
-     * @brief 当前组合文本
+     * @brief 组合开始时的位置（光标之后的段落文本只在位置变化时重新获取）
+     */
+    Selection::Position m_preeditPosition;
+    
+    /**
+     * @brief 光标所在段落中光标之后的文本
+     */
+    QString m_preeditTail;
+
+    /**
+     * @brief 已绘制的公式编号修订号（与文档的编号索引不同时需要重绘可见编号）
+     */
+    quint64 m_equationRevision;
+
+    /**
+     * @brief 为编号预留的位数
+     */
+    int m_numberDigits;
+
+    /**
+     * @brief 函数图像采样器
+     */
+    PlotSampler *m_plotSampler;
+
+    /**
+     * @brief 正文字体（排版、默认行高、光标和输入法共用，只创建一次）
+     */
+    QFont m_textFont;
+
+    /**
+     * @brief 正文字体的度量（定位、点击测试等热路径上直接使用）
+     */
+    QFontMetricsF m_textMetrics;
+
+    /**
+     * @brief 为编号预留的宽度（位数变化时重新计算）
      */
-    QString m_currentComposingText;
+    qreal m_numberWidth;
 };
 
 #endif // DOCUMENTVIEW_H
@@ -0,0 +1,134 @@
+// ============================================================================
+// FormulaItem.h
+// 公式图形项类的头文件
+// 在段落中绘制一个已排版的内联公式
+// ============================================================================
+
+#ifndef FORMULAITEM_H
+#define FORMULAITEM_H
+
+#include "core/MathObject.h"
+#include "view/FormulaLayoutCache.h"
+#include <QGraphicsItem>
+#include <QSharedPointer>
+#include <QRectF>
+#include <QFont>
+#include <QPainter>
+
+class MathLayoutEngine;
+class EquationIndex;
+
+/**
+ * @class FormulaItem
+ * @brief 公式图形项类
+ *
+ * 作为段落图形项的子项，原点位于公式基线的左端。
+ * 公式由数学排版引擎排版，绘制时回放缓存的显示列表，不再遍历表达式树。
+ * 带编号的公式在预留宽度的右端绘制编号，编号在绘制时从公式编号索引中查询。
+ */
+class FormulaItem : public QGraphicsItem
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param formula 公式对象
+     * @param engine 数学排版引擎
+     * @param parent 图形父项
+     */
+    FormulaItem(const QSharedPointer<MathObject> &formula, MathLayoutEngine *engine,
+                QGraphicsItem *parent = nullptr);
+
+    /**
+     * @brief 获取公式对象
+     * @return 公式对象
+     */
+    QSharedPointer<MathObject> formula() const;
+
+    /**
+     * @brief 重新排版公式并更新几何尺寸
+     */
+    void updateGeometry();
+
+    /**
+     * @brief 设置编号的绘制方式
+     * @param index 公式编号索引，为nullptr时不绘制编号
+     * @param handle 所在段落在索引中的句柄
+     * @param slot 公式在段落的带编号公式中的序号（同一公式对象可能出现在多个段落中，编号按位置查询）
+     * @param font 编号字体
+     * @param width 段落为公式及其编号预留的总宽度
+     */
+    void setNumbering(const EquationIndex *index, int handle, int slot, const QFont &font, qreal width);
+
+    /**
+     * @brief 检查是否绘制编号
+     * @return 是否绘制编号
+     */
+    bool isNumbered() const;
+
+    /**
+     * @brief 获取边界矩形
+     * @return 边界矩形
+     */
+    QRectF boundingRect() const override;
+
+    /**
+     * @brief 绘制公式
+     * @param painter 画笔
+     * @param option 样式选项
+     * @param widget 部件
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    /**
+     * @brief 公式对象
+     */
+    QSharedPointer<MathObject> m_formula;
+
+    /**
+     * @brief 数学排版引擎
+     */
+    MathLayoutEngine *m_engine;
+
+    /**
+     * @brief 显示列表（与哈希相同的公式共享）
+     */
+    QSharedPointer<const FormulaDisplayList> m_displayList;
+
+    /**
+     * @brief 边界矩形（含编号）
+     */
+    QRectF m_bounds;
+
+    /**
+     * @brief 公式本身的边界矩形
+     */
+    QRectF m_formulaBounds;
+
+    /**
+     * @brief 公式编号索引
+     */
+    const EquationIndex *m_index;
+
+    /**
+     * @brief 所在段落在索引中的句柄
+     */
+    int m_handle;
+
+    /**
+     * @brief 公式在段落的带编号公式中的序号
+     */
+    int m_slot;
+
+    /**
+     * @brief 编号字体
+     */
+    QFont m_numberFont;
+
+    /**
+     * @brief 预留的总宽度
+     */
+    qreal m_width;
+};
+
+#endif // FORMULAITEM_H
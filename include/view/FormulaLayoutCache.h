@@ -0,0 +1,360 @@
+// ============================================================================
+// FormulaLayoutCache.h
+// 公式排版缓存类的头文件
+// 按（子树结构哈希, 格式, DPI）缓存公式排版结果，按内存预算LRU淘汰
+// ============================================================================
+
+#ifndef FORMULALAYOUTCACHE_H
+#define FORMULALAYOUTCACHE_H
+
+#include "core/MathNode.h"
+#include "core/Format.h"
+#include "view/MatrixGrid.h"
+#include <QObject>
+#include <QCache>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <QHash>
+#include <QList>
+#include <QGlyphRun>
+#include <QPainterPath>
+#include <QColor>
+
+class QPainter;
+
+/**
+ * @struct FormulaGlyph
+ * @brief 公式中一个已定位的字形
+ */
+struct FormulaGlyph
+{
+    /**
+     * @brief 字形文本
+     */
+    QString text;
+
+    /**
+     * @brief 字形索引（文本为空时按索引绘制，用于MATH表中的变体和拼装部件）
+     */
+    quint32 glyph = 0;
+
+    /**
+     * @brief 基线原点位置（相对于所属节点的原点）
+     */
+    QPointF position;
+
+    /**
+     * @brief 脚本层级（0为正文，1为角标，2为二级角标），决定字号
+     */
+    int level = 0;
+
+    /**
+     * @brief 以基线为基准的垂直拉伸比例（伸缩定界符、根号），1表示不拉伸
+     */
+    qreal stretch = 1;
+};
+
+/**
+ * @struct FormulaLayout
+ * @brief 一个公式节点的排版结果
+ *
+ * 包含节点的盒子度量、各子节点原点的偏移，以及节点自身绘制的字形和横线
+ * （分数线、根号上横线等）。子节点的内容由子节点自己的排版结果描述。
+ * 排版结果一经生成便不再修改，可以在结构相同的子树之间共享。
+ */
+struct FormulaLayout
+{
+    /**
+     * @brief 盒子度量
+     */
+    MathBox box;
+
+    /**
+     * @brief 子节点原点相对于本节点原点的偏移（基线坐标，Y轴向下）
+     */
+    QVector<QPointF> childOffsets;
+
+    /**
+     * @brief 组合时使用的子节点盒子，子节点重新排版后盒子不变则无需重新组合
+     */
+    QVector<MathBox> childBoxes;
+
+    /**
+     * @brief 排版时的脚本层级
+     */
+    int level = 0;
+
+    /**
+     * @brief 排版上下文（格式与DPI的组合），上下文变化后结果失效
+     */
+    quint64 context = 0;
+
+    /**
+     * @brief 节点自身的字形
+     */
+    QVector<FormulaGlyph> glyphs;
+
+    /**
+     * @brief 节点自身的横线矩形
+     */
+    QVector<QRectF> rules;
+
+    /**
+     * @brief 矩阵网格（仅矩阵节点）
+     * 矩阵不生成childOffsets和childBoxes，单元格偏移由网格按需计算；
+     * 网格属于节点自身并在编辑时原地更新，因此矩阵排版结果不进入共享缓存
+     */
+    QSharedPointer<MatrixGrid> grid;
+
+    /**
+     * @brief 获取子节点原点的偏移
+     * @param index 子节点索引
+     * @return 偏移
+     */
+    QPointF childOffset(int index) const;
+
+    /**
+     * @brief 估算占用的内存字节数（用作缓存代价）
+     * @return 字节数
+     */
+    int memoryCost() const;
+};
+
+/**
+ * @struct FormulaDisplayList
+ * @brief 公式的显示列表
+ *
+ * 整个公式展开后的绘制指令：同一字号的字形合并为一个字形序列，拉伸的字形转换为轮廓，
+ * 再加上横线矩形。绘制时直接回放，不再遍历表达式树，也不再逐字形调用drawText。
+ */
+struct FormulaDisplayList
+{
+    /**
+     * @brief 字形序列（每个字号一个，坐标相对于公式基线原点）
+     */
+    QList<QGlyphRun> glyphRuns;
+
+    /**
+     * @brief 拉伸字形的轮廓
+     */
+    QPainterPath path;
+
+    /**
+     * @brief 横线（分数线、根号横线、占位框）
+     */
+    QVector<QRectF> rules;
+
+    /**
+     * @brief 绘制颜色
+     */
+    QColor color;
+
+    /**
+     * @brief 回放显示列表
+     * @param painter 画笔
+     * @param origin 公式基线原点
+     */
+    void paint(QPainter *painter, const QPointF &origin) const;
+
+    /**
+     * @brief 估算占用的内存字节数（用作缓存代价）
+     * @return 字节数
+     */
+    int memoryCost() const;
+};
+
+/**
+ * @struct FormulaLayoutKey
+ * @brief 公式排版缓存键
+ */
+struct FormulaLayoutKey
+{
+    /**
+     * @brief 子树结构哈希
+     */
+    quint64 hash = 0;
+
+    /**
+     * @brief 格式键（字体和颜色）
+     */
+    QString formatKey;
+
+    /**
+     * @brief 设备DPI
+     */
+    int dpi = 0;
+
+    /**
+     * @brief 脚本层级
+     */
+    int level = 0;
+
+    /**
+     * @brief 比较两个键是否相等
+     * @param other 另一个键
+     * @return 是否相等
+     */
+    bool operator==(const FormulaLayoutKey &other) const {
+        return hash == other.hash && dpi == other.dpi && level == other.level && formatKey == other.formatKey;
+    }
+};
+
+/**
+ * @brief 计算公式排版缓存键的哈希值
+ * @param key 缓存键
+ * @param seed 种子
+ * @return 哈希值
+ */
+inline size_t qHash(const FormulaLayoutKey &key, size_t seed = 0)
+{
+    return qHash(key.hash, seed) ^ qHash(key.formatKey, seed) ^ (size_t(key.dpi) << 4) ^ size_t(key.level);
+}
+
+/**
+ * @class FormulaLayoutCache
+ * @brief 公式排版缓存类
+ *
+ * 键中包含子树的结构哈希，子树一旦修改其哈希随之改变，旧条目自然不再命中，
+ * 最终被LRU淘汰，无需显式作废。结构相同的子树（如重复出现的公式）共享同一排版结果。
+ * 缓存按估算的内存占用限制总量，并统计命中、未命中和淘汰次数。
+ * 整个公式的显示列表也按同样的键缓存，哈希相同的公式共享同一显示列表。
+ */
+class FormulaLayoutCache : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    FormulaLayoutCache(QObject *parent = nullptr);
+
+    /**
+     * @brief 生成格式键
+     * @param format 格式
+     * @return 格式键
+     */
+    static QString formatKey(const Format &format);
+
+    /**
+     * @brief 查找排版结果
+     * @param key 缓存键
+     * @return 排版结果，未命中时返回空指针
+     */
+    QSharedPointer<const FormulaLayout> find(const FormulaLayoutKey &key);
+
+    /**
+     * @brief 缓存排版结果
+     * @param key 缓存键
+     * @param layout 排版结果
+     */
+    void insert(const FormulaLayoutKey &key, const QSharedPointer<const FormulaLayout> &layout);
+
+    /**
+     * @brief 查找显示列表
+     * @param key 缓存键（根节点的结构哈希）
+     * @return 显示列表，未命中时返回空指针
+     */
+    QSharedPointer<const FormulaDisplayList> findDisplayList(const FormulaLayoutKey &key);
+
+    /**
+     * @brief 缓存显示列表
+     * @param key 缓存键
+     * @param displayList 显示列表
+     */
+    void insertDisplayList(const FormulaLayoutKey &key, const QSharedPointer<const FormulaDisplayList> &displayList);
+
+    /**
+     * @brief 设置内存预算（排版结果和显示列表各自使用该预算）
+     * @param bytes 最大字节数
+     */
+    void setByteBudget(int bytes);
+
+    /**
+     * @brief 获取内存预算
+     * @return 最大字节数
+     */
+    int byteBudget() const;
+
+    /**
+     * @brief 获取当前占用的字节数
+     * @return 字节数
+     */
+    int byteCount() const;
+
+    /**
+     * @brief 获取缓存条目数
+     * @return 条目数
+     */
+    int count() const;
+
+    /**
+     * @brief 清空缓存（统计计数保留）
+     */
+    void clear();
+
+    /**
+     * @brief 获取命中次数
+     * @return 命中次数
+     */
+    int hitCount() const;
+
+    /**
+     * @brief 获取未命中次数
+     * @return 未命中次数
+     */
+    int missCount() const;
+
+    /**
+     * @brief 获取淘汰次数
+     * @return 淘汰次数
+     */
+    int evictionCount() const;
+
+    /**
+     * @brief 获取命中率
+     * @return 命中率（0到1，没有查询时为0）
+     */
+    qreal hitRate() const;
+
+    /**
+     * @brief 重置统计计数
+     */
+    void resetStatistics();
+
+private:
+    /**
+     * @brief 排版结果缓存
+     */
+    QCache<FormulaLayoutKey, QSharedPointer<const FormulaLayout>> m_layouts;
+
+    /**
+     * @brief 显示列表缓存
+     */
+    QCache<FormulaLayoutKey, QSharedPointer<const FormulaDisplayList>> m_displayLists;
+
+    /**
+     * @brief 命中次数
+     */
+    int m_hits;
+
+    /**
+     * @brief 未命中次数
+     */
+    int m_misses;
+
+    /**
+     * @brief 淘汰次数
+     */
+    int m_evictions;
+
+    /**
+     * @brief 默认内存预算（8MB）
+     */
+    static const int DEFAULT_BYTE_BUDGET = 8 * 1024 * 1024;
+};
+
+#endif // FORMULALAYOUTCACHE_H
@@ -0,0 +1,145 @@
+// ============================================================================
+// LayoutScheduler.h
+// 布局调度器类的头文件
+// 合并同一事件循环周期内的布局请求，每个周期最多执行一次布局
+// ============================================================================
+
+#ifndef LAYOUTSCHEDULER_H
+#define LAYOUTSCHEDULER_H
+
+#include <QObject>
+
+class QTimer;
+
+/**
+ * @class LayoutScheduler
+ * @brief 布局调度器类
+ *
+ * 记录需要重新排版的段落范围（脏范围），并通过零间隔定时器在下一次
+ * 事件循环空闲时发出一次layoutRequested信号。同一周期内的多次标记
+ * （例如一次按键引起的多次documentChanged）被合并为一次布局。
+ * 同时统计布局次数，便于检查每个输入事件触发的布局次数不超过一次。
+ */
+class LayoutScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    LayoutScheduler(QObject *parent = nullptr);
+
+    /**
+     * @brief 标记脏范围并调度一次布局
+     * @param first 第一个脏段落索引
+     * @param last 最后一个脏段落索引；last < first 表示没有需要整形的段落，只调度布局
+     */
+    void markDirty(int first, int last);
+
+    /**
+     * @brief 在段落增删后修正挂起的脏范围
+     * @param first 变化的起始段落
+     * @param removed 删除的段落数
+     * @param inserted 插入的段落数
+     */
+    void adjustForSplice(int first, int removed, int inserted);
+
+    /**
+     * @brief 检查是否有挂起的布局
+     * @return 是否有挂起的布局
+     */
+    bool hasPendingLayout() const;
+
+    /**
+     * @brief 取出挂起的脏范围（由执行布局的一方调用，计为一次布局）
+     * @param first 输出：第一个脏段落索引
+     * @param last 输出：最后一个脏段落索引，last < first 表示没有需要整形的段落
+     * @return 是否有挂起的布局
+     */
+    bool takeDirtyRange(int *first, int *last);
+
+    /**
+     * @brief 立即执行挂起的布局（不等待下一个事件循环周期）
+     */
+    void flush();
+
+    /**
+     * @brief 标记一个输入事件的开始，用于统计每个输入事件的布局次数
+     */
+    void beginInputEvent();
+
+    /**
+     * @brief 获取布局总次数
+     * @return 布局总次数
+     */
+    int layoutPassCount() const;
+
+    /**
+     * @brief 获取当前（最近一个）输入事件触发的布局次数
+     * @return 布局次数
+     */
+    int passesForCurrentInputEvent() const;
+
+    /**
+     * @brief 获取单个输入事件触发的最大布局次数
+     * @return 最大布局次数
+     */
+    int maxPassesPerInputEvent() const;
+
+signals:
+    /**
+     * @brief 请求执行布局的信号
+     * 每个事件循环周期最多发出一次
+     */
+    void layoutRequested();
+
+private slots:
+    /**
+     * @brief 定时器触发，请求执行布局
+     */
+    void onTimeout();
+
+private:
+    /**
+     * @brief 零间隔单次定时器
+     */
+    QTimer *m_timer;
+
+    /**
+     * @brief 是否有挂起的布局
+     */
+    bool m_pending;
+
+    /**
+     * @brief 是否有需要整形的脏范围
+     */
+    bool m_hasDirtyRange;
+
+    /**
+     * @brief 脏范围起点
+     */
+    int m_dirtyFirst;
+
+    /**
+     * @brief 脏范围终点
+     */
+    int m_dirtyLast;
+
+    /**
+     * @brief 布局总次数
+     */
+    int m_passCount;
+
+    /**
+     * @brief 当前输入事件的布局次数
+     */
+    int m_passesForInputEvent;
+
+    /**
+     * @brief 单个输入事件的最大布局次数
+     */
+    int m_maxPassesPerInputEvent;
+};
+
+#endif // LAYOUTSCHEDULER_H
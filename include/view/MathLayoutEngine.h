@@ -0,0 +1,327 @@
+// ============================================================================
+// MathLayoutEngine.h
+// 数学排版引擎类的头文件
+// TeX风格的盒子排版：分式、上下标、根式、矩阵和伸缩定界符，按节点增量排版
+// ============================================================================
+
+#ifndef MATHLAYOUTENGINE_H
+#define MATHLAYOUTENGINE_H
+
+#include "core/MathNode.h"
+#include "core/MathObject.h"
+#include "core/MathPosition.h"
+#include "core/Format.h"
+#include "view/FormulaLayoutCache.h"
+#include "view/MathTable.h"
+#include <QObject>
+#include <QFont>
+#include <QRawFont>
+#include <QSharedPointer>
+#include <QRectF>
+
+/**
+ * @struct MathConstants
+ * @brief 数学排版参数
+ *
+ * 以当前层级字体的尺寸表示的排版参数。字体带有MATH表时取自表中的常量，
+ * 否则按字体度量估算（取值参考TeX的默认参数）。
+ */
+struct MathConstants
+{
+    qreal em = 0;                  ///< 字号（1em）
+    qreal xHeight = 0;             ///< x字高
+    qreal axisHeight = 0;          ///< 数学轴高度（分数线、定界符的中心）
+    qreal ruleThickness = 0;       ///< 横线粗细
+    qreal fractionGap = 0;         ///< 分子分母与分数线的最小间距
+    qreal superscriptShiftUp = 0;  ///< 上标最小上移量
+    qreal subscriptShiftDown = 0;  ///< 下标最小下移量
+    qreal superscriptDrop = 0;     ///< 上标基线相对基础顶部的最大下落量
+    qreal subscriptDrop = 0;       ///< 下标基线相对基础底部的最小下落量
+    qreal superscriptBottomMin = 0; ///< 上标底部的最低高度
+    qreal subscriptTopMax = 0;     ///< 下标顶部的最高高度
+    qreal subSuperscriptGap = 0;   ///< 上下标之间的最小间隙
+    qreal scriptSpace = 0;         ///< 角标后的间距
+    qreal radicalGap = 0;          ///< 被开方数与根号横线的间距
+    qreal delimiterShortfall = 0;  ///< 定界符允许比内容矮的最大量
+    qreal columnGap = 0;           ///< 矩阵列间距
+    qreal rowGap = 0;              ///< 矩阵行间距
+};
+
+/**
+ * @class MathLayoutEngine
+ * @brief 数学排版引擎类
+ *
+ * 每个节点缓存自己的排版结果和盒子。节点被修改时只有它和它的祖先被标记为过期，
+ * 排版时未过期的子树直接返回缓存结果，因此编辑公式内部只需重新访问一条祖先链。
+ * 祖先节点在子节点重新排版后，如果所有子节点的盒子都没有变化且自身内容未变，
+ * 就沿用原来的排版结果，不再重新组合。重新组合前还会按结构哈希查询共享的
+ * 排版缓存，结构相同的子树共享同一排版结果。
+ * 矩阵的单元格盒子保存在MatrixGrid中，编辑一个单元格只更新该单元格（O(log n)）。
+ */
+class MathLayoutEngine : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 构造函数
+     * @param cache 共享的排版缓存（可以为nullptr）
+     * @param parent 父对象
+     */
+    MathLayoutEngine(FormulaLayoutCache *cache = nullptr, QObject *parent = nullptr);
+
+    /**
+     * @brief 设置公式格式（字体和颜色）
+     * @param format 格式
+     */
+    void setFormat(const Format &format);
+
+    /**
+     * @brief 获取公式格式
+     * @return 格式
+     */
+    Format format() const;
+
+    /**
+     * @brief 设置设备DPI
+     * @param dpi 设备DPI
+     */
+    void setDpi(int dpi);
+
+    /**
+     * @brief 获取设备DPI
+     * @return 设备DPI
+     */
+    int dpi() const;
+
+    /**
+     * @brief 排版整个公式（重置访问和组合计数）
+     * @param formula 公式对象
+     * @return 根节点的排版结果
+     */
+    QSharedPointer<const FormulaLayout> layoutFormula(const MathObject *formula);
+
+    /**
+     * @brief 排版一个节点（未过期的子树直接返回缓存结果）
+     * @param node 节点
+     * @param level 脚本层级
+     * @return 排版结果
+     */
+    QSharedPointer<const FormulaLayout> layoutNode(MathNode *node, int level);
+
+    /**
+     * @brief 获取公式的显示列表（必要时先排版）
+     * 显示列表按根节点的结构哈希缓存，哈希相同的公式共享同一显示列表
+     * @param formula 公式对象
+     * @return 显示列表
+     */
+    QSharedPointer<const FormulaDisplayList> displayList(const MathObject *formula);
+
+    /**
+     * @brief 点击测试：求离给定点最近的公式内位置
+     * 沿已缓存的盒子树自顶向下进入包含该点的槽位，每层在Row的子节点偏移上二分查找，
+     * 矩阵通过网格查找行列，复杂度为O(深度·log n)
+     * @param formula 公式对象
+     * @param point 相对于公式基线原点的点
+     * @return 公式内位置
+     */
+    MathPosition hitTest(const MathObject *formula, const QPointF &point);
+
+    /**
+     * @brief 获取公式内位置的光标矩形（沿路径累加子节点偏移，O(深度)）
+     * @param formula 公式对象
+     * @param position 公式内位置
+     * @return 光标矩形（宽度为0，相对于公式基线原点），位置无效时返回空矩形
+     */
+    QRectF caretRect(const MathObject *formula, const MathPosition &position);
+
+    /**
+     * @brief 获取层级对应的字体
+     * @param level 脚本层级
+     * @return 字体
+     */
+    QFont fontForLevel(int level) const;
+
+    /**
+     * @brief 获取层级对应的排版参数
+     * @param level 脚本层级
+     * @return 排版参数
+     */
+    const MathConstants &constants(int level) const;
+
+    /**
+     * @brief 获取层级对应的默认字号比例（字体没有MATH表时使用）
+     * @param level 脚本层级
+     * @return 字号比例
+     */
+    static qreal levelScale(int level);
+
+    /**
+     * @brief 获取公式字体的MATH表
+     * @return MATH表
+     */
+    QSharedPointer<const MathTable> mathTable() const;
+
+    /**
+     * @brief 获取子节点的脚本层级
+     * @param node 父节点
+     * @param index 子节点索引
+     * @param level 父节点的脚本层级
+     * @return 子节点的脚本层级
+     */
+    static int childLevel(const MathNode *node, int index, int level);
+
+    /**
+     * @brief 获取上一次layoutFormula访问的节点数
+     * @return 节点数
+     */
+    int visitedNodeCount() const;
+
+    /**
+     * @brief 获取上一次layoutFormula重新组合的节点数
+     * @return 节点数
+     */
+    int composedNodeCount() const;
+
+private:
+    struct DisplayListRecorder;
+
+    /**
+     * @brief 把已排版节点的绘制指令记录到显示列表
+     * @param node 节点
+     * @param origin 节点基线原点
+     * @param recorder 记录器
+     */
+    void recordNode(const MathNode *node, const QPointF &origin, DisplayListRecorder *recorder) const;
+
+    /**
+     * @struct StretchyGlyph
+     * @brief 伸展到目标尺寸的符号（单个变体、拼装部件或拉伸的字形）
+     */
+    struct StretchyGlyph
+    {
+        QVector<FormulaGlyph> glyphs;  ///< 字形（坐标原点任意，由调用者平移）
+        QRectF ink;                    ///< 墨迹范围（与字形同一坐标系）
+        qreal advance = 0;             ///< 水平占位宽度
+    };
+
+    /**
+     * @brief 构造垂直伸展到目标高度的符号
+     * 优先取MATH表中第一个足够高的变体，都不够高时用拼装部件，没有MATH表时纵向拉伸字形
+     * @param symbol 符号字符
+     * @param targetHeight 目标高度
+     * @param level 脚本层级
+     * @return 伸展后的符号
+     */
+    StretchyGlyph stretchyGlyph(const QString &symbol, qreal targetHeight, int level) const;
+
+    /**
+     * @brief 排版矩阵节点（单元格盒子保存在矩阵网格中，按单元格增量更新）
+     * @param node 矩阵节点
+     * @param level 脚本层级
+     * @param previous 同一上下文下的上次排版结果（可以为空）
+     * @return 排版结果
+     */
+    QSharedPointer<const FormulaLayout> layoutMatrix(MathNode *node, int level,
+                                                     const QSharedPointer<const FormulaLayout> &previous);
+
+    /**
+     * @brief 根据子节点盒子组合节点的排版结果
+     * @param node 节点
+     * @param childBoxes 子节点盒子
+     * @param level 脚本层级
+     * @return 排版结果
+     */
+    FormulaLayout compose(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const;
+
+    FormulaLayout composeSymbol(const MathNode *node, int level) const;
+    FormulaLayout composeRow(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const;
+    FormulaLayout composeFraction(const QVector<MathBox> &childBoxes, int level) const;
+    FormulaLayout composeScript(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const;
+    FormulaLayout composeRadical(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const;
+    FormulaLayout composeDelimited(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const;
+
+    /**
+     * @brief 放置一个以数学轴为中心、拉伸到目标高度的定界符
+     * @param layout 排版结果（追加字形）
+     * @param delimiter 定界符字符
+     * @param x 水平位置
+     * @param targetHeight 目标高度
+     * @param level 脚本层级
+     * @param box 盒子（扩展其高度和深度）
+     * @return 定界符宽度
+     */
+    qreal placeDelimiter(FormulaLayout *layout, const QString &delimiter, qreal x,
+                         qreal targetHeight, int level, MathBox *box) const;
+
+    /**
+     * @brief 重新计算各层级字体、参数和排版上下文
+     */
+    void updateContext();
+
+    /**
+     * @brief 层级数量
+     */
+    static const int LEVEL_COUNT = 3;
+
+    /**
+     * @brief 拼装时延伸部件的最大重复次数
+     */
+    static const int MAX_ASSEMBLY_REPEATS = 64;
+
+    /**
+     * @brief 共享的排版缓存
+     */
+    FormulaLayoutCache *m_cache;
+
+    /**
+     * @brief 公式格式
+     */
+    Format m_format;
+
+    /**
+     * @brief 设备DPI
+     */
+    int m_dpi;
+
+    /**
+     * @brief 格式键
+     */
+    QString m_formatKey;
+
+    /**
+     * @brief 排版上下文
+     */
+    quint64 m_context;
+
+    /**
+     * @brief 各层级字体
+     */
+    QFont m_fonts[LEVEL_COUNT];
+
+    /**
+     * @brief 各层级排版参数
+     */
+    MathConstants m_constants[LEVEL_COUNT];
+
+    /**
+     * @brief 各层级的原始字体（按字形索引查询和绘制）
+     */
+    QRawFont m_rawFonts[LEVEL_COUNT];
+
+    /**
+     * @brief 公式字体的MATH表
+     */
+    QSharedPointer<const MathTable> m_mathTable;
+
+    /**
+     * @brief 访问的节点数
+     */
+    int m_visited;
+
+    /**
+     * @brief 重新组合的节点数
+     */
+    int m_composed;
+};
+
+#endif // MATHLAYOUTENGINE_H
@@ -0,0 +1,299 @@
+// ============================================================================
+// MathTable.h
+// OpenType MATH表类的头文件
+// 解析字体的MATH表，提供数学常量、斜体修正、字形变体和字形拼装查询
+// ============================================================================
+
+#ifndef MATHTABLE_H
+#define MATHTABLE_H
+
+#include <QByteArray>
+#include <QRawFont>
+#include <QSharedPointer>
+#include <QVector>
+#include <QString>
+
+/**
+ * @class MathTable
+ * @brief OpenType MATH表类
+ *
+ * Qt不提供MATH表的访问接口，本类从QRawFont取出原始表数据解析一次，
+ * 之后只保留紧凑的有序数组：常量为定长数组，斜体修正和字形构造按字形索引排序，
+ * 变体和拼装部件放在扁平数组中，每次查询都是O(log n)的二分查找，不再解析字节。
+ * 所有数值都是字体设计单位，使用toPixels()按像素字号换算。
+ */
+class MathTable
+{
+public:
+    /**
+     * @brief 数学常量（顺序与MATH表中MathConstants的字段顺序一致）
+     */
+    enum Constant
+    {
+        ScriptPercentScaleDown,
+        ScriptScriptPercentScaleDown,
+        DelimitedSubFormulaMinHeight,
+        DisplayOperatorMinHeight,
+        MathLeading,
+        AxisHeight,
+        AccentBaseHeight,
+        FlattenedAccentBaseHeight,
+        SubscriptShiftDown,
+        SubscriptTopMax,
+        SubscriptBaselineDropMin,
+        SuperscriptShiftUp,
+        SuperscriptShiftUpCramped,
+        SuperscriptBottomMin,
+        SuperscriptBaselineDropMax,
+        SubSuperscriptGapMin,
+        SuperscriptBottomMaxWithSubscript,
+        SpaceAfterScript,
+        UpperLimitGapMin,
+        UpperLimitBaselineRiseMin,
+        LowerLimitGapMin,
+        LowerLimitBaselineDropMin,
+        StackTopShiftUp,
+        StackTopDisplayStyleShiftUp,
+        StackBottomShiftDown,
+        StackBottomDisplayStyleShiftDown,
+        StackGapMin,
+        StackDisplayStyleGapMin,
+        StretchStackTopShiftUp,
+        StretchStackBottomShiftDown,
+        StretchStackGapAboveMin,
+        StretchStackGapBelowMin,
+        FractionNumeratorShiftUp,
+        FractionNumeratorDisplayStyleShiftUp,
+        FractionDenominatorShiftDown,
+        FractionDenominatorDisplayStyleShiftDown,
+        FractionNumeratorGapMin,
+        FractionNumDisplayStyleGapMin,
+        FractionRuleThickness,
+        FractionDenominatorGapMin,
+        FractionDenomDisplayStyleGapMin,
+        SkewedFractionHorizontalGap,
+        SkewedFractionVerticalGap,
+        OverbarVerticalGap,
+        OverbarRuleThickness,
+        OverbarExtraAscender,
+        UnderbarVerticalGap,
+        UnderbarRuleThickness,
+        UnderbarExtraDescender,
+        RadicalVerticalGap,
+        RadicalDisplayStyleVerticalGap,
+        RadicalRuleThickness,
+        RadicalExtraAscender,
+        RadicalKernBeforeDegree,
+        RadicalKernAfterDegree,
+        RadicalDegreeBottomRaisePercent,
+        ConstantCount
+    };
+
+    /**
+     * @struct GlyphVariant
+     * @brief 字形变体（同一符号的逐级加大的预制字形）
+     */
+    struct GlyphVariant
+    {
+        quint16 glyph = 0;    ///< 变体字形索引
+        quint16 advance = 0;  ///< 变体在伸展方向上的尺寸（设计单位）
+    };
+
+    /**
+     * @struct GlyphPart
+     * @brief 字形拼装部件（按从下到上或从左到右的顺序）
+     */
+    struct GlyphPart
+    {
+        quint16 glyph = 0;           ///< 部件字形索引
+        quint16 startConnector = 0;  ///< 起始端可重叠长度
+        quint16 endConnector = 0;    ///< 结束端可重叠长度
+        quint16 fullAdvance = 0;     ///< 部件完整尺寸
+        bool extender = false;       ///< 是否为可重复的延伸部件
+    };
+
+    /**
+     * @struct Range
+     * @brief 扁平数组中一段连续元素的只读视图（不复制数据，随表一起有效）
+     */
+    template <typename T>
+    struct Range
+    {
+        const T *first = nullptr;  ///< 首个元素
+        int count = 0;             ///< 元素个数
+
+        const T *begin() const { return first; }              ///< 起始迭代器
+        const T *end() const { return first + count; }        ///< 结束迭代器
+        int size() const { return count; }                   ///< 元素个数
+        bool isEmpty() const { return count == 0; }           ///< 是否为空
+        const T &last() const { return first[count - 1]; }    ///< 最后一个元素（不能为空）
+    };
+
+    /**
+     * @brief 构造空表
+     */
+    MathTable();
+
+    /**
+     * @brief 从MATH表原始数据解析
+     * @param data MATH表数据
+     * @param unitsPerEm 字体每em的设计单位数
+     * @return 是否解析成功
+     */
+    bool load(const QByteArray &data, qreal unitsPerEm);
+
+    /**
+     * @brief 获取字体的MATH表（同一字体只解析一次，只能在GUI线程调用）
+     * @param font 字体
+     * @return MATH表，字体没有MATH表时返回的表无效
+     */
+    static QSharedPointer<const MathTable> forFont(const QRawFont &font);
+
+    /**
+     * @brief 检查表是否有效
+     * @return 是否有效
+     */
+    bool isValid() const;
+
+    /**
+     * @brief 获取字体每em的设计单位数
+     * @return 设计单位数
+     */
+    qreal unitsPerEm() const;
+
+    /**
+     * @brief 把设计单位换算为像素
+     * @param units 设计单位数值
+     * @param pixelSize 像素字号
+     * @return 像素值
+     */
+    qreal toPixels(qreal units, qreal pixelSize) const;
+
+    /**
+     * @brief 获取数学常量（百分比常量直接返回百分数，其余为设计单位）
+     * @param constant 常量
+     * @return 常量值
+     */
+    int constant(Constant constant) const;
+
+    /**
+     * @brief 获取字形的斜体修正
+     * @param glyph 字形索引
+     * @return 斜体修正（设计单位），没有记录时返回0
+     */
+    int italicsCorrection(quint32 glyph) const;
+
+    /**
+     * @brief 获取字形在指定方向上的变体（从小到大）
+     * @param glyph 字形索引
+     * @param orientation 伸展方向
+     * @return 变体（指向表内数组的视图）
+     */
+    Range<GlyphVariant> variants(quint32 glyph, Qt::Orientation orientation) const;
+
+    /**
+     * @brief 获取字形在指定方向上的拼装部件
+     * @param glyph 字形索引
+     * @param orientation 伸展方向
+     * @return 拼装部件（指向表内数组的视图），没有拼装时为空
+     */
+    Range<GlyphPart> assembly(quint32 glyph, Qt::Orientation orientation) const;
+
+    /**
+     * @brief 获取拼装部件之间的最小重叠长度
+     * @return 最小重叠长度（设计单位）
+     */
+    int minConnectorOverlap() const;
+
+private:
+    /**
+     * @struct Construction
+     * @brief 字形构造在扁平数组中的范围
+     */
+    struct Construction
+    {
+        quint16 glyph = 0;
+        int firstVariant = 0;
+        int variantCount = 0;
+        int firstPart = 0;
+        int partCount = 0;
+    };
+
+    /**
+     * @brief 解析常量子表
+     */
+    bool parseConstants(const QByteArray &data, int offset);
+
+    /**
+     * @brief 解析字形信息子表（斜体修正）
+     */
+    bool parseGlyphInfo(const QByteArray &data, int offset);
+
+    /**
+     * @brief 解析变体子表
+     */
+    bool parseVariants(const QByteArray &data, int offset);
+
+    /**
+     * @brief 解析一个方向的字形构造
+     */
+    bool parseConstructions(const QByteArray &data, int base, int coverageOffset, int count,
+                            int offsetsStart, QVector<Construction> *constructions);
+
+    /**
+     * @brief 查找字形构造（二分查找）
+     */
+    const Construction *findConstruction(quint32 glyph, Qt::Orientation orientation) const;
+
+    /**
+     * @brief 是否有效
+     */
+    bool m_valid;
+
+    /**
+     * @brief 每em的设计单位数
+     */
+    qreal m_unitsPerEm;
+
+    /**
+     * @brief 数学常量
+     */
+    qint16 m_constants[ConstantCount];
+
+    /**
+     * @brief 有斜体修正的字形（升序）
+     */
+    QVector<quint16> m_italicGlyphs;
+
+    /**
+     * @brief 与m_italicGlyphs对应的斜体修正
+     */
+    QVector<qint16> m_italicValues;
+
+    /**
+     * @brief 拼装部件最小重叠长度
+     */
+    int m_minConnectorOverlap;
+
+    /**
+     * @brief 垂直方向的字形构造（按字形索引升序）
+     */
+    QVector<Construction> m_verticalConstructions;
+
+    /**
+     * @brief 水平方向的字形构造（按字形索引升序）
+     */
+    QVector<Construction> m_horizontalConstructions;
+
+    /**
+     * @brief 所有构造的变体
+     */
+    QVector<GlyphVariant> m_variants;
+
+    /**
+     * @brief 所有构造的拼装部件
+     */
+    QVector<GlyphPart> m_parts;
+};
+
+#endif // MATHTABLE_H
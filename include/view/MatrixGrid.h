@@ -0,0 +1,248 @@
+// ============================================================================
+// MatrixGrid.h
+// 矩阵网格类的头文件
+// 缓存矩阵单元格盒子及列宽、行高，单个单元格变化时以O(log n)更新
+// ============================================================================
+
+#ifndef MATRIXGRID_H
+#define MATRIXGRID_H
+
+#include "core/MathNode.h"
+#include <QVector>
+#include <QMap>
+#include <QPointF>
+#include <QString>
+
+/**
+ * @class MatrixGrid
+ * @brief 矩阵网格类
+ *
+ * 保存矩阵（以及align等对齐环境）每个单元格的盒子。每列的单元格宽度、
+ * 每行的单元格高度和深度各用一个有序计数表维护，最大值即最后一个键；
+ * 列宽和行高再放入树状数组，列的X坐标和行的基线位置都是前缀和。
+ * 因此修改一个单元格只需O(log n)，单元格偏移的查询也是O(log n)，
+ * 不需要重新测量其他单元格，也不需要为所有单元格生成偏移数组。
+ */
+class MatrixGrid
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param rows 行数
+     * @param columns 列数
+     * @param alignment 各列对齐方式（'l'/'c'/'r'循环使用，空表示居中）
+     * @param columnGap 列间距
+     * @param rowGap 行间距
+     * @param axisHeight 数学轴高度（网格整体以数学轴居中）
+     */
+    MatrixGrid(int rows, int columns, const QString &alignment, qreal columnGap, qreal rowGap, qreal axisHeight);
+
+    /**
+     * @brief 用所有单元格的盒子重建网格（O(n log n)）
+     * @param cells 单元格盒子（按行存储）
+     */
+    void reset(const QVector<MathBox> &cells);
+
+    /**
+     * @brief 更新一个单元格的盒子（O(log n)）
+     * @param index 单元格索引
+     * @param box 新盒子
+     */
+    void setCell(int index, const MathBox &box);
+
+    /**
+     * @brief 获取单元格的盒子
+     * @param index 单元格索引
+     * @return 盒子
+     */
+    MathBox cell(int index) const;
+
+    /**
+     * @brief 获取行数
+     * @return 行数
+     */
+    int rows() const;
+
+    /**
+     * @brief 获取列数
+     * @return 列数
+     */
+    int columns() const;
+
+    /**
+     * @brief 获取单元格数量
+     * @return 单元格数量
+     */
+    int cellCount() const;
+
+    /**
+     * @brief 获取列宽
+     * @param column 列索引
+     * @return 列宽
+     */
+    qreal columnWidth(int column) const;
+
+    /**
+     * @brief 获取列的左边缘X坐标（O(log n)）
+     * @param column 列索引
+     * @return X坐标
+     */
+    qreal columnX(int column) const;
+
+    /**
+     * @brief 获取行的基线位置（相对于网格顶部，O(log n)）
+     * @param row 行索引
+     * @return Y坐标
+     */
+    qreal rowBaseline(int row) const;
+
+    /**
+     * @brief 获取X坐标所在的列（O(log n)）
+     * @param x X坐标（相对于网格左边缘）
+     * @return 列索引
+     */
+    int columnAt(qreal x) const;
+
+    /**
+     * @brief 获取Y坐标所在的行（O(log n)）
+     * @param y Y坐标（相对于网格顶部）
+     * @return 行索引
+     */
+    int rowAt(qreal y) const;
+
+    /**
+     * @brief 获取单元格原点相对于矩阵原点（基线）的偏移（O(log n)）
+     * @param index 单元格索引
+     * @return 偏移
+     */
+    QPointF cellOffset(int index) const;
+
+    /**
+     * @brief 获取网格整体的盒子
+     * @return 盒子
+     */
+    MathBox box() const;
+
+private:
+    /**
+     * @brief 在有序计数表中加入一个值
+     */
+    static void addValue(QMap<qreal, int> *counts, qreal value);
+
+    /**
+     * @brief 从有序计数表中移除一个值
+     */
+    static void removeValue(QMap<qreal, int> *counts, qreal value);
+
+    /**
+     * @brief 树状数组单点增加
+     */
+    static void treeAdd(QVector<qreal> *tree, int index, qreal delta);
+
+    /**
+     * @brief 树状数组前缀和（[0, count)）
+     */
+    static qreal treePrefix(const QVector<qreal> &tree, int count);
+
+    /**
+     * @brief 树状数组中前缀和不超过value的最长前缀长度（每项另加gap）
+     */
+    static int treeSearch(const QVector<qreal> &tree, qreal value, qreal gap);
+
+    /**
+     * @brief 用计数表的最大值刷新列宽，并更新树状数组
+     */
+    void refreshColumn(int column);
+
+    /**
+     * @brief 用计数表的最大值刷新行高和深度，并更新树状数组
+     */
+    void refreshRow(int row);
+
+    /**
+     * @brief 行数
+     */
+    int m_rows;
+
+    /**
+     * @brief 列数
+     */
+    int m_columns;
+
+    /**
+     * @brief 各列对齐方式
+     */
+    QString m_alignment;
+
+    /**
+     * @brief 列间距
+     */
+    qreal m_columnGap;
+
+    /**
+     * @brief 行间距
+     */
+    qreal m_rowGap;
+
+    /**
+     * @brief 数学轴高度
+     */
+    qreal m_axisHeight;
+
+    /**
+     * @brief 单元格盒子
+     */
+    QVector<MathBox> m_cells;
+
+    /**
+     * @brief 每列单元格宽度的计数表
+     */
+    QVector<QMap<qreal, int>> m_columnWidthCounts;
+
+    /**
+     * @brief 每行单元格高度的计数表
+     */
+    QVector<QMap<qreal, int>> m_rowAscentCounts;
+
+    /**
+     * @brief 每行单元格深度的计数表
+     */
+    QVector<QMap<qreal, int>> m_rowDescentCounts;
+
+    /**
+     * @brief 列宽
+     */
+    QVector<qreal> m_columnWidths;
+
+    /**
+     * @brief 行高（基线以上）
+     */
+    QVector<qreal> m_rowAscents;
+
+    /**
+     * @brief 行深（基线以下）
+     */
+    QVector<qreal> m_rowDescents;
+
+    /**
+     * @brief 列宽的树状数组
+     */
+    QVector<qreal> m_columnTree;
+
+    /**
+     * @brief 行总高的树状数组
+     */
+    QVector<qreal> m_rowTree;
+
+    /**
+     * @brief 列宽之和
+     */
+    qreal m_totalWidth;
+
+    /**
+     * @brief 行总高之和
+     */
+    qreal m_totalHeight;
+};
+
+#endif // MATRIXGRID_H
@@ -0,0 +1,170 @@
+// ============================================================================
+// ParagraphItem.h
+// 段落图形项类的头文件
+// 在场景中绘制一个已整形的段落
+// ============================================================================
+
+#ifndef PARAGRAPHITEM_H
+#define PARAGRAPHITEM_H
+
+#include "view/TextLayoutEngine.h"
+#include "core/MathObject.h"
+#include <QGraphicsItem>
+#include <QSharedPointer>
+#include <QRectF>
+#include <QPainter>
+
+class FormulaItem;
+class ReferenceItem;
+class PlotItem;
+class PlotSampler;
+class MathLayoutEngine;
+class EquationIndex;
+
+/**
+ * @class ParagraphItem
+ * @brief 段落图形项类
+ *
+ * 持有一个段落的排版结果（字形序列），绘制时直接输出字形，
+ * 不再为每个段落创建QTextDocument。排版结果由TextLayoutEngine在后台生成，
+ * 提交时只需替换隐式共享的数据，代价很低。
+ */
+class ParagraphItem : public QGraphicsItem
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 图形父项
+     */
+    ParagraphItem(QGraphicsItem *parent = nullptr);
+
+    /**
+     * @brief 设置排版结果
+     * @param layout 排版结果
+     */
+    void setParagraphLayout(const ParagraphLayout &layout);
+
+    /**
+     * @brief 获取排版结果
+     * @return 排版结果
+     */
+    const ParagraphLayout &paragraphLayout() const;
+
+    /**
+     * @brief 设置段落中的公式（与排版结果中的内联对象一一对应）
+     * 公式作为子项放在预留位置的基线上，子项按公式对象匹配，在中间插入或删除公式时其余子项被复用
+     * @param formulas 公式对象
+     * @param engine 数学排版引擎
+     */
+    void setFormulas(const QVector<QSharedPointer<MathObject>> &formulas, MathLayoutEngine *engine);
+
+    /**
+     * @brief 设置公式编号和交叉引用的绘制方式
+     * 为排版结果中的交叉引用对象创建子项，并让带编号的公式在预留宽度中绘制编号
+     * @param index 公式编号索引
+     * @param handle 段落在索引中的句柄
+     * @param font 编号字体
+     */
+    void setEquationNumbers(const EquationIndex *index, int handle, const QFont &font);
+
+    /**
+     * @brief 设置段落中的函数图像
+     * 为排版结果中的函数图像对象创建子项，图像高度为段落行高，同一图像对象的子项会被复用
+     * @param sampler 采样器
+     */
+    void setPlots(PlotSampler *sampler);
+
+    /**
+     * @brief 重绘公式编号和交叉引用（编号变化后由视图对可见段落调用）
+     */
+    void updateEquationNumbers();
+
+    /**
+     * @brief 设置是否绘制文本
+     * 启用瓦片缓存时文本由瓦片绘制，段落项不再绘制自身，但公式子项仍然绘制
+     * @param visible 是否绘制文本
+     */
+    void setTextVisible(bool visible);
+
+    /**
+     * @brief 设置内容戳
+     * 段落内容变化时由视图分配新的内容戳，之前排队的排版结果随之失效
+     * @param stamp 内容戳
+     */
+    void setStamp(quint64 stamp);
+
+    /**
+     * @brief 获取内容戳
+     * @return 内容戳
+     */
+    quint64 stamp() const;
+
+    /**
+     * @brief 设置裁剪宽度
+     * 输入法组合期间，光标之后的文本改由预编辑层绘制，段落项只绘制到光标处
+     * @param width 裁剪宽度，负数表示不裁剪
+     */
+    void setClipWidth(qreal width);
+
+    /**
+     * @brief 获取裁剪宽度
+     * @return 裁剪宽度，负数表示不裁剪
+     */
+    qreal clipWidth() const;
+
+    /**
+     * @brief 获取边界矩形
+     * @return 边界矩形
+     */
+    QRectF boundingRect() const override;
+
+    /**
+     * @brief 绘制段落
+     * @param painter 画笔
+     * @param option 样式选项
+     * @param widget 部件
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+    /**
+     * @brief 绘制字形序列（图形项和瓦片光栅化共用）
+     * @param painter 画笔，坐标原点位于段落左上角
+     * @param glyphRuns 字形序列
+     * @param clipWidth 裁剪宽度，负数表示不裁剪
+     * @param height 段落行高
+     */
+    static void drawGlyphRuns(QPainter *painter, const QList<QGlyphRun> &glyphRuns, qreal clipWidth, qreal height);
+
+private:
+    /**
+     * @brief 排版结果
+     */
+    ParagraphLayout m_layout;
+
+    /**
+     * @brief 当前内容戳
+     */
+    quint64 m_stamp;
+
+    /**
+     * @brief 裁剪宽度（负数表示不裁剪）
+     */
+    qreal m_clipWidth;
+
+    /**
+     * @brief 公式子项
+     */
+    QVector<FormulaItem *> m_formulaItems;
+
+    /**
+     * @brief 交叉引用子项
+     */
+    QVector<ReferenceItem *> m_referenceItems;
+
+    /**
+     * @brief 函数图像子项
+     */
+    QVector<PlotItem *> m_plotItems;
+};
+
+#endif // PARAGRAPHITEM_H
@@ -0,0 +1,113 @@
+// ============================================================================
+// ParagraphTops.h
+// 段落顶部偏移索引的头文件
+// 以树状数组保存段落高度，按段落查询顶部偏移、按偏移查找段落都是O(log n)
+// ============================================================================
+
+#ifndef PARAGRAPHTOPS_H
+#define PARAGRAPHTOPS_H
+
+#include <QVector>
+
+/**
+ * @class ParagraphTops
+ * @brief 段落顶部偏移索引
+ *
+ * 保存每个段落的高度，段落顶部偏移为其前所有段落高度之和（前缀和）。
+ * 前缀和保存在树状数组（Fenwick树）中：修改一个段落的高度、查询顶部偏移和按偏移查找段落
+ * 都是O(log n)，行高变化时不必逐段重新计算其后段落的偏移。
+ * 增删段落只移动高度表，树状数组在下一次查询时按高度表线性重建（只做加法，
+ * 与段落项数组本身的插入删除同阶），不涉及任何图形项。
+ */
+class ParagraphTops
+{
+public:
+    /**
+     * @brief 构造函数
+     * 创建一个空索引
+     */
+    ParagraphTops();
+
+    /**
+     * @brief 清空索引
+     */
+    void clear();
+
+    /**
+     * @brief 获取段落数
+     * @return 段落数
+     */
+    int count() const;
+
+    /**
+     * @brief 插入若干段落
+     * @param index 插入位置
+     * @param count 段落数
+     * @param height 新段落的高度
+     */
+    void insert(int index, int count, qreal height);
+
+    /**
+     * @brief 删除若干段落
+     * @param index 起始段落
+     * @param count 段落数
+     */
+    void remove(int index, int count);
+
+    /**
+     * @brief 获取段落高度
+     * @param index 段落索引
+     * @return 高度
+     */
+    qreal height(int index) const;
+
+    /**
+     * @brief 设置段落高度，O(log n)
+     * @param index 段落索引
+     * @param height 高度
+     */
+    void setHeight(int index, qreal height);
+
+    /**
+     * @brief 获取段落顶部相对内容顶部的偏移（其前所有段落高度之和），O(log n)
+     * @param index 段落索引，等于段落数时为内容总高度
+     * @return 偏移
+     */
+    qreal top(int index) const;
+
+    /**
+     * @brief 获取内容总高度
+     * @return 高度
+     */
+    qreal total() const;
+
+    /**
+     * @brief 查找偏移所在的段落，O(log n)
+     * @param offset 相对内容顶部的偏移
+     * @return 段落索引；偏移不小于总高度时为段落数
+     */
+    int indexAt(qreal offset) const;
+
+private:
+    /**
+     * @brief 树状数组过期时按高度表重建
+     */
+    void rebuild() const;
+
+    /**
+     * @brief 段落高度
+     */
+    QVector<qreal> m_heights;
+
+    /**
+     * @brief 树状数组（下标从1开始，第i项为第i - lowbit(i)到第i - 1个段落的高度之和）
+     */
+    mutable QVector<qreal> m_tree;
+
+    /**
+     * @brief 树状数组是否需要重建（增删段落后）
+     */
+    mutable bool m_stale;
+};
+
+#endif // PARAGRAPHTOPS_H
@@ -0,0 +1,142 @@
+// ============================================================================
+// PlotItem.h
+// 函数图像图形项类的头文件
+// 在段落中绘制一个内联函数图像，支持滚轮缩放和平移
+// ============================================================================
+
+#ifndef PLOTITEM_H
+#define PLOTITEM_H
+
+#include "core/PlotObject.h"
+#include <QGraphicsItem>
+#include <QGraphicsSceneWheelEvent>
+#include <QSharedPointer>
+#include <QVector>
+#include <QPolygonF>
+#include <QRectF>
+#include <QPainter>
+
+class PlotSampler;
+
+/**
+ * @class PlotItem
+ * @brief 函数图像图形项类
+ *
+ * 作为段落图形项的子项，原点位于基线的左端，占据段落排版为图像预留的宽度，
+ * 高度为段落行高。采样由共享的PlotSampler完成；图形项缓存折线的像素坐标，
+ * 只在区间或公式变化时重建，重建时把每个像素列内的点压缩为首、末、最低、最高四个点，
+ * 因此即使采样点很多，每帧绘制的顶点数也只与像素宽度成正比。
+ * 滚轮缩放（以光标所在的x为中心），Shift+滚轮或横向滚轮平移；
+ * 视图区间是图形项的状态，不写回文档。
+ */
+class PlotItem : public QGraphicsItem
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param plot 函数图像对象
+     * @param sampler 采样器
+     * @param parent 图形父项
+     */
+    PlotItem(const QSharedPointer<PlotObject> &plot, PlotSampler *sampler, QGraphicsItem *parent = nullptr);
+
+    /**
+     * @brief 获取函数图像对象
+     * @return 函数图像对象
+     */
+    QSharedPointer<PlotObject> plot() const;
+
+    /**
+     * @brief 设置图像占据的区域
+     * @param width 预留宽度
+     * @param ascent 基线以上的高度
+     * @param height 总高度
+     */
+    void setExtent(qreal width, qreal ascent, qreal height);
+
+    /**
+     * @brief 获取边界矩形
+     * @return 边界矩形
+     */
+    QRectF boundingRect() const override;
+
+    /**
+     * @brief 绘制函数图像
+     * @param painter 画笔
+     * @param option 样式选项
+     * @param widget 部件
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+protected:
+    /**
+     * @brief 处理滚轮事件：缩放或平移区间
+     * @param event 滚轮事件
+     */
+    void wheelEvent(QGraphicsSceneWheelEvent *event) override;
+
+private:
+    /**
+     * @brief 重新采样并生成折线的像素坐标
+     * @param hash 函数公式的结构哈希
+     */
+    void rebuild(quint64 hash);
+
+    /**
+     * @brief 获取绘图区（边界矩形去掉边框）
+     * @return 绘图区
+     */
+    QRectF plotArea() const;
+
+    /**
+     * @brief 函数图像对象
+     */
+    QSharedPointer<PlotObject> m_plot;
+
+    /**
+     * @brief 采样器
+     */
+    PlotSampler *m_sampler;
+
+    /**
+     * @brief 当前区间左端
+     */
+    double m_xMin;
+
+    /**
+     * @brief 当前区间宽度（平移时保持不变，采样缓存按区间宽度识别缩放比例）
+     */
+    double m_span;
+
+    /**
+     * @brief 当前纵轴范围下端
+     */
+    double m_yMin;
+
+    /**
+     * @brief 当前纵轴范围上端
+     */
+    double m_yMax;
+
+    /**
+     * @brief 边界矩形
+     */
+    QRectF m_bounds;
+
+    /**
+     * @brief 折线（像素坐标，在无定义处断开）
+     */
+    QVector<QPolygonF> m_polylines;
+
+    /**
+     * @brief 生成折线时公式的结构哈希
+     */
+    quint64 m_hash;
+
+    /**
+     * @brief 折线是否需要重建
+     */
+    bool m_dirty;
+};
+
+#endif // PLOTITEM_H
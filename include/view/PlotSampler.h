@@ -0,0 +1,169 @@
+// ============================================================================
+// PlotSampler.h
+// 函数图像采样器类的头文件
+// 按曲率自适应地批量采样y=f(x)，按（公式哈希, 区间, 像素宽度）缓存折线，平移时只补采新露出的区间
+// ============================================================================
+
+#ifndef PLOTSAMPLER_H
+#define PLOTSAMPLER_H
+
+#include "core/MathExpression.h"
+#include <QObject>
+#include <QCache>
+#include <QSharedPointer>
+#include <QVector>
+#include <QPointF>
+#include <QHash>
+
+/**
+ * @struct PlotSampleKey
+ * @brief 采样缓存键
+ *
+ * 区间宽度与像素宽度决定缩放比例，平移不改变键。
+ */
+struct PlotSampleKey
+{
+    /**
+     * @brief 公式结构哈希
+     */
+    quint64 hash = 0;
+
+    /**
+     * @brief 区间宽度
+     */
+    double span = 0;
+
+    /**
+     * @brief 像素宽度
+     */
+    int pixelWidth = 0;
+
+    /**
+     * @brief 比较两个键是否相等
+     */
+    bool operator==(const PlotSampleKey &other) const {
+        return hash == other.hash && span == other.span && pixelWidth == other.pixelWidth;
+    }
+};
+
+/**
+ * @brief 计算采样缓存键的哈希
+ */
+inline size_t qHash(const PlotSampleKey &key, size_t seed = 0)
+{
+    return qHash(key.hash, seed) ^ qHash(key.span, seed) ^ size_t(key.pixelWidth);
+}
+
+/**
+ * @class PlotSampler
+ * @brief 函数图像采样器类
+ *
+ * 先在区间上按像素宽度均匀取点，一次批量求值；之后每轮找出中点偏离弦超过容差
+ * （以及跨越定义域边界）的区间，把所有这些区间的中点收集起来再批量求值一次，
+ * 最多细分若干轮。曲线平缓处保持每像素两个点，弯曲处自动加密。
+ *
+ * 采样结果按（公式结构哈希, 区间宽度, 像素宽度）缓存：区间宽度和像素宽度相同意味着
+ * 缩放比例相同，平移时缓存中已有的采样点直接复用，只对新露出的部分采样并拼接；
+ * 缩放则换到新的缓存项。缓存按采样点数LRU淘汰。
+ */
+class PlotSampler : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit PlotSampler(QObject *parent = nullptr);
+
+    /**
+     * @brief 获取函数在区间上的采样折线
+     * @param expression 函数编译后的表达式
+     * @param hash 函数公式的结构哈希
+     * @param xMin 区间左端
+     * @param xMax 区间右端
+     * @param pixelWidth 区间对应的像素宽度
+     * @return 按x升序排列的采样点（数据坐标，无定义处y为NaN），含区间两侧各一个相邻点
+     */
+    QVector<QPointF> sample(const QSharedPointer<const MathExpression> &expression, quint64 hash,
+                            double xMin, double xMax, int pixelWidth);
+
+    /**
+     * @brief 设置缓存的采样点预算
+     * @param samples 采样点数
+     */
+    void setSampleBudget(int samples);
+
+    /**
+     * @brief 获取累计求值的点数（用于观察平移时的补采量）
+     * @return 点数
+     */
+    qint64 evaluatedCount() const;
+
+    /**
+     * @brief 清空缓存
+     */
+    void clear();
+
+    /**
+     * @brief 每像素的初始采样点数
+     */
+    static const int SAMPLES_PER_PIXEL = 2;
+
+    /**
+     * @brief 最大细分轮数
+     */
+    static const int MAX_REFINEMENTS = 6;
+
+    /**
+     * @brief 细分后采样点数相对初始网格的上限倍数
+     */
+    static const int MAX_DENSITY = 16;
+
+    /**
+     * @brief 默认的缓存采样点预算
+     */
+    static const int DEFAULT_SAMPLE_BUDGET = 4 * 1024 * 1024;
+
+private:
+    /**
+     * @struct Entry
+     * @brief 缓存项：一段连续区间上的采样点
+     */
+    struct Entry
+    {
+        double lo = 0;               ///< 已采样区间左端
+        double hi = 0;               ///< 已采样区间右端
+        QVector<QPointF> points;     ///< 采样点（按x升序）
+    };
+
+    /**
+     * @brief 对一段区间自适应采样
+     * @param expression 函数编译后的表达式
+     * @param a 区间左端
+     * @param b 区间右端
+     * @param pixels 区间对应的像素数
+     * @return 采样点（含两端）
+     */
+    QVector<QPointF> sampleRange(const MathExpression &expression, double a, double b, double pixels);
+
+    /**
+     * @brief 批量求值
+     * @param expression 函数编译后的表达式
+     * @param xs 自变量值
+     * @param ys 输出：函数值
+     */
+    void evaluate(const MathExpression &expression, const QVector<double> &xs, QVector<double> *ys);
+
+    /**
+     * @brief 采样结果缓存（代价为采样点数）
+     */
+    QCache<PlotSampleKey, Entry> m_cache;
+
+    /**
+     * @brief 累计求值的点数
+     */
+    qint64 m_evaluated;
+};
+
+#endif // PLOTSAMPLER_H
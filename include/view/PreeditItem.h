@@ -0,0 +1,113 @@
+// ============================================================================
+// PreeditItem.h
+// 输入法预编辑图形项类的头文件
+// 在光标处内联显示输入法的组合文本
+// ============================================================================
+
+#ifndef PREEDITITEM_H
+#define PREEDITITEM_H
+
+#include <QGraphicsItem>
+#include <QInputMethodEvent>
+#include <QTextLayout>
+#include <QVector>
+#include <QString>
+#include <QFont>
+#include <QPainter>
+
+/**
+ * @class PreeditItem
+ * @brief 输入法预编辑图形项类
+ *
+ * 常驻场景的预编辑层，视图只创建一次。组合文本连同当前段落光标之后的文本
+ * 一起在本项中排版（只重排当前行），段落项本身在光标处裁剪，
+ * 从而实现内联显示。支持输入法提供的文本格式（如下划线）和预编辑光标属性。
+ * 每次预编辑事件只复用已有的QTextLayout、字符串和格式列表，不创建新的图形项。
+ */
+class PreeditItem : public QGraphicsItem
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 图形父项
+     */
+    PreeditItem(QGraphicsItem *parent = nullptr);
+
+    /**
+     * @brief 设置字体
+     * @param font 字体
+     */
+    void setFont(const QFont &font);
+
+    /**
+     * @brief 设置组合文本
+     * @param preedit 组合文本
+     * @param tail 当前段落中光标之后的文本（随组合文本一起重排）
+     * @param attributes 输入法属性（文本格式、光标等）
+     */
+    void setComposition(const QString &preedit, const QString &tail,
+                        const QList<QInputMethodEvent::Attribute> &attributes);
+
+    /**
+     * @brief 清除组合文本
+     */
+    void clear();
+
+    /**
+     * @brief 获取预编辑光标的X坐标（相对于本项）
+     * @return X坐标
+     */
+    qreal cursorX() const;
+
+    /**
+     * @brief 获取边界矩形
+     * @return 边界矩形
+     */
+    QRectF boundingRect() const override;
+
+    /**
+     * @brief 绘制组合文本
+     * @param painter 画笔
+     * @param option 样式选项
+     * @param widget 部件
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    /**
+     * @brief 复用的文本排版对象
+     */
+    QTextLayout m_layout;
+
+    /**
+     * @brief 排版文本（组合文本 + 段落剩余文本）
+     */
+    QString m_text;
+
+    /**
+     * @brief 组合文本的格式范围
+     */
+    QVector<QTextLayout::FormatRange> m_formats;
+
+    /**
+     * @brief 组合文本长度
+     */
+    int m_preeditLength;
+
+    /**
+     * @brief 预编辑光标位置
+     */
+    int m_cursorPosition;
+
+    /**
+     * @brief 预编辑光标是否可见
+     */
+    bool m_cursorVisible;
+
+    /**
+     * @brief 边界矩形
+     */
+    QRectF m_rect;
+};
+
+#endif // PREEDITITEM_H
@@ -0,0 +1,94 @@
+// ============================================================================
+// ReferenceItem.h
+// 交叉引用图形项类的头文件
+// 在段落中绘制对带编号公式的引用，编号在绘制时从公式编号索引中查询
+// ============================================================================
+
+#ifndef REFERENCEITEM_H
+#define REFERENCEITEM_H
+
+#include <QGraphicsItem>
+#include <QString>
+#include <QFont>
+#include <QRectF>
+#include <QPainter>
+
+class EquationIndex;
+
+/**
+ * @class ReferenceItem
+ * @brief 交叉引用图形项类
+ *
+ * 作为段落图形项的子项，原点位于基线的左端，占据段落排版为引用预留的宽度。
+ * 图形项只保存标签，不保存编号：其他位置插入或删除公式后无需更新本项，
+ * 视图只对可见的引用调用update()，绘制时以O(log n)查询当前编号。
+ */
+class ReferenceItem : public QGraphicsItem
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param label 所引用公式的标签
+     * @param index 公式编号索引
+     * @param font 字体
+     * @param parent 图形父项
+     */
+    ReferenceItem(const QString &label, const EquationIndex *index, const QFont &font,
+                  QGraphicsItem *parent = nullptr);
+
+    /**
+     * @brief 获取所引用公式的标签
+     * @return 标签
+     */
+    QString label() const;
+
+    /**
+     * @brief 设置预留宽度
+     * @param width 宽度
+     */
+    void setWidth(qreal width);
+
+    /**
+     * @brief 获取边界矩形
+     * @return 边界矩形
+     */
+    QRectF boundingRect() const override;
+
+    /**
+     * @brief 绘制引用
+     * @param painter 画笔
+     * @param option 样式选项
+     * @param widget 部件
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+    /**
+     * @brief 生成编号的显示文本
+     * @param number 编号，0表示引用无法解析
+     * @return 显示文本，如"(12)"或"(?)"
+     */
+    static QString numberText(int number);
+
+private:
+    /**
+     * @brief 所引用公式的标签
+     */
+    QString m_label;
+
+    /**
+     * @brief 公式编号索引
+     */
+    const EquationIndex *m_index;
+
+    /**
+     * @brief 字体
+     */
+    QFont m_font;
+
+    /**
+     * @brief 边界矩形
+     */
+    QRectF m_bounds;
+};
+
+#endif // REFERENCEITEM_H
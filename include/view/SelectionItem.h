@@ -0,0 +1,115 @@
+// ============================================================================
+// SelectionItem.h
+// 选择高亮图形项类的头文件
+// 在文本下方绘制选择区域的高亮矩形
+// ============================================================================
+
+#ifndef SELECTIONITEM_H
+#define SELECTIONITEM_H
+
+#include "core/Selection.h"
+#include <QGraphicsItem>
+#include <QRectF>
+#include <QPainter>
+
+class DocumentView;
+
+/**
+ * @class SelectionItem
+ * @brief 选择高亮图形项类
+ *
+ * 位于段落项下方的覆盖层，根据视图缓存的光标位置绘制选择高亮。
+ * 选择变化时只重绘新旧选择端点之间变化的行，不触发文本重新排版；
+ * 绘制时只计算暴露区域内的行，因此选择大小不影响拖动时的开销。
+ */
+class SelectionItem : public QGraphicsItem
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param view 提供几何信息的文档视图
+     * @param parent 图形父项
+     */
+    SelectionItem(const DocumentView *view, QGraphicsItem *parent = nullptr);
+
+    /**
+     * @brief 设置选择
+     * @param selection 新的选择
+     */
+    void setSelection(const Selection &selection);
+
+    /**
+     * @brief 设置覆盖范围（通常为场景矩形）
+     * @param extent 覆盖范围
+     */
+    void setExtent(const QRectF &extent);
+
+    /**
+     * @brief 重绘指定段落范围内的高亮（段落排版变化后调用）
+     * @param first 第一个段落索引
+     * @param last 最后一个段落索引
+     */
+    void updateParagraphs(int first, int last);
+
+    /**
+     * @brief 获取边界矩形
+     * @return 边界矩形
+     */
+    QRectF boundingRect() const override;
+
+    /**
+     * @brief 绘制选择高亮
+     * @param painter 画笔
+     * @param option 样式选项
+     * @param widget 部件
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    /**
+     * @brief 获取若干行所占的矩形（横向覆盖整个范围）
+     * @param first 第一个段落索引
+     * @param last 最后一个段落索引
+     * @return 行矩形
+     */
+    QRectF rowsRect(int first, int last) const;
+
+    /**
+     * @brief 获取某一段落中被选中部分的矩形
+     * @param paragraph 段落索引
+     * @return 高亮矩形，未选中时为空矩形
+     */
+    QRectF highlightRect(int paragraph) const;
+
+    /**
+     * @brief 文档视图
+     */
+    const DocumentView *m_view;
+
+    /**
+     * @brief 归一化的选择起点
+     */
+    Selection::Position m_start;
+
+    /**
+     * @brief 归一化的选择终点
+     */
+    Selection::Position m_end;
+
+    /**
+     * @brief 选择是否为空
+     */
+    bool m_empty;
+
+    /**
+     * @brief 覆盖范围
+     */
+    QRectF m_extent;
+
+    /**
+     * @brief 段落结束处的高亮宽度（表示换行符被选中）
+     */
+    static constexpr qreal PARAGRAPH_END_WIDTH = 4.0;
+};
+
+#endif // SELECTIONITEM_H
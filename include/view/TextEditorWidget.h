@@ -17,6 +17,9 @@
 #include <QMouseEvent>
 #include <QKeyEvent>
 #include <QInputMethodEvent>
+#include <QFocusEvent>
+#include <QShowEvent>
+#include <QHideEvent>
 #include <QVariant>
 #include <QStatusBar>
 #include <QLabel>
@@ -87,6 +90,12 @@ public:
      * 重做上一步撤销的操作
      */
     void redo();
+
+    /**
+     * @brief 获取文档控制器
+     * @return 文档控制器
+     */
+    DocumentController *documentController() const;
     
     /**
      * @brief 更新状态栏
@@ -119,6 +128,37 @@ protected:
      * @return 查询结果
      */
     QVariant inputMethodQuery(Qt::InputMethodQuery query) const override;
+
+    /**
+     * @brief 获得焦点事件处理（恢复光标闪烁）
+     * @param event 焦点事件
+     */
+    void focusInEvent(QFocusEvent *event) override;
+
+    /**
+     * @brief 失去焦点事件处理（暂停光标闪烁）
+     * @param event 焦点事件
+     */
+    void focusOutEvent(QFocusEvent *event) override;
+
+    /**
+     * @brief 显示事件处理
+     * @param event 显示事件
+     */
+    void showEvent(QShowEvent *event) override;
+
+    /**
+     * @brief 隐藏事件处理（窗口最小化或被隐藏时暂停光标闪烁）
+     * @param event 隐藏事件
+     */
+    void hideEvent(QHideEvent *event) override;
+
+    /**
+     * @brief 焦点切换处理（Tab留给编辑器，用于在公式的矩阵单元格之间跳转）
+     * @param next 是否切换到下一个部件
+     * @return 是否已切换焦点
+     */
+    bool focusNextPrevChild(bool next) override;
     
 private slots:
     /**
@@ -132,6 +172,12 @@ private slots:
      * 当文档发生变化时调用
      */
     void onDocumentChanged();
+
+    /**
+     * @brief 命令补全候选变化槽
+     * @param completions 补全候选
+     */
+    void onCompletionsChanged(const QVector<SymbolCompletion> &completions);
     
 private:
     /**
@@ -0,0 +1,241 @@
+// ============================================================================
+// TextLayoutEngine.h
+// 文本排版引擎类的头文件
+// 在后台线程池中对段落进行文本整形，并将结果交回GUI线程提交
+// ============================================================================
+
+#ifndef TEXTLAYOUTENGINE_H
+#define TEXTLAYOUTENGINE_H
+
+#include <QObject>
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QFont>
+#include <QGlyphRun>
+#include <QTextLayout>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+class QThreadPool;
+class PlotObject;
+
+/**
+ * @struct InlineObject
+ * @brief 段落中的内联对象（公式、交叉引用或函数图像）
+ *
+ * 对象在段落文本中占一个对象替换字符，排版时为其预留给定宽度。
+ */
+struct InlineObject
+{
+    /**
+     * @enum Kind
+     * @brief 对象类型
+     */
+    enum Kind
+    {
+        Formula,    ///< 公式
+        Reference,  ///< 交叉引用
+        Plot        ///< 函数图像
+    };
+
+    /**
+     * @brief 对象类型
+     */
+    Kind kind = Formula;
+
+    /**
+     * @brief 对象在段落中的字符位置
+     */
+    int position = 0;
+
+    /**
+     * @brief 对象宽度
+     */
+    qreal width = 0;
+
+    /**
+     * @brief 对象在基线以上的高度，排版时行高随之增加
+     */
+    qreal ascent = 0;
+
+    /**
+     * @brief 对象在基线以下的深度
+     */
+    qreal descent = 0;
+
+    /**
+     * @brief 交叉引用所指公式的标签，其他类型为空
+     */
+    QString reference;
+
+    /**
+     * @brief 函数图像对象，其他类型为空（工作线程只传递指针，不访问对象）
+     */
+    QSharedPointer<PlotObject> plot;
+};
+
+/**
+ * @struct ParagraphLayout
+ * @brief 段落排版结果
+ *
+ * 保存一个段落整形后的字形序列及其尺寸。
+ * 由工作线程生成，在GUI线程中只需拷贝即可提交（隐式共享）。
+ */
+struct ParagraphLayout
+{
+    /**
+     * @brief 字形序列（坐标相对于段落左上角）
+     */
+    QList<QGlyphRun> glyphRuns;
+
+    /**
+     * @brief 各光标位置的X坐标（下标为段落内位置，共length + 1项）
+     * 在工作线程中一次算好，光标定位、点击测试和选择绘制都直接查表
+     */
+    QVector<qreal> caretPositions;
+
+    /**
+     * @brief 段落自然宽度
+     */
+    qreal width = 0;
+
+    /**
+     * @brief 段落行高（文本行高与内联对象所需高度中的较大者）
+     */
+    qreal height = 0;
+
+    /**
+     * @brief 基线到行顶部的距离
+     */
+    qreal ascent = 0;
+
+    /**
+     * @brief 段落中的内联对象（与排版请求中的顺序一致）
+     */
+    QVector<InlineObject> objects;
+
+    /**
+     * @brief 排版所依据的段落内容戳，提交时用于识别结果所属的段落及其是否过期
+     */
+    quint64 stamp = 0;
+};
+
+/**
+ * @class TextLayoutEngine
+ * @brief 文本排版引擎类
+ *
+ * 从不可变的段落文本快照出发，在线程池中分批整形段落（QTextLayout是可重入的），
+ * 文本Run的格式（粗体、斜体等）随快照一起传入，整形时应用到对应的字符区间，
+ * 每批完成后通过排队调用回到GUI线程，发出layoutsReady信号供视图提交。
+ * 每个段落快照都带有内容戳，视图只提交内容戳仍然有效的结果，
+ * 因此多个请求可以并行进行，并发编辑后不会提交过期排版。
+ * cancel()会递增版本号，未完成的任务在工作线程中提前终止，到达GUI线程时也会被丢弃。
+ */
+class TextLayoutEngine : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    TextLayoutEngine(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数
+     * 取消所有未完成的任务并等待工作线程退出
+     */
+    ~TextLayoutEngine();
+
+    /**
+     * @brief 请求排版
+     * @param texts 段落文本快照（从first开始的连续段落）
+     * @param stamps 每个段落快照对应的内容戳
+     * @param objects 每个段落的内联对象（可以为空，表示所有段落都没有内联对象）
+     * @param formats 每个段落中文本Run的格式区间（可以为空，表示所有段落都使用默认格式）
+     * @param font 排版字体
+     * @param first 快照中第一个段落的索引
+     * @param priorityParagraph 优先排版的段落索引（通常为可见区域的首段）
+     */
+    void requestLayout(const QVector<QString> &texts, const QVector<quint64> &stamps,
+                       const QVector<QVector<InlineObject>> &objects,
+                       const QVector<QVector<QTextLayout::FormatRange>> &formats,
+                       const QFont &font, int first = 0, int priorityParagraph = 0);
+
+    /**
+     * @brief 取消所有尚未提交的排版请求
+     */
+    void cancel();
+
+    /**
+     * @brief 获取当前版本号
+     * @return 版本号
+     */
+    int version() const;
+
+    /**
+     * @brief 检查是否还有未提交的批次
+     * @return 是否忙碌
+     */
+    bool isBusy() const;
+
+    /**
+     * @brief 同步整形单个段落（可在任意线程调用）
+     * @param text 段落文本
+     * @param font 排版字体
+     * @param objects 段落中的内联对象，排版时为其预留宽度且不绘制占位字符
+     * @param formats 文本Run的格式区间（不与内联对象重叠）
+     * @return 排版结果
+     */
+    static ParagraphLayout shapeParagraph(const QString &text, const QFont &font,
+                                          const QVector<InlineObject> &objects = QVector<InlineObject>(),
+                                          const QVector<QTextLayout::FormatRange> &formats =
+                                              QVector<QTextLayout::FormatRange>());
+
+signals:
+    /**
+     * @brief 一批段落排版完成的信号
+     * @param first 第一个段落的索引
+     * @param layouts 排版结果
+     */
+    void layoutsReady(int first, const QVector<ParagraphLayout> &layouts);
+
+    /**
+     * @brief 当前版本的所有批次均已提交的信号
+     */
+    void layoutFinished();
+
+private:
+    /**
+     * @brief 在GUI线程中提交一批结果
+     * @param version 结果对应的版本号
+     * @param first 第一个段落的索引
+     * @param layouts 排版结果
+     */
+    void commitBatch(int version, int first, const QVector<ParagraphLayout> &layouts);
+
+    friend class LayoutTask;
+
+    /**
+     * @brief 工作线程池
+     */
+    QThreadPool *m_pool;
+
+    /**
+     * @brief 当前版本号（工作线程读取以便提前终止过期任务）
+     */
+    QAtomicInt m_version;
+
+    /**
+     * @brief 当前版本尚未提交的批次数
+     */
+    int m_pendingBatches;
+
+    /**
+     * @brief 每批整形的段落数
+     */
+    static const int BATCH_SIZE = 256;
+};
+
+#endif // TEXTLAYOUTENGINE_H
@@ -0,0 +1,249 @@
+// ============================================================================
+// TileCache.h
+// 瓦片缓存类的头文件
+// 将文档内容光栅化为固定大小的瓦片，滚动时直接贴图
+// ============================================================================
+
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QRectF>
+#include <QPoint>
+#include <QRect>
+#include <QSet>
+#include <QVector>
+#include <QList>
+#include <QGlyphRun>
+
+/**
+ * @struct TileParagraph
+ * @brief 光栅化一个瓦片所需的段落快照
+ *
+ * 只包含绘制所需的数据（隐式共享的字形序列和位置），与段落图形项无关。
+ */
+struct TileParagraph
+{
+    /**
+     * @brief 段落左上角的场景坐标
+     */
+    QPointF position;
+
+    /**
+     * @brief 字形序列（坐标相对于段落左上角）
+     */
+    QList<QGlyphRun> glyphRuns;
+
+    /**
+     * @brief 裁剪宽度（负数表示不裁剪）
+     */
+    qreal clipWidth = -1;
+
+    /**
+     * @brief 段落行高
+     */
+    qreal height = 0;
+};
+
+/**
+ * @class TileCache
+ * @brief 瓦片缓存类
+ *
+ * 场景被划分为边长固定的正方形瓦片，每个瓦片按设备像素比光栅化为一张QImage。
+ * 瓦片保存在按字节预算限制的LRU缓存中，超出预算时淘汰最久未使用的瓦片。
+ * 段落变化时只作废与其重叠的瓦片，滚动时视图只需贴图。
+ * 被作废的瓦片记为脏瓦片：它们因编辑而失效，视图同步重绘以免编辑结果滞后一帧；
+ * 其余缺失的瓦片（滚动新露出的区域）交给TileRenderer在后台绘制。
+ */
+class TileCache : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    TileCache(QObject *parent = nullptr);
+
+    /**
+     * @brief 获取瓦片边长（场景坐标）
+     * @return 瓦片边长
+     */
+    int tileSize() const;
+
+    /**
+     * @brief 设置字节预算
+     * @param bytes 所有缓存瓦片占用的最大字节数
+     */
+    void setByteBudget(qint64 bytes);
+
+    /**
+     * @brief 获取字节预算
+     * @return 字节预算
+     */
+    qint64 byteBudget() const;
+
+    /**
+     * @brief 获取当前缓存占用的字节数
+     * @return 字节数
+     */
+    qint64 byteCount() const;
+
+    /**
+     * @brief 设置光栅化比例（设备像素比与视图缩放的乘积）
+     * 比例变化时清空缓存
+     * @param ratio 光栅化比例
+     */
+    void setDevicePixelRatio(qreal ratio);
+
+    /**
+     * @brief 获取光栅化比例
+     * @return 光栅化比例
+     */
+    qreal devicePixelRatio() const;
+
+    /**
+     * @brief 获取瓦片的场景矩形
+     * @param tile 瓦片坐标
+     * @return 场景矩形
+     */
+    QRectF tileRect(const QPoint &tile) const;
+
+    /**
+     * @brief 获取与矩形相交的瓦片坐标范围
+     * @param rect 场景矩形
+     * @return 瓦片坐标范围
+     */
+    QRect tileRange(const QRectF &rect) const;
+
+    /**
+     * @brief 获取与矩形相交的所有瓦片
+     * @param rect 场景矩形
+     * @return 瓦片坐标列表
+     */
+    QVector<QPoint> tilesIntersecting(const QRectF &rect) const;
+
+    /**
+     * @brief 查找瓦片（命中时更新LRU顺序）
+     * @param tile 瓦片坐标
+     * @return 瓦片图像，未缓存时返回nullptr
+     */
+    const QImage *tile(const QPoint &tile);
+
+    /**
+     * @brief 缓存瓦片
+     * @param tile 瓦片坐标
+     * @param image 瓦片图像
+     */
+    void insert(const QPoint &tile, const QImage &image);
+
+    /**
+     * @brief 作废与矩形重叠的瓦片
+     * @param rect 场景矩形
+     */
+    void invalidate(const QRectF &rect);
+
+    /**
+     * @brief 作废场景Y坐标以下的所有瓦片（段落整体移动时使用）
+     * @param y 场景Y坐标
+     */
+    void invalidateFrom(qreal y);
+
+    /**
+     * @brief 清空缓存
+     */
+    void clear();
+
+    /**
+     * @brief 检查瓦片是否因内容变化而被作废且尚未重新缓存
+     * @param tile 瓦片坐标
+     * @return 是否为脏瓦片
+     */
+    bool isDirty(const QPoint &tile) const;
+
+    /**
+     * @brief 清除脏瓦片记录（滚动后缺失的瓦片都按新露出的区域处理）
+     */
+    void clearDirtyTiles();
+
+    /**
+     * @brief 获取命中次数
+     * @return 命中次数
+     */
+    int hitCount() const;
+
+    /**
+     * @brief 获取未命中次数
+     * @return 未命中次数
+     */
+    int missCount() const;
+
+    /**
+     * @brief 光栅化一个瓦片（只读取快照，可在任意线程调用）
+     * @param rect 瓦片的场景矩形
+     * @param ratio 光栅化比例
+     * @param paragraphs 与瓦片相交的段落快照
+     * @return 瓦片图像（透明背景）
+     */
+    static QImage rasterize(const QRectF &rect, qreal ratio, const QVector<TileParagraph> &paragraphs);
+
+    /**
+     * @brief 瓦片坐标转换为缓存键
+     * @param tile 瓦片坐标
+     * @return 缓存键
+     */
+    static quint64 key(const QPoint &tile);
+
+    /**
+     * @brief 缓存键转换为瓦片坐标
+     * @param key 缓存键
+     * @return 瓦片坐标
+     */
+    static QPoint tileFromKey(quint64 key);
+
+private:
+    /**
+     * @brief 移除缓存的瓦片并记为脏瓦片
+     * @param key 缓存键
+     */
+    void invalidateKey(quint64 key);
+
+    /**
+     * @brief 瓦片缓存（代价以KB计，避免超出int范围）
+     */
+    QCache<quint64, QImage> m_tiles;
+
+    /**
+     * @brief 脏瓦片（按缓存键）
+     */
+    QSet<quint64> m_dirtyTiles;
+
+    /**
+     * @brief 光栅化比例
+     */
+    qreal m_ratio;
+
+    /**
+     * @brief 命中次数
+     */
+    int m_hits;
+
+    /**
+     * @brief 未命中次数
+     */
+    int m_misses;
+
+    /**
+     * @brief 瓦片边长（场景坐标）
+     */
+    static const int TILE_SIZE = 256;
+
+    /**
+     * @brief 默认字节预算（64MB）
+     */
+    static const qint64 DEFAULT_BYTE_BUDGET = 64 * 1024 * 1024;
+};
+
+#endif // TILECACHE_H
@@ -0,0 +1,144 @@
+// ============================================================================
+// TileRenderer.h
+// 瓦片渲染器类的头文件
+// 在后台线程池中并行光栅化瓦片，并将结果交回GUI线程合成
+// ============================================================================
+
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+
+#include "view/TileCache.h"
+#include <QObject>
+#include <QHash>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QImage>
+#include <QPoint>
+#include <QRectF>
+#include <QVector>
+
+class QThreadPool;
+
+/**
+ * @class TileRenderer
+ * @brief 瓦片渲染器类
+ *
+ * 每个瓦片由一个任务在工作线程中绘制到独立的QImage上（每张图像只被一个线程使用）。
+ * 距离视口中心越近的瓦片优先级越高；滚出视口或内容已变化的瓦片可被取消，
+ * 尚未开始的任务直接跳过，已完成的过期结果到达GUI线程时被丢弃。
+ */
+class TileRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    TileRenderer(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数
+     * 取消所有未完成的任务并等待工作线程退出
+     */
+    ~TileRenderer();
+
+    /**
+     * @brief 请求光栅化一个瓦片
+     * @param tile 瓦片坐标
+     * @param rect 瓦片的场景矩形
+     * @param ratio 光栅化比例
+     * @param paragraphs 与瓦片相交的段落快照
+     * @param priority 优先级（越大越先执行）
+     */
+    void request(const QPoint &tile, const QRectF &rect, qreal ratio,
+                 const QVector<TileParagraph> &paragraphs, int priority);
+
+    /**
+     * @brief 检查瓦片是否正在等待光栅化
+     * @param tile 瓦片坐标
+     * @return 是否等待中
+     */
+    bool isPending(const QPoint &tile) const;
+
+    /**
+     * @brief 取消与矩形相交的等待中瓦片（内容变化时使用）
+     * @param rect 场景矩形
+     */
+    void cancelIntersecting(const QRectF &rect);
+
+    /**
+     * @brief 取消不在指定瓦片范围内的等待中瓦片（滚出视口时使用）
+     * @param tiles 保留的瓦片坐标范围
+     */
+    void cancelOutside(const QRect &tiles);
+
+    /**
+     * @brief 取消所有等待中的瓦片
+     */
+    void cancelAll();
+
+    /**
+     * @brief 获取等待中的瓦片数量
+     * @return 瓦片数量
+     */
+    int pendingCount() const;
+
+signals:
+    /**
+     * @brief 瓦片光栅化完成的信号
+     * @param tile 瓦片坐标
+     * @param image 瓦片图像
+     */
+    void tileReady(const QPoint &tile, const QImage &image);
+
+private:
+    /**
+     * @brief 在GUI线程中提交一个瓦片
+     * @param tile 瓦片坐标
+     * @param id 请求编号
+     * @param image 瓦片图像
+     */
+    void commitTile(const QPoint &tile, quint64 id, const QImage &image);
+
+    friend class TileTask;
+
+    /**
+     * @struct PendingTile
+     * @brief 等待中的瓦片请求
+     */
+    struct PendingTile
+    {
+        /**
+         * @brief 请求编号（同一瓦片重新请求后，旧结果据此被丢弃）
+         */
+        quint64 id;
+
+        /**
+         * @brief 瓦片的场景矩形
+         */
+        QRectF rect;
+
+        /**
+         * @brief 取消标志（与工作线程共享）
+         */
+        QSharedPointer<QAtomicInt> cancelled;
+    };
+
+    /**
+     * @brief 工作线程池
+     */
+    QThreadPool *m_pool;
+
+    /**
+     * @brief 等待中的瓦片（按TileCache::key索引）
+     */
+    QHash<quint64, PendingTile> m_pending;
+
+    /**
+     * @brief 下一个请求编号
+     */
+    quint64 m_nextId;
+};
+
+#endif // TILERENDERER_H
@@ -96,6 +96,17 @@ int main(int argc, char *argv[])
     
     // 连接信号槽
     QObject::connect(exitAction, &QAction::triggered, &a, &QApplication::quit);
+    QObject::connect(undoAction, &QAction::triggered, editorWidget, &TextEditorWidget::undo);
+    QObject::connect(redoAction, &QAction::triggered, editorWidget, &TextEditorWidget::redo);
+    
+    // 撤销栈变化时更新撤销、重做菜单项的可用状态
+    DocumentController *documentController = editorWidget->documentController();
+    auto updateUndoActions = [undoAction, redoAction, documentController]() {
+        undoAction->setEnabled(documentController->canUndo());
+        redoAction->setEnabled(documentController->canRedo());
+    };
+    QObject::connect(documentController, &DocumentController::undoStateChanged, updateUndoActions);
+    updateUndoActions();
     
     // 连接鼠标位置更新信号
     QObject::connect(editorWidget->documentView(), &DocumentView::mousePositionChanged, 
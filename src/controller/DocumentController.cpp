@@ -12,7 +12,8 @@
  */
 DocumentController::DocumentController(QObject *parent)
     : QObject(parent),
-      m_document(nullptr)
+      m_document(nullptr),
+      m_editDepth(0)
 {
 }
 
@@ -22,7 +23,15 @@ DocumentController::DocumentController(QObject *parent)
  */
 void DocumentController::setDocument(Document *document)
 {
+    // 未提交的事务随原文档一起放弃
+    if (m_document && m_editDepth > 0)
+        m_document->setChangeLog(nullptr);
+    m_editDepth = 0;
+    m_pendingCommand = EditCommand();
     m_document = document;
+    // 撤销栈中的增量只对原文档有效
+    m_undoStack.clear();
+    emit undoStateChanged();
 }
 
 /**
@@ -43,8 +52,11 @@ void DocumentController::insertText(const Selection::Position &position, const Q
 {
     if (m_document)
     {
+        beginEdit(position);
         m_document->insertText(position.paragraph, position.position, text, Format());
-        emit documentChanged();
+        Selection::Position after = position;
+        after.position += text.length();
+        endEdit(after, EditCommand::Typing, text);
     }
 }
 
@@ -58,6 +70,8 @@ void DocumentController::deleteText(const Selection &selection)
     {
         Selection::Position start = selection.normalizedStart();
         Selection::Position end = selection.normalizedEnd();
+        // 与replaceText一致，反向选择也以规范化的末端作为编辑前的光标位置
+        beginEdit(end);
         
         if (start.paragraph == end.paragraph)
         {
@@ -73,11 +87,8 @@ void DocumentController::deleteText(const Selection &selection)
             int startLength = startPara.length() - start.position;
             m_document->removeText(start.paragraph, start.position, startLength);
             
-            // 2. 删除中间的整个段落
-            for (int i = start.paragraph + 1; i < end.paragraph; i++)
-            {
-                m_document->removeParagraph(start.paragraph + 1);
-            }
+            // 2. 一次删除中间的整个段落，段落列表只移动一次尾部
+            m_document->removeParagraphs(start.paragraph + 1, end.paragraph - start.paragraph - 1);
             
             // 3. 删除结束段落中从开头到end.position的文本
             m_document->removeText(start.paragraph + 1, 0, end.position);
@@ -85,7 +96,8 @@ void DocumentController::deleteText(const Selection &selection)
             // 4. 合并起始段落和结束段落
             mergeParagraphs(start.paragraph);
         }
-        emit documentChanged();
+        // 以上各步的区间在变化记录中合并为一处，结束时只通知一次
+        endEdit(start);
     }
 }
 
@@ -98,23 +110,128 @@ void DocumentController::replaceText(const Selection &selection, const QString &
 {
     if (m_document)
     {
+        // 删除和插入嵌套在同一个编辑操作中，撤销时一步恢复
+        // 反向选择（从后往前拖动）的start()在end()之后，统一按规范化的两端处理
+        Selection::Position start = selection.normalizedStart();
+        beginEdit(selection.normalizedEnd());
         deleteText(selection);
-        insertText(selection.start(), text);
-        emit documentChanged();
+        insertText(start, text);
+        Selection::Position after = start;
+        after.position += text.length();
+        endEdit(after);
+    }
+}
+
+/**
+ * @brief 在指定位置插入公式
+ * @param position 插入位置
+ * @param formula 公式对象
+ */
+void DocumentController::insertFormula(const Selection::Position &position, const QSharedPointer<MathObject> &formula)
+{
+    if (m_document && formula)
+    {
+        beginEdit(position);
+        m_document->insertFormula(position.paragraph, position.position, formula, Format());
+        endEdit(position);
+    }
+}
+
+/**
+ * @brief 在指定位置插入交叉引用
+ * @param position 插入位置
+ * @param label 所引用公式的标签
+ */
+void DocumentController::insertReference(const Selection::Position &position, const QString &label)
+{
+    if (m_document && !label.isEmpty())
+    {
+        beginEdit(position);
+        m_document->insertReference(position.paragraph, position.position, label, Format());
+        Selection::Position after = position;
+        after.position++;
+        endEdit(after);
+    }
+}
+
+/**
+ * @brief 在指定位置插入函数图像
+ * @param position 插入位置
+ * @param plot 函数图像对象
+ */
+void DocumentController::insertPlot(const Selection::Position &position, const QSharedPointer<PlotObject> &plot)
+{
+    if (m_document && plot)
+    {
+        beginEdit(position);
+        m_document->insertPlot(position.paragraph, position.position, plot, Format());
+        Selection::Position after = position;
+        after.position++;
+        endEdit(after);
     }
 }
 
+/**
+ * @brief 设置公式是否带编号及其标签
+ * @param position 公式所在位置
+ * @param numbered 是否带编号
+ * @param label 标签
+ */
+void DocumentController::setEquationNumbered(const Selection::Position &position, bool numbered, const QString &label)
+{
+    if (m_document && position.paragraph >= 0 && position.paragraph < m_document->paragraphCount())
+    {
+        QSharedPointer<MathObject> formula = m_document->paragraph(position.paragraph).formulaAt(position.position);
+        if (!formula)
+            return;
+        FormulaChange change;
+        change.formula = formula;
+        change.numberedBefore = formula->isNumbered();
+        change.labelBefore = formula->label();
+        m_document->setEquationNumbered(position.paragraph, position.position, numbered, label);
+        change.numberedAfter = formula->isNumbered();
+        change.labelAfter = formula->label();
+        // 光标停在公式之前
+        Selection::Position cursor = {position.paragraph, position.position};
+        recordFormulaChange(cursor, change, cursor);
+    }
+}
+
+/**
+ * @brief 通知公式的表达式树已被直接编辑
+ * @param position 编辑前的光标位置
+ * @param edits 表达式树的区间替换
+ * @param cursor 编辑后的光标位置
+ * @param text 输入的文本
+ */
+void DocumentController::updateFormula(const Selection::Position &position, const QVector<MathEdit> &edits,
+                                       const Selection::Position &cursor, const QString &text)
+{
+    if (!m_document || edits.isEmpty() || position.paragraph < 0 || position.paragraph >= m_document->paragraphCount())
+        return;
+    FormulaChange change;
+    change.formula = m_document->paragraph(position.paragraph).formulaAt(position.position);
+    if (!change.formula)
+        return;
+    change.edits = edits;
+    change.numberedBefore = change.numberedAfter = change.formula->isNumbered();
+    change.labelBefore = change.labelAfter = change.formula->label();
+    recordFormulaChange(position, change, cursor, text);
+}
+
 /**
  * @brief 在指定位置插入段落
  * @param paragraphIndex 插入位置
  */
 void DocumentController::insertParagraph(int paragraphIndex)
 {
-    if (m_document)
+    if (m_document && paragraphIndex >= 0 && paragraphIndex <= m_document->paragraphCount())
     {
         Paragraph newParagraph;
+        Selection::Position position = {paragraphIndex, 0};
+        beginEdit(position);
         m_document->insertParagraph(paragraphIndex, newParagraph);
-        emit documentChanged();
+        endEdit(position);
     }
 }
 
@@ -124,10 +241,26 @@ void DocumentController::insertParagraph(int paragraphIndex)
  */
 void DocumentController::deleteParagraph(int paragraphIndex)
 {
-    if (m_document)
+    if (m_document && paragraphIndex >= 0 && paragraphIndex < m_document->paragraphCount())
     {
+        Selection::Position position = {paragraphIndex, 0};
+        beginEdit(position);
         m_document->removeParagraph(paragraphIndex);
-        emit documentChanged();
+        endEdit(position);
+    }
+}
+
+/**
+ * @brief 在指定位置拆分段落
+ * @param position 拆分位置
+ */
+void DocumentController::splitParagraph(const Selection::Position &position)
+{
+    if (m_document && position.paragraph >= 0 && position.paragraph < m_document->paragraphCount())
+    {
+        beginEdit(position);
+        m_document->splitParagraph(position.paragraph, position.position);
+        endEdit({position.paragraph + 1, 0});
     }
 }
 
@@ -137,21 +270,13 @@ void DocumentController::deleteParagraph(int paragraphIndex)
  */
 void DocumentController::mergeParagraphs(int paragraphIndex)
 {
-    if (m_document && paragraphIndex < m_document->paragraphCount() - 1)
+    if (m_document && paragraphIndex >= 0 && paragraphIndex < m_document->paragraphCount() - 1)
     {
-        // 获取两个段落的文本
-        Paragraph para1 = m_document->paragraph(paragraphIndex);
-        Paragraph para2 = m_document->paragraph(paragraphIndex + 1);
-        QString text1 = para1.text();
-        QString text2 = para2.text();
-        
-        // 合并文本
-        QString mergedText = text1 + text2;
-        
-        // 更新第一个段落
-        para1.setText(mergedText);
-        m_document->removeParagraph(paragraphIndex + 1);
-        emit documentChanged();
+        // 光标停在原段落末尾，即两段的衔接处
+        int length = m_document->paragraph(paragraphIndex).length();
+        beginEdit({paragraphIndex + 1, 0});
+        m_document->mergeParagraphs(paragraphIndex);
+        endEdit({paragraphIndex, length});
     }
 }
 
@@ -162,6 +287,264 @@ void DocumentController::mergeParagraphs(int paragraphIndex)
  */
 void DocumentController::applyFormat(const Selection &selection, const Format &format)
 {
-    // 实现格式应用功能
-    // 这里可以添加具体的格式应用逻辑
+    if (m_document && !selection.isEmpty())
+    {
+        Selection::Position start = selection.normalizedStart();
+        Selection::Position end = selection.normalizedEnd();
+        // 区间内的Run都复制同一个格式对象，字体数据隐式共享；整个选择记录为一处变化，只通知一次
+        beginEdit(end);
+        m_document->applyFormat(start.paragraph, start.position, end.paragraph, end.position, format);
+        endEdit(end);
+    }
+}
+
+/**
+ * @brief 开始一个批量编辑事务
+ * @param cursor 事务开始前的光标位置
+ */
+void DocumentController::beginTransaction(const Selection::Position &cursor)
+{
+    if (m_document)
+        beginEdit(cursor);
+}
+
+/**
+ * @brief 提交批量编辑事务
+ * @param cursor 事务结束后的光标位置
+ */
+void DocumentController::commitTransaction(const Selection::Position &cursor)
+{
+    if (m_document && m_editDepth > 0)
+        endEdit(cursor);
+}
+
+/**
+ * @brief 检查是否处于编辑事务中
+ * @return 是否处于编辑事务中
+ */
+bool DocumentController::inTransaction() const
+{
+    return m_editDepth > 0;
+}
+
+/**
+ * @brief 撤销一步
+ * @return 撤销后的光标位置
+ */
+Selection::Position DocumentController::undo()
+{
+    const EditCommand *command = m_editDepth == 0 ? m_undoStack.undo(m_document) : nullptr;
+    if (!command)
+        return {-1, -1};
+    // 撤销按相反顺序恢复各处区间，视图按同样的顺序增删段落项
+    emit paragraphsChanged(splices(*command, true));
+    Selection::Position position = clampedPosition(command->cursorBefore);
+    emit documentChanged();
+    emit undoStateChanged();
+    return position;
+}
+
+/**
+ * @brief 重做一步
+ * @return 重做后的光标位置
+ */
+Selection::Position DocumentController::redo()
+{
+    const EditCommand *command = m_editDepth == 0 ? m_undoStack.redo(m_document) : nullptr;
+    if (!command)
+        return {-1, -1};
+    emit paragraphsChanged(splices(*command, false));
+    Selection::Position position = clampedPosition(command->cursorAfter);
+    emit documentChanged();
+    emit undoStateChanged();
+    return position;
+}
+
+/**
+ * @brief 检查是否可以撤销
+ * @return 是否可以撤销
+ */
+bool DocumentController::canUndo() const
+{
+    return m_undoStack.canUndo();
+}
+
+/**
+ * @brief 检查是否可以重做
+ * @return 是否可以重做
+ */
+bool DocumentController::canRedo() const
+{
+    return m_undoStack.canRedo();
+}
+
+/**
+ * @brief 获取撤销栈
+ * @return 撤销栈
+ */
+UndoStack *DocumentController::undoStack()
+{
+    return &m_undoStack;
+}
+
+/**
+ * @brief 开始一个编辑操作
+ * @param cursor 编辑前的光标位置
+ */
+void DocumentController::beginEdit(const Selection::Position &cursor)
+{
+    if (m_editDepth++ == 0)
+    {
+        m_pendingCommand = EditCommand();
+        m_document->setChangeLog(&m_pendingCommand.changes);
+    }
+    // 事务未给出光标位置时取其中第一个编辑操作的位置
+    if (m_pendingCommand.cursorBefore.paragraph < 0)
+        m_pendingCommand.cursorBefore = cursor;
+}
+
+/**
+ * @brief 结束一个编辑操作
+ * @param cursor 编辑后的光标位置
+ * @param kind 步骤类型
+ * @param text 输入的文本
+ */
+void DocumentController::endEdit(const Selection::Position &cursor, EditCommand::Kind kind, const QString &text)
+{
+    if (cursor.paragraph >= 0)
+        m_pendingCommand.cursorAfter = cursor;
+    if (--m_editDepth > 0)
+        return;
+    m_document->setChangeLog(nullptr);
+    m_pendingCommand.kind = kind;
+    m_pendingCommand.text = text;
+    EditCommand command = m_pendingCommand;
+    m_pendingCommand = EditCommand();
+    if (command.changes.isEmpty())
+        return;
+
+    // 记录中的区间已按执行顺序合并，与重做一样一次通知全部区间，视图按同样的顺序增删段落项
+    m_undoStack.push(command);
+    emit paragraphsChanged(splices(command, false));
+    emit documentChanged();
+    emit undoStateChanged();
+}
+
+/**
+ * @brief 通知一个段落在原处被修改
+ * @param paragraphIndex 段落索引
+ */
+void DocumentController::paragraphTouched(int paragraphIndex)
+{
+    if (m_editDepth > 0)
+    {
+        m_document->markParagraphChanged(paragraphIndex);
+        return;
+    }
+    ParagraphSplice change;
+    change.first = paragraphIndex;
+    change.removed = 1;
+    change.inserted = 1;
+    emit paragraphsChanged({change});
+    emit documentChanged();
+}
+
+/**
+ * @brief 把公式的原处修改记为一处变化
+ * @param position 编辑前的光标位置
+ * @param change 公式的修改
+ * @param cursor 编辑后的光标位置
+ * @param text 输入的文本
+ */
+void DocumentController::recordFormulaChange(const Selection::Position &position, const FormulaChange &change,
+                                             const Selection::Position &cursor, const QString &text)
+{
+    if (change.edits.isEmpty() && change.numberedBefore == change.numberedAfter &&
+        change.labelBefore == change.labelAfter)
+    {
+        paragraphTouched(position.paragraph);
+        return;
+    }
+
+    // 段落文本不变（公式只占一个替换字符），段落区间记为前后相同的替换，用于通知视图重新排版；
+    // 撤销重做在原处替换表达式树的节点，公式内部的光标位置仍然有效
+    beginEdit(position);
+    m_pendingCommand.formulas.append(change);
+    m_document->markParagraphChanged(position.paragraph);
+    endEdit(cursor, text.isEmpty() ? EditCommand::Edit : EditCommand::Typing, text);
+}
+
+/**
+ * @brief 获取一个步骤的段落区间替换在应用时的位置和段落数
+ * @param command 编辑步骤
+ * @param undo 是否为撤销
+ * @return 段落区间替换
+ */
+QVector<ParagraphSplice> DocumentController::splices(const EditCommand &command, bool undo)
+{
+    QVector<ParagraphSplice> result;
+    result.reserve(command.changes.size());
+    for (int i = 0; i < command.changes.size(); i++)
+    {
+        const ParagraphChange &change = command.changes.at(undo ? command.changes.size() - 1 - i : i);
+        ParagraphSplice splice;
+        splice.first = change.first;
+        splice.removed = undo ? change.after.size() : change.before.size();
+        splice.inserted = undo ? change.before.size() : change.after.size();
+        result.append(splice);
+    }
+    return result;
+}
+
+/**
+ * @brief 把光标位置限制在文档范围内
+ * @param position 光标位置
+ * @return 有效的光标位置
+ */
+Selection::Position DocumentController::clampedPosition(const Selection::Position &position) const
+{
+    Selection::Position result = {0, 0};
+    if (!m_document || m_document->paragraphCount() == 0)
+        return result;
+    result.paragraph = qBound(0, position.paragraph, m_document->paragraphCount() - 1);
+    result.position = qBound(0, position.position, m_document->paragraph(result.paragraph).length());
+    // 公式内部的位置在其所在的Row仍然存在时保留
+    if (position.math.isValid() && result.paragraph == position.paragraph && result.position == position.position)
+    {
+        QSharedPointer<MathObject> formula = m_document->paragraph(result.paragraph).formulaAt(result.position);
+        if (formula && position.math.row(formula->root()))
+            result.math = position.math;
+    }
+    return result;
+}
+
+/**
+ * @brief 构造函数，开始事务
+ * @param controller 文档控制器
+ * @param cursor 事务开始前的光标位置
+ */
+EditTransaction::EditTransaction(DocumentController *controller, const Selection::Position &cursor)
+    : m_controller(controller),
+      m_cursor({-1, -1})
+{
+    if (m_controller)
+        m_controller->beginTransaction(cursor);
+}
+
+/**
+ * @brief 析构函数，提交事务
+ */
+EditTransaction::~EditTransaction()
+{
+    if (m_controller)
+        m_controller->commitTransaction(m_cursor);
+}
+
+/**
+ * @brief 设置事务结束后的光标位置
+ * @param cursor 光标位置
+ */
+void EditTransaction::setCursor(const Selection::Position &cursor)
+{
+    m_cursor = cursor;
 }
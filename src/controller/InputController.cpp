@@ -6,6 +6,8 @@
 
 #include "controller/InputController.h"
 #include "view/DocumentView.h"
+#include "core/MathNavigator.h"
+#include "core/MathObject.h"
 #include <QKeyEvent>
 
 /**
@@ -58,23 +60,49 @@ void InputController::handleKeyPress(QKeyEvent *event)
     Selection selection = m_selectionController->selection(); // 实时获取
     
     if (event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter) {
-        // 回车处理...
-        m_documentController->insertParagraph(selection.start().paragraph + 1);
+        // 回车在光标处拆分段落；有选择时先删除选中的文本，两步合为一个撤销步骤
+        Selection::Position at = selection.normalizedStart();
+        if (at.math.isValid()) {
+            // 光标在公式中：在公式之后拆分
+            at = flushMathInput(at);
+            at.position++;
+            at.math = MathPosition();
+        }
+        {
+            EditTransaction transaction(m_documentController, selection.end());
+            if (m_selectionController->hasSelection())
+                m_documentController->deleteText(selection);
+            m_documentController->splitParagraph(at);
+        }
         
-        // 移动光标到新段落
+        // 移动光标到新段落开头
         Selection::Position newPos;
-        newPos.paragraph = selection.start().paragraph + 1;
+        newPos.paragraph = at.paragraph + 1;
         newPos.position = 0;
         Selection newSelection(newPos, newPos);
         m_selectionController->setSelection(newSelection);
+        if (m_documentView) {
+            m_documentView->ensureCursorVisible();
+        }
         event->accept();
     }
     else if (!event->text().isEmpty() && event->text()[0].isPrint()) {
         QString text = event->text();
-        if (m_selectionController->hasSelection()) {
-            m_documentController->replaceText(selection, text);
-            // 新光标位置 = 起始位置 + 文本长度
+        if (selection.start().math.isValid()) {
+            // 公式中：LaTeX快捷输入在光标处增量转换
+            Selection::Position newPos = insertMathText(selection.start(), text);
+            m_selectionController->setSelection(Selection(newPos, newPos));
+        } else if (text == QLatin1String("$") && !m_selectionController->hasSelection()) {
+            // 与TeX一致，$插入一个空公式并进入公式输入
+            QSharedPointer<MathObject> formula(new MathObject());
+            m_documentController->insertFormula(selection.start(), formula);
             Selection::Position newPos = selection.start();
+            newPos.math = MathNavigator::start(formula->root());
+            m_selectionController->setSelection(Selection(newPos, newPos));
+        } else if (m_selectionController->hasSelection()) {
+            m_documentController->replaceText(selection, text);
+            // 新光标位置 = 规范化的起始位置 + 文本长度（反向选择的start()在末端）
+            Selection::Position newPos = selection.normalizedStart();
             newPos.position += text.length();
             m_selectionController->setSelection(Selection(newPos, newPos));
         } else {
@@ -83,8 +111,8 @@ void InputController::handleKeyPress(QKeyEvent *event)
             newPos.position += text.length();
             m_selectionController->setSelection(Selection(newPos, newPos));
         }
+        // 布局由文档变化信号调度，在本事件处理完后合并执行一次
         if (m_documentView) {
-            m_documentView->updateLayout();
             m_documentView->ensureCursorVisible();
         }
         event->accept();
@@ -97,8 +125,8 @@ void InputController::handleKeyPress(QKeyEvent *event)
             // 删除选中的文本
             m_documentController->deleteText(selection);
             
-            // 折叠选择到起始位置
-            Selection newSelection(selection.start(), selection.start());
+            // 折叠选择到规范化的起始位置
+            Selection newSelection(selection.normalizedStart(), selection.normalizedStart());
             m_selectionController->setSelection(newSelection);
         }
         else
@@ -111,12 +139,214 @@ void InputController::handleKeyPress(QKeyEvent *event)
     else if (event->key() == Qt::Key_Left || event->key() == Qt::Key_Right ||
              event->key() == Qt::Key_Up || event->key() == Qt::Key_Down)
     {
-        // 处理方向键，移动光标
-        // 这里可以添加具体的光标移动逻辑
+        // 处理方向键，移动光标（先结束光标处未完成的公式命令）；之后的输入另起一个撤销步骤
+        m_documentController->undoStack()->breakCoalescing();
+        Selection::Position newPos = movedPosition(flushMathInput(selection.start()), event->key());
+        m_selectionController->setSelection(Selection(newPos, newPos));
+        if (m_documentView) {
+            m_documentView->ensureCursorVisible();
+        }
+        event->accept();
+    }
+    else if ((event->key() == Qt::Key_Tab || event->key() == Qt::Key_Backtab) && selection.start().math.isValid())
+    {
+        // 正在输入命令时Tab接受第一个补全候选，否则在矩阵单元格之间跳转
+        Selection::Position newPos = event->key() == Qt::Key_Tab && !m_completions.isEmpty()
+            ? acceptCompletion(selection.start(), 0)
+            : movedPosition(flushMathInput(selection.start()), event->key());
+        m_selectionController->setSelection(Selection(newPos, newPos));
         event->accept();
     }
 }
 
+/**
+ * @brief 计算按方向键或Tab后的光标位置
+ * @param position 当前位置
+ * @param key 按键
+ * @return 新位置
+ */
+Selection::Position InputController::movedPosition(const Selection::Position &position, int key) const
+{
+    Document *document = m_documentController->document();
+    if (!document || position.paragraph < 0 || position.paragraph >= document->paragraphCount())
+        return position;
+
+    Paragraph paragraph = document->paragraph(position.paragraph);
+    Selection::Position result = position;
+
+    // 光标在公式中：在表达式树上移动，只访问当前位置的祖先链
+    if (position.math.isValid()) {
+        QSharedPointer<MathObject> formula = paragraph.formulaAt(position.position);
+        if (formula) {
+            const MathNode *root = formula->root();
+            MathPosition math;
+            switch (key) {
+            case Qt::Key_Left: math = MathNavigator::moveLeft(root, position.math); break;
+            case Qt::Key_Right: math = MathNavigator::moveRight(root, position.math); break;
+            case Qt::Key_Up: math = MathNavigator::moveUp(root, position.math); break;
+            case Qt::Key_Down: math = MathNavigator::moveDown(root, position.math); break;
+            case Qt::Key_Tab: math = MathNavigator::nextCell(root, position.math); break;
+            case Qt::Key_Backtab: math = MathNavigator::previousCell(root, position.math); break;
+            default: break;
+            }
+            if (math.isValid()) {
+                result.math = math;
+                return result;
+            }
+            // 左右越过公式边界时停在公式之前或之后；其余按键没有可去的槽位时不动
+            if (key != Qt::Key_Left && key != Qt::Key_Right)
+                return position;
+            result.math = MathPosition();
+            if (key == Qt::Key_Right)
+                result.position++;
+            return result;
+        }
+        result.math = MathPosition();
+    }
+
+    switch (key) {
+    case Qt::Key_Left:
+        if (result.position > 0) {
+            result.position--;
+            // 从右侧进入公式，停在公式末尾
+            if (QSharedPointer<MathObject> formula = paragraph.formulaAt(result.position))
+                result.math = MathNavigator::end(formula->root());
+        } else if (result.paragraph > 0) {
+            result.paragraph--;
+            result.position = document->paragraph(result.paragraph).length();
+        }
+        break;
+    case Qt::Key_Right:
+        if (result.position < paragraph.length()) {
+            // 从左侧进入公式，停在公式开头
+            if (QSharedPointer<MathObject> formula = paragraph.formulaAt(result.position))
+                result.math = MathNavigator::start(formula->root());
+            else
+                result.position++;
+        } else if (result.paragraph + 1 < document->paragraphCount()) {
+            result.paragraph++;
+            result.position = 0;
+        }
+        break;
+    case Qt::Key_Up:
+    case Qt::Key_Down:
+        result.paragraph = qBound(0, result.paragraph + (key == Qt::Key_Up ? -1 : 1), document->paragraphCount() - 1);
+        result.position = qMin(result.position, document->paragraph(result.paragraph).length());
+        break;
+    default:
+        break;
+    }
+    return result;
+}
+
+/**
+ * @brief 在公式中输入文本
+ * @param position 光标位置
+ * @param text 输入的文本
+ * @return 输入后的光标位置
+ */
+Selection::Position InputController::insertMathText(const Selection::Position &position, const QString &text)
+{
+    Document *document = m_documentController->document();
+    QSharedPointer<MathObject> formula = document ? document->paragraph(position.paragraph).formulaAt(position.position)
+                                                  : QSharedPointer<MathObject>();
+    if (!formula)
+        return position;
+
+    // 每个字符只改动光标处的记号窗口，不重新解析整个公式；撤销只记录被替换的节点
+    QVector<MathEdit> edits;
+    m_mathTokenizer.setEditLog(&edits);
+    Selection::Position result = position;
+    for (QChar character : text) {
+        MathPosition math = m_mathTokenizer.input(formula->root(), result.math, character);
+        if (!math.isValid())
+            break;
+        result.math = math;
+    }
+    m_mathTokenizer.setEditLog(nullptr);
+    m_documentController->updateFormula(position, edits, result, text);
+    updateCompletions();
+    return result;
+}
+
+/**
+ * @brief 结束光标处尚未完成的公式命令
+ * @param position 光标位置
+ * @return 结束后的光标位置
+ */
+Selection::Position InputController::flushMathInput(const Selection::Position &position)
+{
+    if (!position.math.isValid() || !m_mathTokenizer.isPending())
+        return position;
+    Document *document = m_documentController->document();
+    QSharedPointer<MathObject> formula = document ? document->paragraph(position.paragraph).formulaAt(position.position)
+                                                  : QSharedPointer<MathObject>();
+    if (!formula) {
+        m_mathTokenizer.reset();
+        return position;
+    }
+
+    QVector<MathEdit> edits;
+    m_mathTokenizer.setEditLog(&edits);
+    Selection::Position result = position;
+    result.math = m_mathTokenizer.flush(formula->root(), position.math);
+    m_mathTokenizer.setEditLog(nullptr);
+    m_documentController->updateFormula(position, edits, result);
+    updateCompletions();
+    return result;
+}
+
+/**
+ * @brief 接受一个补全候选
+ * @param position 光标位置
+ * @param index 候选的索引
+ * @return 结束后的光标位置
+ */
+Selection::Position InputController::acceptCompletion(const Selection::Position &position, int index)
+{
+    if (index < 0 || index >= m_completions.size())
+        return position;
+    Document *document = m_documentController->document();
+    QSharedPointer<MathObject> formula = document ? document->paragraph(position.paragraph).formulaAt(position.position)
+                                                  : QSharedPointer<MathObject>();
+    if (!formula)
+        return position;
+
+    QVector<MathEdit> edits;
+    m_mathTokenizer.setEditLog(&edits);
+    Selection::Position result = position;
+    result.math = m_mathTokenizer.completeCommand(formula->root(), position.math, m_completions.at(index).name);
+    m_mathTokenizer.setEditLog(nullptr);
+    m_documentController->updateFormula(position, edits, result);
+    updateCompletions();
+    return result;
+}
+
+/**
+ * @brief 按正在输入的命令名更新补全候选
+ */
+void InputController::updateCompletions()
+{
+    // 字典树的前缀和模糊查找只与命令名长度和候选数有关，每次按键都可以直接查询
+    QVector<SymbolCompletion> completions;
+    QString command = m_mathTokenizer.pendingCommand();
+    if (!command.isEmpty())
+        completions = SymbolTrie::shared()->lookup(command, COMPLETION_LIMIT);
+    if (completions.isEmpty() && m_completions.isEmpty())
+        return;
+    m_completions = completions;
+    emit completionsChanged(m_completions);
+}
+
+/**
+ * @brief 获取当前的命令补全候选
+ * @return 补全候选
+ */
+QVector<SymbolCompletion> InputController::completions() const
+{
+    return m_completions;
+}
+
 /**
  * @brief 处理输入法事件
  * @param event 输入法事件
@@ -130,9 +360,12 @@ void InputController::handleInputMethodEvent(QInputMethodEvent *event)
     if (!event->commitString().isEmpty()) {
         QString text = event->commitString();
         // 插入/替换逻辑
-        if (m_selectionController->hasSelection()) {
+        if (selection.start().math.isValid()) {
+            Selection::Position newPos = insertMathText(selection.start(), text);
+            m_selectionController->setSelection(Selection(newPos, newPos));
+        } else if (m_selectionController->hasSelection()) {
             m_documentController->replaceText(selection, text);
-            Selection::Position newPos = selection.start();
+            Selection::Position newPos = selection.normalizedStart();
             newPos.position += text.length();
             m_selectionController->setSelection(Selection(newPos, newPos));
         } else {
@@ -141,8 +374,8 @@ void InputController::handleInputMethodEvent(QInputMethodEvent *event)
             newPos.position += text.length();
             m_selectionController->setSelection(Selection(newPos, newPos));
         }
+        // 布局由文档变化信号调度，在本事件处理完后合并执行一次
         if (m_documentView) {
-            m_documentView->updateLayout();
             m_documentView->ensureCursorVisible();
         }
         m_composingText.clear();
@@ -152,7 +385,7 @@ void InputController::handleInputMethodEvent(QInputMethodEvent *event)
     if (!event->preeditString().isEmpty()) {
         m_composingText = event->preeditString();
         if (m_documentView) {
-            m_documentView->showComposingText(m_composingText);
+            m_documentView->showComposingText(m_composingText, event->attributes());
         }
     } else {
         m_composingText.clear();
@@ -5,12 +5,15 @@
 // ============================================================================
 
 #include "core/Document.h"
+#include "core/MathObject.h"
+#include "core/UndoStack.h"
 
 /**
  * @brief 构造函数
  * 创建一个空文档
  */
 Document::Document()
+    : m_changes(nullptr)
 {
 }
 
@@ -20,7 +23,10 @@ Document::Document()
  */
 void Document::addParagraph(const Paragraph &paragraph)
 {
+    int change = beginChange(m_paragraphs.size(), 0);
     m_paragraphs.append(paragraph);
+    m_equations.insertParagraph(m_paragraphs.size() - 1, paragraph.numberedFormulas());
+    endChange(change, 1);
 }
 
 /**
@@ -32,7 +38,10 @@ void Document::insertParagraph(int position, const Paragraph &paragraph)
 {
     if (position >= 0 && position <= m_paragraphs.size())
     {
+        int change = beginChange(position, 0);
         m_paragraphs.insert(position, paragraph);
+        m_equations.insertParagraph(position, paragraph.numberedFormulas());
+        endChange(change, 1);
     }
 }
 
@@ -42,9 +51,59 @@ void Document::insertParagraph(int position, const Paragraph &paragraph)
  */
 void Document::removeParagraph(int position)
 {
-    if (position >= 0 && position < m_paragraphs.size())
+    removeParagraphs(position, 1);
+}
+
+/**
+ * @brief 删除一段连续的段落
+ * @param first 首个段落的索引
+ * @param count 段落数
+ */
+void Document::removeParagraphs(int first, int count)
+{
+    if (first >= 0 && count > 0 && first + count <= m_paragraphs.size())
+    {
+        int change = beginChange(first, count);
+        m_paragraphs.remove(first, count);
+        m_equations.removeParagraphs(first, count);
+        endChange(change, 0);
+    }
+}
+
+/**
+ * @brief 在指定位置拆分段落
+ * @param paragraphIndex 段落索引
+ * @param position 拆分位置
+ */
+void Document::splitParagraph(int paragraphIndex, int position)
+{
+    if (paragraphIndex >= 0 && paragraphIndex < m_paragraphs.size())
     {
-        m_paragraphs.removeAt(position);
+        int change = beginChange(paragraphIndex, 1);
+        Paragraph tail = m_paragraphs[paragraphIndex].split(position);
+        m_paragraphs.insert(paragraphIndex + 1, tail);
+        // 编号公式可能随后半部分移入新段落，先更新原段落再登记新段落
+        m_equations.setEquations(paragraphIndex, m_paragraphs[paragraphIndex].numberedFormulas());
+        m_equations.insertParagraph(paragraphIndex + 1, tail.numberedFormulas());
+        endChange(change, 2);
+    }
+}
+
+/**
+ * @brief 把指定段落和下一段落合并为一个段落
+ * @param paragraphIndex 段落索引
+ */
+void Document::mergeParagraphs(int paragraphIndex)
+{
+    if (paragraphIndex >= 0 && paragraphIndex < m_paragraphs.size() - 1)
+    {
+        int change = beginChange(paragraphIndex, 2);
+        m_paragraphs[paragraphIndex].merge(m_paragraphs.at(paragraphIndex + 1));
+        m_paragraphs.removeAt(paragraphIndex + 1);
+        // 先注销被合并段落的公式，再以合并后的段落重新登记
+        m_equations.removeParagraph(paragraphIndex + 1);
+        m_equations.setEquations(paragraphIndex, m_paragraphs[paragraphIndex].numberedFormulas());
+        endChange(change, 1);
     }
 }
 
@@ -82,7 +141,29 @@ void Document::insertText(int paragraphIndex, int position, const QString &text,
 {
     if (paragraphIndex >= 0 && paragraphIndex < m_paragraphs.size())
     {
+        int change = beginChange(paragraphIndex, 1);
         m_paragraphs[paragraphIndex].insertText(position, text, format);
+        endChange(change, 1);
+    }
+}
+
+/**
+ * @brief 在指定位置插入公式
+ * @param paragraphIndex 段落索引
+ * @param position 插入位置
+ * @param formula 公式对象
+ * @param format 公式格式
+ */
+void Document::insertFormula(int paragraphIndex, int position, const QSharedPointer<MathObject> &formula,
+                             const Format &format)
+{
+    if (paragraphIndex >= 0 && paragraphIndex < m_paragraphs.size())
+    {
+        int change = beginChange(paragraphIndex, 1);
+        m_paragraphs[paragraphIndex].insertFormula(position, formula, format);
+        if (formula && formula->isNumbered())
+            m_equations.setEquations(paragraphIndex, m_paragraphs[paragraphIndex].numberedFormulas());
+        endChange(change, 1);
     }
 }
 
@@ -96,10 +177,168 @@ void Document::removeText(int paragraphIndex, int position, int length)
 {
     if (paragraphIndex >= 0 && paragraphIndex < m_paragraphs.size())
     {
+        int change = beginChange(paragraphIndex, 1);
         m_paragraphs[paragraphIndex].removeText(position, length);
+        // 删除范围内可能有带编号的公式；没有编号公式的段落在索引中直接返回
+        m_equations.setEquations(paragraphIndex, m_paragraphs[paragraphIndex].numberedFormulas());
+        endChange(change, 1);
     }
 }
 
+/**
+ * @brief 在指定位置插入交叉引用
+ * @param paragraphIndex 段落索引
+ * @param position 插入位置
+ * @param label 所引用公式的标签
+ * @param format 引用格式
+ */
+void Document::insertReference(int paragraphIndex, int position, const QString &label, const Format &format)
+{
+    if (paragraphIndex >= 0 && paragraphIndex < m_paragraphs.size())
+    {
+        int change = beginChange(paragraphIndex, 1);
+        m_paragraphs[paragraphIndex].insertReference(position, label, format);
+        endChange(change, 1);
+    }
+}
+
+/**
+ * @brief 在指定位置插入函数图像
+ * @param paragraphIndex 段落索引
+ * @param position 插入位置
+ * @param plot 函数图像对象
+ * @param format 格式
+ */
+void Document::insertPlot(int paragraphIndex, int position, const QSharedPointer<PlotObject> &plot,
+                          const Format &format)
+{
+    if (paragraphIndex >= 0 && paragraphIndex < m_paragraphs.size())
+    {
+        int change = beginChange(paragraphIndex, 1);
+        m_paragraphs[paragraphIndex].insertPlot(position, plot, format);
+        endChange(change, 1);
+    }
+}
+
+/**
+ * @brief 设置公式是否带编号及其标签
+ * @param paragraphIndex 段落索引
+ * @param position 公式在段落中的位置
+ * @param numbered 是否带编号
+ * @param label 标签
+ */
+void Document::setEquationNumbered(int paragraphIndex, int position, bool numbered, const QString &label)
+{
+    if (paragraphIndex < 0 || paragraphIndex >= m_paragraphs.size())
+        return;
+    QSharedPointer<MathObject> formula = m_paragraphs[paragraphIndex].formulaAt(position);
+    if (!formula)
+        return;
+
+    // 索引按登记时保存的旧标签注销，重新登记只涉及索引中的一条路径
+    formula->setNumbered(numbered);
+    formula->setLabel(label);
+    m_equations.setEquations(paragraphIndex, m_paragraphs[paragraphIndex].numberedFormulas());
+}
+
+/**
+ * @brief 设置一段文本的格式
+ * @param firstParagraph 起始段落
+ * @param firstPosition 起始段落中的起始位置
+ * @param lastParagraph 结束段落
+ * @param lastPosition 结束段落中的结束位置（不含）
+ * @param format 格式
+ */
+void Document::applyFormat(int firstParagraph, int firstPosition, int lastParagraph, int lastPosition,
+                           const Format &format)
+{
+    firstParagraph = qMax(0, firstParagraph);
+    lastParagraph = qMin(lastParagraph, m_paragraphs.size() - 1);
+    if (firstParagraph > lastParagraph)
+        return;
+
+    // 格式不影响公式编号，编号索引不需要更新
+    int count = lastParagraph - firstParagraph + 1;
+    int change = beginChange(firstParagraph, count);
+    if (count == 1)
+    {
+        m_paragraphs[firstParagraph].applyFormat(firstPosition, lastPosition, format);
+    }
+    else
+    {
+        Paragraph &first = m_paragraphs[firstParagraph];
+        first.applyFormat(firstPosition, first.length(), format);
+        for (int i = firstParagraph + 1; i < lastParagraph; i++)
+            m_paragraphs[i].applyFormat(format);
+        m_paragraphs[lastParagraph].applyFormat(0, lastPosition, format);
+    }
+    endChange(change, count);
+}
+
+/**
+ * @brief 获取公式编号索引
+ * @return 公式编号索引
+ */
+const EquationIndex &Document::equationIndex() const
+{
+    return m_equations;
+}
+
+/**
+ * @brief 替换一段连续的段落
+ * @param first 首个段落的索引
+ * @param count 被替换的段落数
+ * @param paragraphs 新的段落
+ */
+void Document::replaceParagraphs(int first, int count, const QVector<Paragraph> &paragraphs)
+{
+    if (first < 0 || count < 0 || first + count > m_paragraphs.size())
+        return;
+
+    int change = beginChange(first, count);
+    // 数量相同的部分原位替换，编号索引中只更新这些节点
+    int common = qMin(count, paragraphs.size());
+    for (int i = 0; i < common; i++)
+    {
+        m_paragraphs[first + i] = paragraphs.at(i);
+        m_equations.setEquations(first + i, paragraphs.at(i).numberedFormulas());
+    }
+    if (count > common)
+    {
+        m_paragraphs.remove(first + common, count - common);
+        m_equations.removeParagraphs(first + common, count - common);
+    }
+    else if (paragraphs.size() > common)
+    {
+        m_paragraphs.insert(first + common, paragraphs.size() - common, Paragraph());
+        for (int i = common; i < paragraphs.size(); i++)
+        {
+            m_paragraphs[first + i] = paragraphs.at(i);
+            m_equations.insertParagraph(first + i, paragraphs.at(i).numberedFormulas());
+        }
+    }
+    endChange(change, paragraphs.size());
+}
+
+/**
+ * @brief 设置变化记录
+ * @param changes 接收段落区间替换的列表
+ */
+void Document::setChangeLog(QVector<ParagraphChange> *changes)
+{
+    m_changes = changes;
+}
+
+/**
+ * @brief 记录一个段落在原处被修改
+ * @param paragraphIndex 段落索引
+ */
+void Document::markParagraphChanged(int paragraphIndex)
+{
+    if (paragraphIndex >= 0 && paragraphIndex < m_paragraphs.size())
+        endChange(beginChange(paragraphIndex, 1), 1);
+}
+
 /**
  * @brief 获取整个文档的文本
  * @return 文档文本
@@ -124,4 +363,64 @@ QString Document::text() const
 void Document::clear()
 {
     m_paragraphs.clear();
+    m_equations.clear();
+}
+
+/**
+ * @brief 开始记录一处变化
+ * @param first 首个段落的索引
+ * @param count 将被修改的段落数
+ * @return 变化在记录中的序号，不记录时返回-1
+ */
+int Document::beginChange(int first, int count)
+{
+    if (!m_changes)
+        return -1;
+    // 段落按值保存，此时只增加引用计数，修改时才由文档一侧分离
+    ParagraphChange change;
+    change.first = first;
+    change.before = m_paragraphs.mid(first, count);
+    m_changes->append(change);
+    return m_changes->size() - 1;
+}
+
+/**
+ * @brief 结束记录一处变化
+ * @param change beginChange()返回的序号
+ * @param count 修改后区间的段落数
+ */
+void Document::endChange(int change, int count)
+{
+    if (!m_changes || change < 0 || change != m_changes->size() - 1)
+        return;
+    ParagraphChange &current = (*m_changes)[change];
+    current.after = m_paragraphs.mid(current.first, count);
+    if (change == 0)
+        return;
+
+    // 本次修改的区间与上一处变化修改后的区间重叠或相邻时，合并为一处替换：
+    // 连续编辑同一段落、删除跨段落选择时的多步操作都只留下一处替换
+    ParagraphChange &previous = (*m_changes)[change - 1];
+    int previousEnd = previous.first + previous.after.size();
+    int currentEnd = current.first + current.before.size();
+    if (current.first > previousEnd || currentEnd < previous.first)
+        return;
+
+    // 修改前：本次区间超出上一处区间的部分此前未被修改，接在上一处的修改前内容两侧
+    if (current.first < previous.first)
+        previous.before = current.before.mid(0, previous.first - current.first) + previous.before;
+    if (currentEnd > previousEnd)
+        previous.before += current.before.mid(previousEnd - current.first);
+
+    // 修改后：用本次修改后的内容替换上一处修改后内容中被覆盖的部分。
+    // 顺序编辑时本次区间接在末尾，只需追加，连续修改k个段落的总代价为O(k)
+    int from = qMax(0, current.first - previous.first);
+    int to = qBound(from, currentEnd - previous.first, previous.after.size());
+    QVector<Paragraph> tail = previous.after.mid(to);
+    previous.after.resize(from);
+    previous.after += current.after;
+    previous.after += tail;
+
+    previous.first = qMin(previous.first, current.first);
+    m_changes->removeLast();
 }
@@ -0,0 +1,447 @@
+// ============================================================================
+// EquationIndex.cpp
+// 公式编号索引类的实现文件
+// 按段落顺序维护带编号的公式，公式的编号即其在文档中的次序，插入删除只需O(log n)
+// ============================================================================
+
+#include "core/EquationIndex.h"
+#include "core/MathObject.h"
+
+/**
+ * @brief 构造函数
+ * 创建一个空索引
+ */
+EquationIndex::EquationIndex()
+    : m_root(-1),
+      m_seed(2463534242u),
+      m_revision(0)
+{
+}
+
+/**
+ * @brief 在指定位置插入一个段落
+ * @param index 段落索引
+ * @param equations 段落中带编号的公式
+ */
+void EquationIndex::insertParagraph(int index, const QVector<const MathObject *> &equations)
+{
+    if (index < 0 || index > paragraphCount())
+        return;
+    int node = allocate(equations);
+    int left = -1;
+    int right = -1;
+    split(m_root, index, &left, &right);
+    m_root = merge(merge(left, node), right);
+    m_nodes[m_root].parent = -1;
+    registerEquations(node);
+    if (!equations.isEmpty())
+        m_revision++;
+}
+
+/**
+ * @brief 删除指定位置的段落
+ * @param index 段落索引
+ */
+void EquationIndex::removeParagraph(int index)
+{
+    removeParagraphs(index, 1);
+}
+
+/**
+ * @brief 删除一段连续的段落
+ * @param index 首个段落的索引
+ * @param count 段落数
+ */
+void EquationIndex::removeParagraphs(int index, int count)
+{
+    if (index < 0 || count <= 0 || index + count > paragraphCount())
+        return;
+    int left = -1;
+    int middle = -1;
+    int right = -1;
+    split(m_root, index, &left, &right);
+    split(right, count, &middle, &right);
+    m_root = merge(left, right);
+    if (m_root >= 0)
+        m_nodes[m_root].parent = -1;
+
+    if (m_nodes[middle].sum > 0)
+        m_revision++;
+    // 拆出的子树整体回收，只有带编号公式的节点需要注销
+    QVector<int> stack;
+    stack.append(middle);
+    while (!stack.isEmpty())
+    {
+        int node = stack.takeLast();
+        if (m_nodes[node].left >= 0)
+            stack.append(m_nodes[node].left);
+        if (m_nodes[node].right >= 0)
+            stack.append(m_nodes[node].right);
+        unregisterEquations(node);
+        m_nodes[node].equations.clear();
+        m_free.append(node);
+    }
+}
+
+/**
+ * @brief 设置一个段落中带编号的公式
+ * @param index 段落索引
+ * @param equations 段落中带编号的公式
+ */
+void EquationIndex::setEquations(int index, const QVector<const MathObject *> &equations)
+{
+    int node = nodeAt(index);
+    if (node < 0)
+        return;
+    // 没有编号公式的段落（绝大多数）编辑时直接返回，不改变修订号
+    if (equations.isEmpty() && m_nodes[node].equations.isEmpty())
+        return;
+
+    unregisterEquations(node);
+    m_nodes[node].equations = equations;
+    registerEquations(node);
+    // 只有到根节点的一条路径上的计数需要更新
+    for (int current = node; current >= 0; current = m_nodes[current].parent)
+        pull(current);
+    m_revision++;
+}
+
+/**
+ * @brief 清空索引
+ */
+void EquationIndex::clear()
+{
+    m_nodes.clear();
+    m_free.clear();
+    m_nodeOf.clear();
+    m_labels.clear();
+    m_root = -1;
+    m_revision++;
+}
+
+/**
+ * @brief 获取段落数
+ * @return 段落数
+ */
+int EquationIndex::paragraphCount() const
+{
+    return sizeOf(m_root);
+}
+
+/**
+ * @brief 获取带编号的公式总数
+ * @return 公式总数
+ */
+int EquationIndex::count() const
+{
+    return sumOf(m_root);
+}
+
+/**
+ * @brief 获取指定段落之前的公式数
+ * @param index 段落索引
+ * @return 公式数
+ */
+int EquationIndex::equationsBefore(int index) const
+{
+    int result = 0;
+    int node = m_root;
+    while (node >= 0)
+    {
+        const Node &current = m_nodes[node];
+        int leftSize = sizeOf(current.left);
+        if (index <= leftSize)
+        {
+            node = current.left;
+        }
+        else
+        {
+            result += sumOf(current.left) + current.equations.size();
+            index -= leftSize + 1;
+            node = current.right;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief 获取段落的句柄
+ * @param index 段落索引
+ * @return 句柄，越界时返回-1
+ */
+int EquationIndex::handle(int index) const
+{
+    return nodeAt(index);
+}
+
+/**
+ * @brief 按段落句柄和公式在段落中的序号获取编号
+ * @param handle 段落句柄
+ * @param slot 公式在段落的带编号公式中的序号
+ * @return 编号，句柄已失效或序号越界时返回0
+ */
+int EquationIndex::numberAt(int handle, int slot) const
+{
+    // 已回收的节点没有公式，序号必然越界
+    if (handle < 0 || handle >= m_nodes.size() || slot < 0 || slot >= m_nodes[handle].equations.size())
+        return 0;
+
+    // 本段落中排在前面的公式，加上左子树，再沿父节点链累加位于左侧的部分
+    int result = slot + sumOf(m_nodes[handle].left);
+    for (int child = handle, parent = m_nodes[handle].parent; parent >= 0;
+         child = parent, parent = m_nodes[parent].parent)
+    {
+        if (m_nodes[parent].right == child)
+            result += sumOf(m_nodes[parent].left) + m_nodes[parent].equations.size();
+    }
+    return result + 1;
+}
+
+/**
+ * @brief 获取公式的编号
+ * @param formula 公式对象
+ * @return 编号，公式未编号时返回0
+ */
+int EquationIndex::number(const MathObject *formula) const
+{
+    // 每处出现O(log n)，取最靠前的一处
+    int result = 0;
+    for (auto it = m_nodeOf.constFind(formula); it != m_nodeOf.constEnd() && it.key() == formula; ++it)
+    {
+        int current = numberAt(it.value(), m_nodes[it.value()].equations.indexOf(formula));
+        if (current > 0 && (result == 0 || current < result))
+            result = current;
+    }
+    return result;
+}
+
+/**
+ * @brief 获取标签所指公式的编号
+ * @param label 标签
+ * @return 编号，标签不存在时返回0
+ */
+int EquationIndex::number(const QString &label) const
+{
+    const MathObject *formula = equation(label);
+    return formula ? number(formula) : 0;
+}
+
+/**
+ * @brief 获取带有指定标签的公式
+ * @param label 标签
+ * @return 公式对象
+ */
+const MathObject *EquationIndex::equation(const QString &label) const
+{
+    if (label.isEmpty())
+        return nullptr;
+    // 登记中的公式都在文档中，可以访问；最近登记的优先
+    for (auto it = m_labels.constFind(label); it != m_labels.constEnd() && it.key() == label; ++it)
+    {
+        if (it.value()->label() == label)
+            return it.value();
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 获取修订号
+ * @return 修订号
+ */
+quint64 EquationIndex::revision() const
+{
+    return m_revision;
+}
+
+/**
+ * @brief 分配一个节点
+ * @param equations 段落中带编号的公式
+ * @return 节点索引
+ */
+int EquationIndex::allocate(const QVector<const MathObject *> &equations)
+{
+    // xorshift32：确定性的伪随机优先级，期望树高O(log n)
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+
+    Node node;
+    node.priority = m_seed;
+    node.sum = equations.size();
+    node.equations = equations;
+    if (!m_free.isEmpty())
+    {
+        int index = m_free.takeLast();
+        m_nodes[index] = node;
+        return index;
+    }
+    m_nodes.append(node);
+    return m_nodes.size() - 1;
+}
+
+/**
+ * @brief 重新计算节点的子树统计并修正子节点的父指针
+ * @param node 节点索引
+ */
+void EquationIndex::pull(int node)
+{
+    Node &current = m_nodes[node];
+    current.size = 1 + sizeOf(current.left) + sizeOf(current.right);
+    current.sum = current.equations.size() + sumOf(current.left) + sumOf(current.right);
+    if (current.left >= 0)
+        m_nodes[current.left].parent = node;
+    if (current.right >= 0)
+        m_nodes[current.right].parent = node;
+}
+
+/**
+ * @brief 按段落数把子树分成两部分
+ * @param node 子树根节点
+ * @param count 左侧部分的段落数
+ * @param left 输出：左侧子树
+ * @param right 输出：右侧子树
+ */
+void EquationIndex::split(int node, int count, int *left, int *right)
+{
+    if (node < 0)
+    {
+        *left = -1;
+        *right = -1;
+        return;
+    }
+    int leftSize = sizeOf(m_nodes[node].left);
+    if (count <= leftSize)
+    {
+        int rest = -1;
+        split(m_nodes[node].left, count, left, &rest);
+        m_nodes[node].left = rest;
+        pull(node);
+        *right = node;
+        if (*left >= 0)
+            m_nodes[*left].parent = -1;
+    }
+    else
+    {
+        int rest = -1;
+        split(m_nodes[node].right, count - leftSize - 1, &rest, right);
+        m_nodes[node].right = rest;
+        pull(node);
+        *left = node;
+        if (*right >= 0)
+            m_nodes[*right].parent = -1;
+    }
+    m_nodes[node].parent = -1;
+}
+
+/**
+ * @brief 合并两棵子树
+ * @param left 左侧子树
+ * @param right 右侧子树
+ * @return 合并后的根节点
+ */
+int EquationIndex::merge(int left, int right)
+{
+    if (left < 0)
+        return right;
+    if (right < 0)
+        return left;
+    if (m_nodes[left].priority > m_nodes[right].priority)
+    {
+        m_nodes[left].right = merge(m_nodes[left].right, right);
+        pull(left);
+        return left;
+    }
+    m_nodes[right].left = merge(left, m_nodes[right].left);
+    pull(right);
+    return right;
+}
+
+/**
+ * @brief 查找指定段落的节点
+ * @param index 段落索引
+ * @return 节点索引
+ */
+int EquationIndex::nodeAt(int index) const
+{
+    if (index < 0 || index >= paragraphCount())
+        return -1;
+    int node = m_root;
+    while (node >= 0)
+    {
+        int leftSize = sizeOf(m_nodes[node].left);
+        if (index < leftSize)
+        {
+            node = m_nodes[node].left;
+        }
+        else if (index == leftSize)
+        {
+            return node;
+        }
+        else
+        {
+            index -= leftSize + 1;
+            node = m_nodes[node].right;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 登记节点中的公式及其标签
+ * @param node 节点索引
+ */
+void EquationIndex::registerEquations(int node)
+{
+    Node &current = m_nodes[node];
+    current.labels.clear();
+    current.labels.reserve(current.equations.size());
+    for (const MathObject *formula : current.equations)
+    {
+        m_nodeOf.insert(formula, node);
+        current.labels.append(formula->label());
+        if (!formula->label().isEmpty())
+            m_labels.insert(formula->label(), formula);
+    }
+}
+
+/**
+ * @brief 注销节点中的公式及其标签
+ * @param node 节点索引
+ */
+void EquationIndex::unregisterEquations(int node)
+{
+    Node &current = m_nodes[node];
+    for (int i = 0; i < current.equations.size(); i++)
+    {
+        const MathObject *formula = current.equations.at(i);
+        // 只移除本段落的这一处登记，同一公式在其他段落中的登记保留
+        auto node_it = m_nodeOf.find(formula, node);
+        if (node_it != m_nodeOf.end())
+            m_nodeOf.erase(node_it);
+        // 公式的标签可能已被就地修改、公式本身可能已释放，只按登记时的标签查找，不访问公式对象
+        auto it = m_labels.find(current.labels.at(i), formula);
+        if (it != m_labels.end())
+            m_labels.erase(it);
+    }
+    current.labels.clear();
+}
+
+/**
+ * @brief 获取子树的段落数
+ * @param node 节点索引
+ * @return 段落数
+ */
+int EquationIndex::sizeOf(int node) const
+{
+    return node >= 0 ? m_nodes[node].size : 0;
+}
+
+/**
+ * @brief 获取子树的公式数
+ * @param node 节点索引
+ * @return 公式数
+ */
+int EquationIndex::sumOf(int node) const
+{
+    return node >= 0 ? m_nodes[node].sum : 0;
+}
@@ -0,0 +1,108 @@
+// ============================================================================
+// MathEdit.cpp
+// 公式编辑记录的实现文件
+// 以Row中一段子节点的替换记录表达式树的一次修改，撤销重做时在原处替换回来
+// ============================================================================
+
+#include "core/MathEdit.h"
+#include "core/MathNode.h"
+
+namespace {
+
+/**
+ * @brief 复制Row中的一段子节点
+ * @param row 所在的Row
+ * @param index 区间起点
+ * @param count 子节点数
+ * @return 子树的副本
+ */
+QVector<QSharedPointer<const MathNode>> copyChildren(const MathNode *row, int index, int count)
+{
+    QVector<QSharedPointer<const MathNode>> nodes;
+    nodes.reserve(count);
+    for (int i = index; i < index + count; i++)
+        nodes.append(QSharedPointer<const MathNode>(row->child(i)->clone()));
+    return nodes;
+}
+
+/**
+ * @brief 把Row中的一段子节点替换为给定子树的副本
+ * @param root 公式根节点
+ * @param position 区间起点
+ * @param count 被替换的子节点数
+ * @param nodes 替换成的子树
+ * @return 是否成功
+ */
+bool replaceChildren(MathNode *root, const MathPosition &position, int count,
+                     const QVector<QSharedPointer<const MathNode>> &nodes)
+{
+    MathNode *row = root ? position.row(root) : nullptr;
+    if (!row || position.offset() + count > row->childCount())
+        return false;
+    for (int i = position.offset() + count - 1; i >= position.offset(); i--)
+        row->removeChild(i);
+    for (int i = 0; i < nodes.size(); i++)
+        row->insertChild(position.offset() + i, nodes.at(i)->clone());
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief 记录替换前的状态
+ * @param row 所在的Row
+ * @param index 区间起点
+ * @param count 将被替换的子节点数
+ * @return 编辑记录
+ */
+MathEdit MathEdit::capture(const MathNode *row, int index, int count)
+{
+    MathEdit edit;
+    edit.position = MathPosition::fromNode(row, index);
+    edit.removed = copyChildren(row, index, count);
+    return edit;
+}
+
+/**
+ * @brief 记录替换后的状态
+ * @param row 所在的Row
+ * @param count 插入的子节点数
+ */
+void MathEdit::finish(const MathNode *row, int count)
+{
+    inserted = copyChildren(row, position.offset(), count);
+}
+
+/**
+ * @brief 撤销这次替换
+ * @param root 公式根节点
+ * @return 是否成功
+ */
+bool MathEdit::undo(MathNode *root) const
+{
+    return replaceChildren(root, position, inserted.size(), removed);
+}
+
+/**
+ * @brief 重做这次替换
+ * @param root 公式根节点
+ * @return 是否成功
+ */
+bool MathEdit::redo(MathNode *root) const
+{
+    return replaceChildren(root, position, removed.size(), inserted);
+}
+
+/**
+ * @brief 获取记录中保存的节点总数
+ * @return 节点数
+ */
+int MathEdit::nodeCount() const
+{
+    int count = 0;
+    for (const QSharedPointer<const MathNode> &node : removed)
+        count += node->nodeCount();
+    for (const QSharedPointer<const MathNode> &node : inserted)
+        count += node->nodeCount();
+    return count;
+}
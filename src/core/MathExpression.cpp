@@ -0,0 +1,774 @@
+// ============================================================================
+// MathExpression.cpp
+// 可求值表达式类的实现文件
+// 把公式的表达式树编译为紧凑的栈式字节码，支持单点求值和按列批量求值
+// ============================================================================
+
+#include "core/MathExpression.h"
+#include "core/MathNode.h"
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief 编译结果缓存的最大条目数
+ */
+const int CacheCapacity = 256;
+
+/**
+ * @brief 圆周率
+ */
+const double Pi = 3.14159265358979323846;
+
+/**
+ * @brief 自然常数
+ */
+const double E = 2.71828182845904523536;
+
+/**
+ * @brief 函数名到操作码的映射
+ */
+const QHash<QString, MathExpression::Opcode> &functionTable()
+{
+    static const QHash<QString, MathExpression::Opcode> table = {
+        {QStringLiteral("sin"), MathExpression::Sin},     {QStringLiteral("cos"), MathExpression::Cos},
+        {QStringLiteral("tan"), MathExpression::Tan},     {QStringLiteral("arcsin"), MathExpression::Asin},
+        {QStringLiteral("arccos"), MathExpression::Acos}, {QStringLiteral("arctan"), MathExpression::Atan},
+        {QStringLiteral("sinh"), MathExpression::Sinh},   {QStringLiteral("cosh"), MathExpression::Cosh},
+        {QStringLiteral("tanh"), MathExpression::Tanh},   {QStringLiteral("exp"), MathExpression::Exp},
+        {QStringLiteral("ln"), MathExpression::Ln},       {QStringLiteral("log"), MathExpression::Log10},
+        {QStringLiteral("lg"), MathExpression::Log10}};
+    return table;
+}
+
+/**
+ * @brief 获取符号节点的文本，非符号节点返回空字符串
+ */
+QString symbolText(const MathNode *node)
+{
+    return node && node->type() == MathNode::Symbol ? node->text() : QString();
+}
+
+/**
+ * @brief 检查符号是否为数字的一部分
+ */
+bool isNumberPart(const QString &text)
+{
+    return text.length() == 1 && (text.at(0).isDigit() || text.at(0) == QLatin1Char('.'));
+}
+
+/**
+ * @brief 检查符号是否为变量名（单个字母，π和e除外）
+ */
+bool isVariableName(const QString &text)
+{
+    return text.length() == 1 && text.at(0).isLetter() && text != QStringLiteral("π")
+           && text != QStringLiteral("e");
+}
+
+/**
+ * @brief 检查Row中的节点能否开始一个因子（用于识别隐式乘法）
+ */
+bool startsFactor(const MathNode *node)
+{
+    if (!node)
+        return false;
+    if (node->type() != MathNode::Symbol)
+        return node->type() != MathNode::Matrix;
+    QString text = node->text();
+    if (text.isEmpty())
+        return false;
+    return isNumberPart(text) || text.at(0).isLetter() || text == QLatin1String("(")
+           || functionTable().contains(text);
+}
+
+/**
+ * @brief 把只含符号的Row拼接为文本（下标变量名），含结构时返回空字符串
+ */
+QString plainText(const MathNode *row)
+{
+    QString result;
+    for (int i = 0; i < row->childCount(); i++)
+    {
+        QString text = symbolText(row->child(i));
+        if (text.isEmpty())
+            return QString();
+        result += text;
+    }
+    return result;
+}
+
+} // namespace
+
+/**
+ * @class MathExpressionCompiler
+ * @brief 表达式树到字节码的编译器
+ *
+ * 对每个Row做递归下降分析，边分析边生成后缀指令；
+ * 两个操作数都是刚生成的常量时直接在编译期计算，替换为一个常量。
+ */
+class MathExpressionCompiler
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param expression 编译结果
+     */
+    explicit MathExpressionCompiler(MathExpression *expression)
+        : m_expression(expression), m_depth(0)
+    {
+    }
+
+    /**
+     * @brief 编译公式根节点
+     * @param root 根节点
+     * @return 是否成功
+     */
+    bool compile(const MathNode *root)
+    {
+        // 方程只对最后一个等号右侧求值
+        int start = 0;
+        for (int i = root->childCount() - 1; i >= 0; i--)
+        {
+            if (symbolText(root->child(i)) == QLatin1String("="))
+            {
+                start = i + 1;
+                break;
+            }
+        }
+        return row(root, start);
+    }
+
+private:
+    /**
+     * @brief 编译整个Row（从start开始）
+     */
+    bool row(const MathNode *node, int start = 0)
+    {
+        int i = start;
+        if (!expression(node, &i))
+            return false;
+        if (i < node->childCount())
+            return fail(QStringLiteral("无法识别的符号：%1").arg(symbolText(node->child(i))));
+        return true;
+    }
+
+    /**
+     * @brief 加减表达式
+     */
+    bool expression(const MathNode *node, int *i)
+    {
+        if (!term(node, i))
+            return false;
+        while (*i < node->childCount())
+        {
+            QString text = symbolText(node->child(*i));
+            MathExpression::Opcode op;
+            if (text == QLatin1String("+"))
+                op = MathExpression::Add;
+            else if (text == QLatin1String("-") || text == QStringLiteral("−"))
+                op = MathExpression::Subtract;
+            else
+                break;
+            (*i)++;
+            if (!term(node, i))
+                return false;
+            emitBinary(op);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 乘除表达式（含隐式乘法）
+     */
+    bool term(const MathNode *node, int *i)
+    {
+        if (!unary(node, i))
+            return false;
+        while (*i < node->childCount())
+        {
+            const MathNode *next = node->child(*i);
+            QString text = symbolText(next);
+            if (text == QLatin1String("*") || text == QStringLiteral("×") || text == QStringLiteral("⋅")
+                || text == QStringLiteral("·") || text == QStringLiteral("∗"))
+            {
+                (*i)++;
+                if (!unary(node, i))
+                    return false;
+                emitBinary(MathExpression::Multiply);
+            }
+            else if (text == QLatin1String("/") || text == QStringLiteral("÷"))
+            {
+                (*i)++;
+                if (!unary(node, i))
+                    return false;
+                emitBinary(MathExpression::Divide);
+            }
+            else if (startsFactor(next))
+            {
+                if (!primary(node, i))
+                    return false;
+                emitBinary(MathExpression::Multiply);
+            }
+            else
+            {
+                break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 正负号
+     */
+    bool unary(const MathNode *node, int *i)
+    {
+        QString text = symbolText(node->child(*i));
+        if (text == QLatin1String("-") || text == QStringLiteral("−"))
+        {
+            (*i)++;
+            if (!unary(node, i))
+                return false;
+            emitUnary(MathExpression::Negate);
+            return true;
+        }
+        if (text == QLatin1String("+"))
+        {
+            (*i)++;
+            return unary(node, i);
+        }
+        return primary(node, i);
+    }
+
+    /**
+     * @brief 基本因子：数字、变量、常数、函数调用、括号和结构节点
+     */
+    bool primary(const MathNode *node, int *i)
+    {
+        const MathNode *current = node->child(*i);
+        if (!current)
+            return fail(QStringLiteral("表达式不完整"));
+
+        switch (current->type())
+        {
+        case MathNode::Symbol:
+            return symbol(node, i);
+        case MathNode::Fraction:
+            (*i)++;
+            if (!row(current->child(0)) || !row(current->child(1)))
+                return false;
+            emitBinary(MathExpression::Divide);
+            return true;
+        case MathNode::Radical:
+            (*i)++;
+            if (!row(current->child(0)))
+                return false;
+            if (current->child(1)->childCount() == 0)
+            {
+                emitUnary(MathExpression::Sqrt);
+                return true;
+            }
+            // n次根：x^(1/n)
+            emitConstant(1);
+            if (!row(current->child(1)))
+                return false;
+            emitBinary(MathExpression::Divide);
+            emitBinary(MathExpression::Power);
+            return true;
+        case MathNode::Delimited:
+            (*i)++;
+            if (!row(current->child(0)))
+                return false;
+            if (current->text() == QLatin1String("||"))
+                emitUnary(MathExpression::Abs);
+            return true;
+        case MathNode::Script:
+            return script(node, i);
+        default:
+            return fail(QStringLiteral("矩阵不能求值"));
+        }
+    }
+
+    /**
+     * @brief 符号开始的因子
+     */
+    bool symbol(const MathNode *node, int *i)
+    {
+        QString text = symbolText(node->child(*i));
+        if (isNumberPart(text))
+        {
+            QString digits;
+            while (isNumberPart(symbolText(node->child(*i))))
+                digits += symbolText(node->child((*i)++));
+            bool ok = false;
+            double value = digits.toDouble(&ok);
+            if (!ok)
+                return fail(QStringLiteral("无效的数字：%1").arg(digits));
+            emitConstant(value);
+            return true;
+        }
+        if (text == QLatin1String("("))
+        {
+            (*i)++;
+            if (!expression(node, i))
+                return false;
+            if (symbolText(node->child(*i)) != QLatin1String(")"))
+                return fail(QStringLiteral("缺少右括号"));
+            (*i)++;
+            return true;
+        }
+        if (functionTable().contains(text))
+        {
+            // 与TeX习惯一致，函数作用于紧随其后的一个因子：sin x、sin(x)
+            (*i)++;
+            if (!primary(node, i))
+                return false;
+            emitUnary(functionTable().value(text));
+            return true;
+        }
+        (*i)++;
+        if (text == QStringLiteral("π"))
+            emitConstant(Pi);
+        else if (text == QLatin1String("e"))
+            emitConstant(E);
+        else if (isVariableName(text))
+            emitVariable(text);
+        else
+            return fail(QStringLiteral("无法计算的符号：%1").arg(text));
+        return true;
+    }
+
+    /**
+     * @brief 上下标：乘方、下标变量和函数的幂（sin^2 x）
+     */
+    bool script(const MathNode *node, int *i)
+    {
+        const MathNode *current = node->child((*i)++);
+        const MathNode *base = current->child(0);
+        const MathNode *sub = current->child(1);
+        const MathNode *sup = current->child(2);
+
+        QString baseText = base->childCount() == 1 ? symbolText(base->child(0)) : QString();
+        if (functionTable().contains(baseText))
+        {
+            if (sub->childCount() > 0)
+                return fail(QStringLiteral("函数不能带下标：%1").arg(baseText));
+            if (!primary(node, i))
+                return false;
+            emitUnary(functionTable().value(baseText));
+        }
+        else if (sub->childCount() > 0)
+        {
+            // 下标是变量名的一部分：x_1、v_max
+            QString index = plainText(sub);
+            if (!isVariableName(baseText) || index.isEmpty())
+                return fail(QStringLiteral("无法计算带下标的表达式"));
+            emitVariable(baseText + QLatin1Char('_') + index);
+        }
+        else if (!row(base))
+        {
+            return false;
+        }
+
+        if (sup->childCount() > 0)
+        {
+            if (!row(sup))
+                return false;
+            emitBinary(MathExpression::Power);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 记录编译错误
+     */
+    bool fail(const QString &message)
+    {
+        if (m_expression->m_error.isEmpty())
+            m_expression->m_error = message;
+        return false;
+    }
+
+    /**
+     * @brief 生成一条指令并更新栈深度
+     */
+    void generate(MathExpression::Opcode op, int operand, int stackEffect)
+    {
+        MathExpression::Instruction instruction;
+        instruction.op = op;
+        instruction.operand = operand;
+        m_expression->m_code.append(instruction);
+        m_depth += stackEffect;
+        m_expression->m_stackDepth = qMax(m_expression->m_stackDepth, m_depth);
+    }
+
+    /**
+     * @brief 生成压入常量的指令
+     */
+    void emitConstant(double value)
+    {
+        m_expression->m_constants.append(value);
+        generate(MathExpression::Constant, m_expression->m_constants.size() - 1, 1);
+    }
+
+    /**
+     * @brief 生成压入变量的指令
+     */
+    void emitVariable(const QString &name)
+    {
+        int index = m_expression->m_variables.indexOf(name);
+        if (index < 0)
+        {
+            m_expression->m_variables.append(name);
+            index = m_expression->m_variables.size() - 1;
+        }
+        generate(MathExpression::Variable, index, 1);
+    }
+
+    /**
+     * @brief 检查倒数第n条指令是否为常量
+     */
+    bool isConstantAt(int fromEnd) const
+    {
+        const QVector<MathExpression::Instruction> &code = m_expression->m_code;
+        return code.size() >= fromEnd && code.at(code.size() - fromEnd).op == MathExpression::Constant;
+    }
+
+    /**
+     * @brief 弹出最后一条常量指令并返回其值
+     */
+    double popConstant()
+    {
+        double value = m_expression->m_constants.at(m_expression->m_code.takeLast().operand);
+        m_expression->m_constants.removeLast();
+        m_depth--;
+        return value;
+    }
+
+    /**
+     * @brief 生成一元操作（操作数为常量时折叠）
+     */
+    void emitUnary(MathExpression::Opcode op)
+    {
+        if (isConstantAt(1))
+        {
+            emitConstant(MathExpression::apply(op, popConstant()));
+            return;
+        }
+        generate(op, 0, 0);
+    }
+
+    /**
+     * @brief 生成二元操作（两个操作数都是常量时折叠）
+     */
+    void emitBinary(MathExpression::Opcode op)
+    {
+        if (isConstantAt(1) && isConstantAt(2))
+        {
+            double b = popConstant();
+            double a = popConstant();
+            emitConstant(MathExpression::apply(op, a, b));
+            return;
+        }
+        generate(op, 0, -1);
+    }
+
+    /**
+     * @brief 编译结果
+     */
+    MathExpression *m_expression;
+
+    /**
+     * @brief 当前栈深度
+     */
+    int m_depth;
+};
+
+/**
+ * @brief 构造函数
+ * @param root 公式根节点
+ */
+MathExpression::MathExpression(const MathNode *root)
+    : m_stackDepth(0)
+{
+    if (!root)
+    {
+        m_error = QStringLiteral("公式为空");
+        return;
+    }
+    MathExpressionCompiler compiler(this);
+    if (!compiler.compile(root))
+    {
+        m_code.clear();
+        m_constants.clear();
+        m_stackDepth = 0;
+    }
+    else if (m_code.isEmpty())
+    {
+        m_error = QStringLiteral("公式为空");
+    }
+}
+
+/**
+ * @brief 编译表达式树，结构相同的公式共享同一份编译结果
+ * @param root 公式根节点
+ * @return 编译结果
+ */
+QSharedPointer<const MathExpression> MathExpression::compile(const MathNode *root)
+{
+    if (!root)
+        return QSharedPointer<const MathExpression>();
+
+    static QMutex mutex;
+    static QCache<quint64, QSharedPointer<const MathExpression>> cache(CacheCapacity);
+
+    quint64 hash = root->hash();
+    {
+        QMutexLocker locker(&mutex);
+        if (QSharedPointer<const MathExpression> *cached = cache.object(hash))
+            return *cached;
+    }
+
+    // 编译在锁外进行，只访问调用线程拥有的表达式树
+    QSharedPointer<const MathExpression> expression(new MathExpression(root));
+    QMutexLocker locker(&mutex);
+    cache.insert(hash, new QSharedPointer<const MathExpression>(expression));
+    return expression;
+}
+
+/**
+ * @brief 检查是否编译成功
+ * @return 是否可以求值
+ */
+bool MathExpression::isValid() const
+{
+    return m_error.isEmpty();
+}
+
+/**
+ * @brief 获取编译错误
+ * @return 错误信息
+ */
+QString MathExpression::errorString() const
+{
+    return m_error;
+}
+
+/**
+ * @brief 获取变量名
+ * @return 变量名列表
+ */
+QStringList MathExpression::variables() const
+{
+    return m_variables;
+}
+
+/**
+ * @brief 获取变量的序号
+ * @param name 变量名
+ * @return 序号
+ */
+int MathExpression::variableIndex(const QString &name) const
+{
+    return m_variables.indexOf(name);
+}
+
+/**
+ * @brief 检查表达式是否为常量
+ * @return 是否为常量
+ */
+bool MathExpression::isConstant() const
+{
+    return isValid() && m_variables.isEmpty();
+}
+
+/**
+ * @brief 单点求值
+ * @param values 各变量的值
+ * @return 结果
+ */
+double MathExpression::evaluate(const QVector<double> &values) const
+{
+    if (!isValid() || values.size() < m_variables.size())
+        return std::numeric_limits<double>::quiet_NaN();
+
+    QVarLengthArray<double, 32> stack(m_stackDepth);
+    int top = 0;
+    for (const Instruction &instruction : m_code)
+    {
+        switch (instruction.op)
+        {
+        case Constant:
+            stack[top++] = m_constants.at(instruction.operand);
+            break;
+        case Variable:
+            stack[top++] = values.at(instruction.operand);
+            break;
+        case Add:
+        case Subtract:
+        case Multiply:
+        case Divide:
+        case Power:
+            top--;
+            stack[top - 1] = apply(instruction.op, stack[top - 1], stack[top]);
+            break;
+        default:
+            stack[top - 1] = apply(instruction.op, stack[top - 1]);
+            break;
+        }
+    }
+    return stack[0];
+}
+
+/**
+ * @brief 按列批量求值
+ * @param columns 各变量的值数组
+ * @param count 求值点数
+ * @param results 输出：count个结果
+ */
+void MathExpression::evaluate(const QVector<const double *> &columns, int count, double *results) const
+{
+    if (!isValid() || columns.size() < m_variables.size())
+    {
+        std::fill(results, results + count, std::numeric_limits<double>::quiet_NaN());
+        return;
+    }
+
+    // 栈按块排列：第k层占stack[k * BLOCK_SIZE, (k + 1) * BLOCK_SIZE)
+    std::vector<double> stack(static_cast<size_t>(m_stackDepth) * BLOCK_SIZE);
+    for (int offset = 0; offset < count; offset += BLOCK_SIZE)
+    {
+        const int n = qMin(BLOCK_SIZE, count - offset);
+        int top = 0;
+        for (const Instruction &instruction : m_code)
+        {
+            // slot为下一个空闲层，a、b为次栈顶和栈顶
+            double *slot = stack.data() + static_cast<size_t>(top) * BLOCK_SIZE;
+            double *a = top >= 2 ? slot - 2 * BLOCK_SIZE : slot;
+            double *b = top >= 1 ? slot - BLOCK_SIZE : slot;
+            switch (instruction.op)
+            {
+            case Constant:
+                std::fill(slot, slot + n, m_constants.at(instruction.operand));
+                top++;
+                break;
+            case Variable:
+                std::copy(columns.at(instruction.operand) + offset, columns.at(instruction.operand) + offset + n, slot);
+                top++;
+                break;
+            // 算术指令的内层循环没有分支和函数调用，可以被自动向量化
+            case Add:
+                for (int i = 0; i < n; i++)
+                    a[i] += b[i];
+                top--;
+                break;
+            case Subtract:
+                for (int i = 0; i < n; i++)
+                    a[i] -= b[i];
+                top--;
+                break;
+            case Multiply:
+                for (int i = 0; i < n; i++)
+                    a[i] *= b[i];
+                top--;
+                break;
+            case Divide:
+                for (int i = 0; i < n; i++)
+                    a[i] /= b[i];
+                top--;
+                break;
+            case Power:
+                for (int i = 0; i < n; i++)
+                    a[i] = std::pow(a[i], b[i]);
+                top--;
+                break;
+            case Negate:
+                for (int i = 0; i < n; i++)
+                    b[i] = -b[i];
+                break;
+            case Abs:
+                for (int i = 0; i < n; i++)
+                    b[i] = std::fabs(b[i]);
+                break;
+            case Sqrt:
+                for (int i = 0; i < n; i++)
+                    b[i] = std::sqrt(b[i]);
+                break;
+            default:
+            {
+                const Opcode op = instruction.op;
+                for (int i = 0; i < n; i++)
+                    b[i] = apply(op, b[i]);
+                break;
+            }
+            }
+        }
+        std::copy(stack.data(), stack.data() + n, results + offset);
+    }
+}
+
+/**
+ * @brief 获取字节码的指令数
+ * @return 指令数
+ */
+int MathExpression::instructionCount() const
+{
+    return m_code.size();
+}
+
+/**
+ * @brief 计算一元操作
+ * @param op 操作码
+ * @param a 操作数
+ * @return 结果
+ */
+double MathExpression::apply(Opcode op, double a)
+{
+    switch (op)
+    {
+    case Negate: return -a;
+    case Abs: return std::fabs(a);
+    case Sqrt: return std::sqrt(a);
+    case Exp: return std::exp(a);
+    case Ln: return std::log(a);
+    case Log10: return std::log10(a);
+    case Sin: return std::sin(a);
+    case Cos: return std::cos(a);
+    case Tan: return std::tan(a);
+    case Asin: return std::asin(a);
+    case Acos: return std::acos(a);
+    case Atan: return std::atan(a);
+    case Sinh: return std::sinh(a);
+    case Cosh: return std::cosh(a);
+    case Tanh: return std::tanh(a);
+    default: return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+/**
+ * @brief 计算二元操作
+ * @param op 操作码
+ * @param a 左操作数
+ * @param b 右操作数
+ * @return 结果
+ */
+double MathExpression::apply(Opcode op, double a, double b)
+{
+    switch (op)
+    {
+    case Add: return a + b;
+    case Subtract: return a - b;
+    case Multiply: return a * b;
+    case Divide: return a / b;
+    case Power: return std::pow(a, b);
+    default: return std::numeric_limits<double>::quiet_NaN();
+    }
+}
@@ -0,0 +1,292 @@
+// ============================================================================
+// MathNavigator.cpp
+// 公式光标导航类的实现文件
+// 在表达式树上按结构移动光标：左右进出槽位、上下在分子分母和角标间切换、Tab在矩阵单元格间跳转
+// ============================================================================
+
+#include "core/MathNavigator.h"
+#include "core/MathNode.h"
+
+namespace {
+
+/**
+ * @brief 获取结构节点的槽位数（符号和Row没有槽位）
+ */
+int slotCount(const MathNode *node)
+{
+    if (!node || node->type() == MathNode::Row || node->type() == MathNode::Symbol)
+        return 0;
+    return node->childCount();
+}
+
+/**
+ * @brief 槽位顺序中第rank个槽位的索引（根式先根指数后被开方数）
+ */
+int slotAtRank(const MathNode *node, int rank)
+{
+    return node->type() == MathNode::Radical ? node->childCount() - 1 - rank : rank;
+}
+
+/**
+ * @brief 槽位在槽位顺序中的次序
+ */
+int rankOfSlot(const MathNode *node, int index)
+{
+    return node->type() == MathNode::Radical ? node->childCount() - 1 - index : index;
+}
+
+/**
+ * @brief 检查槽位在左右移动时是否跳过（空角标、空根指数）
+ */
+bool isSkipped(const MathNode *node, int index)
+{
+    const MathNode *slot = node->child(index);
+    if (!slot || slot->childCount() > 0)
+        return false;
+    return (node->type() == MathNode::Script && index > 0)
+        || (node->type() == MathNode::Radical && index == 1);
+}
+
+} // namespace
+
+/**
+ * @brief 获取公式的起始位置
+ * @param root 根节点
+ * @return 位置
+ */
+MathPosition MathNavigator::start(const MathNode *root)
+{
+    return MathPosition::fromNode(root, 0);
+}
+
+/**
+ * @brief 获取公式的结束位置
+ * @param root 根节点
+ * @return 位置
+ */
+MathPosition MathNavigator::end(const MathNode *root)
+{
+    return root ? MathPosition::fromNode(root, root->childCount()) : MathPosition();
+}
+
+/**
+ * @brief 向左移动一步
+ * @param root 根节点
+ * @param position 当前位置
+ * @return 新位置
+ */
+MathPosition MathNavigator::moveLeft(const MathNode *root, const MathPosition &position)
+{
+    const MathNode *row = position.row(root);
+    if (!row)
+        return MathPosition();
+
+    int offset = position.offset();
+    if (offset == 0)
+        return leaveSlot(row, false);
+
+    // 左侧是结构：进入其最后一个槽位的末尾；否则越过左侧节点
+    const MathNode *node = row->child(offset - 1);
+    int slot = adjacentSlot(node, -1, false);
+    if (slot >= 0)
+        return MathPosition::fromNode(node->child(slot), node->child(slot)->childCount());
+    return MathPosition::fromNode(row, offset - 1);
+}
+
+/**
+ * @brief 向右移动一步
+ * @param root 根节点
+ * @param position 当前位置
+ * @return 新位置
+ */
+MathPosition MathNavigator::moveRight(const MathNode *root, const MathPosition &position)
+{
+    const MathNode *row = position.row(root);
+    if (!row)
+        return MathPosition();
+
+    int offset = position.offset();
+    if (offset == row->childCount())
+        return leaveSlot(row, true);
+
+    // 右侧是结构：进入其第一个槽位的开头；否则越过右侧节点
+    const MathNode *node = row->child(offset);
+    int slot = adjacentSlot(node, -1, true);
+    if (slot >= 0)
+        return MathPosition::fromNode(node->child(slot), 0);
+    return MathPosition::fromNode(row, offset + 1);
+}
+
+/**
+ * @brief 向上移动到上方的槽位
+ * @param root 根节点
+ * @param position 当前位置
+ * @return 新位置
+ */
+MathPosition MathNavigator::moveUp(const MathNode *root, const MathPosition &position)
+{
+    const MathNode *row = position.row(root);
+    // 当前槽位没有上方槽位时继续在外层结构中查找
+    for (const MathNode *slot = row; slot && slot->parent(); slot = slot->parent()->parent())
+    {
+        const MathNode *node = slot->parent();
+        int target = verticalSlot(node, slot->indexInParent(), true);
+        if (target >= 0)
+        {
+            const MathNode *targetRow = node->child(target);
+            int offset = slot == row ? qMin(position.offset(), targetRow->childCount()) : targetRow->childCount();
+            return MathPosition::fromNode(targetRow, offset);
+        }
+    }
+    return MathPosition();
+}
+
+/**
+ * @brief 向下移动到下方的槽位
+ * @param root 根节点
+ * @param position 当前位置
+ * @return 新位置
+ */
+MathPosition MathNavigator::moveDown(const MathNode *root, const MathPosition &position)
+{
+    const MathNode *row = position.row(root);
+    for (const MathNode *slot = row; slot && slot->parent(); slot = slot->parent()->parent())
+    {
+        const MathNode *node = slot->parent();
+        int target = verticalSlot(node, slot->indexInParent(), false);
+        if (target >= 0)
+        {
+            const MathNode *targetRow = node->child(target);
+            int offset = slot == row ? qMin(position.offset(), targetRow->childCount()) : 0;
+            return MathPosition::fromNode(targetRow, offset);
+        }
+    }
+    return MathPosition();
+}
+
+/**
+ * @brief 移动到所在矩阵的下一个单元格
+ * @param root 根节点
+ * @param position 当前位置
+ * @return 新位置
+ */
+MathPosition MathNavigator::nextCell(const MathNode *root, const MathPosition &position)
+{
+    const MathNode *row = position.row(root);
+    for (const MathNode *slot = row; slot && slot->parent(); slot = slot->parent()->parent())
+    {
+        const MathNode *node = slot->parent();
+        if (node->type() != MathNode::Matrix)
+            continue;
+        int index = slot->indexInParent() + 1;
+        if (index < node->childCount())
+            return MathPosition::fromNode(node->child(index), 0);
+        return MathPosition::fromNode(node->parent(), node->indexInParent() + 1);
+    }
+    return MathPosition();
+}
+
+/**
+ * @brief 移动到所在矩阵的上一个单元格
+ * @param root 根节点
+ * @param position 当前位置
+ * @return 新位置
+ */
+MathPosition MathNavigator::previousCell(const MathNode *root, const MathPosition &position)
+{
+    const MathNode *row = position.row(root);
+    for (const MathNode *slot = row; slot && slot->parent(); slot = slot->parent()->parent())
+    {
+        const MathNode *node = slot->parent();
+        if (node->type() != MathNode::Matrix)
+            continue;
+        int index = slot->indexInParent() - 1;
+        if (index >= 0)
+            return MathPosition::fromNode(node->child(index), node->child(index)->childCount());
+        return MathPosition::fromNode(node->parent(), node->indexInParent());
+    }
+    return MathPosition();
+}
+
+/**
+ * @brief 按槽位顺序查找相邻的可进入槽位
+ * @param node 结构节点
+ * @param index 当前槽位索引
+ * @param forward 是否向后查找
+ * @return 槽位索引
+ */
+int MathNavigator::adjacentSlot(const MathNode *node, int index, bool forward)
+{
+    int count = slotCount(node);
+    if (count == 0)
+        return -1;
+    int step = forward ? 1 : -1;
+    int rank = index >= 0 ? rankOfSlot(node, index) : (forward ? -1 : count);
+    for (rank += step; rank >= 0 && rank < count; rank += step)
+    {
+        int slot = slotAtRank(node, rank);
+        if (!isSkipped(node, slot))
+            return slot;
+    }
+    return -1;
+}
+
+/**
+ * @brief 查找垂直方向上相邻的槽位
+ * @param node 结构节点
+ * @param index 当前槽位索引
+ * @param up 是否向上
+ * @return 槽位索引
+ */
+int MathNavigator::verticalSlot(const MathNode *node, int index, bool up)
+{
+    switch (node->type())
+    {
+    case MathNode::Fraction:
+        // 分子0，分母1
+        if (up)
+            return index == 1 ? 0 : -1;
+        return index == 0 ? 1 : -1;
+    case MathNode::Script:
+        // 基础0，下标1，上标2
+        if (up)
+            return index != 2 ? 2 : -1;
+        return index != 1 ? 1 : -1;
+    case MathNode::Radical:
+        // 被开方数0，根指数1（根指数在左上方）
+        if (up)
+            return index == 0 ? 1 : -1;
+        return index == 1 ? 0 : -1;
+    case MathNode::Matrix:
+    {
+        int target = up ? index - node->columns() : index + node->columns();
+        return target >= 0 && target < node->childCount() ? target : -1;
+    }
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief 离开当前槽位
+ * @param row 当前槽位
+ * @param forward 是否向后
+ * @return 新位置
+ */
+MathPosition MathNavigator::leaveSlot(const MathNode *row, bool forward)
+{
+    const MathNode *node = row->parent();
+    if (!node)
+        return MathPosition();
+
+    // 同一结构中还有可进入的槽位（矩阵按行优先顺序）
+    int slot = adjacentSlot(node, row->indexInParent(), forward);
+    if (slot >= 0)
+    {
+        const MathNode *target = node->child(slot);
+        return MathPosition::fromNode(target, forward ? 0 : target->childCount());
+    }
+
+    // 移到结构之前或之后
+    return MathPosition::fromNode(node->parent(), node->indexInParent() + (forward ? 1 : 0));
+}
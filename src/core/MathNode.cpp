@@ -0,0 +1,368 @@
+// ============================================================================
+// MathNode.cpp
+// 数学表达式节点类的实现文件
+// 表示公式的表达式树，节点缓存子树的结构哈希
+// ============================================================================
+
+#include "core/MathNode.h"
+#include <QHash>
+
+namespace {
+
+/**
+ * @brief 把一个值混入64位哈希（FNV-1a风格）
+ * @param hash 当前哈希
+ * @param value 要混入的值
+ * @return 新哈希
+ */
+quint64 mixHash(quint64 hash, quint64 value)
+{
+    hash ^= value;
+    hash *= 0x100000001b3ULL;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ * @param type 节点类型
+ * @param text 节点文本
+ */
+MathNode::MathNode(Type type, const QString &text)
+    : m_type(type),
+      m_text(text),
+      m_parent(nullptr),
+      m_index(-1),
+      m_columns(0),
+      m_hash(0),
+      m_hashValid(false),
+      m_layoutDirty(true),
+      m_contentChanged(true)
+{
+}
+
+/**
+ * @brief 析构函数
+ */
+MathNode::~MathNode()
+{
+    qDeleteAll(m_children);
+}
+
+/**
+ * @brief 创建节点并补齐固定的子节点
+ * @param type 节点类型
+ * @param text 节点文本
+ * @return 新节点
+ */
+MathNode *MathNode::create(Type type, const QString &text)
+{
+    MathNode *node = new MathNode(type, text);
+    int slots = 0;
+    switch (type)
+    {
+    case Fraction:
+    case Radical:
+        slots = 2;
+        break;
+    case Script:
+        slots = 3;
+        break;
+    case Delimited:
+        slots = 1;
+        if (node->m_text.length() != 2)
+            node->m_text = QStringLiteral("()");
+        break;
+    default:
+        break;
+    }
+    for (int i = 0; i < slots; i++)
+        node->appendChild(new MathNode(Row));
+    return node;
+}
+
+/**
+ * @brief 创建矩阵节点
+ * @param rows 行数
+ * @param columns 列数
+ * @param alignment 各列对齐方式
+ * @return 新节点
+ */
+MathNode *MathNode::createMatrix(int rows, int columns, const QString &alignment)
+{
+    MathNode *node = new MathNode(Matrix, alignment);
+    node->m_columns = qMax(1, columns);
+    int cells = qMax(1, rows) * node->m_columns;
+    node->m_children.reserve(cells);
+    for (int i = 0; i < cells; i++)
+        node->appendChild(new MathNode(Row));
+    return node;
+}
+
+/**
+ * @brief 深拷贝子树
+ * @return 新节点
+ */
+MathNode *MathNode::clone() const
+{
+    MathNode *node = new MathNode(m_type, m_text);
+    node->m_columns = m_columns;
+    node->m_children.reserve(m_children.size());
+    for (const MathNode *child : m_children)
+        node->appendChild(child->clone());
+    return node;
+}
+
+/**
+ * @brief 获取节点类型
+ * @return 节点类型
+ */
+MathNode::Type MathNode::type() const
+{
+    return m_type;
+}
+
+/**
+ * @brief 获取节点文本
+ * @return 节点文本
+ */
+QString MathNode::text() const
+{
+    return m_text;
+}
+
+/**
+ * @brief 设置节点文本
+ * @param text 节点文本
+ */
+void MathNode::setText(const QString &text)
+{
+    if (m_text == text)
+        return;
+    m_text = text;
+    invalidate();
+}
+
+/**
+ * @brief 获取父节点
+ * @return 父节点
+ */
+MathNode *MathNode::parent() const
+{
+    return m_parent;
+}
+
+/**
+ * @brief 获取本节点在父节点中的索引
+ * @return 索引
+ */
+int MathNode::indexInParent() const
+{
+    return m_parent ? m_index : -1;
+}
+
+/**
+ * @brief 获取子节点数量
+ * @return 子节点数量
+ */
+int MathNode::childCount() const
+{
+    return m_children.size();
+}
+
+/**
+ * @brief 获取子节点
+ * @param index 子节点索引
+ * @return 子节点
+ */
+MathNode *MathNode::child(int index) const
+{
+    return m_children.value(index, nullptr);
+}
+
+/**
+ * @brief 插入子节点
+ * @param index 插入位置
+ * @param child 子节点
+ */
+void MathNode::insertChild(int index, MathNode *child)
+{
+    if (!child || child->m_parent)
+        return;
+    index = qBound(0, index, m_children.size());
+    m_children.insert(index, child);
+    child->m_parent = this;
+    for (int i = index; i < m_children.size(); i++)
+        m_children[i]->m_index = i;
+    invalidate();
+}
+
+/**
+ * @brief 追加子节点
+ * @param child 子节点
+ */
+void MathNode::appendChild(MathNode *child)
+{
+    insertChild(m_children.size(), child);
+}
+
+/**
+ * @brief 取出子节点
+ * @param index 子节点索引
+ * @return 子节点
+ */
+MathNode *MathNode::takeChild(int index)
+{
+    if (index < 0 || index >= m_children.size())
+        return nullptr;
+    MathNode *child = m_children.takeAt(index);
+    child->m_parent = nullptr;
+    child->m_index = -1;
+    m_dirtyChildren.remove(child);
+    for (int i = index; i < m_children.size(); i++)
+        m_children[i]->m_index = i;
+    invalidate();
+    return child;
+}
+
+/**
+ * @brief 删除子节点
+ * @param index 子节点索引
+ */
+void MathNode::removeChild(int index)
+{
+    delete takeChild(index);
+}
+
+/**
+ * @brief 获取矩阵列数
+ * @return 列数
+ */
+int MathNode::columns() const
+{
+    return m_type == Matrix ? m_columns : 0;
+}
+
+/**
+ * @brief 获取矩阵行数
+ * @return 行数
+ */
+int MathNode::rows() const
+{
+    return m_type == Matrix && m_columns > 0 ? m_children.size() / m_columns : 0;
+}
+
+/**
+ * @brief 获取结构哈希
+ * @return 结构哈希
+ */
+quint64 MathNode::hash() const
+{
+    if (m_hashValid)
+        return m_hash;
+
+    // 只有被作废的节点需要重新组合，未修改的子节点直接返回缓存值
+    quint64 hash = mixHash(0xcbf29ce484222325ULL, static_cast<quint64>(m_type));
+    hash = mixHash(hash, static_cast<quint64>(qHash(m_text)));
+    hash = mixHash(hash, static_cast<quint64>(m_columns));
+    hash = mixHash(hash, static_cast<quint64>(m_children.size()));
+    for (const MathNode *child : m_children)
+        hash = mixHash(hash, child->hash());
+
+    m_hash = hash;
+    m_hashValid = true;
+    return m_hash;
+}
+
+/**
+ * @brief 获取子树节点总数
+ * @return 节点数
+ */
+int MathNode::nodeCount() const
+{
+    int count = 1;
+    for (const MathNode *child : m_children)
+        count += child->nodeCount();
+    return count;
+}
+
+/**
+ * @brief 获取缓存的排版结果
+ * @return 排版结果
+ */
+QSharedPointer<const FormulaLayout> MathNode::layout() const
+{
+    return m_layout;
+}
+
+/**
+ * @brief 获取缓存的盒子
+ * @return 盒子度量
+ */
+MathBox MathNode::box() const
+{
+    return m_box;
+}
+
+/**
+ * @brief 设置排版结果
+ * @param layout 排版结果
+ * @param box 盒子度量
+ */
+void MathNode::setLayout(const QSharedPointer<const FormulaLayout> &layout, const MathBox &box)
+{
+    m_layout = layout;
+    m_box = box;
+    m_layoutDirty = false;
+    m_contentChanged = false;
+    m_dirtyChildren.clear();
+}
+
+/**
+ * @brief 检查排版是否过期
+ * @return 是否过期
+ */
+bool MathNode::isLayoutDirty() const
+{
+    return m_layoutDirty;
+}
+
+/**
+ * @brief 检查自身内容是否已变化
+ * @return 是否已变化
+ */
+bool MathNode::isContentChanged() const
+{
+    return m_contentChanged;
+}
+
+/**
+ * @brief 获取自上次排版后排版过期的子节点
+ * @return 过期的子节点
+ */
+const QSet<MathNode *> &MathNode::dirtyChildren() const
+{
+    return m_dirtyChildren;
+}
+
+/**
+ * @brief 本节点内容变化，作废本节点及所有祖先的缓存
+ */
+void MathNode::invalidate()
+{
+    m_contentChanged = true;
+    // 有效的哈希/排版意味着子孙也有效，遇到两者都已作废的祖先即可停止；
+    // 停止前仍要把当前节点登记到父节点，它可能是该父节点新过期的子节点
+    for (MathNode *node = this; node; node = node->m_parent)
+    {
+        bool valid = node->m_hashValid || !node->m_layoutDirty;
+        node->m_hashValid = false;
+        node->m_layoutDirty = true;
+        if (node->m_parent)
+            node->m_parent->m_dirtyChildren.insert(node);
+        if (!valid)
+            break;
+    }
+}
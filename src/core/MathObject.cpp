@@ -0,0 +1,99 @@
+// ============================================================================
+// MathObject.cpp
+// 公式对象类的实现文件
+// 嵌入段落中的一个公式，拥有表达式树的根节点
+// ============================================================================
+
+#include "core/MathObject.h"
+
+const QChar MathObject::ReplacementCharacter = QChar(0xFFFC);
+
+/**
+ * @brief 构造函数
+ */
+MathObject::MathObject()
+    : m_root(new MathNode(MathNode::Row)),
+      m_numbered(false)
+{
+}
+
+/**
+ * @brief 构造函数
+ * @param root 根节点
+ */
+MathObject::MathObject(MathNode *root)
+    : m_root(root ? root : new MathNode(MathNode::Row)),
+      m_numbered(false)
+{
+}
+
+/**
+ * @brief 析构函数
+ */
+MathObject::~MathObject()
+{
+    delete m_root;
+}
+
+/**
+ * @brief 获取根节点
+ * @return 根节点
+ */
+MathNode *MathObject::root() const
+{
+    return m_root;
+}
+
+/**
+ * @brief 获取公式的结构哈希
+ * @return 结构哈希
+ */
+quint64 MathObject::hash() const
+{
+    return m_root->hash();
+}
+
+/**
+ * @brief 获取公式编译后的可求值表达式
+ * @return 可求值表达式
+ */
+QSharedPointer<const MathExpression> MathObject::expression() const
+{
+    return MathExpression::compile(m_root);
+}
+
+/**
+ * @brief 检查公式是否带编号
+ * @return 是否带编号
+ */
+bool MathObject::isNumbered() const
+{
+    return m_numbered;
+}
+
+/**
+ * @brief 设置公式是否带编号
+ * @param numbered 是否带编号
+ */
+void MathObject::setNumbered(bool numbered)
+{
+    m_numbered = numbered;
+}
+
+/**
+ * @brief 获取公式的标签
+ * @return 标签
+ */
+QString MathObject::label() const
+{
+    return m_label;
+}
+
+/**
+ * @brief 设置公式的标签
+ * @param label 标签
+ */
+void MathObject::setLabel(const QString &label)
+{
+    m_label = label;
+}
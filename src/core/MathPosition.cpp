@@ -0,0 +1,124 @@
+// ============================================================================
+// MathPosition.cpp
+// 公式内位置类的实现文件
+// 以从根节点到所在Row的子节点索引路径加Row内偏移表示公式中的光标位置
+// ============================================================================
+
+#include "core/MathPosition.h"
+#include "core/MathNode.h"
+#include <algorithm>
+
+/**
+ * @brief 构造函数
+ */
+MathPosition::MathPosition()
+    : m_offset(-1)
+{
+}
+
+/**
+ * @brief 构造函数
+ * @param path 子节点索引路径
+ * @param offset Row内的偏移
+ */
+MathPosition::MathPosition(const QVector<int> &path, int offset)
+    : m_path(path),
+      m_offset(offset)
+{
+}
+
+/**
+ * @brief 由Row节点和偏移构造位置
+ * @param row 所在的Row节点
+ * @param offset Row内的偏移
+ * @return 位置
+ */
+MathPosition MathPosition::fromNode(const MathNode *row, int offset)
+{
+    if (!row || offset < 0 || offset > row->childCount())
+        return MathPosition();
+
+    // 沿祖先链收集索引（节点缓存了自己在父节点中的索引），再反转为从根开始的顺序
+    QVector<int> path;
+    for (const MathNode *node = row; node->parent(); node = node->parent())
+        path.append(node->indexInParent());
+    std::reverse(path.begin(), path.end());
+    return MathPosition(path, offset);
+}
+
+/**
+ * @brief 获取子节点索引路径
+ * @return 路径
+ */
+const QVector<int> &MathPosition::path() const
+{
+    return m_path;
+}
+
+/**
+ * @brief 获取Row内的偏移
+ * @return 偏移
+ */
+int MathPosition::offset() const
+{
+    return m_offset;
+}
+
+/**
+ * @brief 获取嵌套深度
+ * @return 路径长度
+ */
+int MathPosition::depth() const
+{
+    return m_path.size();
+}
+
+/**
+ * @brief 检查位置是否有效
+ * @return 是否有效
+ */
+bool MathPosition::isValid() const
+{
+    return m_offset >= 0;
+}
+
+/**
+ * @brief 在给定的表达式树中解析所在的Row
+ * @param root 根节点
+ * @return Row节点
+ */
+MathNode *MathPosition::row(const MathNode *root) const
+{
+    if (!root || !isValid())
+        return nullptr;
+    MathNode *node = const_cast<MathNode *>(root);
+    for (int index : m_path)
+    {
+        node = node->child(index);
+        if (!node)
+            return nullptr;
+    }
+    if (node->type() != MathNode::Row || m_offset > node->childCount())
+        return nullptr;
+    return node;
+}
+
+/**
+ * @brief 比较两个位置是否相等
+ * @param other 另一个位置
+ * @return 是否相等
+ */
+bool MathPosition::operator==(const MathPosition &other) const
+{
+    return m_offset == other.m_offset && m_path == other.m_path;
+}
+
+/**
+ * @brief 比较两个位置是否不等
+ * @param other 另一个位置
+ * @return 是否不等
+ */
+bool MathPosition::operator!=(const MathPosition &other) const
+{
+    return !(*this == other);
+}
@@ -0,0 +1,346 @@
+// ============================================================================
+// MathTokenizer.cpp
+// 公式输入词法分析器类的实现文件
+// 在光标处增量识别LaTeX快捷输入（\alpha、\frac、^、_），直接转换为表达式树编辑
+// ============================================================================
+
+#include "core/MathTokenizer.h"
+#include "core/MathNode.h"
+#include "core/SymbolTrie.h"
+
+namespace {
+
+/**
+ * @brief 反斜杠符号的文本
+ */
+const QString Backslash = QStringLiteral("\\");
+
+/**
+ * @brief 按命令名创建结构节点
+ * @param name 命令名
+ * @param caretRow 输出：结构中光标应进入的Row
+ * @return 结构节点，不是结构命令时返回nullptr
+ */
+MathNode *createStructure(const QString &name, MathNode **caretRow)
+{
+    MathNode *node = nullptr;
+    if (name == QLatin1String("frac"))
+    {
+        node = MathNode::create(MathNode::Fraction);
+        *caretRow = node->child(0);
+    }
+    else if (name == QLatin1String("sqrt"))
+    {
+        node = MathNode::create(MathNode::Radical);
+        *caretRow = node->child(0);
+    }
+    else if (name == QLatin1String("matrix"))
+    {
+        node = MathNode::createMatrix(2, 2);
+        *caretRow = node->child(0);
+    }
+    else if (name == QLatin1String("pmatrix") || name == QLatin1String("bmatrix"))
+    {
+        node = MathNode::create(MathNode::Delimited, name.at(0) == QLatin1Char('p') ? QStringLiteral("()")
+                                                                                     : QStringLiteral("[]"));
+        MathNode *matrix = MathNode::createMatrix(2, 2);
+        node->child(0)->appendChild(matrix);
+        *caretRow = matrix->child(0);
+    }
+    return node;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ */
+MathTokenizer::MathTokenizer()
+    : m_root(nullptr),
+      m_tokenStart(-1),
+      m_edits(nullptr)
+{
+}
+
+/**
+ * @brief 处理一个输入字符并修改表达式树
+ * @param root 公式根节点
+ * @param caret 光标位置
+ * @param character 输入字符
+ * @return 输入后的光标位置
+ */
+MathPosition MathTokenizer::input(MathNode *root, const MathPosition &caret, QChar character)
+{
+    MathNode *row = caret.row(root);
+    if (!row)
+    {
+        reset();
+        return MathPosition();
+    }
+
+    // 词法状态只在上次输入结束的光标处有效，且记号窗口必须仍是反斜杠加命令名
+    if (root != m_root || caret != m_caret)
+        reset();
+    if (m_tokenStart >= 0)
+    {
+        MathNode *backslash = row->child(m_tokenStart);
+        if (!backslash || backslash->text() != Backslash
+            || m_tokenStart + 1 + m_command.length() != caret.offset())
+            reset();
+    }
+
+    MathPosition result;
+    if (m_tokenStart < 0)
+    {
+        result = insertCharacter(row, caret.offset(), character);
+    }
+    else if (character.isLetter())
+    {
+        // 命令名的字母先作为符号插入，命令结束时整体替换
+        beginReplace(row, caret.offset(), 0);
+        row->insertChild(caret.offset(), MathNode::create(MathNode::Symbol, QString(character)));
+        endReplace(row, 1);
+        m_command += character;
+        result = MathPosition::fromNode(row, caret.offset() + 1);
+    }
+    else
+    {
+        bool consumed = false;
+        result = finishCommand(row, caret.offset(), character, &consumed);
+        if (!consumed)
+        {
+            MathNode *resultRow = result.row(root);
+            result = insertCharacter(resultRow, result.offset(), character);
+        }
+    }
+
+    m_root = root;
+    m_caret = result;
+    return result;
+}
+
+/**
+ * @brief 结束尚未完成的命令记号
+ * @param root 公式根节点
+ * @param caret 光标位置
+ * @return 结束后的光标位置
+ */
+MathPosition MathTokenizer::flush(MathNode *root, const MathPosition &caret)
+{
+    if (!isPending() || root != m_root || caret != m_caret)
+    {
+        reset();
+        return caret;
+    }
+    MathNode *row = caret.row(root);
+    if (!row)
+    {
+        reset();
+        return caret;
+    }
+    bool consumed = false;
+    return finishCommand(row, caret.offset(), QLatin1Char(' '), &consumed);
+}
+
+/**
+ * @brief 丢弃词法状态
+ */
+void MathTokenizer::reset()
+{
+    m_root = nullptr;
+    m_caret = MathPosition();
+    m_tokenStart = -1;
+    m_command.clear();
+}
+
+/**
+ * @brief 设置编辑记录
+ * @param edits 编辑记录
+ */
+void MathTokenizer::setEditLog(QVector<MathEdit> *edits)
+{
+    m_edits = edits;
+}
+
+/**
+ * @brief 检查是否正在输入命令
+ * @return 是否有未完成的命令记号
+ */
+bool MathTokenizer::isPending() const
+{
+    return m_tokenStart >= 0;
+}
+
+/**
+ * @brief 查找命令对应的符号
+ * @param name 命令名
+ * @return 符号文本
+ */
+QString MathTokenizer::symbolForCommand(const QString &name)
+{
+    // 符号表与补全共用同一棵字典树，用户宏插入后也能直接转换
+    return SymbolTrie::shared()->symbol(name);
+}
+
+/**
+ * @brief 获取正在输入的命令名
+ * @return 命令名
+ */
+QString MathTokenizer::pendingCommand() const
+{
+    return m_tokenStart >= 0 ? m_command : QString();
+}
+
+/**
+ * @brief 以补全选中的命令结束正在输入的命令
+ * @param root 公式根节点
+ * @param caret 光标位置
+ * @param name 选中的命令名
+ * @return 结束后的光标位置
+ */
+MathPosition MathTokenizer::completeCommand(MathNode *root, const MathPosition &caret, const QString &name)
+{
+    if (!isPending() || root != m_root || caret != m_caret || name.isEmpty())
+        return caret;
+    MathNode *row = caret.row(root);
+    if (!row)
+    {
+        reset();
+        return caret;
+    }
+    // 记号窗口不变，只把命令名换成选中的命令
+    m_command = name;
+    bool consumed = false;
+    return finishCommand(row, caret.offset(), QLatin1Char(' '), &consumed);
+}
+
+/**
+ * @brief 在光标处处理一个字符
+ * @param row 光标所在的Row
+ * @param offset Row内的偏移
+ * @param character 输入字符
+ * @return 新的光标位置
+ */
+MathPosition MathTokenizer::insertCharacter(MathNode *row, int offset, QChar character)
+{
+    if (character == QLatin1Char('^'))
+        return attachScript(row, offset, 2);
+    if (character == QLatin1Char('_'))
+        return attachScript(row, offset, 1);
+    // 与TeX一致，数学模式中的空格不产生符号
+    if (character.isSpace())
+        return MathPosition::fromNode(row, offset);
+
+    if (character == QLatin1Char('\\'))
+    {
+        m_tokenStart = offset;
+        m_command.clear();
+    }
+    beginReplace(row, offset, 0);
+    row->insertChild(offset, MathNode::create(MathNode::Symbol, QString(character)));
+    endReplace(row, 1);
+    return MathPosition::fromNode(row, offset + 1);
+}
+
+/**
+ * @brief 结束命令记号
+ * @param row 光标所在的Row
+ * @param offset 记号窗口的结束偏移
+ * @param terminator 结束命令的字符
+ * @param consumed 输出：结束字符是否已被命令消耗
+ * @return 新的光标位置
+ */
+MathPosition MathTokenizer::finishCommand(MathNode *row, int offset, QChar terminator, bool *consumed)
+{
+    int start = m_tokenStart;
+    QString name = m_command;
+    m_tokenStart = -1;
+    m_command.clear();
+    *consumed = false;
+
+    QString symbol;
+    MathNode *structure = nullptr;
+    MathNode *caretRow = nullptr;
+    if (name.isEmpty())
+    {
+        // 转义字符：\{、\}、\_等，结果就是字符本身
+        symbol = QString(terminator);
+        *consumed = true;
+    }
+    else
+    {
+        structure = createStructure(name, &caretRow);
+        if (!structure)
+            symbol = symbolForCommand(name);
+        // 未知命令保留为普通符号
+        if (symbol.isEmpty() && !structure)
+            return MathPosition::fromNode(row, offset);
+        // 结束命令的空格属于命令本身
+        *consumed = terminator.isSpace();
+    }
+
+    // 只替换记号窗口中的节点
+    beginReplace(row, start, offset - start);
+    for (int i = offset - 1; i >= start; i--)
+        row->removeChild(i);
+    row->insertChild(start, structure ? structure : MathNode::create(MathNode::Symbol, symbol));
+    endReplace(row, 1);
+    if (structure)
+        return MathPosition::fromNode(caretRow, 0);
+    return MathPosition::fromNode(row, start + 1);
+}
+
+/**
+ * @brief 把光标前的节点包进上下标结构并进入角标槽位
+ * @param row 光标所在的Row
+ * @param offset Row内的偏移
+ * @param slot 角标槽位
+ * @return 新的光标位置
+ */
+MathPosition MathTokenizer::attachScript(MathNode *row, int offset, int slot)
+{
+    // 光标前已是上下标结构：进入其对应的角标槽位，而不是再嵌套一层
+    MathNode *previous = row->child(offset - 1);
+    if (previous && previous->type() == MathNode::Script)
+    {
+        MathNode *target = previous->child(slot);
+        return MathPosition::fromNode(target, target->childCount());
+    }
+
+    // 光标前的节点移入底数（保留其排版缓存），整体记为一次替换
+    MathNode *script = MathNode::create(MathNode::Script);
+    if (previous)
+        offset--;
+    beginReplace(row, offset, previous ? 1 : 0);
+    if (previous)
+        script->child(0)->appendChild(row->takeChild(offset));
+    row->insertChild(offset, script);
+    endReplace(row, 1);
+    return MathPosition::fromNode(script->child(slot), 0);
+}
+
+/**
+ * @brief 开始一次Row区间替换
+ * @param row 所在的Row
+ * @param index 区间起点
+ * @param count 将被替换的子节点数
+ */
+void MathTokenizer::beginReplace(const MathNode *row, int index, int count)
+{
+    if (m_edits)
+        m_edit = MathEdit::capture(row, index, count);
+}
+
+/**
+ * @brief 结束一次Row区间替换
+ * @param row 所在的Row
+ * @param count 插入的子节点数
+ */
+void MathTokenizer::endReplace(const MathNode *row, int count)
+{
+    if (!m_edits)
+        return;
+    m_edit.finish(row, count);
+    m_edits->append(m_edit);
+    m_edit = MathEdit();
+}
@@ -5,6 +5,24 @@
 // ============================================================================
 
 #include "core/Paragraph.h"
+#include "core/MathObject.h"
+#include "core/PlotObject.h"
+
+namespace {
+
+/**
+ * @brief 比较两个对象Run是否引用同一个对象
+ * @param a 第一个Run
+ * @param b 第二个Run
+ * @return 是否为同一对象且格式相同
+ */
+bool sameObject(const Run &a, const Run &b)
+{
+    return a.isObject() && b.isObject() && a.formula() == b.formula() && a.plot() == b.plot() &&
+           a.reference() == b.reference() && a.format() == b.format();
+}
+
+} // namespace
 
 /**
  * @brief 构造函数
@@ -122,6 +140,16 @@ void Paragraph::insertText(int position, const QString &text, const Format &form
         Run &run = m_runs[i];
         int runEnd = currentPos + run.length(); // 当前Run的结束位置
 
+        // 公式和交叉引用Run不能插入文本：位于其前方时插入新Run，位于其后方时交给下一个Run
+        if (run.isObject()) {
+            if (position == currentPos) {
+                m_runs.insert(i, Run(text, format));
+                return;
+            }
+            currentPos = runEnd;
+            continue;
+        }
+
         // 如果插入位置在当前Run范围内
         if (position >= currentPos && position <= runEnd) {
             int runPos = position - currentPos; // 计算在Run内部的相对位置
@@ -145,7 +173,11 @@ void Paragraph::removeText(int position, int length)
     if (length <= 0)
         return;
     
+    // 被完全删除的Run是连续的一段（只有首尾两个Run可能保留部分文本），最后一次移除
     int currentPos = 0;
+    int first = -1;
+    int firstEmpty = -1;
+    int emptyCount = 0;
     for (int i = 0; i < m_runs.size() && length > 0; i++)
     {
         Run &run = m_runs[i];
@@ -153,21 +185,362 @@ void Paragraph::removeText(int position, int length)
         
         if (position < runEnd)
         {
+            if (first < 0)
+                first = i;
             int runPos = position - currentPos;
             int runLength = qMin(length, runEnd - position);
             run.remove(runPos, runLength);
             length -= runLength;
             position += runLength;
             
-            // 如果Run为空，移除它
             if (run.length() == 0)
             {
-                m_runs.removeAt(i);
-                i--;
+                if (firstEmpty < 0)
+                    firstEmpty = i;
+                emptyCount++;
             }
         }
         currentPos = runEnd;
     }
+    if (emptyCount > 0)
+        m_runs.remove(firstEmpty, emptyCount);
+    // 删除处两侧的Run衔接在一起（如删除两段同格式文本之间的公式），只有这里可能出现相邻的同格式Run
+    if (first >= 0)
+        coalesceRuns(qMax(0, first - 1), qMin(m_runs.size(), first + 2));
+}
+
+/**
+ * @brief 在指定位置插入公式
+ * @param position 插入位置
+ * @param formula 公式对象
+ * @param format 公式格式
+ */
+void Paragraph::insertFormula(int position, const QSharedPointer<MathObject> &formula, const Format &format)
+{
+    if (!formula)
+        return;
+    m_runs.insert(splitRunAt(position), Run(formula, format));
+}
+
+/**
+ * @brief 在指定位置插入交叉引用
+ * @param position 插入位置
+ * @param label 所引用公式的标签
+ * @param format 引用格式
+ */
+void Paragraph::insertReference(int position, const QString &label, const Format &format)
+{
+    if (label.isEmpty())
+        return;
+    m_runs.insert(splitRunAt(position), Run::reference(label, format));
+}
+
+/**
+ * @brief 在指定位置插入函数图像
+ * @param position 插入位置
+ * @param plot 函数图像对象
+ * @param format 格式
+ */
+void Paragraph::insertPlot(int position, const QSharedPointer<PlotObject> &plot, const Format &format)
+{
+    if (!plot)
+        return;
+    m_runs.insert(splitRunAt(position), Run(plot, format));
+}
+
+/**
+ * @brief 在指定位置把段落一分为二
+ * @param position 拆分位置
+ * @return 位置之后的部分
+ */
+Paragraph Paragraph::split(int position)
+{
+    Paragraph tail;
+    int index = splitRunAt(qMax(0, position));
+    tail.m_runs = m_runs.mid(index);
+    m_runs.remove(index, m_runs.size() - index);
+    return tail;
+}
+
+/**
+ * @brief 把另一个段落接在本段落末尾
+ * @param next 接在末尾的段落
+ */
+void Paragraph::merge(const Paragraph &next)
+{
+    if (next.m_runs.isEmpty())
+        return;
+    int from = 0;
+    if (!m_runs.isEmpty())
+    {
+        Run &last = m_runs.last();
+        const Run &first = next.m_runs.first();
+        if (!last.isObject() && !first.isObject() && last.format() == first.format())
+        {
+            last.insert(last.length(), first.text());
+            from = 1;
+        }
+    }
+    m_runs.reserve(m_runs.size() + next.m_runs.size() - from);
+    for (int i = from; i < next.m_runs.size(); i++)
+        m_runs.append(next.m_runs.at(i));
+}
+
+/**
+ * @brief 截取段落的一部分
+ * @param position 起始位置
+ * @param length 长度，负数表示到段落末尾
+ * @return 截取的部分
+ */
+Paragraph Paragraph::mid(int position, int length) const
+{
+    Paragraph result;
+    position = qMax(0, position);
+    int end = length < 0 ? this->length() : position + length;
+    int currentPos = 0;
+    for (int i = 0; i < m_runs.size() && currentPos < end; i++)
+    {
+        const Run &run = m_runs.at(i);
+        int runEnd = currentPos + run.length();
+        if (runEnd > position)
+        {
+            // 对象Run长度为1，要么整个落在区间内，要么不在；文本Run裁掉区间外的部分
+            Run part = run;
+            if (runEnd > end)
+                part.remove(end - currentPos, runEnd - end);
+            if (currentPos < position)
+                part.remove(0, position - currentPos);
+            result.m_runs.append(part);
+        }
+        currentPos = runEnd;
+    }
+    return result;
+}
+
+/**
+ * @brief 计算与另一个段落开头相同的部分的长度
+ * @param other 另一个段落
+ * @return 相同前缀的字符数
+ */
+int Paragraph::commonPrefixLength(const Paragraph &other) const
+{
+    // 两个Run游标同步前进，a、b为各自当前Run中已比较的字符数
+    int length = 0;
+    int i = 0, j = 0;
+    int a = 0, b = 0;
+    while (i < m_runs.size() && j < other.m_runs.size())
+    {
+        const Run &x = m_runs.at(i);
+        const Run &y = other.m_runs.at(j);
+        if (x.isObject() || y.isObject())
+        {
+            if (a > 0 || b > 0 || !sameObject(x, y))
+                break;
+            length++;
+            i++;
+            j++;
+            continue;
+        }
+        if (x.format() != y.format())
+            break;
+        QString xs = x.text();
+        QString ys = y.text();
+        int n = qMin(xs.size() - a, ys.size() - b);
+        const QChar *p = xs.constData() + a;
+        const QChar *q = ys.constData() + b;
+        int k = 0;
+        // 未被修改的Run与原段落共享文本，同一块内存不必逐字比较
+        if (p == q)
+            k = n;
+        while (k < n && p[k] == q[k])
+            k++;
+        length += k;
+        if (k < n)
+            break;
+        a += k;
+        b += k;
+        if (a == xs.size())
+        {
+            i++;
+            a = 0;
+        }
+        if (b == ys.size())
+        {
+            j++;
+            b = 0;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief 计算与另一个段落末尾相同的部分的长度
+ * @param other 另一个段落
+ * @return 相同后缀的字符数
+ */
+int Paragraph::commonSuffixLength(const Paragraph &other) const
+{
+    // 与commonPrefixLength对称，从末尾向前比较，a、b为各自当前Run末尾已比较的字符数
+    int length = 0;
+    int i = m_runs.size() - 1, j = other.m_runs.size() - 1;
+    int a = 0, b = 0;
+    while (i >= 0 && j >= 0)
+    {
+        const Run &x = m_runs.at(i);
+        const Run &y = other.m_runs.at(j);
+        if (x.isObject() || y.isObject())
+        {
+            if (a > 0 || b > 0 || !sameObject(x, y))
+                break;
+            length++;
+            i--;
+            j--;
+            continue;
+        }
+        if (x.format() != y.format())
+            break;
+        QString xs = x.text();
+        QString ys = y.text();
+        int n = qMin(xs.size() - a, ys.size() - b);
+        const QChar *p = xs.constData() + xs.size() - a;
+        const QChar *q = ys.constData() + ys.size() - b;
+        int k = 0;
+        if (p == q)
+            k = n;
+        while (k < n && p[-1 - k] == q[-1 - k])
+            k++;
+        length += k;
+        if (k < n)
+            break;
+        a += k;
+        b += k;
+        if (a == xs.size())
+        {
+            i--;
+            a = 0;
+        }
+        if (b == ys.size())
+        {
+            j--;
+            b = 0;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief 设置一段文本的格式
+ * @param start 起始位置
+ * @param end 结束位置（不含）
+ * @param format 格式
+ */
+void Paragraph::applyFormat(int start, int end, const Format &format)
+{
+    if (end <= start)
+        return;
+    // 先拆起点再拆终点，终点的拆分不影响起点处的索引
+    int first = splitRunAt(qMax(0, start));
+    int last = splitRunAt(end);
+    for (int i = first; i < last; i++)
+        m_runs[i].setFormat(format);
+    // 只有区间内部和两端的衔接处可能出现相邻的同格式Run
+    coalesceRuns(qMax(0, first - 1), qMin(m_runs.size(), last + 1));
+}
+
+/**
+ * @brief 设置整个段落的格式
+ * @param format 格式
+ */
+void Paragraph::applyFormat(const Format &format)
+{
+    for (Run &run : m_runs)
+        run.setFormat(format);
+    coalesceRuns(0, m_runs.size());
+}
+
+/**
+ * @brief 获取段落中带编号的公式
+ * @return 带编号的公式（按出现顺序）
+ */
+QVector<const MathObject *> Paragraph::numberedFormulas() const
+{
+    QVector<const MathObject *> result;
+    for (const Run &run : m_runs)
+    {
+        if (run.isFormula() && run.formula()->isNumbered())
+            result.append(run.formula().data());
+    }
+    return result;
+}
+
+/**
+ * @brief 获取指定字符位置上的公式
+ * @param position 字符位置
+ * @return 公式对象
+ */
+QSharedPointer<MathObject> Paragraph::formulaAt(int position) const
+{
+    int currentPos = 0;
+    for (const Run &run : m_runs)
+    {
+        int runEnd = currentPos + run.length();
+        if (position < runEnd)
+            return position >= currentPos && run.isFormula() ? run.formula() : QSharedPointer<MathObject>();
+        currentPos = runEnd;
+    }
+    return QSharedPointer<MathObject>();
+}
+
+/**
+ * @brief 在指定位置拆分Run
+ * @param position 段落内的字符位置
+ * @return 从该位置开始的Run的索引
+ */
+int Paragraph::splitRunAt(int position)
+{
+    int currentPos = 0;
+    for (int i = 0; i < m_runs.size(); i++)
+    {
+        int runEnd = currentPos + m_runs[i].length();
+        if (position <= currentPos)
+            return i;
+        if (position < runEnd)
+        {
+            // 对象Run长度为1，不会走到这里；文本Run拆成前后两段
+            int offset = position - currentPos;
+            Run tail = m_runs[i];
+            tail.remove(0, offset);
+            m_runs[i].remove(offset, runEnd - position);
+            m_runs.insert(i + 1, tail);
+            return i + 1;
+        }
+        currentPos = runEnd;
+    }
+    return m_runs.size();
+}
+
+/**
+ * @brief 合并区间内相邻的同格式文本Run
+ * @param from 首个Run的索引
+ * @param to 末尾Run之后的索引
+ */
+void Paragraph::coalesceRuns(int from, int to)
+{
+    if (to - from < 2)
+        return;
+    // 原位压缩：可合并的Run接到前一个Run末尾，其余前移，最后一次删除多余的部分
+    int target = from;
+    for (int i = from + 1; i < to; i++)
+    {
+        Run &previous = m_runs[target];
+        const Run &current = m_runs.at(i);
+        if (!previous.isObject() && !current.isObject() && previous.format() == current.format())
+            previous.insert(previous.length(), current.text());
+        else if (++target != i)
+            m_runs[target] = current;
+    }
+    if (target + 1 < to)
+        m_runs.remove(target + 1, to - target - 1);
 }
 
 /**
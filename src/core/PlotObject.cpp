@@ -0,0 +1,94 @@
+// ============================================================================
+// PlotObject.cpp
+// 函数图像对象类的实现文件
+// 嵌入段落中的一个内联函数图像，绘制某个公式y=f(x)在给定区间上的图像
+// ============================================================================
+
+#include "core/PlotObject.h"
+
+/**
+ * @brief 构造函数
+ * @param function 函数公式
+ * @param xMin 区间左端
+ * @param xMax 区间右端
+ * @param width 图像宽度
+ */
+PlotObject::PlotObject(const QSharedPointer<MathObject> &function, double xMin, double xMax, int width)
+    : m_function(function),
+      m_xMin(xMin),
+      m_xMax(xMax > xMin ? xMax : xMin + 1),
+      m_width(qMax(1, width))
+{
+}
+
+/**
+ * @brief 获取函数公式
+ * @return 函数公式
+ */
+QSharedPointer<MathObject> PlotObject::function() const
+{
+    return m_function;
+}
+
+/**
+ * @brief 获取区间左端
+ * @return 区间左端
+ */
+double PlotObject::xMin() const
+{
+    return m_xMin;
+}
+
+/**
+ * @brief 获取区间右端
+ * @return 区间右端
+ */
+double PlotObject::xMax() const
+{
+    return m_xMax;
+}
+
+/**
+ * @brief 设置区间
+ * @param xMin 区间左端
+ * @param xMax 区间右端
+ */
+void PlotObject::setRange(double xMin, double xMax)
+{
+    if (xMax > xMin)
+    {
+        m_xMin = xMin;
+        m_xMax = xMax;
+    }
+}
+
+/**
+ * @brief 获取图像宽度
+ * @return 宽度
+ */
+int PlotObject::width() const
+{
+    return m_width;
+}
+
+/**
+ * @brief 设置图像宽度
+ * @param width 宽度
+ */
+void PlotObject::setWidth(int width)
+{
+    m_width = qMax(1, width);
+}
+
+/**
+ * @brief 获取自变量名
+ * @param expression 函数编译后的表达式
+ * @return 自变量名
+ */
+QString PlotObject::argument(const MathExpression &expression)
+{
+    QStringList variables = expression.variables();
+    if (variables.contains(QStringLiteral("x")))
+        return variables.size() == 1 ? QStringLiteral("x") : QString();
+    return variables.size() == 1 ? variables.first() : QString();
+}
@@ -5,6 +5,8 @@
 // ============================================================================
 
 #include "core/Run.h"
+#include "core/MathObject.h"
+#include "core/PlotObject.h"
 
 /**
  * @brief 构造函数
@@ -24,6 +26,102 @@ Run::Run(const QString &text, const Format &format)
 {
 }
 
+/**
+ * @brief 构造函数
+ * @param formula 公式对象
+ * @param format 公式格式
+ */
+Run::Run(const QSharedPointer<MathObject> &formula, const Format &format)
+    : m_text(MathObject::ReplacementCharacter), m_format(format), m_formula(formula)
+{
+}
+
+/**
+ * @brief 构造函数
+ * @param plot 函数图像对象
+ * @param format 格式
+ */
+Run::Run(const QSharedPointer<PlotObject> &plot, const Format &format)
+    : m_text(MathObject::ReplacementCharacter), m_format(format), m_plot(plot)
+{
+}
+
+/**
+ * @brief 创建一个交叉引用Run
+ * @param label 所引用公式的标签
+ * @param format 引用格式
+ * @return 交叉引用Run
+ */
+Run Run::reference(const QString &label, const Format &format)
+{
+    Run run(QString(MathObject::ReplacementCharacter), format);
+    run.m_reference = label;
+    return run;
+}
+
+/**
+ * @brief 检查是否为公式Run
+ * @return 是否为公式
+ */
+bool Run::isFormula() const
+{
+    return !m_formula.isNull();
+}
+
+/**
+ * @brief 获取公式对象
+ * @return 公式对象
+ */
+QSharedPointer<MathObject> Run::formula() const
+{
+    return m_formula;
+}
+
+/**
+ * @brief 检查是否为交叉引用Run
+ * @return 是否为交叉引用
+ */
+bool Run::isReference() const
+{
+    return !m_reference.isEmpty();
+}
+
+/**
+ * @brief 获取交叉引用的标签
+ * @return 标签
+ */
+QString Run::reference() const
+{
+    return m_reference;
+}
+
+/**
+ * @brief 检查是否为函数图像Run
+ * @return 是否为函数图像
+ */
+bool Run::isPlot() const
+{
+    return !m_plot.isNull();
+}
+
+/**
+ * @brief 获取函数图像对象
+ * @return 函数图像对象
+ */
+QSharedPointer<PlotObject> Run::plot() const
+{
+    return m_plot;
+}
+
+/**
+ * @brief 检查是否为占一个替换字符的对象Run
+ * @return 是否为对象
+ */
+bool Run::isObject() const
+{
+    return isFormula() || isReference() || isPlot();
+}
+
 /**
  * @brief 获取文本内容
  * @return 文本内容
@@ -0,0 +1,409 @@
+// ============================================================================
+// SymbolTrie.cpp
+// 命令符号字典树类的实现文件
+// 紧凑存储公式命令名及其符号，支持精确查找、按权重排序的前缀补全和模糊补全
+// ============================================================================
+
+#include "core/SymbolTrie.h"
+#include <queue>
+#include <algorithm>
+#include <utility>
+#include <climits>
+
+namespace {
+
+/**
+ * @struct BuiltinSymbol
+ * @brief 内置符号表中的一项
+ */
+struct BuiltinSymbol
+{
+    const char *name;    ///< 命令名
+    const char *symbol;  ///< 符号（UTF-8），结构命令为空串
+    int weight;          ///< 权重
+};
+
+/**
+ * @brief 内置符号表（权重按常用程度粗略划分：结构100，常用字母和运算符60到90，其余更低）
+ */
+const BuiltinSymbol BuiltinSymbols[] = {
+    // 结构
+    {"frac", "", 100}, {"sqrt", "", 95}, {"matrix", "", 70}, {"pmatrix", "", 75}, {"bmatrix", "", 72},
+    // 小写希腊字母
+    {"alpha", "α", 90}, {"beta", "β", 88}, {"gamma", "γ", 85}, {"delta", "δ", 85},
+    {"epsilon", "ε", 80}, {"varepsilon", "ε", 55}, {"zeta", "ζ", 60}, {"eta", "η", 65},
+    {"theta", "θ", 85}, {"vartheta", "ϑ", 40}, {"iota", "ι", 40}, {"kappa", "κ", 55},
+    {"lambda", "λ", 85}, {"mu", "μ", 85}, {"nu", "ν", 65}, {"xi", "ξ", 55},
+    {"omicron", "ο", 20}, {"pi", "π", 90}, {"varpi", "ϖ", 20}, {"rho", "ρ", 75},
+    {"varrho", "ϱ", 20}, {"sigma", "σ", 85}, {"varsigma", "ς", 25}, {"tau", "τ", 70},
+    {"upsilon", "υ", 35}, {"phi", "φ", 80}, {"varphi", "ϕ", 55}, {"chi", "χ", 55},
+    {"psi", "ψ", 70}, {"omega", "ω", 80},
+    // 大写希腊字母
+    {"Gamma", "Γ", 60}, {"Delta", "Δ", 75}, {"Theta", "Θ", 50}, {"Lambda", "Λ", 55},
+    {"Xi", "Ξ", 35}, {"Pi", "Π", 50}, {"Sigma", "Σ", 60}, {"Upsilon", "Υ", 25},
+    {"Phi", "Φ", 55}, {"Psi", "Ψ", 50}, {"Omega", "Ω", 65},
+    // 二元运算符
+    {"pm", "±", 85}, {"mp", "∓", 50}, {"times", "×", 90}, {"div", "÷", 75},
+    {"cdot", "⋅", 85}, {"ast", "∗", 40}, {"star", "⋆", 35}, {"circ", "∘", 55},
+    {"bullet", "∙", 40}, {"oplus", "⊕", 45}, {"ominus", "⊖", 30}, {"otimes", "⊗", 50},
+    {"oslash", "⊘", 20}, {"odot", "⊙", 30}, {"cup", "∪", 70}, {"cap", "∩", 70},
+    {"sqcup", "⊔", 20}, {"sqcap", "⊓", 20}, {"vee", "∨", 55}, {"wedge", "∧", 55},
+    {"setminus", "∖", 50}, {"wr", "≀", 10}, {"diamond", "⋄", 20}, {"bigtriangleup", "△", 15},
+    {"bigtriangledown", "▽", 15}, {"triangleleft", "◁", 15}, {"triangleright", "▷", 15},
+    {"uplus", "⊎", 15}, {"amalg", "⨿", 10}, {"dagger", "†", 25}, {"ddagger", "‡", 15},
+    // 关系符
+    {"le", "≤", 88}, {"leq", "≤", 85}, {"ge", "≥", 88}, {"geq", "≥", 85},
+    {"ne", "≠", 85}, {"neq", "≠", 80}, {"approx", "≈", 80}, {"equiv", "≡", 70},
+    {"sim", "∼", 60}, {"simeq", "≃", 40}, {"cong", "≅", 50}, {"propto", "∝", 55},
+    {"ll", "≪", 50}, {"gg", "≫", 50}, {"prec", "≺", 25}, {"succ", "≻", 25},
+    {"preceq", "⪯", 15}, {"succeq", "⪰", 15}, {"subset", "⊂", 70}, {"supset", "⊃", 55},
+    {"subseteq", "⊆", 70}, {"supseteq", "⊇", 50}, {"sqsubseteq", "⊑", 15}, {"sqsupseteq", "⊒", 15},
+    {"in", "∈", 90}, {"notin", "∉", 70}, {"ni", "∋", 35}, {"vdash", "⊢", 30},
+    {"dashv", "⊣", 15}, {"models", "⊨", 25}, {"perp", "⊥", 55}, {"parallel", "∥", 50},
+    {"mid", "∣", 55}, {"asymp", "≍", 20}, {"doteq", "≐", 15}, {"bowtie", "⋈", 10},
+    // 箭头
+    {"to", "→", 85}, {"rightarrow", "→", 75}, {"leftarrow", "←", 60}, {"gets", "←", 40},
+    {"leftrightarrow", "↔", 55}, {"Rightarrow", "⇒", 75}, {"Leftarrow", "⇐", 50},
+    {"Leftrightarrow", "⇔", 70}, {"implies", "⟹", 65}, {"impliedby", "⟸", 30}, {"iff", "⟺", 65},
+    {"mapsto", "↦", 65}, {"longrightarrow", "⟶", 40}, {"longleftarrow", "⟵", 25},
+    {"longmapsto", "⟼", 25}, {"uparrow", "↑", 45}, {"downarrow", "↓", 45},
+    {"updownarrow", "↕", 20}, {"Uparrow", "⇑", 20}, {"Downarrow", "⇓", 20},
+    {"nearrow", "↗", 20}, {"searrow", "↘", 20}, {"swarrow", "↙", 15}, {"nwarrow", "↖", 15},
+    {"hookrightarrow", "↪", 35}, {"hookleftarrow", "↩", 15}, {"rightharpoonup", "⇀", 15},
+    {"leftharpoonup", "↼", 10}, {"rightleftharpoons", "⇌", 30},
+    // 大型运算符
+    {"sum", "∑", 95}, {"prod", "∏", 80}, {"coprod", "∐", 25}, {"int", "∫", 95},
+    {"iint", "∬", 55}, {"iiint", "∭", 40}, {"oint", "∮", 55}, {"bigcup", "⋃", 55},
+    {"bigcap", "⋂", 55}, {"bigvee", "⋁", 25}, {"bigwedge", "⋀", 25}, {"bigoplus", "⨁", 35},
+    {"bigotimes", "⨂", 35}, {"bigodot", "⨀", 15}, {"biguplus", "⨄", 10}, {"bigsqcup", "⨆", 10},
+    // 杂项符号
+    {"infty", "∞", 92}, {"partial", "∂", 88}, {"nabla", "∇", 75}, {"forall", "∀", 80},
+    {"exists", "∃", 80}, {"nexists", "∄", 35}, {"emptyset", "∅", 70}, {"varnothing", "∅", 45},
+    {"neg", "¬", 50}, {"lnot", "¬", 25}, {"angle", "∠", 45}, {"triangle", "△", 40},
+    {"prime", "′", 55}, {"hbar", "ℏ", 55}, {"ell", "ℓ", 50}, {"wp", "℘", 15},
+    {"Re", "ℜ", 40}, {"Im", "ℑ", 40}, {"aleph", "ℵ", 35}, {"beth", "ℶ", 10},
+    {"top", "⊤", 25}, {"bot", "⊥", 30}, {"therefore", "∴", 45}, {"because", "∵", 40},
+    {"ldots", "…", 70}, {"cdots", "⋯", 75}, {"vdots", "⋮", 60}, {"ddots", "⋱", 55},
+    {"degree", "°", 45}, {"checkmark", "✓", 15}, {"clubsuit", "♣", 10}, {"diamondsuit", "♢", 10},
+    {"heartsuit", "♡", 10}, {"spadesuit", "♠", 10}, {"flat", "♭", 10}, {"natural", "♮", 10},
+    {"sharp", "♯", 10}, {"surd", "√", 20}, {"Box", "□", 15}, {"square", "□", 20},
+    {"blacksquare", "■", 15}, {"lozenge", "◊", 10},
+    // 数集
+    {"N", "ℕ", 50}, {"Z", "ℤ", 50}, {"Q", "ℚ", 45}, {"R", "ℝ", 60}, {"C", "ℂ", 50},
+    // 定界符
+    {"langle", "⟨", 60}, {"rangle", "⟩", 60}, {"lfloor", "⌊", 55}, {"rfloor", "⌋", 55},
+    {"lceil", "⌈", 50}, {"rceil", "⌉", 50}, {"lbrace", "{", 40}, {"rbrace", "}", 40},
+    {"vert", "|", 40}, {"Vert", "‖", 40}, {"lVert", "‖", 20}, {"rVert", "‖", 20},
+    // 函数名
+    {"sin", "sin", 85}, {"cos", "cos", 85}, {"tan", "tan", 75}, {"cot", "cot", 45},
+    {"sec", "sec", 40}, {"csc", "csc", 35}, {"arcsin", "arcsin", 45}, {"arccos", "arccos", 45},
+    {"arctan", "arctan", 50}, {"sinh", "sinh", 40}, {"cosh", "cosh", 40}, {"tanh", "tanh", 40},
+    {"log", "log", 85}, {"ln", "ln", 85}, {"lg", "lg", 30}, {"exp", "exp", 70},
+    {"lim", "lim", 90}, {"limsup", "lim sup", 35}, {"liminf", "lim inf", 35}, {"max", "max", 75},
+    {"min", "min", 75}, {"sup", "sup", 60}, {"inf", "inf", 60}, {"det", "det", 65},
+    {"dim", "dim", 45}, {"ker", "ker", 45}, {"deg", "deg", 35}, {"gcd", "gcd", 45},
+    {"arg", "arg", 40}, {"Pr", "Pr", 35}, {"hom", "hom", 20}
+};
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ */
+SymbolTrie::SymbolTrie()
+    : m_nodes(1)
+{
+}
+
+/**
+ * @brief 获取全应用共享的字典树
+ * @return 字典树
+ */
+SymbolTrie *SymbolTrie::shared()
+{
+    static SymbolTrie *trie = []() {
+        SymbolTrie *builtin = new SymbolTrie();
+        for (const BuiltinSymbol &item : BuiltinSymbols)
+            builtin->insert(QString::fromLatin1(item.name), QString::fromUtf8(item.symbol), item.weight);
+        return builtin;
+    }();
+    return trie;
+}
+
+/**
+ * @brief 插入或更新一个命令
+ * @param name 命令名
+ * @param symbol 命令对应的符号
+ * @param weight 权重
+ */
+void SymbolTrie::insert(const QString &name, const QString &symbol, int weight)
+{
+    if (name.isEmpty())
+        return;
+    weight = qMax(0, weight);
+
+    int node = 0;
+    m_nodes[node].best = qMax(m_nodes[node].best, weight);
+    for (QChar character : name)
+    {
+        // 在按字符排序的兄弟链表中查找，找不到时在有序位置插入新节点
+        ushort code = character.unicode();
+        int previous = -1;
+        int child = m_nodes[node].firstChild;
+        while (child >= 0 && m_nodes[child].character < code)
+        {
+            previous = child;
+            child = m_nodes[child].nextSibling;
+        }
+        if (child < 0 || m_nodes[child].character != code)
+        {
+            Node created;
+            created.character = code;
+            created.nextSibling = child;
+            int index = m_nodes.size();
+            m_nodes.append(created);
+            if (previous >= 0)
+                m_nodes[previous].nextSibling = index;
+            else
+                m_nodes[node].firstChild = index;
+            child = index;
+        }
+        node = child;
+        // 权重降低时祖先的最大权重不回退，只会让搜索多展开一些分支，不影响结果顺序
+        m_nodes[node].best = qMax(m_nodes[node].best, weight);
+    }
+
+    Entry entry;
+    entry.name = name;
+    entry.symbol = symbol;
+    entry.weight = weight;
+    if (m_nodes[node].entry >= 0)
+    {
+        m_entries[m_nodes[node].entry] = entry;
+    }
+    else
+    {
+        m_nodes[node].entry = m_entries.size();
+        m_entries.append(entry);
+    }
+}
+
+/**
+ * @brief 检查命令是否存在
+ * @param name 命令名
+ * @return 是否存在
+ */
+bool SymbolTrie::contains(const QString &name) const
+{
+    int node = findNode(name);
+    return node >= 0 && m_nodes.at(node).entry >= 0;
+}
+
+/**
+ * @brief 精确查找命令对应的符号
+ * @param name 命令名
+ * @return 符号
+ */
+QString SymbolTrie::symbol(const QString &name) const
+{
+    int node = findNode(name);
+    if (node < 0 || m_nodes.at(node).entry < 0)
+        return QString();
+    return m_entries.at(m_nodes.at(node).entry).symbol;
+}
+
+/**
+ * @brief 前缀补全
+ * @param prefix 已输入的前缀
+ * @param limit 最多返回的条数
+ * @return 补全候选
+ */
+QVector<SymbolCompletion> SymbolTrie::complete(const QString &prefix, int limit) const
+{
+    QVector<SymbolCompletion> results;
+    int node = findNode(prefix);
+    if (node >= 0 && limit > 0)
+        collect(QVector<int>() << node, QVector<int>(), limit, 0, &results);
+    return results;
+}
+
+/**
+ * @brief 模糊补全
+ * @param pattern 已输入的文本
+ * @param limit 最多返回的条数
+ * @param maxEdits 允许的最大编辑距离
+ * @return 补全候选
+ */
+QVector<SymbolCompletion> SymbolTrie::fuzzyComplete(const QString &pattern, int limit, int maxEdits) const
+{
+    QVector<SymbolCompletion> results;
+    if (limit <= 0)
+        return results;
+    maxEdits = qMax(0, maxEdits);
+
+    // 深度优先遍历，每个节点带着其路径前缀与pattern的编辑距离行
+    // 一行中的最小值是更深节点能达到的下界，超过maxEdits的分支直接剪掉
+    struct Frame
+    {
+        int node;
+        QVector<int> row;
+        int distance;  // 路径上各前缀的最小编辑距离
+    };
+    int length = pattern.length();
+    QVector<int> firstRow(length + 1);
+    for (int j = 0; j <= length; j++)
+        firstRow[j] = j;
+
+    // 子树候选（整棵子树同一距离）和单个命令候选，按距离分组
+    QVector<QVector<int>> subtrees(maxEdits + 1);
+    QVector<QVector<int>> entries(maxEdits + 1);
+
+    QVector<Frame> stack;
+    Frame root = {0, firstRow, INT_MAX};
+    stack.append(root);
+    while (!stack.isEmpty())
+    {
+        Frame frame = stack.takeLast();
+        const Node &node = m_nodes.at(frame.node);
+        int distance = qMin(frame.distance, frame.row.at(length));
+        int lowest = *std::min_element(frame.row.constBegin(), frame.row.constEnd());
+        if (distance <= maxEdits && lowest >= distance)
+        {
+            // 更深的前缀不会更接近，整棵子树都取这个距离
+            subtrees[distance].append(frame.node);
+            continue;
+        }
+        if (lowest > maxEdits)
+            continue;
+        if (node.entry >= 0 && distance <= maxEdits)
+            entries[distance].append(node.entry);
+
+        for (int child = node.firstChild; child >= 0; child = m_nodes.at(child).nextSibling)
+        {
+            QChar character(m_nodes.at(child).character);
+            QVector<int> row(length + 1);
+            row[0] = frame.row.at(0) + 1;
+            for (int j = 1; j <= length; j++)
+            {
+                int substitution = frame.row.at(j - 1) + (pattern.at(j - 1) == character ? 0 : 1);
+                row[j] = qMin(qMin(row[j - 1] + 1, frame.row.at(j) + 1), substitution);
+            }
+            Frame next = {child, row, distance};
+            stack.append(next);
+        }
+    }
+
+    // 距离小的优先，同一距离内按权重合并各候选
+    for (int distance = 0; distance <= maxEdits && results.size() < limit; distance++)
+        collect(subtrees.at(distance), entries.at(distance), limit - results.size(), distance, &results);
+    return results;
+}
+
+/**
+ * @brief 补全
+ * @param text 已输入的文本
+ * @param limit 最多返回的条数
+ * @return 补全候选
+ */
+QVector<SymbolCompletion> SymbolTrie::lookup(const QString &text, int limit) const
+{
+    QVector<SymbolCompletion> results = complete(text, limit);
+    if (results.size() >= limit)
+        return results;
+
+    // 前缀匹配的命令编辑距离为0，模糊补全中只取距离大于0的部分补足
+    for (const SymbolCompletion &completion : fuzzyComplete(text, limit, 1))
+    {
+        if (results.size() >= limit)
+            break;
+        if (completion.distance > 0)
+            results.append(completion);
+    }
+    return results;
+}
+
+/**
+ * @brief 获取命令数
+ * @return 命令数
+ */
+int SymbolTrie::size() const
+{
+    return m_entries.size();
+}
+
+/**
+ * @brief 获取节点数
+ * @return 节点数
+ */
+int SymbolTrie::nodeCount() const
+{
+    return m_nodes.size();
+}
+
+/**
+ * @brief 查找字符串对应的节点
+ * @param text 字符串
+ * @return 节点索引
+ */
+int SymbolTrie::findNode(const QString &text) const
+{
+    int node = 0;
+    for (QChar character : text)
+    {
+        ushort code = character.unicode();
+        int child = m_nodes.at(node).firstChild;
+        while (child >= 0 && m_nodes.at(child).character < code)
+            child = m_nodes.at(child).nextSibling;
+        if (child < 0 || m_nodes.at(child).character != code)
+            return -1;
+        node = child;
+    }
+    return node;
+}
+
+/**
+ * @brief 按权重取若干子树和单个命令中的前若干个命令
+ * @param nodes 子树根节点
+ * @param entries 单个命令
+ * @param limit 最多取的条数
+ * @param distance 写入候选的编辑距离
+ * @param results 结果
+ */
+void SymbolTrie::collect(const QVector<int> &nodes, const QVector<int> &entries, int limit, int distance,
+                         QVector<SymbolCompletion> *results) const
+{
+    // 最优优先：队列中节点的键是子树最大权重，命令的键是自身权重（以负数编号区分）；
+    // 弹出命令时队列中已没有更大的权重，因此结果按权重降序，且只展开必要的分支
+    std::priority_queue<std::pair<int, int>> queue;
+    for (int node : nodes)
+    {
+        if (m_nodes.at(node).best >= 0)
+            queue.push(std::make_pair(m_nodes.at(node).best, node));
+    }
+    for (int entry : entries)
+        queue.push(std::make_pair(m_entries.at(entry).weight, -(entry + 1)));
+
+    int added = 0;
+    while (!queue.empty() && added < limit)
+    {
+        std::pair<int, int> top = queue.top();
+        queue.pop();
+        if (top.second < 0)
+        {
+            const Entry &entry = m_entries.at(-top.second - 1);
+            SymbolCompletion completion;
+            completion.name = entry.name;
+            completion.symbol = entry.symbol;
+            completion.distance = distance;
+            completion.weight = entry.weight;
+            results->append(completion);
+            added++;
+            continue;
+        }
+        const Node &current = m_nodes.at(top.second);
+        if (current.entry >= 0)
+            queue.push(std::make_pair(m_entries.at(current.entry).weight, -(current.entry + 1)));
+        for (int child = current.firstChild; child >= 0; child = m_nodes.at(child).nextSibling)
+            queue.push(std::make_pair(m_nodes.at(child).best, child));
+    }
+}
@@ -0,0 +1,233 @@
+// ============================================================================
+// UndoJournal.cpp
+// 撤销日志类的实现文件
+// 把较旧或较大的撤销步骤压缩后追加到磁盘上的临时文件，回放时通过内存映射读取
+// ============================================================================
+
+#include "core/UndoJournal.h"
+#include "core/UndoStack.h"
+#include <QDataStream>
+#include <QDir>
+
+namespace {
+
+/**
+ * @brief Run在记录中的类型标记
+ */
+enum RunTag : quint8
+{
+    TextRun = 0,    ///< 文本Run：文本和格式写入记录
+    ObjectRun = 1   ///< 对象Run：记录对象表中的序号
+};
+
+/**
+ * @brief 写入一个段落
+ * @param stream 数据流
+ * @param paragraph 段落
+ * @param objects 对象表
+ */
+void writeParagraph(QDataStream &stream, const Paragraph &paragraph, QVector<Run> *objects)
+{
+    stream << qint32(paragraph.runCount());
+    for (int i = 0; i < paragraph.runCount(); i++)
+    {
+        Run run = paragraph.run(i);
+        if (run.isObject())
+        {
+            stream << quint8(ObjectRun) << qint32(objects->size());
+            objects->append(run);
+        }
+        else
+        {
+            Format format = run.format();
+            stream << quint8(TextRun) << run.text() << format.font() << format.color();
+        }
+    }
+}
+
+/**
+ * @brief 读取一个段落
+ * @param stream 数据流
+ * @param objects 对象表
+ * @param paragraph 输出：段落
+ * @return 是否读取成功
+ */
+bool readParagraph(QDataStream &stream, const QVector<Run> &objects, Paragraph *paragraph)
+{
+    qint32 count = 0;
+    stream >> count;
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        quint8 tag = 0;
+        stream >> tag;
+        if (tag == ObjectRun)
+        {
+            qint32 index = -1;
+            stream >> index;
+            if (index < 0 || index >= objects.size())
+                return false;
+            paragraph->addRun(objects.at(index));
+        }
+        else
+        {
+            QString text;
+            QFont font;
+            QColor color;
+            stream >> text >> font >> color;
+            paragraph->addRun(Run(text, Format(font, color)));
+        }
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief 写入一组段落
+ */
+void writeParagraphs(QDataStream &stream, const QVector<Paragraph> &paragraphs, QVector<Run> *objects)
+{
+    stream << qint32(paragraphs.size());
+    for (const Paragraph &paragraph : paragraphs)
+        writeParagraph(stream, paragraph, objects);
+}
+
+/**
+ * @brief 读取一组段落
+ */
+bool readParagraphs(QDataStream &stream, const QVector<Run> &objects, QVector<Paragraph> *paragraphs)
+{
+    qint32 count = 0;
+    stream >> count;
+    if (count < 0)
+        return false;
+    paragraphs->reserve(count);
+    for (qint32 i = 0; i < count; i++)
+    {
+        Paragraph paragraph;
+        if (!readParagraph(stream, objects, &paragraph))
+            return false;
+        paragraphs->append(paragraph);
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ */
+UndoJournal::UndoJournal()
+    : m_file(QDir::tempPath() + QStringLiteral("/MathEditor-undo-XXXXXX.journal"))
+{
+}
+
+/**
+ * @brief 追加一条记录
+ * @param changes 段落区间替换
+ * @param objects 输出：记录中引用的对象Run
+ * @param offset 输出：记录在文件中的偏移
+ * @param size 输出：记录的长度
+ * @return 是否写入成功
+ */
+bool UndoJournal::write(const QVector<ParagraphChange> &changes, QVector<Run> *objects, qint64 *offset, qint64 *size)
+{
+    if (!open())
+        return false;
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    QVector<Run> table;
+    stream << qint32(changes.size());
+    for (const ParagraphChange &change : changes)
+    {
+        stream << qint32(change.first) << qint32(change.offset) << qint32(change.suffix);
+        writeParagraphs(stream, change.before, &table);
+        writeParagraphs(stream, change.after, &table);
+    }
+
+    // 只追加：已写入的记录从不改写，记录的偏移在步骤的整个生命周期内有效
+    QByteArray record = qCompress(payload);
+    qint64 end = m_file.size();
+    if (!m_file.seek(end) || m_file.write(record) != record.size() || !m_file.flush())
+    {
+        m_file.resize(end);
+        return false;
+    }
+    *objects = table;
+    *offset = end;
+    *size = record.size();
+    return true;
+}
+
+/**
+ * @brief 读取一条记录
+ * @param offset 记录在文件中的偏移
+ * @param size 记录的长度
+ * @param objects 记录中引用的对象Run
+ * @param changes 输出：段落区间替换
+ * @return 是否读取成功
+ */
+bool UndoJournal::read(qint64 offset, qint64 size, const QVector<Run> &objects, QVector<ParagraphChange> *changes)
+{
+    if (!m_file.isOpen() || offset < 0 || size <= 0 || offset + size > m_file.size())
+        return false;
+
+    // 映射记录所在的区域，直接从映射的内存解压
+    uchar *data = m_file.map(offset, size);
+    if (!data)
+        return false;
+    QByteArray payload = qUncompress(QByteArray::fromRawData(reinterpret_cast<const char *>(data), size));
+    m_file.unmap(data);
+    if (payload.isEmpty())
+        return false;
+
+    QDataStream stream(payload);
+    qint32 count = 0;
+    stream >> count;
+    if (count < 0)
+        return false;
+    QVector<ParagraphChange> result;
+    result.reserve(count);
+    for (qint32 i = 0; i < count; i++)
+    {
+        ParagraphChange change;
+        qint32 first = 0;
+        qint32 offset = 0;
+        qint32 suffix = 0;
+        stream >> first >> offset >> suffix;
+        change.first = first;
+        change.offset = offset;
+        change.suffix = suffix;
+        if (!readParagraphs(stream, objects, &change.before) || !readParagraphs(stream, objects, &change.after))
+            return false;
+        result.append(change);
+    }
+    *changes = result;
+    return true;
+}
+
+/**
+ * @brief 清空日志
+ */
+void UndoJournal::clear()
+{
+    if (m_file.isOpen())
+        m_file.resize(0);
+}
+
+/**
+ * @brief 获取日志文件的大小
+ * @return 字节数
+ */
+qint64 UndoJournal::size() const
+{
+    return m_file.isOpen() ? m_file.size() : 0;
+}
+
+/**
+ * @brief 按需创建临时文件
+ * @return 文件是否可用
+ */
+bool UndoJournal::open()
+{
+    return m_file.isOpen() || m_file.open();
+}
@@ -0,0 +1,429 @@
+// ============================================================================
+// UndoStack.cpp
+// 撤销栈类的实现文件
+// 以段落区间的替换记录每次编辑的增量，支持撤销重做、连续输入合并和内存预算，较旧的步骤溢出到磁盘日志
+// ============================================================================
+
+#include "core/UndoStack.h"
+#include "core/Document.h"
+#include <algorithm>
+
+/**
+ * @brief 构造函数
+ * 创建一个空撤销栈
+ */
+UndoStack::UndoStack()
+    : m_index(0),
+      m_budget(DEFAULT_MEMORY_BUDGET),
+      m_usage(0),
+      m_coalescing(false)
+{
+}
+
+/**
+ * @brief 压入一个步骤
+ * @param command 编辑步骤
+ */
+void UndoStack::push(const EditCommand &command)
+{
+    if (command.changes.isEmpty())
+        return;
+
+    // 新的编辑使之后的步骤不可重做
+    while (m_commands.size() > m_index)
+    {
+        m_usage -= m_commands.last().cost;
+        m_commands.removeLast();
+    }
+
+    // 记录的是完整段落，入栈前只留下被删除和插入的片段
+    EditCommand compacted = command;
+    for (ParagraphChange &change : compacted.changes)
+        compact(&change);
+
+    if (!coalesce(compacted))
+    {
+        m_commands.append(compacted);
+        m_commands.last().cost = estimateCost(compacted);
+        m_usage += m_commands.last().cost;
+        m_index = m_commands.size();
+        // 大段粘贴、全部替换等大步骤直接溢出，不占用最近步骤的内存
+        if (m_commands.last().cost > LARGE_STEP_COST)
+            spill(m_index - 1);
+    }
+    m_coalescing = command.kind == EditCommand::Typing;
+    trim();
+}
+
+/**
+ * @brief 检查是否可以撤销
+ * @return 是否可以撤销
+ */
+bool UndoStack::canUndo() const
+{
+    return m_index > 0;
+}
+
+/**
+ * @brief 检查是否可以重做
+ * @return 是否可以重做
+ */
+bool UndoStack::canRedo() const
+{
+    return m_index < m_commands.size();
+}
+
+/**
+ * @brief 撤销一步
+ * @param document 文档
+ * @return 被撤销的步骤
+ */
+const EditCommand *UndoStack::undo(Document *document)
+{
+    if (!document || !canUndo())
+        return nullptr;
+    const EditCommand *command = load(m_index - 1);
+    if (!command)
+        return nullptr;
+    m_index--;
+    // 先在原处撤销公式的修改，再按相反顺序把每处区间换回修改前的段落
+    for (int i = command->formulas.size() - 1; i >= 0; i--)
+    {
+        const FormulaChange &change = command->formulas.at(i);
+        for (int j = change.edits.size() - 1; j >= 0; j--)
+            change.edits.at(j).undo(change.formula->root());
+        change.formula->setNumbered(change.numberedBefore);
+        change.formula->setLabel(change.labelBefore);
+    }
+    for (int i = command->changes.size() - 1; i >= 0; i--)
+    {
+        const ParagraphChange &change = command->changes.at(i);
+        apply(document, change, change.after, change.before);
+    }
+    m_coalescing = false;
+    return command;
+}
+
+/**
+ * @brief 重做一步
+ * @param document 文档
+ * @return 被重做的步骤
+ */
+const EditCommand *UndoStack::redo(Document *document)
+{
+    if (!document || !canRedo())
+        return nullptr;
+    const EditCommand *command = load(m_index);
+    if (!command)
+        return nullptr;
+    m_index++;
+    for (const FormulaChange &change : command->formulas)
+    {
+        for (const MathEdit &edit : change.edits)
+            edit.redo(change.formula->root());
+        change.formula->setNumbered(change.numberedAfter);
+        change.formula->setLabel(change.labelAfter);
+    }
+    for (const ParagraphChange &change : command->changes)
+        apply(document, change, change.before, change.after);
+    m_coalescing = false;
+    return command;
+}
+
+/**
+ * @brief 禁止下一次输入与栈顶合并
+ */
+void UndoStack::breakCoalescing()
+{
+    m_coalescing = false;
+}
+
+/**
+ * @brief 获取步骤数
+ * @return 步骤数
+ */
+int UndoStack::count() const
+{
+    return m_commands.size();
+}
+
+/**
+ * @brief 获取当前位置
+ * @return 当前位置
+ */
+int UndoStack::index() const
+{
+    return m_index;
+}
+
+/**
+ * @brief 设置内存预算
+ * @param bytes 字节数
+ */
+void UndoStack::setMemoryBudget(qint64 bytes)
+{
+    m_budget = bytes;
+    trim();
+}
+
+/**
+ * @brief 获取内存预算
+ * @return 字节数
+ */
+qint64 UndoStack::memoryBudget() const
+{
+    return m_budget;
+}
+
+/**
+ * @brief 获取各步骤估计占用的内存
+ * @return 字节数
+ */
+qint64 UndoStack::memoryUsage() const
+{
+    return m_usage;
+}
+
+/**
+ * @brief 获取磁盘日志的大小
+ * @return 字节数
+ */
+qint64 UndoStack::journalSize() const
+{
+    return m_journal.size();
+}
+
+/**
+ * @brief 清空撤销栈
+ */
+void UndoStack::clear()
+{
+    m_commands.clear();
+    m_loaded = EditCommand();
+    m_index = 0;
+    m_usage = 0;
+    m_coalescing = false;
+    m_journal.clear();
+}
+
+/**
+ * @brief 估计一个步骤占用的内存
+ * @param command 编辑步骤
+ * @return 字节数
+ */
+qint64 UndoStack::estimateCost(const EditCommand &command)
+{
+    qint64 bytes = sizeof(EditCommand) + command.text.size() * sizeof(QChar) + command.objects.size() * sizeof(Run);
+    for (const ParagraphChange &change : command.changes)
+    {
+        bytes += sizeof(ParagraphChange);
+        for (const Paragraph &paragraph : change.before)
+            bytes += sizeof(Paragraph) + paragraph.runCount() * sizeof(Run) + paragraph.length() * sizeof(QChar);
+        for (const Paragraph &paragraph : change.after)
+            bytes += sizeof(Paragraph) + paragraph.runCount() * sizeof(Run) + paragraph.length() * sizeof(QChar);
+    }
+    for (const FormulaChange &change : command.formulas)
+    {
+        bytes += sizeof(FormulaChange) + (change.labelBefore.size() + change.labelAfter.size()) * sizeof(QChar);
+        for (const MathEdit &edit : change.edits)
+            bytes += sizeof(MathEdit) + edit.nodeCount() * sizeof(MathNode);
+    }
+    return bytes;
+}
+
+/**
+ * @brief 去掉替换首尾未变化的部分
+ * @param change 段落区间替换
+ */
+void UndoStack::compact(ParagraphChange *change)
+{
+    // 插入或删除整段时没有可以去掉的部分
+    if (change->before.isEmpty() || change->after.isEmpty())
+        return;
+    Paragraph &beforeFirst = change->before.first();
+    Paragraph &afterFirst = change->after.first();
+    int offset = beforeFirst.commonPrefixLength(afterFirst);
+
+    // 只有一段时前缀和后缀不能重叠
+    const Paragraph &beforeLast = change->before.last();
+    const Paragraph &afterLast = change->after.last();
+    int beforeLimit = change->before.size() == 1 ? beforeLast.length() - offset : beforeLast.length();
+    int afterLimit = change->after.size() == 1 ? afterLast.length() - offset : afterLast.length();
+    int suffix = qMin(beforeLast.commonSuffixLength(afterLast), qMin(beforeLimit, afterLimit));
+
+    if (suffix > 0)
+    {
+        change->before.last() = beforeLast.mid(0, beforeLast.length() - suffix);
+        change->after.last() = afterLast.mid(0, afterLast.length() - suffix);
+    }
+    if (offset > 0)
+    {
+        beforeFirst = beforeFirst.mid(offset);
+        afterFirst = afterFirst.mid(offset);
+    }
+    change->offset = offset;
+    change->suffix = suffix;
+}
+
+/**
+ * @brief 在文档中应用一处替换
+ * @param document 文档
+ * @param change 段落区间替换
+ * @param from 文档中当前的片段
+ * @param to 替换后的片段
+ */
+void UndoStack::apply(Document *document, const ParagraphChange &change,
+                      const QVector<Paragraph> &from, const QVector<Paragraph> &to)
+{
+    if (change.offset == 0 && change.suffix == 0)
+    {
+        document->replaceParagraphs(change.first, from.size(), to);
+        return;
+    }
+
+    // 把首段开头和末段末尾未变化的部分接回片段，得到完整的段落
+    QVector<Paragraph> paragraphs = to;
+    Paragraph head = document->paragraph(change.first).mid(0, change.offset);
+    Paragraph last = document->paragraph(change.first + from.size() - 1);
+    head.merge(paragraphs.first());
+    paragraphs.first() = head;
+    paragraphs.last().merge(last.mid(last.length() - change.suffix));
+    document->replaceParagraphs(change.first, from.size(), paragraphs);
+}
+
+/**
+ * @brief 尝试把连续输入并入栈顶
+ * @param command 编辑步骤
+ * @return 是否已合并
+ */
+bool UndoStack::coalesce(const EditCommand &command)
+{
+    if (!m_coalescing || m_index == 0 || command.kind != EditCommand::Typing || command.text.isEmpty())
+        return false;
+    EditCommand &top = m_commands[m_index - 1];
+    if (top.kind != EditCommand::Typing || top.text.isEmpty() || top.journalOffset >= 0 ||
+        !(top.cursorAfter == command.cursorBefore))
+        return false;
+    if (top.changes.size() != 1 || command.changes.size() != 1)
+        return false;
+    ParagraphChange &previous = top.changes.first();
+    const ParagraphChange &current = command.changes.first();
+    if (previous.first != current.first || previous.after.size() != 1 ||
+        current.before.size() != 1 || current.after.size() != 1)
+        return false;
+    // 本次替换的部分必须落在上一步插入的片段之内（含两端），才能把两步合成一处替换
+    const Paragraph &inserted = previous.after.first();
+    int start = current.offset - previous.offset;
+    int removed = current.before.first().length();
+    if (start < 0 || start + removed > inserted.length())
+        return false;
+    // 公式中的输入只与同一公式中的输入合并
+    if (top.formulas.size() != command.formulas.size() || top.formulas.size() > 1 ||
+        (!top.formulas.isEmpty() && top.formulas.first().formula != command.formulas.first().formula))
+        return false;
+    // 单词边界：上一步以空白结尾而本次以非空白开头时另起一步
+    if (top.text.back().isSpace() && !command.text.front().isSpace())
+        return false;
+
+    Paragraph merged = inserted.mid(0, start);
+    merged.merge(current.after.first());
+    merged.merge(inserted.mid(start + removed));
+    previous.after.first() = merged;
+    if (!top.formulas.isEmpty())
+    {
+        FormulaChange &formula = top.formulas.first();
+        const FormulaChange &next = command.formulas.first();
+        formula.edits += next.edits;
+        formula.numberedAfter = next.numberedAfter;
+        formula.labelAfter = next.labelAfter;
+    }
+    top.text += command.text;
+    top.cursorAfter = command.cursorAfter;
+    m_usage -= top.cost;
+    top.cost = estimateCost(top);
+    m_usage += top.cost;
+    return true;
+}
+
+/**
+ * @brief 按内存预算溢出或丢弃最旧的步骤
+ */
+void UndoStack::trim()
+{
+    // 先把最旧的步骤溢出到磁盘日志，最近的若干步留在内存中以便快速撤销
+    bool journalFailed = false;
+    for (int i = 0; m_usage > m_budget && !journalFailed && i < m_index - RECENT_STEPS; i++)
+        journalFailed = !spill(i);
+
+    // 最近的步骤本身超出预算：从最大的开始溢出，历史不丢弃
+    if (m_usage > m_budget && !journalFailed)
+    {
+        QVector<int> recent;
+        for (int i = qMax(0, m_index - RECENT_STEPS); i < m_commands.size(); i++)
+        {
+            if (m_commands.at(i).journalOffset < 0)
+                recent.append(i);
+        }
+        std::sort(recent.begin(), recent.end(), [this](int a, int b) {
+            return m_commands.at(a).cost > m_commands.at(b).cost;
+        });
+        for (int i = 0; m_usage > m_budget && !journalFailed && i < recent.size(); i++)
+            journalFailed = !spill(recent.at(i));
+    }
+    if (!journalFailed)
+        return;
+
+    // 只有日志不可用时才丢弃最旧的步骤，至少保留最新的一步；
+    // 每一步的cost就是它当前计入m_usage的部分（已溢出的步骤只剩对象表）
+    int drop = 0;
+    while (m_usage > m_budget && drop < m_index - 1)
+        m_usage -= m_commands.at(drop++).cost;
+    if (drop == 0)
+        return;
+    m_commands.remove(0, drop);
+    m_index -= drop;
+}
+
+/**
+ * @brief 把一个步骤溢出到磁盘日志
+ * @param index 步骤序号
+ * @return 是否已溢出
+ */
+bool UndoStack::spill(int index)
+{
+    EditCommand &command = m_commands[index];
+    if (command.journalOffset >= 0)
+        return true;
+    if (!m_journal.write(command.changes, &command.objects, &command.journalOffset, &command.journalSize))
+    {
+        command.journalOffset = -1;
+        return false;
+    }
+    command.changes.clear();
+    command.changes.squeeze();
+    m_usage -= command.cost;
+    command.cost = estimateCost(command);
+    m_usage += command.cost;
+    return true;
+}
+
+/**
+ * @brief 获取步骤的段落区间替换
+ * @param index 步骤序号
+ * @return 步骤，读取失败时返回nullptr
+ */
+const EditCommand *UndoStack::load(int index)
+{
+    const EditCommand &command = m_commands.at(index);
+    if (command.journalOffset < 0)
+        return &command;
+
+    // 溢出的步骤：映射日志读出段落区间替换，放在临时副本中，应用后即可释放
+    m_loaded = command;
+    if (!m_journal.read(command.journalOffset, command.journalSize, command.objects, &m_loaded.changes))
+    {
+        m_loaded = EditCommand();
+        return nullptr;
+    }
+    return &m_loaded;
+}
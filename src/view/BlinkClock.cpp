@@ -0,0 +1,125 @@
+// ============================================================================
+// BlinkClock.cpp
+// 光标闪烁时钟类的实现文件
+// 全应用共享的闪烁时钟，统一驱动所有光标的闪烁
+// ============================================================================
+
+#include "view/BlinkClock.h"
+#include <QTimer>
+#include <QGuiApplication>
+#include <QStyleHints>
+
+/**
+ * @brief 获取全局闪烁时钟
+ * @return 闪烁时钟
+ */
+BlinkClock *BlinkClock::instance()
+{
+    static BlinkClock *clock = new BlinkClock(QCoreApplication::instance());
+    return clock;
+}
+
+/**
+ * @brief 构造函数
+ * @param parent 父对象
+ */
+BlinkClock::BlinkClock(QObject *parent)
+    : QObject(parent),
+      m_timer(new QTimer(this)),
+      m_visiblePhase(true),
+      m_applicationActive(true)
+{
+    // 使用系统的光标闪烁时间（一个完整周期），半个周期切换一次
+    int flashTime = QGuiApplication::styleHints()->cursorFlashTime();
+    m_timer->setInterval(flashTime > 0 ? flashTime / 2 : DEFAULT_INTERVAL);
+    connect(m_timer, &QTimer::timeout, this, &BlinkClock::onTimeout);
+
+    m_applicationActive = QGuiApplication::applicationState() == Qt::ApplicationActive;
+    connect(qGuiApp, &QGuiApplication::applicationStateChanged,
+            this, &BlinkClock::onApplicationStateChanged);
+}
+
+/**
+ * @brief 注册一个正在闪烁的光标
+ * @param cursor 光标对象
+ */
+void BlinkClock::addCursor(const QObject *cursor)
+{
+    m_cursors.insert(cursor);
+    updateTimer();
+}
+
+/**
+ * @brief 注销一个光标
+ * @param cursor 光标对象
+ */
+void BlinkClock::removeCursor(const QObject *cursor)
+{
+    m_cursors.remove(cursor);
+    updateTimer();
+}
+
+/**
+ * @brief 重新开始一个周期
+ */
+void BlinkClock::restart()
+{
+    if (!m_visiblePhase)
+    {
+        m_visiblePhase = true;
+        emit phaseChanged(m_visiblePhase);
+    }
+    if (m_timer->isActive())
+        m_timer->start(); // 重新计时
+}
+
+/**
+ * @brief 当前是否处于可见相位
+ * @return 是否可见
+ */
+bool BlinkClock::isVisiblePhase() const
+{
+    return m_visiblePhase;
+}
+
+/**
+ * @brief 定时器触发，切换相位
+ */
+void BlinkClock::onTimeout()
+{
+    m_visiblePhase = !m_visiblePhase;
+    emit phaseChanged(m_visiblePhase);
+}
+
+/**
+ * @brief 应用状态变化
+ * @param state 应用状态
+ */
+void BlinkClock::onApplicationStateChanged(Qt::ApplicationState state)
+{
+    m_applicationActive = state == Qt::ApplicationActive;
+    updateTimer();
+}
+
+/**
+ * @brief 根据光标数量和应用状态启动或停止定时器
+ */
+void BlinkClock::updateTimer()
+{
+    bool shouldRun = m_applicationActive && !m_cursors.isEmpty()
+                     && QGuiApplication::styleHints()->cursorFlashTime() > 0;
+    if (shouldRun && !m_timer->isActive())
+    {
+        m_timer->start();
+    }
+    else if (!shouldRun && m_timer->isActive())
+    {
+        m_timer->stop();
+        // 停止时保持可见相位，恢复时光标立即显示
+        if (!m_visiblePhase)
+        {
+            m_visiblePhase = true;
+            emit phaseChanged(m_visiblePhase);
+        }
+    }
+}
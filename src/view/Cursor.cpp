@@ -5,7 +5,10 @@
 // ============================================================================
 
 #include "view/Cursor.h"
+#include "view/BlinkClock.h"
 #include <QPainter>
+#include <QFontMetricsF>
+#include <QtMath>
 
 /**
  * @brief 构造函数
@@ -13,9 +16,22 @@
  * @param graphicsParent 图形父项
  */
 Cursor::Cursor(QObject *parent, QGraphicsItem *graphicsParent)
-    : QObject(parent), QGraphicsItem(graphicsParent), m_visible(true), m_blinkTimer(new QTimer(this))
+    : QObject(parent), QGraphicsItem(graphicsParent),
+      m_visible(true), m_blinking(false), m_suspended(false)
 {
-    connect(m_blinkTimer, &QTimer::timeout, this, &Cursor::toggleVisibility);
+    // 光标高度只依赖固定的排版字体，计算一次即可
+    QFont font("Microsoft YaHei", 12);
+    QFontMetricsF metrics(font);
+    m_height = qCeil(metrics.height());
+}
+
+/**
+ * @brief 析构函数
+ */
+Cursor::~Cursor()
+{
+    if (m_blinking)
+        BlinkClock::instance()->removeCursor(this);
 }
 
 /**
@@ -25,7 +41,9 @@ Cursor::Cursor(QObject *parent, QGraphicsItem *graphicsParent)
 void Cursor::setPosition(const Selection::Position &position)
 {
     m_position = position;
-    update();
+    // 移动光标后立即显示，重新开始闪烁周期
+    if (m_blinking && !m_suspended)
+        BlinkClock::instance()->restart();
 }
 
 /**
@@ -37,13 +55,21 @@ Selection::Position Cursor::position() const
     return m_position;
 }
 
+/**
+ * @brief 设置光标在场景中的坐标（对齐到整像素）
+ * @param point 场景坐标
+ */
+void Cursor::setAlignedPos(const QPointF &point)
+{
+    setPos(qRound(point.x()), qRound(point.y()));
+}
+
 /**
  * @brief 显示光标
  */
 void Cursor::show()
 {
-    m_visible = true;
-    update();
+    setCaretVisible(true);
 }
 
 /**
@@ -51,8 +77,7 @@ void Cursor::show()
  */
 void Cursor::hide()
 {
-    m_visible = false;
-    update();
+    setCaretVisible(false);
 }
 
 /**
@@ -69,7 +94,17 @@ bool Cursor::isVisible() const
  */
 void Cursor::startBlinking()
 {
-    m_blinkTimer->start(BLINK_INTERVAL);
+    if (m_blinking)
+        return;
+    m_blinking = true;
+    if (!m_suspended)
+    {
+        BlinkClock *clock = BlinkClock::instance();
+        connect(clock, &BlinkClock::phaseChanged, this, &Cursor::onBlinkPhaseChanged);
+        clock->addCursor(this);
+        clock->restart();
+        setCaretVisible(clock->isVisiblePhase());
+    }
 }
 
 /**
@@ -77,9 +112,47 @@ void Cursor::startBlinking()
  */
 void Cursor::stopBlinking()
 {
-    m_blinkTimer->stop();
-    m_visible = true;
-    update();
+    if (m_blinking)
+    {
+        m_blinking = false;
+        BlinkClock *clock = BlinkClock::instance();
+        disconnect(clock, &BlinkClock::phaseChanged, this, &Cursor::onBlinkPhaseChanged);
+        clock->removeCursor(this);
+    }
+    if (!m_suspended)
+        setCaretVisible(true);
+}
+
+/**
+ * @brief 暂停或恢复光标
+ * @param suspended 是否暂停
+ */
+void Cursor::setSuspended(bool suspended)
+{
+    if (m_suspended == suspended)
+        return;
+    m_suspended = suspended;
+
+    BlinkClock *clock = BlinkClock::instance();
+    if (suspended)
+    {
+        if (m_blinking)
+        {
+            disconnect(clock, &BlinkClock::phaseChanged, this, &Cursor::onBlinkPhaseChanged);
+            clock->removeCursor(this);
+        }
+        setCaretVisible(false);
+    }
+    else
+    {
+        if (m_blinking)
+        {
+            connect(clock, &BlinkClock::phaseChanged, this, &Cursor::onBlinkPhaseChanged);
+            clock->addCursor(this);
+            clock->restart();
+        }
+        setCaretVisible(true);
+    }
 }
 
 /**
@@ -88,11 +161,8 @@ void Cursor::stopBlinking()
  */
 QRectF Cursor::boundingRect() const
 {
-    // 获取字体度量
-    QFont font("Microsoft YaHei", 12);
-    QFontMetrics metrics(font);
-    int height = metrics.height();
-    return QRectF(0, 0, 1, height); // 调整光标宽度为1像素
+    // 宽1像素、高度取整，配合setAlignedPos使重绘区域恰好覆盖光标所在像素
+    return QRectF(0, 0, 1, m_height);
 }
 
 /**
@@ -108,21 +178,27 @@ void Cursor::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QW
     
     if (m_visible)
     {
-        // 获取字体度量 - 使用浮点版本
-        QFont font("Microsoft YaHei", 12);
-        QFontMetricsF metrics(font);
-        qreal height = metrics.height();
-        
-        painter->setPen(QPen(Qt::black, 1.0)); // 使用浮点宽度
-        painter->drawLine(QPointF(0, 0), QPointF(0, height)); // 使用浮点坐标绘制
+        painter->fillRect(QRectF(0, 0, 1, m_height), Qt::black);
     }
 }
 
 /**
- * @brief 切换可见性
+ * @brief 闪烁相位变化
+ * @param visible 是否可见
+ */
+void Cursor::onBlinkPhaseChanged(bool visible)
+{
+    setCaretVisible(visible);
+}
+
+/**
+ * @brief 设置可见性，仅在变化时重绘
+ * @param visible 是否可见
  */
-void Cursor::toggleVisibility()
+void Cursor::setCaretVisible(bool visible)
 {
-    m_visible = !m_visible;
+    if (m_visible == visible)
+        return;
+    m_visible = visible;
     update();
 }
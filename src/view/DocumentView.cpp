@@ -5,13 +5,19 @@
 // ============================================================================
 
 #include "view/DocumentView.h"
-#include <QGraphicsTextItem>
-#include <QTextDocument>
+#include "view/ParagraphItem.h"
+#include "view/SelectionItem.h"
+#include "view/PreeditItem.h"
+#include "view/TileRenderer.h"
+#include "view/ReferenceItem.h"
+#include "view/PlotSampler.h"
+#include "core/PlotObject.h"
 #include <QMouseEvent>
 #include <QKeyEvent>
-#include <QFontMetrics>
 #include <QGuiApplication>
 #include <QInputMethod>
+#include <QSet>
+#include <algorithm>
 
 /**
  * @brief 构造函数
@@ -21,12 +27,37 @@ DocumentView::DocumentView(QWidget *parent)
     : QGraphicsView(parent),
       m_scene(new QGraphicsScene(this)),          // 图形场景，用于管理文档的可视化元素
       m_document(nullptr),                        // 文档指针，初始化为空，后续通过setDocument设置
+      m_layoutEngine(new TextLayoutEngine(this)), // 后台排版引擎，在线程池中整形段落
+      m_layoutScheduler(new LayoutScheduler(this)), // 布局调度器，合并同一周期内的布局请求
+      m_nextStamp(0),                             // 段落内容戳计数器
+      m_positionsDirtyFrom(-1),                   // 需要重新定位的首个段落，-1表示无
+      m_tileCache(new TileCache(this)),           // 文本瓦片缓存，滚动时直接贴图
+      m_tileRenderer(new TileRenderer(this)),     // 后台瓦片渲染器，并行绘制新露出的瓦片
+      m_tileCacheEnabled(true),                   // 默认启用瓦片缓存
+      m_formulaLayoutCache(new FormulaLayoutCache(this)), // 公式排版缓存，按结构哈希共享
+      m_mathLayoutEngine(new MathLayoutEngine(m_formulaLayoutCache, this)), // 数学排版引擎，按节点增量排版
       m_cursor(new Cursor(this)),                 // 光标对象，用于显示和控制文本插入点
+      m_selectionItem(new SelectionItem(this)),   // 选择高亮覆盖层，拖动选择时不触发重新排版
       m_selecting(false),                         // 选择状态标志，用于跟踪鼠标拖拽选择操作
-      m_composingTextItem(nullptr) // 组合文本项指针，用于显示输入法的临时组合字符
+      m_preeditItem(new PreeditItem()),            // 预编辑层，常驻场景，用于内联显示输入法的组合字符
+      m_preeditParagraphItem(nullptr),            // 组合期间被裁剪的段落项
+      m_preeditPosition({-1, -1}),                // 组合开始时的位置
+      m_equationRevision(0),                      // 已绘制的公式编号修订号
+      m_numberDigits(0),                          // 编号预留的位数，构造后设为至少三位
+      m_plotSampler(new PlotSampler(this)),       // 函数图像采样器，各图像共享采样缓存
+      m_textFont("Microsoft YaHei", 12),          // 正文字体，只创建一次
+      m_textMetrics(m_textFont),                  // 正文字体度量，热路径上直接使用
+      m_numberWidth(0)                            // 编号预留宽度，随位数更新
 {
+    setNumberDigits(3);
     setScene(m_scene); // 设置当前视图的场景为m_scene
     m_scene->addItem(m_cursor); // 将光标对象添加到场景中
+    m_scene->addItem(m_selectionItem); // 将选择高亮覆盖层添加到场景中
+    m_preeditItem->setFont(m_textFont);
+    m_preeditItem->hide();
+    m_scene->addItem(m_preeditItem); // 将预编辑层添加到场景中（只创建一次）
+    m_mathLayoutEngine->setFormat(Format(QFont("Cambria Math", 12)));
+    m_mathLayoutEngine->setDpi(logicalDpiY());
     setDragMode(NoDrag); // 禁用拖拽模式
     setRenderHint(QPainter::Antialiasing); // 启用抗锯齿渲染
     setAlignment(Qt::AlignLeft | Qt::AlignTop); // 设置文本对齐方式为左对齐和顶部对齐
@@ -35,6 +66,11 @@ DocumentView::DocumentView(QWidget *parent)
     setFrameStyle(QFrame::NoFrame);                // 无边框
     setViewportMargins(0, 0, 0, 0);               // 无内边距
     
+    // 选择覆盖层覆盖整个场景，只在场景矩形变化时改变几何
+    connect(m_scene, &QGraphicsScene::sceneRectChanged, this, [this](const QRectF &rect) {
+        m_selectionItem->setExtent(rect);
+    });
+    
     // 设置一个默认场景矩形，防止显示问题
     m_scene->setSceneRect(0, 0, 800, 600);
 
@@ -42,6 +78,13 @@ DocumentView::DocumentView(QWidget *parent)
     setFocusPolicy(Qt::NoFocus);
     // 禁用输入法（父部件会处理）
     setAttribute(Qt::WA_InputMethodEnabled, false);
+
+    // 后台排版结果回到GUI线程后逐批提交
+    connect(m_layoutEngine, &TextLayoutEngine::layoutsReady, this, &DocumentView::onLayoutsReady);
+    // 每个事件循环周期最多执行一次布局
+    connect(m_layoutScheduler, &LayoutScheduler::layoutRequested, this, &DocumentView::updateLayout);
+    // 后台光栅化的瓦片回到GUI线程后合成
+    connect(m_tileRenderer, &TileRenderer::tileReady, this, &DocumentView::onTileReady);
 }
 
 /**
@@ -60,7 +103,24 @@ void DocumentView::setDocument(Document *document)
         m_cursor->setPosition(startPos);
     }
     
-    updateLayout();
+    // 新文档：丢弃未完成的排版，重建所有段落项
+    m_layoutEngine->cancel();
+    m_pendingItems.clear();
+    m_pendingFormulas.clear();
+    m_plotSampler->clear();
+    if (m_document) {
+        m_equationRevision = m_document->equationIndex().revision();
+        setNumberDigits(qMax(3, QString::number(m_document->equationIndex().count()).length()));
+    }
+    for (ParagraphItem *item : m_paragraphItems)
+        destroyParagraphItem(item);
+    m_paragraphItems.clear();
+    m_paragraphTops.clear();
+    m_placedItems.clear();
+    m_tileRenderer->cancelAll();
+    m_tileCache->clear();
+    m_scene->invalidate(m_scene->sceneRect(), QGraphicsScene::ForegroundLayer);
+    scheduleLayout();
 }
 
 /**
@@ -86,9 +146,10 @@ void DocumentView::setSelection(const Selection &selection)
         {
             m_cursor->setPosition(m_selection.start());
             QPointF cursorPoint = pointFromPosition(m_selection.start());
-            m_cursor->setPos(cursorPoint);
+            m_cursor->setAlignedPos(cursorPoint);
         }
-        updateLayout(); // 可能不需要，但保留
+        // 选择变化不影响文本排版，只重绘高亮变化的行
+        m_selectionItem->setSelection(m_selection);
         emit selectionChanged(m_selection);
         // 关键：通知输入法更新
         updateInputMethod();
@@ -113,78 +174,607 @@ Cursor *DocumentView::cursor() const
     return m_cursor;
 }
 
+/**
+ * @brief 获取布局调度器
+ * @return 布局调度器指针
+ */
+LayoutScheduler *DocumentView::layoutScheduler() const
+{
+    return m_layoutScheduler;
+}
+
+/**
+ * @brief 调度布局
+ * @param first 第一个段落索引
+ * @param last 最后一个段落索引，-1表示到文档末尾
+ */
+void DocumentView::scheduleLayout(int first, int last)
+{
+    int count = m_document ? m_document->paragraphCount() : 0;
+    if (last < 0 || last >= count)
+        last = count - 1;
+    first = qMax(0, first);
+
+    // 段落项数量会在布局时同步，这里只处理已有的项
+    invalidateParagraphs(first, qMin(last, m_paragraphItems.size() - 1));
+    m_layoutScheduler->markDirty(first, last);
+}
+
+/**
+ * @brief 应用段落范围变化
+ * @param first 变化的起始段落
+ * @param removed 被替换的段落数
+ * @param inserted 替换后的段落数
+ */
+void DocumentView::applyParagraphChange(int first, int removed, int inserted)
+{
+    if (first < 0 || first > m_paragraphItems.size())
+    {
+        // 与段落项不一致，退化为整篇重新排版
+        scheduleLayout();
+        return;
+    }
+    removed = qMin(removed, m_paragraphItems.size() - first);
+
+    // 复用被替换的段落项，只增删差额部分；新段落在排版结果到达前按默认行高占位
+    int reused = qMin(removed, inserted);
+    for (int i = reused; i < removed; i++)
+        destroyParagraphItem(m_paragraphItems[first + i]);
+    if (removed > reused)
+    {
+        m_paragraphItems.remove(first + reused, removed - reused);
+        m_paragraphTops.remove(first + reused, removed - reused);
+    }
+    if (inserted > reused)
+    {
+        m_paragraphItems.insert(first + reused, inserted - reused, nullptr);
+        for (int i = reused; i < inserted; i++)
+            m_paragraphItems[first + i] = createParagraphItem();
+        m_paragraphTops.insert(first + reused, inserted - reused, m_textMetrics.height());
+    }
+
+    // 段落数量变化时，其后的段落整体移动（复用的段落项位置不变）
+    if (removed != inserted)
+        m_positionsDirtyFrom = m_positionsDirtyFrom < 0 ? first : qMin(m_positionsDirtyFrom, first);
+
+    m_layoutScheduler->adjustForSplice(first, removed, inserted);
+    invalidateParagraphs(first, first + inserted - 1);
+    m_layoutScheduler->markDirty(first, first + inserted - 1);
+}
+
+/**
+ * @brief 按顺序应用一次编辑中的全部段落范围变化
+ * @param changes 段落区间替换
+ */
+void DocumentView::applyParagraphChanges(const QVector<ParagraphSplice> &changes)
+{
+    for (const ParagraphSplice &change : changes)
+        applyParagraphChange(change.first, change.removed, change.inserted);
+}
+
+/**
+ * @brief 记录一个段落宽度
+ * @param width 段落宽度
+ */
+void DocumentView::trackParagraphWidth(qreal width)
+{
+    m_paragraphWidths[width]++;
+}
+
+/**
+ * @brief 移除一个段落宽度的记录
+ * @param width 段落宽度
+ */
+void DocumentView::untrackParagraphWidth(qreal width)
+{
+    auto it = m_paragraphWidths.find(width);
+    if (it != m_paragraphWidths.end() && --it.value() == 0)
+        m_paragraphWidths.erase(it);
+}
+
+/**
+ * @brief 为指定范围的段落分配新的内容戳
+ * @param first 第一个段落索引
+ * @param last 最后一个段落索引
+ */
+void DocumentView::invalidateParagraphs(int first, int last)
+{
+    for (int i = first; i <= last; i++)
+    {
+        ParagraphItem *item = m_paragraphItems[i];
+        m_pendingItems.remove(item->stamp());
+        m_pendingFormulas.remove(item->stamp());
+        item->setStamp(++m_nextStamp);
+        m_pendingItems.insert(item->stamp(), item);
+    }
+}
+
+/**
+ * @brief 创建段落图形项并加入场景
+ * @return 新的段落图形项
+ */
+ParagraphItem *DocumentView::createParagraphItem()
+{
+    ParagraphItem *item = new ParagraphItem();
+    // 启用瓦片缓存时文本由瓦片绘制，段落项只保存排版结果和公式子项
+    item->setTextVisible(!m_tileCacheEnabled);
+    // 进入视口附近时才放置并显示
+    item->hide();
+    m_scene->addItem(item);
+    trackParagraphWidth(item->paragraphLayout().width);
+    return item;
+}
+
+/**
+ * @brief 从场景中移除并销毁段落图形项
+ * @param item 段落图形项
+ */
+void DocumentView::destroyParagraphItem(ParagraphItem *item)
+{
+    if (item == m_preeditParagraphItem)
+        m_preeditParagraphItem = nullptr;
+    m_placedItems.removeOne(item);
+    m_pendingItems.remove(item->stamp());
+    m_pendingFormulas.remove(item->stamp());
+    untrackParagraphWidth(item->paragraphLayout().width);
+    m_scene->removeItem(item);
+    delete item;
+}
+
+/**
+ * @brief 作废段落图形项所覆盖的瓦片并请求重绘
+ * @param paragraph 段落索引
+ */
+void DocumentView::invalidateTiles(int paragraph)
+{
+    if (paragraph < 0 || paragraph >= m_paragraphItems.size())
+        return;
+    invalidateTiles(m_paragraphItems[paragraph]->boundingRect().translated(10, 10 + paragraphTop(paragraph)));
+}
+
+/**
+ * @brief 作废与矩形重叠的瓦片并请求重绘
+ * @param rect 场景矩形
+ */
+void DocumentView::invalidateTiles(const QRectF &rect)
+{
+    if (rect.isEmpty())
+        return;
+    m_tileCache->invalidate(rect);
+    m_tileRenderer->cancelIntersecting(rect);
+    // 启用瓦片时段落项是隐藏的，需要显式请求重绘前景层
+    if (m_tileCacheEnabled)
+        m_scene->invalidate(rect, QGraphicsScene::ForegroundLayer);
+}
+
+/**
+ * @brief 收集与矩形相交的段落快照
+ * @param rect 场景矩形
+ * @return 段落快照
+ */
+QVector<TileParagraph> DocumentView::tileParagraphs(const QRectF &rect) const
+{
+    QVector<TileParagraph> paragraphs;
+    if (m_paragraphItems.isEmpty())
+        return paragraphs;
+
+    // 位置取自段落顶部偏移索引，瓦片中的段落项不必已放置
+    int first = qMin(paragraphAt(rect.top()), m_paragraphItems.size() - 1);
+    int last = qMin(paragraphAt(rect.bottom()), m_paragraphItems.size() - 1);
+    qreal top = 10 + paragraphTop(first);
+    for (int i = first; i <= last; top += paragraphHeight(i), i++) {
+        const ParagraphItem *item = m_paragraphItems[i];
+        if (!item->boundingRect().translated(10, top).intersects(rect))
+            continue;
+        TileParagraph paragraph;
+        paragraph.position = QPointF(10, top);
+        paragraph.glyphRuns = item->paragraphLayout().glyphRuns;
+        paragraph.clipWidth = item->clipWidth();
+        paragraph.height = item->paragraphLayout().height;
+        paragraphs.append(paragraph);
+    }
+    return paragraphs;
+}
+
+/**
+ * @brief 启用或禁用瓦片缓存
+ * @param enabled 是否启用
+ */
+void DocumentView::setTileCacheEnabled(bool enabled)
+{
+    if (m_tileCacheEnabled == enabled)
+        return;
+    m_tileCacheEnabled = enabled;
+    m_tileRenderer->cancelAll();
+    m_tileCache->clear();
+    for (ParagraphItem *item : m_paragraphItems)
+        item->setTextVisible(!enabled);
+    m_scene->invalidate(m_scene->sceneRect(), QGraphicsScene::ForegroundLayer);
+}
+
+/**
+ * @brief 检查瓦片缓存是否启用
+ * @return 是否启用
+ */
+bool DocumentView::isTileCacheEnabled() const
+{
+    return m_tileCacheEnabled;
+}
+
+/**
+ * @brief 获取瓦片缓存
+ * @return 瓦片缓存
+ */
+TileCache *DocumentView::tileCache() const
+{
+    return m_tileCache;
+}
+
+/**
+ * @brief 获取数学排版引擎
+ * @return 数学排版引擎
+ */
+MathLayoutEngine *DocumentView::mathLayoutEngine() const
+{
+    return m_mathLayoutEngine;
+}
+
+/**
+ * @brief 绘制前景
+ * @param painter 画笔
+ * @param rect 暴露区域（场景坐标）
+ */
+void DocumentView::drawForeground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+    if (!m_tileCacheEnabled)
+        return;
+
+    // 瓦片按设备像素比和视图缩放光栅化，贴图时一个瓦片像素对应一个设备像素；
+    // 比例变化（缩放）时缓存被清空，按旧比例排队的瓦片全部取消
+    qreal ratio = viewport()->devicePixelRatioF() * transform().m11();
+    if (!qFuzzyCompare(ratio, m_tileCache->devicePixelRatio())) {
+        m_tileRenderer->cancelAll();
+        m_tileCache->setDevicePixelRatio(ratio);
+    }
+
+    // 离视口中心越近的瓦片优先级越高
+    QRect visibleTiles = m_tileCache->tileRange(mapToScene(viewport()->rect()).boundingRect());
+    QPoint centerTile = visibleTiles.center();
+    for (const QPoint &tile : m_tileCache->tilesIntersecting(rect)) {
+        QRectF tileRect = m_tileCache->tileRect(tile);
+        if (const QImage *image = m_tileCache->tile(tile)) {
+            painter->drawImage(tileRect.topLeft(), *image);
+            continue;
+        }
+        if (m_tileCache->isDirty(tile)) {
+            // 编辑引起的失效：同步重绘，保证输入立即可见
+            QImage image = TileCache::rasterize(tileRect, ratio, tileParagraphs(tileRect));
+            m_tileCache->insert(tile, image);
+            painter->drawImage(tileRect.topLeft(), image);
+            continue;
+        }
+        if (!m_tileRenderer->isPending(tile)) {
+            int priority = -(tile - centerTile).manhattanLength();
+            m_tileRenderer->request(tile, tileRect, ratio, tileParagraphs(tileRect), priority);
+        }
+        // 等待中的瓦片显示占位
+        painter->fillRect(tileRect, QColor(128, 128, 128, 24));
+    }
+}
+
+/**
+ * @brief 滚动内容
+ * @param dx 水平滚动量
+ * @param dy 垂直滚动量
+ */
+void DocumentView::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    placeParagraphItems();
+    if (!m_tileCacheEnabled)
+        return;
+
+    // 保留视口及其周围一圈瓦片的请求，其余的已滚出视口
+    QRect visibleTiles = m_tileCache->tileRange(mapToScene(viewport()->rect()).boundingRect());
+    m_tileRenderer->cancelOutside(visibleTiles.adjusted(-1, -1, 1, 1));
+    // 滚动后缺失的瓦片都按新露出的区域处理，交给后台绘制
+    m_tileCache->clearDirtyTiles();
+}
+
+/**
+ * @brief 视口大小变化
+ * @param event 大小变化事件
+ */
+void DocumentView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    placeParagraphItems();
+}
+
+/**
+ * @brief 合成一个后台光栅化完成的瓦片
+ * @param tile 瓦片坐标
+ * @param image 瓦片图像
+ */
+void DocumentView::onTileReady(const QPoint &tile, const QImage &image)
+{
+    // 按旧比例绘制的结果已被取消，这里只会收到当前比例的瓦片
+    m_tileCache->insert(tile, image);
+    m_scene->invalidate(m_tileCache->tileRect(tile), QGraphicsScene::ForegroundLayer);
+}
+
 /**
  * @brief 更新布局
- * 重新布局文档内容并更新光标位置
+ * 执行一次布局，只处理自上次布局以来标记为脏的段落
  * 1. 首先检查场景和文档是否有效，无效则直接返回
- * 2. 清除场景中除光标外的所有图形项
- * 3. 遍历文档中的每个段落，创建新的文本图形项并添加到场景中
- * 4. 更新光标位置到当前文档位置
- * 5. 确保场景有合理的矩形范围，防止显示问题
- * 6. 更新输入法系统，通知光标位置变化
- * TODO: 局部更新，只更新受影响的段落
+ * 2. 从布局调度器取出脏范围（计入布局次数统计）
+ * 3. 段落项数量与文档不一致时（如外部直接修改了文档），在末尾同步差额
+ * 4. 段落数量变化后，重新定位其后的段落项
+ * 5. 为脏段落生成只读文本快照，交给后台排版引擎整形，可见区域优先
+ * 6. 更新光标位置到当前文档位置，并通知输入法系统
+ * 7. 段落数量变化时更新场景矩形（行宽变化在排版结果提交时更新）
  */
 void DocumentView::updateLayout() {
     // 检查场景和文档是否有效
     if (!m_scene || !m_document)
         return;
 
-    // 保存当前场景矩形，避免布局过程中场景大小变化
-    QRectF oldSceneRect = m_scene->sceneRect();
+    // 编号只在绘制时查询，这里只重绘可见的编号和引用；位数变化时会标记整篇重新排版
+    updateEquationNumbers();
+
+    int first = 0;
+    int last = -1;
+    if (!m_layoutScheduler->takeDirtyRange(&first, &last))
+        return;
+
+    int count = m_document->paragraphCount();
 
-    // 清除场景中的所有项目，除了光标（我们稍后会单独处理它）
-    QList<QGraphicsItem *> items = m_scene->items();
-    for (QGraphicsItem *item : items) {
-        if (item != m_cursor) {  // 不删除光标项
-            m_scene->removeItem(item);
-            delete item;
+    // 兜底：同步段落项数量
+    if (m_paragraphItems.size() != count) {
+        int oldCount = m_paragraphItems.size();
+        while (m_paragraphItems.size() > count)
+            destroyParagraphItem(m_paragraphItems.takeLast());
+        while (m_paragraphItems.size() < count)
+            m_paragraphItems.append(createParagraphItem());
+        m_paragraphTops.remove(count, oldCount - count);
+        m_paragraphTops.insert(oldCount, count - oldCount, m_textMetrics.height());
+        if (count > oldCount) {
+            invalidateParagraphs(oldCount, count - 1);
+            first = last < first ? oldCount : qMin(first, oldCount);
+            last = count - 1;
         }
+        int from = qMin(oldCount, count);
+        m_positionsDirtyFrom = m_positionsDirtyFrom < 0 ? from : qMin(m_positionsDirtyFrom, from);
     }
 
-    // 获取字体度量
-    QFont font("Microsoft YaHei", 12);
-    QFontMetrics metrics(font);
-    int lineHeight = metrics.height();
-
-    // 简单的文档布局
-    qreal y = 10; // 起始Y坐标
+    // 重新定位段落数量变化点之后的段落项
+    if (m_positionsDirtyFrom >= 0) {
+        repositionParagraphs(m_positionsDirtyFrom);
+        m_positionsDirtyFrom = -1;
+        updateSceneRect();
+    }
 
-    // 遍历文档中的所有段落
-    for (int i = 0; i < m_document->paragraphCount(); i++) {
-        Paragraph paragraph = m_document->paragraph(i);
-        QString text = paragraph.text();
+    // 为脏段落生成文本快照（隐式共享，工作线程只读）
+    first = qMax(0, first);
+    last = qMin(last, count - 1);
+    if (first <= last) {
+        QVector<QString> texts;
+        QVector<quint64> stamps;
+        QVector<QVector<InlineObject>> objects;
+        QVector<QVector<QTextLayout::FormatRange>> formats;
+        texts.reserve(last - first + 1);
+        stamps.reserve(last - first + 1);
+        objects.reserve(last - first + 1);
+        formats.reserve(last - first + 1);
+        for (int i = first; i <= last; i++) {
+            Paragraph paragraph = m_document->paragraph(i);
+            texts.append(paragraph.text());
+            stamps.append(m_paragraphItems[i]->stamp());
 
-        // 创建文本项并设置位置和字体
-        QGraphicsTextItem *textItem = new QGraphicsTextItem(text);
-        textItem->setFont(font);
-        
-        // 1. 清除文档边距
-        textItem->document()->setDocumentMargin(0);
-        
-        // 2. 清除段落间距（使用样式表方法）
-        textItem->document()->setDefaultStyleSheet("p { margin:0; padding:0; }");
-        
-        // 3. 设置文本宽度，确保边界矩形紧凑
-        textItem->setTextWidth(textItem->document()->idealWidth());
-        
-        // 设置文本项位置
-        textItem->setPos(10, y);
-        m_scene->addItem(textItem);
+            // 公式在GUI线程中增量排版，只把宽度交给后台整形预留位置
+            QVector<InlineObject> paragraphObjects;
+            QVector<QTextLayout::FormatRange> paragraphFormats;
+            QVector<QSharedPointer<MathObject>> formulas;
+            int position = 0;
+            for (int r = 0; r < paragraph.runCount(); r++) {
+                Run run = paragraph.run(r);
+                if (run.isFormula()) {
+                    QSharedPointer<const FormulaLayout> layout = m_mathLayoutEngine->layoutFormula(run.formula().data());
+                    InlineObject object;
+                    object.position = position;
+                    object.width = layout ? layout->box.width : 0;
+                    object.ascent = layout ? layout->box.ascent : 0;
+                    object.descent = layout ? layout->box.descent : 0;
+                    // 带编号的公式在其后预留编号宽度（按位数预留，编号变化时无需重新排版）
+                    if (run.formula()->isNumbered())
+                        object.width += m_textMetrics.horizontalAdvance(QLatin1Char('M')) + numberWidth();
+                    paragraphObjects.append(object);
+                    formulas.append(run.formula());
+                } else if (run.isReference()) {
+                    InlineObject object;
+                    object.position = position;
+                    object.width = numberWidth();
+                    object.kind = InlineObject::Reference;
+                    object.reference = run.reference();
+                    paragraphObjects.append(object);
+                } else if (run.isPlot()) {
+                    InlineObject object;
+                    object.position = position;
+                    object.width = run.plot()->width();
+                    object.kind = InlineObject::Plot;
+                    object.plot = run.plot();
+                    paragraphObjects.append(object);
+                } else if (run.format() != Format()) {
+                    // 只应用格式中显式设置的字体属性（如粗体）和颜色，其余沿用视图字体
+                    QTextLayout::FormatRange range;
+                    range.start = position;
+                    range.length = run.length();
+                    range.format.setFont(run.format().font(), QTextCharFormat::FontPropertiesSpecifiedOnly);
+                    if (run.format().color().isValid())
+                        range.format.setForeground(run.format().color());
+                    paragraphFormats.append(range);
+                }
+                position += run.length();
+            }
+            objects.append(paragraphObjects);
+            formats.append(paragraphFormats);
+            if (!formulas.isEmpty())
+                m_pendingFormulas.insert(stamps.last(), formulas);
+        }
 
-        y += lineHeight; // 移动到下一行
+        // 后台整形，从可见区域的首段开始
+        int firstVisible = paragraphAt(mapToScene(QPoint(0, 0)).y());
+        m_layoutEngine->requestLayout(texts, stamps, objects, formats, m_textFont, first, firstVisible);
     }
 
     // 更新光标位置
     if (m_cursor) {
         QPointF point = pointFromPosition(m_cursor->position());
-        m_cursor->setPos(point);
+        m_cursor->setAlignedPos(point);
         // 通知输入法系统光标位置已更新
         updateInputMethod();
     }
-    
-    // 计算新的场景矩形
-    QRectF newSceneRect = m_scene->itemsBoundingRect().adjusted(-10, -10, 10, 10);
-    if (newSceneRect.isNull() || newSceneRect.isEmpty()) {
+}
+
+/**
+ * @brief 提交一批后台排版结果
+ * @param first 第一个段落的索引
+ * @param layouts 排版结果
+ */
+void DocumentView::onLayoutsReady(int first, const QVector<ParagraphLayout> &layouts)
+{
+    // 按内容戳提交：段落索引可能已因插入/删除而移动，过期的结果查不到对应项而被丢弃
+    int repositionFrom = -1;
+    int committedFirst = -1;
+    int committedLast = -1;
+    for (int i = 0; i < layouts.size(); i++) {
+        const ParagraphLayout &layout = layouts[i];
+        ParagraphItem *item = m_pendingItems.take(layout.stamp);
+        if (item) {
+            // 请求之后没有增删段落时first + i处段落项的内容戳与结果相同；否则（编辑与排版交错）在段落项中查找
+            int index = first + i;
+            if (index >= m_paragraphItems.size() || m_paragraphItems[index]->stamp() != layout.stamp)
+                index = m_paragraphItems.indexOf(item);
+            committedFirst = committedFirst < 0 ? index : qMin(committedFirst, index);
+            committedLast = qMax(committedLast, index);
+            untrackParagraphWidth(item->paragraphLayout().width);
+            // 新旧排版覆盖的瓦片都需要重新光栅化
+            invalidateTiles(index);
+            item->setParagraphLayout(layout);
+            item->setFormulas(m_pendingFormulas.take(layout.stamp), m_mathLayoutEngine);
+            item->setEquationNumbers(&m_document->equationIndex(), m_document->equationIndex().handle(index), m_textFont);
+            item->setPlots(m_plotSampler);
+            // 行高变化时O(log n)更新偏移索引，其后的段落整体移动
+            qreal height = qMax(m_textMetrics.height(), layout.height);
+            if (height != m_paragraphTops.height(index)) {
+                m_paragraphTops.setHeight(index, height);
+                repositionFrom = repositionFrom < 0 ? index : qMin(repositionFrom, index);
+            }
+            invalidateTiles(index);
+            trackParagraphWidth(layout.width);
+        }
+    }
+
+    // 段落数量的变化尚未处理时一并处理
+    if (repositionFrom >= 0) {
+        if (m_positionsDirtyFrom >= 0)
+            repositionFrom = qMin(repositionFrom, m_positionsDirtyFrom);
+        repositionParagraphs(repositionFrom);
+        m_positionsDirtyFrom = -1;
+        if (m_cursor)
+            m_cursor->setAlignedPos(pointFromPosition(m_cursor->position()));
+        m_selectionItem->update();
+    }
+
+    // 行宽和总高度可能变化，O(log n)更新场景矩形
+    updateSceneRect();
+
+    // 光标位置缓存已更新，重绘这些段落上的选择高亮；范围取自已提交段落的当前索引，
+    // 而不是请求时的first（其间增删段落后已过期）
+    if (committedFirst >= 0)
+        m_selectionItem->updateParagraphs(committedFirst, committedLast);
+}
+
+/**
+ * @brief 重绘可见区域中的公式编号和交叉引用
+ */
+void DocumentView::updateEquationNumbers()
+{
+    if (!m_document)
+        return;
+    const EquationIndex &index = m_document->equationIndex();
+    if (index.revision() == m_equationRevision)
+        return;
+    m_equationRevision = index.revision();
+
+    // 预留宽度按编号位数计算，位数变化时所有含编号和引用的段落都需要重新排版。
+    // 至少预留三位，一般文档不会触发；超过之后也只在总数跨过10的幂时发生一次
+    int digits = qMax(3, QString::number(index.count()).length());
+    if (digits != m_numberDigits) {
+        setNumberDigits(digits);
+        scheduleLayout();
+        return;
+    }
+
+    // 编号在绘制时查询，不可见的段落滚动进入视口时自然绘制出新编号，只需重绘可见段落
+    QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+    int firstVisible = paragraphAt(visible.top());
+    int lastVisible = qMin(m_paragraphItems.size() - 1, paragraphAt(visible.bottom()));
+    for (int i = firstVisible; i <= lastVisible; i++)
+        m_paragraphItems[i]->updateEquationNumbers();
+}
+
+/**
+ * @brief 获取为编号预留的宽度
+ * @return 宽度
+ */
+qreal DocumentView::numberWidth() const
+{
+    return m_numberWidth;
+}
+
+/**
+ * @brief 设置为编号预留的位数，并重新计算预留宽度
+ * @param digits 位数
+ */
+void DocumentView::setNumberDigits(int digits)
+{
+    m_numberDigits = digits;
+    m_numberWidth = m_textMetrics.horizontalAdvance(QStringLiteral("(%1)").arg(QString(digits, QLatin1Char('0'))));
+}
+
+/**
+ * @brief 获取已提交且未过期的段落排版结果
+ * @param paragraph 段落索引
+ * @return 排版结果，不可用时返回nullptr
+ */
+const ParagraphLayout *DocumentView::committedLayout(int paragraph) const
+{
+    if (paragraph < 0 || paragraph >= m_paragraphItems.size())
+        return nullptr;
+    const ParagraphItem *item = m_paragraphItems[paragraph];
+    // 仍在等待新结果的段落，其现有排版已过期
+    if (m_pendingItems.contains(item->stamp()))
+        return nullptr;
+    return &item->paragraphLayout();
+}
+
+/**
+ * @brief 根据文档范围更新场景矩形
+ */
+void DocumentView::updateSceneRect()
+{
+    // 保存当前场景矩形，用于判断变化是否显著
+    QRectF oldSceneRect = m_scene->sceneRect();
+
+    // 文档范围：最大行宽取自有序宽度表，总高度取自段落顶部偏移索引
+    qreal maxWidth = m_paragraphWidths.isEmpty() ? 0 : m_paragraphWidths.lastKey();
+    qreal height = paragraphTop(m_paragraphItems.size());
+
+    // 内容位于(10, 10)，四周各留10像素边距
+    QRectF newSceneRect(0, 0, maxWidth + 20, height + 20);
+    if (m_paragraphItems.isEmpty()) {
         newSceneRect = QRectF(0, 0, 800, 600); // 设置默认大小
     }
     
@@ -239,7 +829,7 @@ void DocumentView::mousePressEvent(QMouseEvent *event)
         setSelection(selection);
         m_cursor->setPosition(m_selectionStart);
         QPointF cursorPoint = pointFromPosition(m_selectionStart);
-        m_cursor->setPos(cursorPoint);
+        m_cursor->setAlignedPos(cursorPoint);
         m_cursor->show();
         m_cursor->stopBlinking();
         ensureCursorVisible();
@@ -264,10 +854,9 @@ void DocumentView::mouseMoveEvent(QMouseEvent *event)
     
     if (m_selecting && (event->buttons() & Qt::LeftButton))
     {
-        QPoint point = event->pos();
-        Selection::Position endPos = positionFromPoint(point);
+        Selection::Position endPos = positionFromPoint(scenePos);
         
-        // 更新选择
+        // 更新选择（只重绘高亮覆盖层，不重新排版）
         Selection selection(m_selectionStart, endPos);
         setSelection(selection);
     }
@@ -292,7 +881,7 @@ void DocumentView::mouseReleaseEvent(QMouseEvent *event)
         
         // 更新光标在场景中的实际位置
         QPointF cursorPoint = pointFromPosition(cursorPos);
-        m_cursor->setPos(cursorPoint);
+        m_cursor->setAlignedPos(cursorPoint);
         
         // 开始闪烁
         m_cursor->startBlinking();
@@ -325,15 +914,40 @@ Selection::Position DocumentView::positionFromPoint(const QPointF &point) const
 {
     if (!m_document) return {0, 0};
 
-    QFont font("Microsoft YaHei", 12);
-    QFontMetricsF metrics(font);
-    qreal lineHeight = metrics.height();
     qreal leftMargin = 10.0;
 
     // 计算段落索引（Y 坐标定位）
-    int paraIndex = qMax(0, static_cast<int>((point.y() - leftMargin) / lineHeight));
-    if (paraIndex >= m_document->paragraphCount())
-        paraIndex = qMax(0, m_document->paragraphCount() - 1);
+    int paraIndex = paragraphAt(point.y());
+
+    // 优先使用排版缓存的光标位置，二分查找最近的间隙
+    if (const ParagraphLayout *layout = committedLayout(paraIndex)) {
+        const QVector<qreal> &carets = layout->caretPositions;
+        if (!carets.isEmpty()) {
+            qreal x = point.x() - leftMargin;
+
+            // 点落在公式上：由公式的盒子树定位到公式内部
+            int object = static_cast<int>(std::upper_bound(carets.constBegin(), carets.constEnd(), x)
+                                          - carets.constBegin()) - 1;
+            if (object >= 0 && object < carets.size() - 1) {
+                QSharedPointer<MathObject> formula = m_document->paragraph(paraIndex).formulaAt(object);
+                if (formula) {
+                    qreal baseline = paragraphRect(paraIndex).top() + layout->ascent;
+                    Selection::Position position = {paraIndex, object};
+                    position.math = m_mathLayoutEngine->hitTest(formula.data(),
+                                                                QPointF(x - carets[object], point.y() - baseline));
+                    return position;
+                }
+            }
+
+            auto it = std::lower_bound(carets.constBegin(), carets.constEnd(), x);
+            int index = static_cast<int>(it - carets.constBegin());
+            if (index >= carets.size())
+                return {paraIndex, static_cast<int>(carets.size()) - 1};
+            if (index > 0 && x - carets[index - 1] < carets[index] - x)
+                index--;
+            return {paraIndex, index};
+        }
+    }
 
     QString text = m_document->paragraph(paraIndex).text();
 
@@ -342,7 +956,7 @@ Selection::Position DocumentView::positionFromPoint(const QPointF &point) const
     gapPositions.append(leftMargin);
     qreal currentX = leftMargin;
     for (int i = 0; i < text.length(); ++i) {
-        currentX += metrics.horizontalAdvance(text[i]);
+        currentX += m_textMetrics.horizontalAdvance(text[i]);
         gapPositions.append(currentX);
     }
 
@@ -370,22 +984,156 @@ QPointF DocumentView::pointFromPosition(const Selection::Position &position) con
     if (!m_document || position.paragraph >= m_document->paragraphCount())
         return QPointF(10, 10);
 
-    QFont font("Microsoft YaHei", 12);
-    QFontMetricsF metrics(font);
-    qreal lineHeight = metrics.height();
     qreal leftMargin = 10.0;
 
-    // Y 坐标
-    qreal y = leftMargin + position.paragraph * lineHeight;
+    // Y 坐标：段落顶部
+    qreal y = leftMargin + paragraphTop(position.paragraph);
+
+    // X 坐标：优先查排版缓存的光标位置
+    if (const ParagraphLayout *layout = committedLayout(position.paragraph)) {
+        const QVector<qreal> &carets = layout->caretPositions;
+        if (position.position >= 0 && position.position < carets.size()) {
+            // 公式内部：公式原点在替换字符的光标位置和段落基线上
+            if (position.math.isValid()) {
+                QSharedPointer<MathObject> formula = m_document->paragraph(position.paragraph).formulaAt(position.position);
+                QRectF caret = m_mathLayoutEngine->caretRect(formula.data(), position.math);
+                if (!caret.isNull())
+                    return QPointF(leftMargin + carets[position.position] + caret.left(),
+                                   y + layout->ascent + caret.top());
+            }
+            // 文本光标与文本行对齐：高公式使基线下移时光标随之下移
+            return QPointF(leftMargin + carets[position.position], y + layout->ascent - m_textMetrics.ascent());
+        }
+    }
 
-    // X 坐标 = 左边界 + 前 position 个字符的宽度
+    // 排版结果尚未到达：X 坐标 = 左边界 + 前 position 个字符的宽度
     QString text = m_document->paragraph(position.paragraph).text();
     int actualPos = qMin(position.position, text.length());
-    qreal x = leftMargin + metrics.horizontalAdvance(text.left(actualPos));
+    qreal x = leftMargin + m_textMetrics.horizontalAdvance(text.left(actualPos));
 
     return QPointF(x, y);
 }
 
+/**
+ * @brief 获取段落所在行的矩形
+ * @param paragraph 段落索引
+ * @return 行矩形
+ */
+QRectF DocumentView::paragraphRect(int paragraph) const
+{
+    qreal leftMargin = 10.0;
+
+    qreal width = 0;
+    if (const ParagraphLayout *layout = committedLayout(paragraph)) {
+        width = layout->width;
+    } else if (m_document && paragraph >= 0 && paragraph < m_document->paragraphCount()) {
+        width = m_textMetrics.horizontalAdvance(m_document->paragraph(paragraph).text());
+    }
+    return QRectF(leftMargin, leftMargin + paragraphTop(paragraph), width, paragraphHeight(paragraph));
+}
+
+/**
+ * @brief 获取场景Y坐标所在的段落
+ * @param y 场景Y坐标
+ * @return 段落索引
+ */
+int DocumentView::paragraphAt(qreal y) const
+{
+    qreal leftMargin = 10.0;
+
+    // 在段落顶部偏移索引上查找，超出已有段落项的部分按默认行高外推
+    int count = m_document ? m_document->paragraphCount() : 0;
+    qreal offset = y - leftMargin;
+    qreal total = m_paragraphTops.total();
+    int paraIndex;
+    if (offset < total) {
+        paraIndex = m_paragraphTops.indexAt(offset);
+    } else {
+        paraIndex = m_paragraphTops.count() + static_cast<int>((offset - total) / m_textMetrics.height());
+    }
+    if (paraIndex >= count)
+        paraIndex = count - 1;
+    return qMax(0, paraIndex);
+}
+
+/**
+ * @brief 指定段落之后的内容整体移动后，作废其下方的瓦片并重新放置视口附近的段落项
+ * @param from 第一个移动的段落
+ */
+void DocumentView::repositionParagraphs(int from)
+{
+    // 其后的内容整体移动，作废该位置以下的瓦片
+    qreal top = 10 + paragraphTop(qMax(0, from));
+    m_tileCache->invalidateFrom(top);
+    m_tileRenderer->cancelAll();
+    if (m_tileCacheEnabled) {
+        QRectF sceneRect = m_scene->sceneRect();
+        m_scene->invalidate(QRectF(sceneRect.left(), top, sceneRect.width(), qMax<qreal>(0, sceneRect.bottom() - top)),
+                            QGraphicsScene::ForegroundLayer);
+    }
+    placeParagraphItems();
+}
+
+/**
+ * @brief 放置视口及其上下各一屏内的段落项，其余段落项隐藏
+ */
+void DocumentView::placeParagraphItems()
+{
+    int count = m_paragraphItems.size();
+    QVector<ParagraphItem *> placed;
+    if (count > 0) {
+        QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+        qreal margin = visible.height();
+        int first = qMin(m_paragraphTops.indexAt(visible.top() - margin - 10), count - 1);
+        int last = qMin(m_paragraphTops.indexAt(visible.bottom() + margin - 10), count - 1);
+        placed.reserve(last - first + 1);
+        qreal top = 10 + m_paragraphTops.top(first);
+        for (int i = first; i <= last; top += m_paragraphTops.height(i), i++) {
+            ParagraphItem *item = m_paragraphItems[i];
+            if (item->pos() != QPointF(10, top))
+                item->setPos(10, top);
+            item->show();
+            placed.append(item);
+        }
+    }
+
+    // 离开这一范围的段落项隐藏，留在原处直到再次进入
+    QSet<ParagraphItem *> kept;
+    kept.reserve(placed.size());
+    for (ParagraphItem *item : placed)
+        kept.insert(item);
+    for (ParagraphItem *item : m_placedItems) {
+        if (!kept.contains(item))
+            item->hide();
+    }
+    m_placedItems = placed;
+}
+
+/**
+ * @brief 获取段落顶部相对内容顶部的偏移
+ * @param paragraph 段落索引
+ * @return 偏移
+ */
+qreal DocumentView::paragraphTop(int paragraph) const
+{
+    int count = m_paragraphTops.count();
+    if (paragraph <= count)
+        return m_paragraphTops.top(qMax(0, paragraph));
+    return m_paragraphTops.total() + (paragraph - count) * m_textMetrics.height();
+}
+
+/**
+ * @brief 获取段落所占的高度
+ * @param paragraph 段落索引
+ * @return 高度
+ */
+qreal DocumentView::paragraphHeight(int paragraph) const
+{
+    if (paragraph < 0 || paragraph >= m_paragraphTops.count())
+        return m_textMetrics.height();
+    return m_paragraphTops.height(paragraph);
+}
+
 /**
  * @brief 输入法查询
  * @param query 查询类型
@@ -402,23 +1150,21 @@ QVariant DocumentView::inputMethodQuery(Qt::InputMethodQuery query) const
     {
         // 获取光标位置（场景坐标）
         QPointF cursorPos = pointFromPosition(m_cursor->position());
+        // 组合期间以预编辑光标为准，候选窗口跟随组合文本
+        if (m_preeditItem->isVisible())
+            cursorPos.rx() += m_preeditItem->cursorX();
         // 转换为视图坐标
         QPoint viewPos = mapFromScene(cursorPos.toPoint());
         
         // 使用动态行高计算光标矩形
-        QFont font("Microsoft YaHei", 12);
-        QFontMetricsF metrics(font);
-        int lineHeight = metrics.height();
+        int lineHeight = m_textMetrics.height();
         
         return QRect(viewPos.x(), viewPos.y(), 2, lineHeight);
     }
     case Qt::ImFont:
     {
         // 返回默认字体
-        QFont font;
-        font.setFamily("Microsoft YaHei");
-        font.setPointSize(12);
-        return font;
+        return m_textFont;
     }
     case Qt::ImCursorPosition:
     {
@@ -476,38 +1222,49 @@ QVariant DocumentView::inputMethodQueryPublic(Qt::InputMethodQuery query) const
 /**
  * @brief 绘制组合文本
  * @param text 组合文本
+ * @param attributes 输入法属性
  * @param position 位置
  */
-void DocumentView::drawComposingText(const QString &text, const Selection::Position &position)
+void DocumentView::drawComposingText(const QString &text, const QList<QInputMethodEvent::Attribute> &attributes,
+                                     const Selection::Position &position)
 {
-    // 清除之前的组合文本
-    clearComposingText();
-    
     if (text.isEmpty()) {
+        clearComposingText();
         return;
     }
     
-    // 创建组合文本显示项
-    m_composingTextItem = new QGraphicsTextItem(text);
-    
-    // 设置组合文本样式（通常为带下划线的灰色文本）
-    QFont font = m_composingTextItem->font();
-    font.setFamily("Microsoft YaHei");
-    font.setPointSize(12);
-    m_composingTextItem->setFont(font);
-    
-    QColor composingColor(128, 128, 128); // 灰色
-    m_composingTextItem->setDefaultTextColor(composingColor);
+    QPointF caretPoint = pointFromPosition(position);
     
-    // 设置位置（在光标位置显示）
-    QPointF pos = pointFromPosition(position);
-    m_composingTextItem->setPos(pos);
+    // 组合位置变化时才重新获取光标之后的段落文本并调整裁剪
+    if (!(m_preeditPosition == position)) {
+        if (m_preeditParagraphItem) {
+            m_preeditParagraphItem->setClipWidth(-1);
+            invalidateTiles(m_preeditParagraphItem->sceneBoundingRect());
+        }
+        m_preeditParagraphItem = nullptr;
+        m_preeditTail.truncate(0);
+        
+        if (m_document && position.paragraph >= 0 && position.paragraph < m_document->paragraphCount()) {
+            QString paragraphText = m_document->paragraph(position.paragraph).text();
+            int caret = qBound(0, position.position, paragraphText.length());
+            m_preeditTail.append(paragraphText.constData() + caret, paragraphText.length() - caret);
+        }
+        if (position.paragraph >= 0 && position.paragraph < m_paragraphItems.size()) {
+            // 段落项只绘制到光标处，其后文本由预编辑层连同组合文本一起绘制
+            m_preeditParagraphItem = m_paragraphItems[position.paragraph];
+            m_preeditParagraphItem->setClipWidth(caretPoint.x() - m_preeditParagraphItem->pos().x());
+            invalidateTiles(m_preeditParagraphItem->sceneBoundingRect());
+        }
+        m_preeditPosition = position;
+        m_preeditItem->setPos(caretPoint);
+    }
     
-    // 添加到场景
-    m_scene->addItem(m_composingTextItem);
+    // 复用预编辑层，只重排当前行
+    m_preeditItem->setComposition(text, m_preeditTail, attributes);
+    m_preeditItem->show();
     
-    // 保存当前组合文本
-    m_currentComposingText = text;
+    // 组合期间由预编辑层绘制光标
+    m_cursor->setVisible(false);
 }
 
 /**
@@ -515,22 +1272,30 @@ void DocumentView::drawComposingText(const QString &text, const Selection::Posit
  */
 void DocumentView::clearComposingText()
 {
-    if (m_composingTextItem) {
-        m_scene->removeItem(m_composingTextItem);
-        delete m_composingTextItem;
-        m_composingTextItem = nullptr;
+    if (m_preeditParagraphItem) {
+        m_preeditParagraphItem->setClipWidth(-1);
+        invalidateTiles(m_preeditParagraphItem->sceneBoundingRect());
+        m_preeditParagraphItem = nullptr;
+    }
+    m_preeditPosition = {-1, -1};
+    m_preeditTail.truncate(0);
+    
+    if (m_preeditItem->isVisible()) {
+        m_preeditItem->hide();
+        m_preeditItem->clear();
+        m_cursor->setVisible(true);
     }
-    m_currentComposingText.clear();
 }
 
 /**
  * @brief 显示组合文本
  * @param text 组合文本
+ * @param attributes 输入法属性
  */
-void DocumentView::showComposingText(const QString &text)
+void DocumentView::showComposingText(const QString &text, const QList<QInputMethodEvent::Attribute> &attributes)
 {
     if (m_cursor && !text.isEmpty()) {
-        drawComposingText(text, m_cursor->position());
+        drawComposingText(text, attributes, m_cursor->position());
     }
 }
 
@@ -0,0 +1,132 @@
+// ============================================================================
+// FormulaItem.cpp
+// 公式图形项类的实现文件
+// 在段落中绘制一个已排版的内联公式
+// ============================================================================
+
+#include "view/FormulaItem.h"
+#include "view/MathLayoutEngine.h"
+#include "view/ReferenceItem.h"
+#include "core/EquationIndex.h"
+#include <QFontMetricsF>
+
+/**
+ * @brief 构造函数
+ * @param formula 公式对象
+ * @param engine 数学排版引擎
+ * @param parent 图形父项
+ */
+FormulaItem::FormulaItem(const QSharedPointer<MathObject> &formula, MathLayoutEngine *engine,
+                         QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_formula(formula),
+      m_engine(engine),
+      m_index(nullptr),
+      m_handle(-1),
+      m_slot(-1),
+      m_width(0)
+{
+    updateGeometry();
+}
+
+/**
+ * @brief 获取公式对象
+ * @return 公式对象
+ */
+QSharedPointer<MathObject> FormulaItem::formula() const
+{
+    return m_formula;
+}
+
+/**
+ * @brief 重新排版公式并更新几何尺寸
+ */
+void FormulaItem::updateGeometry()
+{
+    QSharedPointer<const FormulaLayout> layout = m_engine->layoutFormula(m_formula.data());
+    QRectF bounds;
+    if (layout)
+        bounds = QRectF(0, -layout->box.ascent, layout->box.width, layout->box.height());
+    m_displayList = m_engine->displayList(m_formula.data());
+    m_formulaBounds = bounds;
+    if (isNumbered())
+    {
+        QFontMetricsF metrics(m_numberFont);
+        bounds |= QRectF(bounds.right(), -metrics.ascent(), qMax<qreal>(0, m_width - bounds.right()), metrics.height());
+    }
+    if (bounds != m_bounds)
+    {
+        prepareGeometryChange();
+        m_bounds = bounds;
+    }
+    update();
+}
+
+/**
+ * @brief 设置编号的绘制方式
+ * @param index 公式编号索引
+ * @param handle 所在段落的句柄
+ * @param slot 公式在段落的带编号公式中的序号
+ * @param font 编号字体
+ * @param width 预留的总宽度
+ */
+void FormulaItem::setNumbering(const EquationIndex *index, int handle, int slot, const QFont &font, qreal width)
+{
+    if (m_handle != handle || m_slot != slot)
+    {
+        m_handle = handle;
+        m_slot = slot;
+        update();
+    }
+    if (m_index == index && m_numberFont == font && m_width == width)
+        return;
+    m_index = index;
+    m_numberFont = font;
+    m_width = width;
+    updateGeometry();
+}
+
+/**
+ * @brief 检查是否绘制编号
+ * @return 是否绘制编号
+ */
+bool FormulaItem::isNumbered() const
+{
+    return m_index && m_formula->isNumbered();
+}
+
+/**
+ * @brief 获取边界矩形
+ * @return 边界矩形
+ */
+QRectF FormulaItem::boundingRect() const
+{
+    return m_bounds;
+}
+
+/**
+ * @brief 绘制公式
+ * @param painter 绘图工具
+ * @param option 样式选项
+ * @param widget 部件
+ */
+void FormulaItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    if (!m_displayList)
+        return;
+    painter->save();
+    m_displayList->paint(painter, QPointF(0, 0));
+    if (isNumbered())
+    {
+        // 编号右对齐到预留宽度的末端，每次绘制时按所在段落和序号在索引中查询
+        QString text = ReferenceItem::numberText(m_index->numberAt(m_handle, m_slot));
+        QFontMetricsF metrics(m_numberFont);
+        painter->setFont(m_numberFont);
+        painter->setPen(Qt::black);
+        painter->drawText(QPointF(qMax(m_formulaBounds.right(), m_width - metrics.horizontalAdvance(text)), 0), text);
+    }
+    painter->restore();
+}
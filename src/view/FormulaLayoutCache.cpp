@@ -0,0 +1,240 @@
+// ============================================================================
+// FormulaLayoutCache.cpp
+// 公式排版缓存类的实现文件
+// 按（子树结构哈希, 格式, DPI）缓存公式排版结果，按内存预算LRU淘汰
+// ============================================================================
+
+#include "view/FormulaLayoutCache.h"
+#include <QPainter>
+
+/**
+ * @brief 获取子节点原点的偏移
+ * @param index 子节点索引
+ * @return 偏移
+ */
+QPointF FormulaLayout::childOffset(int index) const
+{
+    return grid ? grid->cellOffset(index) : childOffsets.value(index);
+}
+
+/**
+ * @brief 估算占用的内存字节数
+ * @return 字节数
+ */
+int FormulaLayout::memoryCost() const
+{
+    int cost = static_cast<int>(sizeof(FormulaLayout));
+    cost += childOffsets.size() * static_cast<int>(sizeof(QPointF));
+    cost += childBoxes.size() * static_cast<int>(sizeof(MathBox));
+    cost += rules.size() * static_cast<int>(sizeof(QRectF));
+    for (const FormulaGlyph &glyph : glyphs)
+        cost += static_cast<int>(sizeof(FormulaGlyph)) + glyph.text.size() * static_cast<int>(sizeof(QChar));
+    return cost;
+}
+
+/**
+ * @brief 回放显示列表
+ * @param painter 画笔
+ * @param origin 公式基线原点
+ */
+void FormulaDisplayList::paint(QPainter *painter, const QPointF &origin) const
+{
+    painter->setPen(color);
+    for (const QGlyphRun &glyphRun : glyphRuns)
+        painter->drawGlyphRun(origin, glyphRun);
+    if (!path.isEmpty())
+        painter->fillPath(path.translated(origin), color);
+    for (const QRectF &rule : rules)
+        painter->fillRect(rule.translated(origin), color);
+}
+
+/**
+ * @brief 估算占用的内存字节数
+ * @return 字节数
+ */
+int FormulaDisplayList::memoryCost() const
+{
+    int cost = static_cast<int>(sizeof(FormulaDisplayList));
+    for (const QGlyphRun &glyphRun : glyphRuns)
+        cost += glyphRun.glyphIndexes().size() * static_cast<int>(sizeof(quint32) + sizeof(QPointF));
+    cost += path.elementCount() * static_cast<int>(sizeof(QPainterPath::Element));
+    cost += rules.size() * static_cast<int>(sizeof(QRectF));
+    return cost;
+}
+
+/**
+ * @brief 构造函数
+ * @param parent 父对象
+ */
+FormulaLayoutCache::FormulaLayoutCache(QObject *parent)
+    : QObject(parent),
+      m_hits(0),
+      m_misses(0),
+      m_evictions(0)
+{
+    m_layouts.setMaxCost(DEFAULT_BYTE_BUDGET);
+    m_displayLists.setMaxCost(DEFAULT_BYTE_BUDGET);
+}
+
+/**
+ * @brief 生成格式键
+ * @param format 格式
+ * @return 格式键
+ */
+QString FormulaLayoutCache::formatKey(const Format &format)
+{
+    return format.font().key() + QLatin1Char('|') + format.color().name(QColor::HexArgb);
+}
+
+/**
+ * @brief 查找排版结果
+ * @param key 缓存键
+ * @return 排版结果
+ */
+QSharedPointer<const FormulaLayout> FormulaLayoutCache::find(const FormulaLayoutKey &key)
+{
+    QSharedPointer<const FormulaLayout> *layout = m_layouts.object(key);
+    if (!layout)
+    {
+        m_misses++;
+        return QSharedPointer<const FormulaLayout>();
+    }
+    m_hits++;
+    return *layout;
+}
+
+/**
+ * @brief 缓存排版结果
+ * @param key 缓存键
+ * @param layout 排版结果
+ */
+void FormulaLayoutCache::insert(const FormulaLayoutKey &key, const QSharedPointer<const FormulaLayout> &layout)
+{
+    if (!layout)
+        return;
+
+    // QCache不报告淘汰，用插入前后的条目数推算
+    int expected = m_layouts.count() + (m_layouts.contains(key) ? 0 : 1);
+    m_layouts.insert(key, new QSharedPointer<const FormulaLayout>(layout), layout->memoryCost());
+    m_evictions += expected - m_layouts.count();
+}
+
+/**
+ * @brief 查找显示列表
+ * @param key 缓存键
+ * @return 显示列表
+ */
+QSharedPointer<const FormulaDisplayList> FormulaLayoutCache::findDisplayList(const FormulaLayoutKey &key)
+{
+    QSharedPointer<const FormulaDisplayList> *displayList = m_displayLists.object(key);
+    return displayList ? *displayList : QSharedPointer<const FormulaDisplayList>();
+}
+
+/**
+ * @brief 缓存显示列表
+ * @param key 缓存键
+ * @param displayList 显示列表
+ */
+void FormulaLayoutCache::insertDisplayList(const FormulaLayoutKey &key,
+                                           const QSharedPointer<const FormulaDisplayList> &displayList)
+{
+    if (!displayList)
+        return;
+    m_displayLists.insert(key, new QSharedPointer<const FormulaDisplayList>(displayList),
+                          displayList->memoryCost());
+}
+
+/**
+ * @brief 设置内存预算
+ * @param bytes 最大字节数
+ */
+void FormulaLayoutCache::setByteBudget(int bytes)
+{
+    int before = m_layouts.count();
+    m_layouts.setMaxCost(qMax(0, bytes));
+    m_displayLists.setMaxCost(qMax(0, bytes));
+    m_evictions += before - m_layouts.count();
+}
+
+/**
+ * @brief 获取内存预算
+ * @return 最大字节数
+ */
+int FormulaLayoutCache::byteBudget() const
+{
+    return m_layouts.maxCost();
+}
+
+/**
+ * @brief 获取当前占用的字节数
+ * @return 字节数
+ */
+int FormulaLayoutCache::byteCount() const
+{
+    return m_layouts.totalCost() + m_displayLists.totalCost();
+}
+
+/**
+ * @brief 获取缓存条目数
+ * @return 条目数
+ */
+int FormulaLayoutCache::count() const
+{
+    return m_layouts.count();
+}
+
+/**
+ * @brief 清空缓存
+ */
+void FormulaLayoutCache::clear()
+{
+    m_layouts.clear();
+    m_displayLists.clear();
+}
+
+/**
+ * @brief 获取命中次数
+ * @return 命中次数
+ */
+int FormulaLayoutCache::hitCount() const
+{
+    return m_hits;
+}
+
+/**
+ * @brief 获取未命中次数
+ * @return 未命中次数
+ */
+int FormulaLayoutCache::missCount() const
+{
+    return m_misses;
+}
+
+/**
+ * @brief 获取淘汰次数
+ * @return 淘汰次数
+ */
+int FormulaLayoutCache::evictionCount() const
+{
+    return m_evictions;
+}
+
+/**
+ * @brief 获取命中率
+ * @return 命中率
+ */
+qreal FormulaLayoutCache::hitRate() const
+{
+    int lookups = m_hits + m_misses;
+    return lookups > 0 ? qreal(m_hits) / lookups : 0;
+}
+
+/**
+ * @brief 重置统计计数
+ */
+void FormulaLayoutCache::resetStatistics()
+{
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+}
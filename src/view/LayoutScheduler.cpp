@@ -0,0 +1,179 @@
+// ============================================================================
+// LayoutScheduler.cpp
+// 布局调度器类的实现文件
+// 合并同一事件循环周期内的布局请求，每个周期最多执行一次布局
+// ============================================================================
+
+#include "view/LayoutScheduler.h"
+#include <QTimer>
+
+/**
+ * @brief 构造函数
+ * @param parent 父对象
+ */
+LayoutScheduler::LayoutScheduler(QObject *parent)
+    : QObject(parent),
+      m_timer(new QTimer(this)),
+      m_pending(false),
+      m_hasDirtyRange(false),
+      m_dirtyFirst(0),
+      m_dirtyLast(0),
+      m_passCount(0),
+      m_passesForInputEvent(0),
+      m_maxPassesPerInputEvent(0)
+{
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(0);
+    connect(m_timer, &QTimer::timeout, this, &LayoutScheduler::onTimeout);
+}
+
+/**
+ * @brief 标记脏范围并调度一次布局
+ * @param first 第一个脏段落索引
+ * @param last 最后一个脏段落索引
+ */
+void LayoutScheduler::markDirty(int first, int last)
+{
+    if (last >= first)
+    {
+        if (!m_hasDirtyRange)
+        {
+            m_dirtyFirst = first;
+            m_dirtyLast = last;
+            m_hasDirtyRange = true;
+        }
+        else
+        {
+            // 合并为覆盖两者的范围
+            m_dirtyFirst = qMin(m_dirtyFirst, first);
+            m_dirtyLast = qMax(m_dirtyLast, last);
+        }
+    }
+
+    m_pending = true;
+    if (!m_timer->isActive())
+        m_timer->start();
+}
+
+/**
+ * @brief 在段落增删后修正挂起的脏范围
+ * @param first 变化的起始段落
+ * @param removed 删除的段落数
+ * @param inserted 插入的段落数
+ */
+void LayoutScheduler::adjustForSplice(int first, int removed, int inserted)
+{
+    if (!m_hasDirtyRange)
+        return;
+
+    int delta = inserted - removed;
+    int removedEnd = first + removed; // 被替换区间之后的第一个旧索引
+
+    // 位于替换区间之后的端点随之平移，落在替换区间内的端点收缩到区间边界
+    if (m_dirtyFirst >= removedEnd)
+        m_dirtyFirst += delta;
+    else if (m_dirtyFirst > first)
+        m_dirtyFirst = first;
+
+    if (m_dirtyLast >= removedEnd)
+        m_dirtyLast += delta;
+    else if (m_dirtyLast >= first)
+        m_dirtyLast = first + inserted - 1;
+
+    if (m_dirtyLast < m_dirtyFirst)
+        m_hasDirtyRange = false;
+}
+
+/**
+ * @brief 检查是否有挂起的布局
+ * @return 是否有挂起的布局
+ */
+bool LayoutScheduler::hasPendingLayout() const
+{
+    return m_pending;
+}
+
+/**
+ * @brief 取出挂起的脏范围
+ * @param first 输出：第一个脏段落索引
+ * @param last 输出：最后一个脏段落索引
+ * @return 是否有挂起的布局
+ */
+bool LayoutScheduler::takeDirtyRange(int *first, int *last)
+{
+    if (!m_pending)
+        return false;
+
+    if (m_hasDirtyRange)
+    {
+        *first = m_dirtyFirst;
+        *last = m_dirtyLast;
+    }
+    else
+    {
+        *first = 0;
+        *last = -1;
+    }
+    m_pending = false;
+    m_hasDirtyRange = false;
+    m_timer->stop();
+
+    // 统计布局次数
+    m_passCount++;
+    m_passesForInputEvent++;
+    m_maxPassesPerInputEvent = qMax(m_maxPassesPerInputEvent, m_passesForInputEvent);
+    return true;
+}
+
+/**
+ * @brief 立即执行挂起的布局
+ */
+void LayoutScheduler::flush()
+{
+    if (m_pending)
+        emit layoutRequested();
+}
+
+/**
+ * @brief 标记一个输入事件的开始
+ */
+void LayoutScheduler::beginInputEvent()
+{
+    m_passesForInputEvent = 0;
+}
+
+/**
+ * @brief 获取布局总次数
+ * @return 布局总次数
+ */
+int LayoutScheduler::layoutPassCount() const
+{
+    return m_passCount;
+}
+
+/**
+ * @brief 获取当前输入事件触发的布局次数
+ * @return 布局次数
+ */
+int LayoutScheduler::passesForCurrentInputEvent() const
+{
+    return m_passesForInputEvent;
+}
+
+/**
+ * @brief 获取单个输入事件触发的最大布局次数
+ * @return 最大布局次数
+ */
+int LayoutScheduler::maxPassesPerInputEvent() const
+{
+    return m_maxPassesPerInputEvent;
+}
+
+/**
+ * @brief 定时器触发，请求执行布局
+ */
+void LayoutScheduler::onTimeout()
+{
+    if (m_pending)
+        emit layoutRequested();
+}
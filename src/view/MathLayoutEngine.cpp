@@ -0,0 +1,1039 @@
+// ============================================================================
+// MathLayoutEngine.cpp
+// 数学排版引擎类的实现文件
+// TeX风格的盒子排版：分式、上下标、根式、矩阵和伸缩定界符，按节点增量排版
+// ============================================================================
+
+#include "view/MathLayoutEngine.h"
+#include <QFontMetricsF>
+#include <QGlyphRun>
+#include <QTransform>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief 原子类别（决定行内符号间距）
+ */
+enum AtomClass
+{
+    OrdinaryAtom,
+    BinaryAtom,
+    RelationAtom
+};
+
+/**
+ * @brief 获取节点的原子类别
+ * @param node 节点
+ * @return 原子类别
+ */
+AtomClass atomClass(const MathNode *node)
+{
+    if (node->type() != MathNode::Symbol || node->text().length() != 1)
+        return OrdinaryAtom;
+    switch (node->text().at(0).unicode())
+    {
+    case '+': case '-': case '*': case 0x2212: case 0x00B1: case 0x00D7: case 0x00F7: case 0x22C5:
+        return BinaryAtom;
+    case '=': case '<': case '>': case 0x2260: case 0x2264: case 0x2265: case 0x2248: case 0x2261:
+    case 0x2192: case 0x2208:
+        return RelationAtom;
+    default:
+        return OrdinaryAtom;
+    }
+}
+
+/**
+ * @brief 检查空行是否为可省略的槽位（角标和根指数），可省略的空槽不占空间
+ * @param node 行节点
+ * @return 是否可省略
+ */
+bool isOptionalSlot(const MathNode *node)
+{
+    const MathNode *parent = node->parent();
+    if (!parent)
+        return false;
+    int index = node->indexInParent();
+    return (parent->type() == MathNode::Script && index > 0)
+        || (parent->type() == MathNode::Radical && index == 1);
+}
+
+/**
+ * @brief 合并两个64位哈希值
+ */
+quint64 mixContext(quint64 hash, quint64 value)
+{
+    return (hash ^ value) * 0x100000001b3ULL;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ * @param cache 共享的排版缓存（可以为nullptr）
+ * @param parent 父对象
+ */
+MathLayoutEngine::MathLayoutEngine(FormulaLayoutCache *cache, QObject *parent)
+    : QObject(parent),
+      m_cache(cache),
+      m_dpi(96),
+      m_context(0),
+      m_visited(0),
+      m_composed(0)
+{
+    updateContext();
+}
+
+/**
+ * @brief 设置公式格式（字体和颜色）
+ * @param format 格式
+ */
+void MathLayoutEngine::setFormat(const Format &format)
+{
+    if (m_format == format)
+        return;
+    m_format = format;
+    updateContext();
+}
+
+/**
+ * @brief 获取公式格式
+ * @return 格式
+ */
+Format MathLayoutEngine::format() const
+{
+    return m_format;
+}
+
+/**
+ * @brief 设置设备DPI
+ * @param dpi 设备DPI
+ */
+void MathLayoutEngine::setDpi(int dpi)
+{
+    if (m_dpi == dpi || dpi <= 0)
+        return;
+    m_dpi = dpi;
+    updateContext();
+}
+
+/**
+ * @brief 获取设备DPI
+ * @return 设备DPI
+ */
+int MathLayoutEngine::dpi() const
+{
+    return m_dpi;
+}
+
+/**
+ * @brief 排版整个公式（重置访问和组合计数）
+ * @param formula 公式对象
+ * @return 根节点的排版结果
+ */
+QSharedPointer<const FormulaLayout> MathLayoutEngine::layoutFormula(const MathObject *formula)
+{
+    m_visited = 0;
+    m_composed = 0;
+    if (!formula || !formula->root())
+        return QSharedPointer<const FormulaLayout>();
+    return layoutNode(formula->root(), 0);
+}
+
+/**
+ * @brief 排版一个节点（未过期的子树直接返回缓存结果）
+ * @param node 节点
+ * @param level 脚本层级
+ * @return 排版结果
+ */
+QSharedPointer<const FormulaLayout> MathLayoutEngine::layoutNode(MathNode *node, int level)
+{
+    m_visited++;
+    QSharedPointer<const FormulaLayout> previous = node->layout();
+    bool sameContext = previous && previous->context == m_context && previous->level == level;
+    if (sameContext && !node->isLayoutDirty())
+        return previous;
+    if (node->type() == MathNode::Matrix)
+        return layoutMatrix(node, level, sameContext ? previous : QSharedPointer<const FormulaLayout>());
+
+    QVector<MathBox> childBoxes;
+    if (sameContext && !node->isContentChanged() && previous->childBoxes.size() == node->childCount())
+    {
+        // 子节点列表未变：只重新排版过期的子节点，其余沿用上次的盒子
+        childBoxes = previous->childBoxes;
+        for (MathNode *child : node->dirtyChildren())
+        {
+            int index = child->indexInParent();
+            childBoxes[index] = layoutNode(child, childLevel(node, index, level))->box;
+        }
+    }
+    else
+    {
+        childBoxes.reserve(node->childCount());
+        for (int i = 0; i < node->childCount(); i++)
+            childBoxes.append(layoutNode(node->child(i), childLevel(node, i, level))->box);
+    }
+
+    QSharedPointer<const FormulaLayout> result;
+    if (sameContext && !node->isContentChanged() && previous->childBoxes == childBoxes)
+    {
+        // 子节点的盒子都没有变化，原来的组合结果仍然正确
+        result = previous;
+    }
+    else
+    {
+        FormulaLayoutKey key;
+        key.hash = node->hash();
+        key.formatKey = m_formatKey;
+        key.dpi = m_dpi;
+        key.level = level;
+        // 空行的排版取决于它所在的槽位而不只是结构，不进入共享缓存
+        bool shareable = m_cache && (node->type() != MathNode::Row || node->childCount() > 0);
+        if (shareable)
+            result = m_cache->find(key);
+        if (!result)
+        {
+            m_composed++;
+            FormulaLayout layout = compose(node, childBoxes, level);
+            layout.childBoxes = childBoxes;
+            layout.level = level;
+            layout.context = m_context;
+            result = QSharedPointer<const FormulaLayout>(new FormulaLayout(layout));
+            if (shareable)
+                m_cache->insert(key, result);
+        }
+    }
+
+    node->setLayout(result, result->box);
+    return result;
+}
+
+/**
+ * @brief 排版矩阵节点
+ * @param node 矩阵节点
+ * @param level 脚本层级
+ * @param previous 同一上下文下的上次排版结果（可以为空）
+ * @return 排版结果
+ */
+QSharedPointer<const FormulaLayout> MathLayoutEngine::layoutMatrix(MathNode *node, int level,
+                                                                   const QSharedPointer<const FormulaLayout> &previous)
+{
+    QSharedPointer<MatrixGrid> grid = previous ? previous->grid : QSharedPointer<MatrixGrid>();
+    if (grid && !node->isContentChanged() && grid->cellCount() == node->childCount())
+    {
+        // 只更新过期的单元格，每个单元格O(log n)，其余单元格不再访问
+        for (MathNode *child : node->dirtyChildren())
+            grid->setCell(child->indexInParent(), layoutNode(child, level)->box);
+    }
+    else
+    {
+        const MathConstants &c = constants(level);
+        grid = QSharedPointer<MatrixGrid>(new MatrixGrid(node->rows(), node->columns(), node->text(),
+                                                         c.columnGap, c.rowGap, c.axisHeight));
+        QVector<MathBox> cells;
+        cells.reserve(node->childCount());
+        for (int i = 0; i < node->childCount(); i++)
+            cells.append(layoutNode(node->child(i), level)->box);
+        grid->reset(cells);
+    }
+    m_composed++;
+
+    MathBox box = grid->box();
+    QSharedPointer<const FormulaLayout> result = previous;
+    if (!previous || previous->grid != grid || previous->box != box)
+    {
+        FormulaLayout layout;
+        layout.box = box;
+        layout.grid = grid;
+        layout.level = level;
+        layout.context = m_context;
+        result = QSharedPointer<const FormulaLayout>(new FormulaLayout(layout));
+    }
+    node->setLayout(result, box);
+    return result;
+}
+
+/**
+ * @struct MathLayoutEngine::DisplayListRecorder
+ * @brief 显示列表记录器：按字号收集字形，拉伸字形和横线直接写入显示列表
+ */
+struct MathLayoutEngine::DisplayListRecorder
+{
+    QVector<quint32> glyphIndexes[LEVEL_COUNT];
+    QVector<QPointF> glyphPositions[LEVEL_COUNT];
+    FormulaDisplayList *displayList = nullptr;
+};
+
+/**
+ * @brief 获取公式的显示列表（必要时先排版）
+ * @param formula 公式对象
+ * @return 显示列表
+ */
+QSharedPointer<const FormulaDisplayList> MathLayoutEngine::displayList(const MathObject *formula)
+{
+    if (!formula || !formula->root())
+        return QSharedPointer<const FormulaDisplayList>();
+    MathNode *root = formula->root();
+    if (!root->layout() || root->isLayoutDirty() || root->layout()->context != m_context)
+        layoutFormula(formula);
+
+    FormulaLayoutKey key;
+    key.hash = root->hash();
+    key.formatKey = m_formatKey;
+    key.dpi = m_dpi;
+    if (m_cache)
+    {
+        QSharedPointer<const FormulaDisplayList> cached = m_cache->findDisplayList(key);
+        if (cached)
+            return cached;
+    }
+
+    QSharedPointer<FormulaDisplayList> displayList(new FormulaDisplayList());
+    displayList->color = m_format.color();
+    DisplayListRecorder recorder;
+    recorder.displayList = displayList.data();
+    recordNode(root, QPointF(0, 0), &recorder);
+
+    // 同一字号的字形合并为一个字形序列
+    for (int level = 0; level < LEVEL_COUNT; level++)
+    {
+        if (recorder.glyphIndexes[level].isEmpty())
+            continue;
+        QGlyphRun glyphRun;
+        glyphRun.setRawFont(m_rawFonts[level]);
+        glyphRun.setGlyphIndexes(recorder.glyphIndexes[level]);
+        glyphRun.setPositions(recorder.glyphPositions[level]);
+        displayList->glyphRuns.append(glyphRun);
+    }
+
+    if (m_cache)
+        m_cache->insertDisplayList(key, displayList);
+    return displayList;
+}
+
+/**
+ * @brief 点击测试：求离给定点最近的公式内位置
+ * @param formula 公式对象
+ * @param point 相对于公式基线原点的点
+ * @return 公式内位置
+ */
+MathPosition MathLayoutEngine::hitTest(const MathObject *formula, const QPointF &point)
+{
+    if (!formula || !formula->root())
+        return MathPosition();
+    const MathNode *row = formula->root();
+    if (!row->layout() || row->isLayoutDirty() || row->layout()->context != m_context)
+        layoutFormula(formula);
+
+    QPointF origin(0, 0);
+    while (true)
+    {
+        QSharedPointer<const FormulaLayout> layout = row->layout();
+        int count = row->childCount();
+        if (!layout || count == 0)
+            return MathPosition::fromNode(row, 0);
+
+        // Row的子节点从左到右排列，二分查找左边缘不超过该点的最后一个子节点
+        qreal x = point.x() - origin.x();
+        int low = 0;
+        int high = count;
+        while (low < high)
+        {
+            int middle = (low + high) / 2;
+            if (layout->childOffset(middle).x() <= x)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (low == 0)
+            return MathPosition::fromNode(row, 0);
+
+        int index = low - 1;
+        const MathNode *node = row->child(index);
+        QPointF nodeOrigin = origin + layout->childOffset(index);
+        QSharedPointer<const FormulaLayout> nodeLayout = node->layout();
+        if (x >= layout->childOffset(index).x() + node->box().width)
+            return MathPosition::fromNode(row, index + 1);
+
+        // 结构节点：进入包含该点的槽位
+        const MathNode *slot = nullptr;
+        if (nodeLayout && node->type() == MathNode::Matrix && nodeLayout->grid)
+        {
+            const MatrixGrid *grid = nodeLayout->grid.data();
+            QPointF local = point - nodeOrigin;
+            int column = grid->columnAt(local.x());
+            int gridRow = grid->rowAt(local.y() + grid->box().ascent);
+            if (column >= 0 && gridRow >= 0)
+                slot = node->child(gridRow * node->columns() + column);
+        }
+        else if (nodeLayout && node->type() != MathNode::Symbol)
+        {
+            for (int i = 0; i < node->childCount(); i++)
+            {
+                const MathNode *child = node->child(i);
+                QPointF childOrigin = nodeOrigin + nodeLayout->childOffset(i);
+                MathBox box = child->box();
+                QRectF rect(childOrigin.x(), childOrigin.y() - box.ascent, box.width, box.height());
+                if (child->type() == MathNode::Row && rect.contains(point))
+                {
+                    slot = child;
+                    break;
+                }
+            }
+        }
+        if (slot)
+        {
+            origin = nodeOrigin + nodeLayout->childOffset(slot->indexInParent());
+            row = slot;
+            continue;
+        }
+
+        // 原子节点或落在结构的装饰上：取较近的一侧
+        bool before = point.x() < nodeOrigin.x() + node->box().width / 2;
+        return MathPosition::fromNode(row, before ? index : index + 1);
+    }
+}
+
+/**
+ * @brief 获取公式内位置的光标矩形
+ * @param formula 公式对象
+ * @param position 公式内位置
+ * @return 光标矩形
+ */
+QRectF MathLayoutEngine::caretRect(const MathObject *formula, const MathPosition &position)
+{
+    if (!formula || !formula->root() || !position.row(formula->root()))
+        return QRectF();
+    const MathNode *node = formula->root();
+    if (!node->layout() || node->isLayoutDirty() || node->layout()->context != m_context)
+        layoutFormula(formula);
+
+    QPointF origin(0, 0);
+    for (int index : position.path())
+    {
+        origin += node->layout()->childOffset(index);
+        node = node->child(index);
+    }
+
+    QSharedPointer<const FormulaLayout> layout = node->layout();
+    int offset = position.offset();
+    qreal x = 0;
+    if (offset < node->childCount())
+        x = layout->childOffset(offset).x();
+    else if (offset > 0)
+        x = layout->childOffset(offset - 1).x() + node->child(offset - 1)->box().width;
+
+    // 光标至少和所在层级的x字高一样高，空槽位里也能看清
+    MathBox box = node->box();
+    const MathConstants &c = constants(layout->level);
+    qreal ascent = qMax(box.ascent, c.xHeight);
+    qreal descent = qMax(box.descent, c.ruleThickness);
+    return QRectF(origin.x() + x, origin.y() - ascent, 0, ascent + descent);
+}
+
+/**
+ * @brief 把已排版节点的绘制指令记录到显示列表
+ * @param node 节点
+ * @param origin 节点基线原点
+ * @param recorder 记录器
+ */
+void MathLayoutEngine::recordNode(const MathNode *node, const QPointF &origin, DisplayListRecorder *recorder) const
+{
+    QSharedPointer<const FormulaLayout> layout = node->layout();
+    if (!layout)
+        return;
+
+    for (const FormulaGlyph &glyph : layout->glyphs)
+    {
+        int level = qBound(0, glyph.level, LEVEL_COUNT - 1);
+        const QRawFont &rawFont = m_rawFonts[level];
+        QVector<quint32> indexes;
+        QVector<QPointF> positions;
+        if (glyph.text.isEmpty())
+        {
+            indexes.append(glyph.glyph);
+            positions.append(QPointF(0, 0));
+        }
+        else
+        {
+            indexes = rawFont.glyphIndexesForString(glyph.text);
+            QVector<QPointF> advances = rawFont.advancesForGlyphIndexes(indexes);
+            QPointF pen;
+            for (const QPointF &advance : advances)
+            {
+                positions.append(pen);
+                pen += advance;
+            }
+        }
+
+        QPointF base = origin + glyph.position;
+        for (int i = 0; i < indexes.size() && i < positions.size(); i++)
+        {
+            if (glyph.stretch == 1)
+            {
+                recorder->glyphIndexes[level].append(indexes.at(i));
+                recorder->glyphPositions[level].append(base + positions.at(i));
+            }
+            else
+            {
+                // 拉伸的字形无法放进字形序列，转换为轮廓
+                QTransform transform;
+                transform.translate(base.x() + positions.at(i).x(), base.y() + positions.at(i).y());
+                transform.scale(1, glyph.stretch);
+                recorder->displayList->path.addPath(transform.map(rawFont.pathForGlyph(indexes.at(i))));
+            }
+        }
+    }
+    for (const QRectF &rule : layout->rules)
+        recorder->displayList->rules.append(rule.translated(origin));
+
+    for (int i = 0; i < node->childCount(); i++)
+        recordNode(node->child(i), origin + layout->childOffset(i), recorder);
+}
+
+/**
+ * @brief 获取层级对应的字体
+ * @param level 脚本层级
+ * @return 字体
+ */
+QFont MathLayoutEngine::fontForLevel(int level) const
+{
+    return m_fonts[qBound(0, level, LEVEL_COUNT - 1)];
+}
+
+/**
+ * @brief 获取层级对应的排版参数
+ * @param level 脚本层级
+ * @return 排版参数
+ */
+const MathConstants &MathLayoutEngine::constants(int level) const
+{
+    return m_constants[qBound(0, level, LEVEL_COUNT - 1)];
+}
+
+/**
+ * @brief 获取层级对应的默认字号比例
+ * @param level 脚本层级
+ * @return 字号比例
+ */
+qreal MathLayoutEngine::levelScale(int level)
+{
+    static const qreal scales[LEVEL_COUNT] = { 1.0, 0.7, 0.5 };
+    return scales[qBound(0, level, LEVEL_COUNT - 1)];
+}
+
+/**
+ * @brief 获取公式字体的MATH表
+ * @return MATH表
+ */
+QSharedPointer<const MathTable> MathLayoutEngine::mathTable() const
+{
+    return m_mathTable;
+}
+
+/**
+ * @brief 获取子节点的脚本层级
+ * @param node 父节点
+ * @param index 子节点索引
+ * @param level 父节点的脚本层级
+ * @return 子节点的脚本层级
+ */
+int MathLayoutEngine::childLevel(const MathNode *node, int index, int level)
+{
+    switch (node->type())
+    {
+    case MathNode::Fraction:
+        return qMin(level + 1, LEVEL_COUNT - 1);
+    case MathNode::Script:
+        return index == 0 ? level : qMin(level + 1, LEVEL_COUNT - 1);
+    case MathNode::Radical:
+        return index == 0 ? level : LEVEL_COUNT - 1;
+    default:
+        return level;
+    }
+}
+
+/**
+ * @brief 获取上一次layoutFormula访问的节点数
+ * @return 节点数
+ */
+int MathLayoutEngine::visitedNodeCount() const
+{
+    return m_visited;
+}
+
+/**
+ * @brief 获取上一次layoutFormula重新组合的节点数
+ * @return 节点数
+ */
+int MathLayoutEngine::composedNodeCount() const
+{
+    return m_composed;
+}
+
+/**
+ * @brief 根据子节点盒子组合节点的排版结果
+ * @param node 节点
+ * @param childBoxes 子节点盒子
+ * @param level 脚本层级
+ * @return 排版结果
+ */
+FormulaLayout MathLayoutEngine::compose(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const
+{
+    switch (node->type())
+    {
+    case MathNode::Symbol:
+        return composeSymbol(node, level);
+    case MathNode::Fraction:
+        return composeFraction(childBoxes, level);
+    case MathNode::Script:
+        return composeScript(node, childBoxes, level);
+    case MathNode::Radical:
+        return composeRadical(node, childBoxes, level);
+    case MathNode::Delimited:
+        return composeDelimited(node, childBoxes, level);
+    case MathNode::Row:
+    default:
+        return composeRow(node, childBoxes, level);
+    }
+}
+
+/**
+ * @brief 组合符号：字形的紧包围盒，斜体修正取自右侧悬出量
+ */
+FormulaLayout MathLayoutEngine::composeSymbol(const MathNode *node, int level) const
+{
+    FormulaLayout layout;
+    QString text = node->text();
+    if (text.isEmpty())
+        return layout;
+
+    QFontMetricsF metrics(fontForLevel(level));
+    QRectF bounds = metrics.tightBoundingRect(text);
+    layout.box.width = metrics.horizontalAdvance(text);
+    layout.box.ascent = qMax<qreal>(0, -bounds.top());
+    layout.box.descent = qMax<qreal>(0, bounds.bottom());
+    layout.box.italicCorrection = qMax<qreal>(0, -metrics.rightBearing(text.at(text.length() - 1)));
+
+    // 单个字形优先使用MATH表中的斜体修正
+    const QRawFont &rawFont = m_rawFonts[qBound(0, level, LEVEL_COUNT - 1)];
+    if (m_mathTable->isValid() && rawFont.isValid())
+    {
+        QVector<quint32> indexes = rawFont.glyphIndexesForString(text);
+        if (indexes.size() == 1)
+            layout.box.italicCorrection = m_mathTable->toPixels(m_mathTable->italicsCorrection(indexes.first()),
+                                                                rawFont.pixelSize());
+    }
+
+    FormulaGlyph glyph;
+    glyph.text = text;
+    glyph.level = level;
+    layout.glyphs.append(glyph);
+    return layout;
+}
+
+/**
+ * @brief 组合水平行：正文层级在二元运算符和关系符两侧加间距，必需的空槽显示占位框
+ */
+FormulaLayout MathLayoutEngine::composeRow(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const
+{
+    FormulaLayout layout;
+    const MathConstants &c = constants(level);
+
+    if (childBoxes.isEmpty())
+    {
+        if (isOptionalSlot(node))
+            return layout;
+        // 占位框：一个x字高的空心方框
+        qreal t = c.ruleThickness * 0.5;
+        qreal w = c.xHeight * 0.8;
+        qreal h = c.xHeight;
+        layout.box.width = w + 2 * c.scriptSpace;
+        layout.box.ascent = h;
+        layout.rules.append(QRectF(c.scriptSpace, -h, w, t));
+        layout.rules.append(QRectF(c.scriptSpace, -t, w, t));
+        layout.rules.append(QRectF(c.scriptSpace, -h, t, h));
+        layout.rules.append(QRectF(c.scriptSpace + w - t, -h, t, h));
+        return layout;
+    }
+
+    qreal x = 0;
+    int previous = -1;
+    layout.childOffsets.reserve(childBoxes.size());
+    for (int i = 0; i < childBoxes.size(); i++)
+    {
+        int cls = atomClass(node->child(i));
+        // 行首或紧跟运算符的二元运算符按一元处理（如负号）
+        if (cls == BinaryAtom && (previous == -1 || previous == BinaryAtom || previous == RelationAtom))
+            cls = OrdinaryAtom;
+        if (previous != -1 && level == 0)
+        {
+            if ((cls == RelationAtom) != (previous == RelationAtom))
+                x += c.em * 5 / 18;
+            else if ((cls == BinaryAtom) != (previous == BinaryAtom))
+                x += c.em * 4 / 18;
+        }
+        const MathBox &box = childBoxes.at(i);
+        layout.childOffsets.append(QPointF(x, 0));
+        x += box.width;
+        layout.box.ascent = qMax(layout.box.ascent, box.ascent);
+        layout.box.descent = qMax(layout.box.descent, box.descent);
+        previous = cls;
+    }
+    layout.box.width = x;
+    layout.box.italicCorrection = childBoxes.last().italicCorrection;
+    return layout;
+}
+
+/**
+ * @brief 组合分式：分数线位于数学轴上，分子分母与分数线保持最小间距
+ */
+FormulaLayout MathLayoutEngine::composeFraction(const QVector<MathBox> &childBoxes, int level) const
+{
+    FormulaLayout layout;
+    const MathConstants &c = constants(level);
+    MathBox numerator = childBoxes.value(0);
+    MathBox denominator = childBoxes.value(1);
+
+    qreal t = c.ruleThickness;
+    qreal pad = c.em * 0.1;
+    qreal width = qMax(numerator.width, denominator.width) + 2 * pad;
+    qreal ruleTop = -c.axisHeight - t / 2;
+    qreal numeratorY = ruleTop - c.fractionGap - numerator.descent;
+    qreal denominatorY = ruleTop + t + c.fractionGap + denominator.ascent;
+
+    layout.childOffsets.append(QPointF((width - numerator.width) / 2, numeratorY));
+    layout.childOffsets.append(QPointF((width - denominator.width) / 2, denominatorY));
+    layout.rules.append(QRectF(0, ruleTop, width, t));
+    layout.box.width = width;
+    layout.box.ascent = qMax<qreal>(0, numerator.ascent - numeratorY);
+    layout.box.descent = qMax<qreal>(0, denominatorY + denominator.descent);
+    return layout;
+}
+
+/**
+ * @brief 组合上下标：按TeX规则计算上移和下移量，同时存在时保证两者的最小间隙
+ */
+FormulaLayout MathLayoutEngine::composeScript(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const
+{
+    FormulaLayout layout;
+    const MathConstants &c = constants(level);
+    MathBox base = childBoxes.value(0);
+    MathBox sub = childBoxes.value(1);
+    MathBox sup = childBoxes.value(2);
+    bool hasSub = node->child(1) && node->child(1)->childCount() > 0;
+    bool hasSup = node->child(2) && node->child(2)->childCount() > 0;
+
+    qreal shiftUp = 0;
+    qreal shiftDown = 0;
+    if (hasSup)
+    {
+        shiftUp = qMax(c.superscriptShiftUp, base.ascent - c.superscriptDrop);
+        shiftUp = qMax(shiftUp, sup.descent + c.superscriptBottomMin);
+    }
+    if (hasSub)
+    {
+        shiftDown = qMax(c.subscriptShiftDown, sub.ascent - c.subscriptTopMax);
+        shiftDown = qMax(shiftDown, base.descent + c.subscriptDrop);
+    }
+    if (hasSub && hasSup)
+    {
+        qreal minGap = c.subSuperscriptGap;
+        qreal gap = (shiftUp - sup.descent) - (sub.ascent - shiftDown);
+        if (gap < minGap)
+            shiftDown += minGap - gap;
+    }
+
+    layout.childOffsets.append(QPointF(0, 0));
+    layout.childOffsets.append(QPointF(base.width, shiftDown));
+    layout.childOffsets.append(QPointF(base.width + base.italicCorrection, -shiftUp));
+
+    qreal scriptWidth = qMax(hasSub ? sub.width : 0, hasSup ? base.italicCorrection + sup.width : 0);
+    layout.box.width = base.width + scriptWidth + (hasSub || hasSup ? c.scriptSpace : 0);
+    layout.box.ascent = qMax(base.ascent, hasSup ? shiftUp + sup.ascent : 0);
+    layout.box.descent = qMax(base.descent, hasSub ? shiftDown + sub.descent : 0);
+    if (!hasSub && !hasSup)
+        layout.box.italicCorrection = base.italicCorrection;
+    return layout;
+}
+
+/**
+ * @brief 组合根式：根号伸展到被开方数高度，上方接一条横线，可带根指数
+ */
+FormulaLayout MathLayoutEngine::composeRadical(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const
+{
+    FormulaLayout layout;
+    const MathConstants &c = constants(level);
+    MathBox radicand = childBoxes.value(0);
+    MathBox index = childBoxes.value(1);
+    bool hasIndex = node->child(1) && node->child(1)->childCount() > 0;
+
+    static const QString sign(QChar(0x221A));
+    qreal t = c.ruleThickness;
+    qreal barTop = -(radicand.ascent + c.radicalGap + t);
+    StretchyGlyph stretchy = stretchyGlyph(sign, radicand.descent + t - barTop, level);
+    qreal signWidth = stretchy.advance;
+    // 根号墨迹的顶部对齐横线顶部
+    qreal signBottom = barTop + stretchy.ink.height();
+
+    // 根指数放在根号左上方，必要时把根号右移
+    qreal signX = hasIndex ? qMax<qreal>(0, index.width - signWidth * 0.5) : 0;
+    qreal indexY = signBottom - 0.6 * (signBottom - barTop) - index.descent;
+
+    QPointF offset(signX, barTop - stretchy.ink.top());
+    for (FormulaGlyph glyph : stretchy.glyphs)
+    {
+        glyph.position += offset;
+        layout.glyphs.append(glyph);
+    }
+
+    qreal radicandX = signX + signWidth;
+    qreal width = radicandX + radicand.width + c.scriptSpace;
+    qreal ruleX = qMax(signX, signX + stretchy.ink.right() - t);
+    layout.rules.append(QRectF(ruleX, barTop, width - ruleX, t));
+
+    layout.childOffsets.append(QPointF(radicandX, 0));
+    layout.childOffsets.append(QPointF(signX + signWidth * 0.5 - index.width, indexY));
+    layout.box.width = width;
+    layout.box.ascent = qMax(-barTop + t, hasIndex ? index.ascent - indexY : 0);
+    layout.box.descent = qMax(radicand.descent, signBottom);
+    return layout;
+}
+
+/**
+ * @brief 组合定界符：两侧字形以数学轴为中心拉伸到覆盖内容的高度（'.'表示该侧无定界符）
+ */
+FormulaLayout MathLayoutEngine::composeDelimited(const MathNode *node, const QVector<MathBox> &childBoxes, int level) const
+{
+    FormulaLayout layout;
+    const MathConstants &c = constants(level);
+    MathBox body = childBoxes.value(0);
+    QString text = node->text();
+
+    qreal delta = qMax(body.ascent - c.axisHeight, body.descent + c.axisHeight);
+    qreal target = qMax(2 * delta * 0.901, 2 * delta - c.delimiterShortfall);
+
+    layout.box.ascent = body.ascent;
+    layout.box.descent = body.descent;
+    qreal x = 0;
+    if (text.length() > 0 && text.at(0) != QLatin1Char('.'))
+        x += placeDelimiter(&layout, text.left(1), x, target, level, &layout.box);
+    layout.childOffsets.append(QPointF(x, 0));
+    x += body.width;
+    if (text.length() > 1 && text.at(1) != QLatin1Char('.'))
+        x += placeDelimiter(&layout, text.mid(1, 1), x, target, level, &layout.box);
+    layout.box.width = x;
+    return layout;
+}
+
+/**
+ * @brief 放置一个以数学轴为中心、伸展到目标高度的定界符
+ * @param layout 排版结果（追加字形）
+ * @param delimiter 定界符字符
+ * @param x 水平位置
+ * @param targetHeight 目标高度
+ * @param level 脚本层级
+ * @param box 盒子（扩展其高度和深度）
+ * @return 定界符宽度
+ */
+qreal MathLayoutEngine::placeDelimiter(FormulaLayout *layout, const QString &delimiter, qreal x,
+                                       qreal targetHeight, int level, MathBox *box) const
+{
+    StretchyGlyph stretchy = stretchyGlyph(delimiter, targetHeight, level);
+    QPointF offset(x, -constants(level).axisHeight - stretchy.ink.center().y());
+    for (FormulaGlyph glyph : stretchy.glyphs)
+    {
+        glyph.position += offset;
+        layout->glyphs.append(glyph);
+    }
+
+    QRectF ink = stretchy.ink.translated(offset);
+    box->ascent = qMax(box->ascent, -ink.top());
+    box->descent = qMax(box->descent, ink.bottom());
+    return stretchy.advance;
+}
+
+/**
+ * @brief 构造垂直伸展到目标高度的符号
+ * @param symbol 符号字符
+ * @param targetHeight 目标高度
+ * @param level 脚本层级
+ * @return 伸展后的符号
+ */
+MathLayoutEngine::StretchyGlyph MathLayoutEngine::stretchyGlyph(const QString &symbol, qreal targetHeight, int level) const
+{
+    StretchyGlyph result;
+    level = qBound(0, level, LEVEL_COUNT - 1);
+    const QRawFont &rawFont = m_rawFonts[level];
+    QVector<quint32> indexes = rawFont.isValid() ? rawFont.glyphIndexesForString(symbol) : QVector<quint32>();
+
+    if (m_mathTable->isValid() && indexes.size() == 1 && indexes.first() != 0)
+    {
+        qreal pixelSize = rawFont.pixelSize();
+        quint32 chosen = indexes.first();
+        bool tallEnough = false;
+        // 变体按尺寸递增排列，二分查找第一个足够高的；都不够高时取最大的变体
+        MathTable::Range<MathTable::GlyphVariant> variants = m_mathTable->variants(chosen, Qt::Vertical);
+        auto variant = std::lower_bound(variants.begin(), variants.end(), targetHeight,
+                                        [this, pixelSize](const MathTable::GlyphVariant &entry, qreal height) {
+                                            return m_mathTable->toPixels(entry.advance, pixelSize) < height;
+                                        });
+        if (variant != variants.end())
+        {
+            chosen = variant->glyph;
+            tallEnough = true;
+        }
+        else if (!variants.isEmpty())
+        {
+            chosen = variants.last().glyph;
+        }
+
+        MathTable::Range<MathTable::GlyphPart> parts = m_mathTable->assembly(indexes.first(), Qt::Vertical);
+        if (tallEnough || parts.isEmpty())
+        {
+            FormulaGlyph glyph;
+            glyph.glyph = chosen;
+            glyph.level = level;
+            result.glyphs.append(glyph);
+            result.ink = rawFont.boundingRect(chosen);
+            result.advance = rawFont.advancesForGlyphIndexes(QVector<quint32>() << chosen).value(0).x();
+            return result;
+        }
+
+        // 拼装：增加延伸部件的重复次数，直到按最小重叠拼接的最大长度达到目标
+        qreal minOverlap = m_mathTable->toPixels(m_mathTable->minConnectorOverlap(), pixelSize);
+        bool hasExtender = false;
+        for (const MathTable::GlyphPart &part : parts)
+            hasExtender = hasExtender || part.extender;
+        int repeats = 0;
+        int count = 0;
+        qreal fullLength = 0;
+        forever
+        {
+            count = 0;
+            fullLength = 0;
+            for (const MathTable::GlyphPart &part : parts)
+            {
+                int times = part.extender ? repeats : 1;
+                count += times;
+                fullLength += times * m_mathTable->toPixels(part.fullAdvance, pixelSize);
+            }
+            if (!hasExtender || repeats >= MAX_ASSEMBLY_REPEATS
+                || fullLength - (count - 1) * minOverlap >= targetHeight)
+                break;
+            repeats++;
+        }
+
+        // 多出的长度平均分给各连接处的重叠
+        qreal overlap = count > 1 ? qMax(minOverlap, (fullLength - targetHeight) / (count - 1)) : 0;
+        qreal y = 0;
+        qreal width = 0;
+        for (const MathTable::GlyphPart &part : parts)
+        {
+            QRectF bounds = rawFont.boundingRect(part.glyph);
+            qreal advance = m_mathTable->toPixels(part.fullAdvance, pixelSize);
+            int times = part.extender ? repeats : 1;
+            for (int i = 0; i < times; i++)
+            {
+                // 部件从下往上排列，墨迹底部对齐当前位置
+                FormulaGlyph glyph;
+                glyph.glyph = part.glyph;
+                glyph.position = QPointF(0, y - bounds.bottom());
+                glyph.level = level;
+                result.glyphs.append(glyph);
+                y -= advance - overlap;
+                width = qMax(width, rawFont.advancesForGlyphIndexes(QVector<quint32>() << part.glyph).value(0).x());
+            }
+        }
+        qreal top = y - (count > 0 ? overlap : 0);
+        result.ink = QRectF(0, top, width, -top);
+        result.advance = width;
+        return result;
+    }
+
+    // 没有MATH表：纵向拉伸普通字形
+    QFontMetricsF metrics(fontForLevel(level));
+    QRectF bounds = metrics.tightBoundingRect(symbol);
+    qreal stretch = bounds.height() > 0 ? qMax<qreal>(1, targetHeight / bounds.height()) : 1;
+    FormulaGlyph glyph;
+    glyph.text = symbol;
+    glyph.level = level;
+    glyph.stretch = stretch;
+    result.glyphs.append(glyph);
+    result.ink = QRectF(bounds.left(), bounds.top() * stretch, bounds.width(), bounds.height() * stretch);
+    result.advance = metrics.horizontalAdvance(symbol);
+    return result;
+}
+
+/**
+ * @brief 重新计算各层级字体、参数和排版上下文
+ */
+void MathLayoutEngine::updateContext()
+{
+    m_formatKey = FormulaLayoutCache::formatKey(m_format);
+    m_context = mixContext(mixContext(0xcbf29ce484222325ULL, qHash(m_formatKey)), static_cast<quint64>(m_dpi));
+
+    QFont base = m_format.font();
+    qreal pointSize = base.pointSizeF() > 0 ? base.pointSizeF() : base.pixelSize() * 72.0 / m_dpi;
+    m_mathTable = MathTable::forFont(QRawFont::fromFont(base));
+    const MathTable *table = m_mathTable->isValid() ? m_mathTable.data() : nullptr;
+    for (int level = 0; level < LEVEL_COUNT; level++)
+    {
+        // 角标字号比例优先取自MATH表
+        qreal scale = levelScale(level);
+        if (table && level == 1 && table->constant(MathTable::ScriptPercentScaleDown) > 0)
+            scale = table->constant(MathTable::ScriptPercentScaleDown) / 100.0;
+        else if (table && level == 2 && table->constant(MathTable::ScriptScriptPercentScaleDown) > 0)
+            scale = table->constant(MathTable::ScriptScriptPercentScaleDown) / 100.0;
+
+        QFont font = base;
+        font.setPointSizeF(pointSize * scale);
+        m_fonts[level] = font;
+        m_rawFonts[level] = QRawFont::fromFont(font);
+
+        QFontMetricsF metrics(font);
+        MathConstants &c = m_constants[level];
+        c.em = font.pointSizeF() * m_dpi / 72.0;
+        c.xHeight = metrics.xHeight();
+        c.delimiterShortfall = c.em * 0.5;
+        c.columnGap = c.em * 0.8;
+        c.rowGap = c.em * 0.3;
+
+        if (table && m_rawFonts[level].isValid())
+        {
+            qreal pixelSize = m_rawFonts[level].pixelSize();
+            auto value = [table, pixelSize](MathTable::Constant constant) {
+                return table->toPixels(table->constant(constant), pixelSize);
+            };
+            c.axisHeight = value(MathTable::AxisHeight);
+            c.ruleThickness = value(MathTable::FractionRuleThickness);
+            c.fractionGap = value(MathTable::FractionNumeratorGapMin);
+            c.superscriptShiftUp = value(MathTable::SuperscriptShiftUp);
+            c.subscriptShiftDown = value(MathTable::SubscriptShiftDown);
+            c.superscriptDrop = value(MathTable::SuperscriptBaselineDropMax);
+            c.subscriptDrop = value(MathTable::SubscriptBaselineDropMin);
+            c.superscriptBottomMin = value(MathTable::SuperscriptBottomMin);
+            c.subscriptTopMax = value(MathTable::SubscriptTopMax);
+            c.subSuperscriptGap = value(MathTable::SubSuperscriptGapMin);
+            c.scriptSpace = value(MathTable::SpaceAfterScript);
+            c.radicalGap = value(MathTable::RadicalVerticalGap);
+            continue;
+        }
+
+        // 没有MATH表：按字体度量估算，数学轴取减号的中心高度
+        QRectF minus = metrics.tightBoundingRect(QString(QChar(0x2212)));
+        c.axisHeight = minus.isEmpty() ? c.xHeight / 2 : -(minus.top() + minus.bottom()) / 2;
+        c.ruleThickness = qMax(metrics.lineWidth(), c.em * 0.04);
+        c.fractionGap = c.ruleThickness;
+        c.superscriptShiftUp = c.em * 0.413;
+        c.subscriptShiftDown = c.em * 0.15;
+        c.superscriptDrop = c.em * 0.386 * levelScale(1);
+        c.subscriptDrop = c.em * 0.05 * levelScale(1);
+        c.superscriptBottomMin = c.xHeight / 4;
+        c.subscriptTopMax = c.xHeight * 0.8;
+        c.subSuperscriptGap = 4 * c.ruleThickness;
+        c.scriptSpace = c.em * 0.05;
+        c.radicalGap = c.ruleThickness + c.xHeight / 4;
+    }
+}
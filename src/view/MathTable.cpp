@@ -0,0 +1,415 @@
+// ============================================================================
+// MathTable.cpp
+// OpenType MATH表类的实现文件
+// 解析字体的MATH表，提供数学常量、斜体修正、字形变体和字形拼装查询
+// ============================================================================
+
+#include "view/MathTable.h"
+#include <QHash>
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief 读取大端无符号16位整数，越界时返回0并清除ok标志
+ */
+quint16 readU16(const QByteArray &data, int offset, bool *ok)
+{
+    if (offset < 0 || offset + 2 > data.size())
+    {
+        *ok = false;
+        return 0;
+    }
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData()) + offset;
+    return static_cast<quint16>((p[0] << 8) | p[1]);
+}
+
+/**
+ * @brief 读取大端有符号16位整数
+ */
+qint16 readS16(const QByteArray &data, int offset, bool *ok)
+{
+    return static_cast<qint16>(readU16(data, offset, ok));
+}
+
+/**
+ * @brief 解析覆盖表，返回按覆盖索引排列的字形
+ * @param data 表数据
+ * @param offset 覆盖表偏移
+ * @param ok 解析标志
+ * @return 字形索引
+ */
+QVector<quint16> readCoverage(const QByteArray &data, int offset, bool *ok)
+{
+    QVector<quint16> glyphs;
+    quint16 format = readU16(data, offset, ok);
+    quint16 count = readU16(data, offset + 2, ok);
+    if (format == 1)
+    {
+        glyphs.reserve(count);
+        for (int i = 0; i < count && *ok; i++)
+            glyphs.append(readU16(data, offset + 4 + i * 2, ok));
+    }
+    else if (format == 2)
+    {
+        // 范围记录：起始字形、结束字形、起始覆盖索引
+        for (int i = 0; i < count && *ok; i++)
+        {
+            int record = offset + 4 + i * 6;
+            quint16 start = readU16(data, record, ok);
+            quint16 end = readU16(data, record + 2, ok);
+            quint16 startIndex = readU16(data, record + 4, ok);
+            if (!*ok || end < start)
+                break;
+            if (glyphs.size() < startIndex + (end - start) + 1)
+                glyphs.resize(startIndex + (end - start) + 1);
+            for (int glyph = start; glyph <= end; glyph++)
+                glyphs[startIndex + glyph - start] = static_cast<quint16>(glyph);
+        }
+    }
+    else
+    {
+        *ok = false;
+    }
+    return glyphs;
+}
+
+} // namespace
+
+/**
+ * @brief 构造空表
+ */
+MathTable::MathTable()
+    : m_valid(false),
+      m_unitsPerEm(1000),
+      m_minConnectorOverlap(0)
+{
+    std::fill(m_constants, m_constants + ConstantCount, qint16(0));
+}
+
+/**
+ * @brief 从MATH表原始数据解析
+ * @param data MATH表数据
+ * @param unitsPerEm 字体每em的设计单位数
+ * @return 是否解析成功
+ */
+bool MathTable::load(const QByteArray &data, qreal unitsPerEm)
+{
+    *this = MathTable();
+    if (unitsPerEm > 0)
+        m_unitsPerEm = unitsPerEm;
+
+    // 表头：主版本、次版本、常量/字形信息/变体子表偏移
+    bool ok = true;
+    quint16 majorVersion = readU16(data, 0, &ok);
+    int constantsOffset = readU16(data, 4, &ok);
+    int glyphInfoOffset = readU16(data, 6, &ok);
+    int variantsOffset = readU16(data, 8, &ok);
+    if (!ok || majorVersion != 1)
+        return false;
+
+    if (!parseConstants(data, constantsOffset))
+        return false;
+    // 字形信息和变体解析失败时仍可使用常量
+    if (glyphInfoOffset && !parseGlyphInfo(data, glyphInfoOffset))
+    {
+        m_italicGlyphs.clear();
+        m_italicValues.clear();
+    }
+    if (variantsOffset && !parseVariants(data, variantsOffset))
+    {
+        m_verticalConstructions.clear();
+        m_horizontalConstructions.clear();
+        m_variants.clear();
+        m_parts.clear();
+    }
+
+    m_valid = true;
+    return true;
+}
+
+/**
+ * @brief 获取字体的MATH表（同一字体只解析一次）
+ * @param font 字体
+ * @return MATH表
+ */
+QSharedPointer<const MathTable> MathTable::forFont(const QRawFont &font)
+{
+    // 表内容与字号无关，按字体族和样式缓存
+    static QHash<QString, QSharedPointer<const MathTable>> tables;
+    QString key = font.familyName() + QLatin1Char('|') + font.styleName();
+    QSharedPointer<const MathTable> table = tables.value(key);
+    if (!table)
+    {
+        QSharedPointer<MathTable> loaded(new MathTable());
+        if (font.isValid())
+            loaded->load(font.fontTable("MATH"), font.unitsPerEm());
+        table = loaded;
+        tables.insert(key, table);
+    }
+    return table;
+}
+
+/**
+ * @brief 检查表是否有效
+ * @return 是否有效
+ */
+bool MathTable::isValid() const
+{
+    return m_valid;
+}
+
+/**
+ * @brief 获取字体每em的设计单位数
+ * @return 设计单位数
+ */
+qreal MathTable::unitsPerEm() const
+{
+    return m_unitsPerEm;
+}
+
+/**
+ * @brief 把设计单位换算为像素
+ * @param units 设计单位数值
+ * @param pixelSize 像素字号
+ * @return 像素值
+ */
+qreal MathTable::toPixels(qreal units, qreal pixelSize) const
+{
+    return units * pixelSize / m_unitsPerEm;
+}
+
+/**
+ * @brief 获取数学常量
+ * @param constant 常量
+ * @return 常量值
+ */
+int MathTable::constant(Constant constant) const
+{
+    if (constant < 0 || constant >= ConstantCount)
+        return 0;
+    return m_constants[constant];
+}
+
+/**
+ * @brief 获取字形的斜体修正
+ * @param glyph 字形索引
+ * @return 斜体修正（设计单位）
+ */
+int MathTable::italicsCorrection(quint32 glyph) const
+{
+    auto it = std::lower_bound(m_italicGlyphs.constBegin(), m_italicGlyphs.constEnd(), glyph);
+    if (it == m_italicGlyphs.constEnd() || *it != glyph)
+        return 0;
+    return m_italicValues.at(static_cast<int>(it - m_italicGlyphs.constBegin()));
+}
+
+/**
+ * @brief 获取字形在指定方向上的变体
+ * @param glyph 字形索引
+ * @param orientation 伸展方向
+ * @return 变体
+ */
+MathTable::Range<MathTable::GlyphVariant> MathTable::variants(quint32 glyph, Qt::Orientation orientation) const
+{
+    Range<GlyphVariant> range;
+    const Construction *construction = findConstruction(glyph, orientation);
+    if (construction && construction->variantCount > 0)
+    {
+        range.first = m_variants.constData() + construction->firstVariant;
+        range.count = construction->variantCount;
+    }
+    return range;
+}
+
+/**
+ * @brief 获取字形在指定方向上的拼装部件
+ * @param glyph 字形索引
+ * @param orientation 伸展方向
+ * @return 拼装部件
+ */
+MathTable::Range<MathTable::GlyphPart> MathTable::assembly(quint32 glyph, Qt::Orientation orientation) const
+{
+    Range<GlyphPart> range;
+    const Construction *construction = findConstruction(glyph, orientation);
+    if (construction && construction->partCount > 0)
+    {
+        range.first = m_parts.constData() + construction->firstPart;
+        range.count = construction->partCount;
+    }
+    return range;
+}
+
+/**
+ * @brief 获取拼装部件之间的最小重叠长度
+ * @return 最小重叠长度（设计单位）
+ */
+int MathTable::minConnectorOverlap() const
+{
+    return m_minConnectorOverlap;
+}
+
+/**
+ * @brief 解析常量子表
+ * @param data 表数据
+ * @param offset 子表偏移
+ * @return 是否成功
+ */
+bool MathTable::parseConstants(const QByteArray &data, int offset)
+{
+    // 前两个是百分比，接着两个设计单位值，然后是51个MathValueRecord（值+设备表偏移），
+    // 最后一个百分比
+    bool ok = true;
+    int field = offset;
+    for (int i = 0; i < ConstantCount && ok; i++)
+    {
+        m_constants[i] = readS16(data, field, &ok);
+        bool valueRecord = i >= MathLeading && i < RadicalDegreeBottomRaisePercent;
+        field += valueRecord ? 4 : 2;
+    }
+    return ok;
+}
+
+/**
+ * @brief 解析字形信息子表（斜体修正）
+ * @param data 表数据
+ * @param offset 子表偏移
+ * @return 是否成功
+ */
+bool MathTable::parseGlyphInfo(const QByteArray &data, int offset)
+{
+    bool ok = true;
+    int italicsOffset = readU16(data, offset, &ok);
+    if (!ok || italicsOffset == 0)
+        return ok;
+
+    int base = offset + italicsOffset;
+    int coverageOffset = readU16(data, base, &ok);
+    int count = readU16(data, base + 2, &ok);
+    QVector<quint16> glyphs = readCoverage(data, base + coverageOffset, &ok);
+    if (!ok)
+        return false;
+
+    count = qMin(count, glyphs.size());
+    QVector<QPair<quint16, qint16>> records;
+    records.reserve(count);
+    for (int i = 0; i < count && ok; i++)
+        records.append(qMakePair(glyphs.at(i), readS16(data, base + 4 + i * 4, &ok)));
+    std::sort(records.begin(), records.end());
+
+    m_italicGlyphs.reserve(records.size());
+    m_italicValues.reserve(records.size());
+    for (const auto &record : records)
+    {
+        m_italicGlyphs.append(record.first);
+        m_italicValues.append(record.second);
+    }
+    return ok;
+}
+
+/**
+ * @brief 解析变体子表
+ * @param data 表数据
+ * @param offset 子表偏移
+ * @return 是否成功
+ */
+bool MathTable::parseVariants(const QByteArray &data, int offset)
+{
+    bool ok = true;
+    m_minConnectorOverlap = readU16(data, offset, &ok);
+    int verticalCoverage = readU16(data, offset + 2, &ok);
+    int horizontalCoverage = readU16(data, offset + 4, &ok);
+    int verticalCount = readU16(data, offset + 6, &ok);
+    int horizontalCount = readU16(data, offset + 8, &ok);
+    if (!ok)
+        return false;
+
+    int offsetsStart = offset + 10;
+    return parseConstructions(data, offset, verticalCoverage, verticalCount, offsetsStart,
+                              &m_verticalConstructions)
+        && parseConstructions(data, offset, horizontalCoverage, horizontalCount, offsetsStart + verticalCount * 2,
+                              &m_horizontalConstructions);
+}
+
+/**
+ * @brief 解析一个方向的字形构造
+ * @param data 表数据
+ * @param base 变体子表偏移（其他偏移均相对于它）
+ * @param coverageOffset 覆盖表偏移
+ * @param count 构造数量
+ * @param offsetsStart 构造偏移数组的位置
+ * @param constructions 输出的构造（按字形索引排序）
+ * @return 是否成功
+ */
+bool MathTable::parseConstructions(const QByteArray &data, int base, int coverageOffset, int count,
+                                   int offsetsStart, QVector<Construction> *constructions)
+{
+    if (count == 0 || coverageOffset == 0)
+        return true;
+
+    bool ok = true;
+    QVector<quint16> glyphs = readCoverage(data, base + coverageOffset, &ok);
+    count = qMin(count, glyphs.size());
+    for (int i = 0; i < count && ok; i++)
+    {
+        int construction = base + readU16(data, offsetsStart + i * 2, &ok);
+        int assemblyOffset = readU16(data, construction, &ok);
+        int variantCount = readU16(data, construction + 2, &ok);
+
+        Construction entry;
+        entry.glyph = glyphs.at(i);
+        entry.firstVariant = m_variants.size();
+        entry.variantCount = variantCount;
+        for (int v = 0; v < variantCount && ok; v++)
+        {
+            GlyphVariant variant;
+            variant.glyph = readU16(data, construction + 4 + v * 4, &ok);
+            variant.advance = readU16(data, construction + 6 + v * 4, &ok);
+            m_variants.append(variant);
+        }
+
+        // 拼装：斜体修正（MathValueRecord），部件数量，部件记录
+        entry.firstPart = m_parts.size();
+        if (assemblyOffset)
+        {
+            int assembly = construction + assemblyOffset;
+            int partCount = readU16(data, assembly + 4, &ok);
+            for (int p = 0; p < partCount && ok; p++)
+            {
+                int record = assembly + 6 + p * 10;
+                GlyphPart part;
+                part.glyph = readU16(data, record, &ok);
+                part.startConnector = readU16(data, record + 2, &ok);
+                part.endConnector = readU16(data, record + 4, &ok);
+                part.fullAdvance = readU16(data, record + 6, &ok);
+                part.extender = readU16(data, record + 8, &ok) & 0x0001;
+                m_parts.append(part);
+            }
+            entry.partCount = partCount;
+        }
+        constructions->append(entry);
+    }
+
+    std::sort(constructions->begin(), constructions->end(),
+              [](const Construction &a, const Construction &b) { return a.glyph < b.glyph; });
+    return ok;
+}
+
+/**
+ * @brief 查找字形构造（二分查找）
+ * @param glyph 字形索引
+ * @param orientation 伸展方向
+ * @return 字形构造，不存在时返回nullptr
+ */
+const MathTable::Construction *MathTable::findConstruction(quint32 glyph, Qt::Orientation orientation) const
+{
+    const QVector<Construction> &constructions =
+        orientation == Qt::Vertical ? m_verticalConstructions : m_horizontalConstructions;
+    auto it = std::lower_bound(constructions.constBegin(), constructions.constEnd(), glyph,
+                               [](const Construction &construction, quint32 value) {
+                                   return construction.glyph < value;
+                               });
+    if (it == constructions.constEnd() || it->glyph != glyph)
+        return nullptr;
+    return &*it;
+}
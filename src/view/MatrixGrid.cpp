@@ -0,0 +1,338 @@
+// ============================================================================
+// MatrixGrid.cpp
+// 矩阵网格类的实现文件
+// 缓存矩阵单元格盒子及列宽、行高，单个单元格变化时以O(log n)更新
+// ============================================================================
+
+#include "view/MatrixGrid.h"
+
+/**
+ * @brief 构造函数
+ * @param rows 行数
+ * @param columns 列数
+ * @param alignment 各列对齐方式
+ * @param columnGap 列间距
+ * @param rowGap 行间距
+ * @param axisHeight 数学轴高度
+ */
+MatrixGrid::MatrixGrid(int rows, int columns, const QString &alignment, qreal columnGap, qreal rowGap, qreal axisHeight)
+    : m_rows(qMax(0, rows)),
+      m_columns(qMax(0, columns)),
+      m_alignment(alignment),
+      m_columnGap(columnGap),
+      m_rowGap(rowGap),
+      m_axisHeight(axisHeight),
+      m_totalWidth(0),
+      m_totalHeight(0)
+{
+    reset(QVector<MathBox>(m_rows * m_columns));
+}
+
+/**
+ * @brief 用所有单元格的盒子重建网格
+ * @param cells 单元格盒子
+ */
+void MatrixGrid::reset(const QVector<MathBox> &cells)
+{
+    m_cells = cells;
+    m_cells.resize(m_rows * m_columns);
+    m_columnWidthCounts = QVector<QMap<qreal, int>>(m_columns);
+    m_rowAscentCounts = QVector<QMap<qreal, int>>(m_rows);
+    m_rowDescentCounts = QVector<QMap<qreal, int>>(m_rows);
+    for (int i = 0; i < m_cells.size(); i++)
+    {
+        const MathBox &box = m_cells.at(i);
+        addValue(&m_columnWidthCounts[i % m_columns], box.width);
+        addValue(&m_rowAscentCounts[i / m_columns], box.ascent);
+        addValue(&m_rowDescentCounts[i / m_columns], box.descent);
+    }
+
+    m_columnWidths = QVector<qreal>(m_columns, 0);
+    m_rowAscents = QVector<qreal>(m_rows, 0);
+    m_rowDescents = QVector<qreal>(m_rows, 0);
+    m_columnTree = QVector<qreal>(m_columns + 1, 0);
+    m_rowTree = QVector<qreal>(m_rows + 1, 0);
+    m_totalWidth = 0;
+    m_totalHeight = 0;
+    for (int column = 0; column < m_columns; column++)
+        refreshColumn(column);
+    for (int row = 0; row < m_rows; row++)
+        refreshRow(row);
+}
+
+/**
+ * @brief 更新一个单元格的盒子
+ * @param index 单元格索引
+ * @param box 新盒子
+ */
+void MatrixGrid::setCell(int index, const MathBox &box)
+{
+    if (index < 0 || index >= m_cells.size())
+        return;
+    MathBox old = m_cells.at(index);
+    if (old == box)
+        return;
+    m_cells[index] = box;
+
+    int column = index % m_columns;
+    int row = index / m_columns;
+    if (old.width != box.width)
+    {
+        removeValue(&m_columnWidthCounts[column], old.width);
+        addValue(&m_columnWidthCounts[column], box.width);
+        refreshColumn(column);
+    }
+    if (old.ascent != box.ascent || old.descent != box.descent)
+    {
+        removeValue(&m_rowAscentCounts[row], old.ascent);
+        addValue(&m_rowAscentCounts[row], box.ascent);
+        removeValue(&m_rowDescentCounts[row], old.descent);
+        addValue(&m_rowDescentCounts[row], box.descent);
+        refreshRow(row);
+    }
+}
+
+/**
+ * @brief 获取单元格的盒子
+ * @param index 单元格索引
+ * @return 盒子
+ */
+MathBox MatrixGrid::cell(int index) const
+{
+    return m_cells.value(index);
+}
+
+/**
+ * @brief 获取行数
+ * @return 行数
+ */
+int MatrixGrid::rows() const
+{
+    return m_rows;
+}
+
+/**
+ * @brief 获取列数
+ * @return 列数
+ */
+int MatrixGrid::columns() const
+{
+    return m_columns;
+}
+
+/**
+ * @brief 获取单元格数量
+ * @return 单元格数量
+ */
+int MatrixGrid::cellCount() const
+{
+    return m_cells.size();
+}
+
+/**
+ * @brief 获取列宽
+ * @param column 列索引
+ * @return 列宽
+ */
+qreal MatrixGrid::columnWidth(int column) const
+{
+    return m_columnWidths.value(column);
+}
+
+/**
+ * @brief 获取列的左边缘X坐标
+ * @param column 列索引
+ * @return X坐标
+ */
+qreal MatrixGrid::columnX(int column) const
+{
+    column = qBound(0, column, m_columns);
+    return treePrefix(m_columnTree, column) + column * m_columnGap;
+}
+
+/**
+ * @brief 获取行的基线位置（相对于网格顶部）
+ * @param row 行索引
+ * @return Y坐标
+ */
+qreal MatrixGrid::rowBaseline(int row) const
+{
+    row = qBound(0, row, m_rows - 1);
+    return treePrefix(m_rowTree, row) + row * m_rowGap + m_rowAscents.value(row);
+}
+
+/**
+ * @brief 获取X坐标所在的列
+ * @param x X坐标（相对于网格左边缘）
+ * @return 列索引
+ */
+int MatrixGrid::columnAt(qreal x) const
+{
+    if (m_columns == 0)
+        return -1;
+    return qMin(treeSearch(m_columnTree, x, m_columnGap), m_columns - 1);
+}
+
+/**
+ * @brief 获取Y坐标所在的行
+ * @param y Y坐标（相对于网格顶部）
+ * @return 行索引
+ */
+int MatrixGrid::rowAt(qreal y) const
+{
+    if (m_rows == 0)
+        return -1;
+    return qMin(treeSearch(m_rowTree, y, m_rowGap), m_rows - 1);
+}
+
+/**
+ * @brief 获取单元格原点相对于矩阵原点（基线）的偏移
+ * @param index 单元格索引
+ * @return 偏移
+ */
+QPointF MatrixGrid::cellOffset(int index) const
+{
+    if (index < 0 || index >= m_cells.size())
+        return QPointF();
+    int column = index % m_columns;
+    int row = index / m_columns;
+
+    // 对齐方式：左对齐0，居中0.5，右对齐1
+    qreal factor = 0.5;
+    if (!m_alignment.isEmpty())
+    {
+        QChar align = m_alignment.at(column % m_alignment.length());
+        factor = align == QLatin1Char('l') ? 0 : (align == QLatin1Char('r') ? 1 : 0.5);
+    }
+    qreal x = columnX(column) + factor * (m_columnWidths.at(column) - m_cells.at(index).width);
+
+    // 网格高度的中心对齐到数学轴
+    MathBox grid = box();
+    qreal y = -grid.ascent + rowBaseline(row);
+    return QPointF(x, y);
+}
+
+/**
+ * @brief 获取网格整体的盒子
+ * @return 盒子
+ */
+MathBox MatrixGrid::box() const
+{
+    MathBox box;
+    qreal height = m_totalHeight + qMax(0, m_rows - 1) * m_rowGap;
+    box.width = m_totalWidth + qMax(0, m_columns - 1) * m_columnGap;
+    box.ascent = qMax<qreal>(0, m_axisHeight + height / 2);
+    box.descent = qMax<qreal>(0, height / 2 - m_axisHeight);
+    return box;
+}
+
+/**
+ * @brief 在有序计数表中加入一个值
+ * @param counts 计数表
+ * @param value 值
+ */
+void MatrixGrid::addValue(QMap<qreal, int> *counts, qreal value)
+{
+    (*counts)[value]++;
+}
+
+/**
+ * @brief 从有序计数表中移除一个值
+ * @param counts 计数表
+ * @param value 值
+ */
+void MatrixGrid::removeValue(QMap<qreal, int> *counts, qreal value)
+{
+    auto it = counts->find(value);
+    if (it != counts->end() && --it.value() == 0)
+        counts->erase(it);
+}
+
+/**
+ * @brief 树状数组单点增加
+ * @param tree 树状数组（下标从1开始）
+ * @param index 元素索引（从0开始）
+ * @param delta 增量
+ */
+void MatrixGrid::treeAdd(QVector<qreal> *tree, int index, qreal delta)
+{
+    for (int i = index + 1; i < tree->size(); i += i & -i)
+        (*tree)[i] += delta;
+}
+
+/**
+ * @brief 树状数组前缀和
+ * @param tree 树状数组
+ * @param count 前缀长度
+ * @return [0, count)的和
+ */
+qreal MatrixGrid::treePrefix(const QVector<qreal> &tree, int count)
+{
+    qreal sum = 0;
+    for (int i = qMin(count, tree.size() - 1); i > 0; i -= i & -i)
+        sum += tree.at(i);
+    return sum;
+}
+
+/**
+ * @brief 树状数组中（每项另加gap后）前缀和不超过value的最长前缀长度
+ * @param tree 树状数组
+ * @param value 目标值
+ * @param gap 每项附加的间距
+ * @return 前缀长度
+ */
+int MatrixGrid::treeSearch(const QVector<qreal> &tree, qreal value, qreal gap)
+{
+    int n = tree.size() - 1;
+    int step = 1;
+    while (step * 2 <= n)
+        step *= 2;
+
+    int position = 0;
+    qreal sum = 0;
+    for (; step > 0; step /= 2)
+    {
+        int next = position + step;
+        if (next <= n && sum + tree.at(next) + step * gap <= value)
+        {
+            position = next;
+            sum += tree.at(next) + step * gap;
+        }
+    }
+    return position;
+}
+
+/**
+ * @brief 用计数表的最大值刷新列宽，并更新树状数组
+ * @param column 列索引
+ */
+void MatrixGrid::refreshColumn(int column)
+{
+    const QMap<qreal, int> &counts = m_columnWidthCounts.at(column);
+    qreal width = counts.isEmpty() ? 0 : counts.lastKey();
+    qreal delta = width - m_columnWidths.at(column);
+    if (delta == 0)
+        return;
+    m_columnWidths[column] = width;
+    treeAdd(&m_columnTree, column, delta);
+    m_totalWidth += delta;
+}
+
+/**
+ * @brief 用计数表的最大值刷新行高和深度，并更新树状数组
+ * @param row 行索引
+ */
+void MatrixGrid::refreshRow(int row)
+{
+    const QMap<qreal, int> &ascents = m_rowAscentCounts.at(row);
+    const QMap<qreal, int> &descents = m_rowDescentCounts.at(row);
+    qreal ascent = ascents.isEmpty() ? 0 : ascents.lastKey();
+    qreal descent = descents.isEmpty() ? 0 : descents.lastKey();
+    qreal delta = (ascent + descent) - (m_rowAscents.at(row) + m_rowDescents.at(row));
+    m_rowAscents[row] = ascent;
+    m_rowDescents[row] = descent;
+    if (delta == 0)
+        return;
+    treeAdd(&m_rowTree, row, delta);
+    m_totalHeight += delta;
+}
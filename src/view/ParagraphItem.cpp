@@ -0,0 +1,264 @@
+// ============================================================================
+// ParagraphItem.cpp
+// 段落图形项类的实现文件
+// 在场景中绘制一个已整形的段落
+// ============================================================================
+
+#include "view/ParagraphItem.h"
+#include "view/FormulaItem.h"
+#include "view/ReferenceItem.h"
+#include "view/PlotItem.h"
+#include <QMultiHash>
+
+/**
+ * @brief 构造函数
+ * @param parent 图形父项
+ */
+ParagraphItem::ParagraphItem(QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_stamp(0),
+      m_clipWidth(-1)
+{
+}
+
+/**
+ * @brief 设置排版结果
+ * @param layout 排版结果
+ */
+void ParagraphItem::setParagraphLayout(const ParagraphLayout &layout)
+{
+    prepareGeometryChange();
+    m_layout = layout;
+    update();
+}
+
+/**
+ * @brief 获取排版结果
+ * @return 排版结果
+ */
+const ParagraphLayout &ParagraphItem::paragraphLayout() const
+{
+    return m_layout;
+}
+
+/**
+ * @brief 设置段落中的公式
+ * @param formulas 公式对象
+ * @param engine 数学排版引擎
+ */
+void ParagraphItem::setFormulas(const QVector<QSharedPointer<MathObject>> &formulas, MathLayoutEngine *engine)
+{
+    // 旧子项按公式对象索引，中间插入或删除公式时其余公式的子项被复用
+    QMultiHash<const MathObject *, FormulaItem *> reusable;
+    for (FormulaItem *item : m_formulaItems)
+        reusable.insert(item->formula().data(), item);
+
+    // 排版结果中的对象按位置排列，交叉引用、函数图像与公式交错，公式按出现顺序与formulas对应
+    QVector<FormulaItem *> items;
+    for (const InlineObject &object : m_layout.objects)
+    {
+        if (object.kind != InlineObject::Formula)
+            continue;
+        if (items.size() == formulas.size())
+            break;
+        const QSharedPointer<MathObject> &formula = formulas.at(items.size());
+        FormulaItem *item = reusable.take(formula.data());
+        if (item)
+            item->updateGeometry();
+        else
+            item = new FormulaItem(formula, engine, this);
+        item->setPos(m_layout.caretPositions.value(object.position), m_layout.ascent);
+        items.append(item);
+    }
+
+    // 不再出现的公式
+    qDeleteAll(reusable);
+    m_formulaItems = items;
+}
+
+/**
+ * @brief 设置公式编号和交叉引用的绘制方式
+ * @param index 公式编号索引
+ * @param handle 段落在索引中的句柄
+ * @param font 编号字体
+ */
+void ParagraphItem::setEquationNumbers(const EquationIndex *index, int handle, const QFont &font)
+{
+    // 旧的交叉引用子项按标签索引，中间插入或删除引用时其余子项被复用
+    QMultiHash<QString, ReferenceItem *> reusable;
+    for (ReferenceItem *item : m_referenceItems)
+        reusable.insert(item->label(), item);
+
+    int formula = 0;
+    int slot = 0;
+    QVector<ReferenceItem *> items;
+    for (const InlineObject &object : m_layout.objects)
+    {
+        if (object.kind == InlineObject::Formula)
+        {
+            // 带编号公式的预留宽度包含编号
+            // 序号与索引登记的顺序一致：段落中带编号的公式依次排列
+            if (formula < m_formulaItems.size())
+            {
+                FormulaItem *item = m_formulaItems.at(formula++);
+                item->setNumbering(index, handle, slot, font, object.width);
+                if (item->formula()->isNumbered())
+                    slot++;
+            }
+            continue;
+        }
+        if (object.kind != InlineObject::Reference)
+            continue;
+
+        ReferenceItem *item = reusable.take(object.reference);
+        if (item)
+            item->update();
+        else
+            item = new ReferenceItem(object.reference, index, font, this);
+        item->setWidth(object.width);
+        item->setPos(m_layout.caretPositions.value(object.position), m_layout.ascent);
+        items.append(item);
+    }
+
+    // 不再出现的交叉引用
+    qDeleteAll(reusable);
+    m_referenceItems = items;
+}
+
+/**
+ * @brief 设置段落中的函数图像
+ * @param sampler 采样器
+ */
+void ParagraphItem::setPlots(PlotSampler *sampler)
+{
+    // 同一图像对象的子项被复用，保留用户平移缩放后的区间
+    QMultiHash<const PlotObject *, PlotItem *> reusable;
+    for (PlotItem *item : m_plotItems)
+        reusable.insert(item->plot().data(), item);
+
+    QVector<PlotItem *> items;
+    for (const InlineObject &object : m_layout.objects)
+    {
+        if (object.kind != InlineObject::Plot || !object.plot)
+            continue;
+        PlotItem *item = reusable.take(object.plot.data());
+        if (item)
+            item->update();
+        else
+            item = new PlotItem(object.plot, sampler, this);
+        item->setExtent(object.width, m_layout.ascent, m_layout.height);
+        item->setPos(m_layout.caretPositions.value(object.position), m_layout.ascent);
+        items.append(item);
+    }
+
+    // 不再出现的函数图像
+    qDeleteAll(reusable);
+    m_plotItems = items;
+}
+
+/**
+ * @brief 重绘公式编号和交叉引用
+ */
+void ParagraphItem::updateEquationNumbers()
+{
+    for (FormulaItem *item : m_formulaItems)
+    {
+        if (item->isNumbered())
+            item->update();
+    }
+    for (ReferenceItem *item : m_referenceItems)
+        item->update();
+}
+
+/**
+ * @brief 设置是否绘制文本
+ * @param visible 是否绘制文本
+ */
+void ParagraphItem::setTextVisible(bool visible)
+{
+    setFlag(ItemHasNoContents, !visible);
+}
+
+/**
+ * @brief 设置内容戳
+ * @param stamp 内容戳
+ */
+void ParagraphItem::setStamp(quint64 stamp)
+{
+    m_stamp = stamp;
+}
+
+/**
+ * @brief 获取内容戳
+ * @return 内容戳
+ */
+quint64 ParagraphItem::stamp() const
+{
+    return m_stamp;
+}
+
+/**
+ * @brief 设置裁剪宽度
+ * @param width 裁剪宽度，负数表示不裁剪
+ */
+void ParagraphItem::setClipWidth(qreal width)
+{
+    if (m_clipWidth != width)
+    {
+        m_clipWidth = width;
+        update();
+    }
+}
+
+/**
+ * @brief 获取裁剪宽度
+ * @return 裁剪宽度，负数表示不裁剪
+ */
+qreal ParagraphItem::clipWidth() const
+{
+    return m_clipWidth;
+}
+
+/**
+ * @brief 获取边界矩形
+ * @return 边界矩形
+ */
+QRectF ParagraphItem::boundingRect() const
+{
+    return QRectF(0, 0, m_layout.width, m_layout.height);
+}
+
+/**
+ * @brief 绘制段落
+ * @param painter 绘图工具
+ * @param option 样式选项
+ * @param widget 部件
+ */
+void ParagraphItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    drawGlyphRuns(painter, m_layout.glyphRuns, m_clipWidth, m_layout.height);
+}
+
+/**
+ * @brief 绘制字形序列
+ * @param painter 绘图工具
+ * @param glyphRuns 字形序列
+ * @param clipWidth 裁剪宽度，负数表示不裁剪
+ * @param height 段落行高
+ */
+void ParagraphItem::drawGlyphRuns(QPainter *painter, const QList<QGlyphRun> &glyphRuns, qreal clipWidth, qreal height)
+{
+    painter->save();
+    if (clipWidth >= 0)
+        painter->setClipRect(QRectF(0, 0, clipWidth, height), Qt::IntersectClip);
+
+    painter->setPen(Qt::black);
+    for (const QGlyphRun &glyphRun : glyphRuns)
+    {
+        painter->drawGlyphRun(QPointF(0, 0), glyphRun);
+    }
+    painter->restore();
+}
@@ -0,0 +1,161 @@
+// ============================================================================
+// ParagraphTops.cpp
+// 段落顶部偏移索引的实现文件
+// 以树状数组保存段落高度，按段落查询顶部偏移、按偏移查找段落都是O(log n)
+// ============================================================================
+
+#include "view/ParagraphTops.h"
+
+/**
+ * @brief 构造函数
+ */
+ParagraphTops::ParagraphTops()
+    : m_tree(1, 0),
+      m_stale(false)
+{
+}
+
+/**
+ * @brief 清空索引
+ */
+void ParagraphTops::clear()
+{
+    m_heights.clear();
+    m_tree = QVector<qreal>(1, 0);
+    m_stale = false;
+}
+
+/**
+ * @brief 获取段落数
+ * @return 段落数
+ */
+int ParagraphTops::count() const
+{
+    return m_heights.size();
+}
+
+/**
+ * @brief 插入若干段落
+ * @param index 插入位置
+ * @param count 段落数
+ * @param height 新段落的高度
+ */
+void ParagraphTops::insert(int index, int count, qreal height)
+{
+    if (count <= 0)
+        return;
+    m_heights.insert(qBound(0, index, m_heights.size()), count, height);
+    m_stale = true;
+}
+
+/**
+ * @brief 删除若干段落
+ * @param index 起始段落
+ * @param count 段落数
+ */
+void ParagraphTops::remove(int index, int count)
+{
+    if (index < 0 || index >= m_heights.size())
+        return;
+    count = qMin(count, m_heights.size() - index);
+    if (count <= 0)
+        return;
+    m_heights.remove(index, count);
+    m_stale = true;
+}
+
+/**
+ * @brief 获取段落高度
+ * @param index 段落索引
+ * @return 高度
+ */
+qreal ParagraphTops::height(int index) const
+{
+    return m_heights.value(index, 0);
+}
+
+/**
+ * @brief 设置段落高度
+ * @param index 段落索引
+ * @param height 高度
+ */
+void ParagraphTops::setHeight(int index, qreal height)
+{
+    if (index < 0 || index >= m_heights.size())
+        return;
+    qreal delta = height - m_heights[index];
+    m_heights[index] = height;
+    if (m_stale || delta == 0)
+        return;
+    // 只更新覆盖该段落的O(log n)个区间和
+    int n = m_heights.size();
+    for (int i = index + 1; i <= n; i += i & -i)
+        m_tree[i] += delta;
+}
+
+/**
+ * @brief 获取段落顶部相对内容顶部的偏移
+ * @param index 段落索引
+ * @return 偏移
+ */
+qreal ParagraphTops::top(int index) const
+{
+    rebuild();
+    qreal sum = 0;
+    for (int i = qBound(0, index, m_heights.size()); i > 0; i -= i & -i)
+        sum += m_tree[i];
+    return sum;
+}
+
+/**
+ * @brief 获取内容总高度
+ * @return 高度
+ */
+qreal ParagraphTops::total() const
+{
+    return top(m_heights.size());
+}
+
+/**
+ * @brief 查找偏移所在的段落
+ * @param offset 相对内容顶部的偏移
+ * @return 段落索引
+ */
+int ParagraphTops::indexAt(qreal offset) const
+{
+    rebuild();
+    // 从最高位开始下降：每一步跳过整段顶部不超过偏移的区间
+    int n = m_heights.size();
+    int step = 1;
+    while (step * 2 <= n)
+        step *= 2;
+    int index = 0;
+    for (; step > 0 && n > 0; step /= 2) {
+        if (index + step <= n && m_tree[index + step] <= offset) {
+            index += step;
+            offset -= m_tree[index];
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief 树状数组过期时按高度表重建
+ */
+void ParagraphTops::rebuild() const
+{
+    if (!m_stale)
+        return;
+    // 每项先取自身高度，再按下标顺序加到父区间上，总共O(n)次加法
+    int n = m_heights.size();
+    m_tree.resize(n + 1);
+    m_tree[0] = 0;
+    for (int i = 1; i <= n; i++)
+        m_tree[i] = m_heights[i - 1];
+    for (int i = 1; i <= n; i++) {
+        int parent = i + (i & -i);
+        if (parent <= n)
+            m_tree[parent] += m_tree[i];
+    }
+    m_stale = false;
+}
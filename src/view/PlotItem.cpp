@@ -0,0 +1,291 @@
+// ============================================================================
+// PlotItem.cpp
+// 函数图像图形项类的实现文件
+// 在段落中绘制一个内联函数图像，支持滚轮缩放和平移
+// ============================================================================
+
+#include "view/PlotItem.h"
+#include "view/PlotSampler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief 纵轴自动缩放时忽略的两端比例（避免tan x等在极点附近的值把纵轴压扁）
+ */
+const double OutlierFraction = 0.01;
+
+/**
+ * @brief 每个滚轮刻度的缩放倍数
+ */
+const double ZoomStep = 1.25;
+
+/**
+ * @brief 每个滚轮刻度平移的区间比例
+ */
+const double PanStep = 0.1;
+
+/**
+ * @brief 一个像素列内的折线点
+ *
+ * 同一像素列中的点在屏幕上重叠，只保留首、末和最低、最高点即可画出相同的图形。
+ */
+struct PixelColumn
+{
+    int column = 0;      ///< 像素列
+    int count = 0;       ///< 点数
+    QPointF first;       ///< 首点
+    QPointF last;        ///< 末点
+    QPointF low;         ///< 最低点（像素坐标y最大）
+    QPointF high;        ///< 最高点（像素坐标y最小）
+    bool lowFirst = false; ///< 最低点是否先于最高点出现
+
+    /**
+     * @brief 加入一个点
+     */
+    void add(const QPointF &point)
+    {
+        if (count == 0)
+        {
+            first = low = high = point;
+        }
+        else if (point.y() > low.y())
+        {
+            low = point;
+            lowFirst = false;
+        }
+        else if (point.y() < high.y())
+        {
+            high = point;
+            lowFirst = true;
+        }
+        last = point;
+        count++;
+    }
+
+    /**
+     * @brief 把本列的点按出现顺序追加到折线
+     */
+    void flush(QPolygonF *polyline)
+    {
+        if (count == 0)
+            return;
+        polyline->append(first);
+        if (count > 2)
+        {
+            polyline->append(lowFirst ? low : high);
+            polyline->append(lowFirst ? high : low);
+        }
+        if (count > 1)
+            polyline->append(last);
+        count = 0;
+        lowFirst = false;
+    }
+};
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ * @param plot 函数图像对象
+ * @param sampler 采样器
+ * @param parent 图形父项
+ */
+PlotItem::PlotItem(const QSharedPointer<PlotObject> &plot, PlotSampler *sampler, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_plot(plot),
+      m_sampler(sampler),
+      m_xMin(plot->xMin()),
+      m_span(plot->xMax() - plot->xMin()),
+      m_yMin(0),
+      m_yMax(0),
+      m_hash(0),
+      m_dirty(true)
+{
+}
+
+/**
+ * @brief 获取函数图像对象
+ * @return 函数图像对象
+ */
+QSharedPointer<PlotObject> PlotItem::plot() const
+{
+    return m_plot;
+}
+
+/**
+ * @brief 设置图像占据的区域
+ * @param width 预留宽度
+ * @param ascent 基线以上的高度
+ * @param height 总高度
+ */
+void PlotItem::setExtent(qreal width, qreal ascent, qreal height)
+{
+    QRectF bounds(0, -ascent, width, height);
+    if (m_bounds != bounds)
+    {
+        prepareGeometryChange();
+        m_bounds = bounds;
+        m_dirty = true;
+    }
+}
+
+/**
+ * @brief 获取边界矩形
+ * @return 边界矩形
+ */
+QRectF PlotItem::boundingRect() const
+{
+    return m_bounds;
+}
+
+/**
+ * @brief 绘制函数图像
+ * @param painter 绘图工具
+ * @param option 样式选项
+ * @param widget 部件
+ */
+void PlotItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    // 公式被编辑后结构哈希改变，重新采样（哈希由节点缓存，查询代价很低）
+    quint64 hash = m_plot->function() ? m_plot->function()->hash() : 0;
+    if (m_dirty || hash != m_hash)
+        rebuild(hash);
+
+    QRectF area = plotArea();
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setPen(QPen(Qt::lightGray, 0));
+    painter->setBrush(Qt::NoBrush);
+    painter->drawRect(m_bounds.adjusted(0.5, 0.5, -0.5, -0.5));
+    painter->setClipRect(area, Qt::IntersectClip);
+
+    // 坐标轴（在区间内时）
+    if (m_xMin < 0 && m_xMin + m_span > 0)
+    {
+        qreal x = area.left() - m_xMin / m_span * area.width();
+        painter->drawLine(QPointF(x, area.top()), QPointF(x, area.bottom()));
+    }
+    if (m_yMax > m_yMin && m_yMin < 0 && m_yMax > 0)
+    {
+        qreal y = area.bottom() + m_yMin / (m_yMax - m_yMin) * area.height();
+        painter->drawLine(QPointF(area.left(), y), QPointF(area.right(), y));
+    }
+
+    painter->setPen(QPen(QColor(0, 90, 200), 1.2));
+    for (const QPolygonF &polyline : m_polylines)
+        painter->drawPolyline(polyline);
+    painter->restore();
+}
+
+/**
+ * @brief 处理滚轮事件
+ * @param event 滚轮事件
+ */
+void PlotItem::wheelEvent(QGraphicsSceneWheelEvent *event)
+{
+    QRectF area = plotArea();
+    double steps = event->delta() / 120.0;
+    if (area.width() <= 0 || steps == 0)
+    {
+        event->ignore();
+        return;
+    }
+
+    if (event->orientation() == Qt::Horizontal || (event->modifiers() & Qt::ShiftModifier))
+    {
+        // 平移：区间宽度不变，采样器复用已有的采样点，只补采新露出的部分
+        m_xMin -= steps * PanStep * m_span;
+    }
+    else
+    {
+        // 缩放：保持光标下的x不动
+        double ratio = qBound(0.0, (event->pos().x() - area.left()) / area.width(), 1.0);
+        double anchor = m_xMin + ratio * m_span;
+        m_span *= std::pow(ZoomStep, -steps);
+        m_xMin = anchor - ratio * m_span;
+    }
+    m_dirty = true;
+    update();
+    event->accept();
+}
+
+/**
+ * @brief 重新采样并生成折线的像素坐标
+ * @param hash 函数公式的结构哈希
+ */
+void PlotItem::rebuild(quint64 hash)
+{
+    m_dirty = false;
+    m_hash = hash;
+    m_polylines.clear();
+    m_yMin = m_yMax = 0;
+
+    QRectF area = plotArea();
+    QSharedPointer<MathObject> function = m_plot->function();
+    if (!function || !m_sampler || area.width() <= 0 || area.height() <= 0)
+        return;
+    QVector<QPointF> samples = m_sampler->sample(function->expression(), hash, m_xMin, m_xMin + m_span,
+                                                 qMax(1, qRound(area.width())));
+
+    // 纵轴按区间内有限值的分位数自动缩放
+    QVector<double> values;
+    values.reserve(samples.size());
+    for (const QPointF &point : samples)
+    {
+        if (std::isfinite(point.y()))
+            values.append(point.y());
+    }
+    if (values.isEmpty())
+        return;
+    int trim = static_cast<int>(values.size() * OutlierFraction);
+    std::nth_element(values.begin(), values.begin() + trim, values.end());
+    m_yMin = values.at(trim);
+    std::nth_element(values.begin(), values.end() - 1 - trim, values.end());
+    m_yMax = values.at(values.size() - 1 - trim);
+    double padding = m_yMax > m_yMin ? (m_yMax - m_yMin) * 0.05 : qMax(1.0, std::fabs(m_yMin) * 0.5);
+    m_yMin -= padding;
+    m_yMax += padding;
+
+    // 转换为像素坐标，同一像素列的点压缩为最多四个，无定义处断开折线
+    double scaleX = area.width() / m_span;
+    double scaleY = area.height() / (m_yMax - m_yMin);
+    QPolygonF polyline;
+    PixelColumn column;
+    for (const QPointF &point : samples)
+    {
+        if (!std::isfinite(point.y()))
+        {
+            column.flush(&polyline);
+            if (polyline.size() > 1)
+                m_polylines.append(polyline);
+            polyline.clear();
+            continue;
+        }
+        // 远超绘图区的值截断到附近，避免极大的坐标（超出部分被裁剪）
+        double y = area.bottom() - (point.y() - m_yMin) * scaleY;
+        QPointF pixel(area.left() + (point.x() - m_xMin) * scaleX,
+                      qBound(area.top() - area.height(), y, area.bottom() + area.height()));
+        int index = static_cast<int>(std::floor(pixel.x()));
+        if (column.count > 0 && index != column.column)
+            column.flush(&polyline);
+        column.column = index;
+        column.add(pixel);
+    }
+    column.flush(&polyline);
+    if (polyline.size() > 1)
+        m_polylines.append(polyline);
+}
+
+/**
+ * @brief 获取绘图区
+ * @return 绘图区
+ */
+QRectF PlotItem::plotArea() const
+{
+    return m_bounds.adjusted(1, 1, -1, -1);
+}
@@ -0,0 +1,279 @@
+// ============================================================================
+// PlotSampler.cpp
+// 函数图像采样器类的实现文件
+// 按曲率自适应地批量采样y=f(x)，按（公式哈希, 区间, 像素宽度）缓存折线，平移时只补采新露出的区间
+// ============================================================================
+
+#include "view/PlotSampler.h"
+#include "core/PlotObject.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief 按x比较采样点
+ */
+bool lessX(const QPointF &point, double x)
+{
+    return point.x() < x;
+}
+
+/**
+ * @brief 检查两个采样点之间的区间是否需要细分
+ * @param left 左端点
+ * @param middle 中点
+ * @param right 右端点
+ * @param tolerance 中点偏离弦的容差
+ */
+bool needsRefinement(const QPointF &left, const QPointF &middle, const QPointF &right, double tolerance)
+{
+    bool leftFinite = std::isfinite(left.y());
+    bool middleFinite = std::isfinite(middle.y());
+    bool rightFinite = std::isfinite(right.y());
+    // 跨越定义域边界（如ln x在0附近、tan x的极点）时细分以逼近边界
+    if (leftFinite != middleFinite || middleFinite != rightFinite)
+        return true;
+    if (!middleFinite)
+        return false;
+    return std::fabs(middle.y() - (left.y() + right.y()) / 2) > tolerance;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ * @param parent 父对象
+ */
+PlotSampler::PlotSampler(QObject *parent)
+    : QObject(parent),
+      m_cache(DEFAULT_SAMPLE_BUDGET),
+      m_evaluated(0)
+{
+}
+
+/**
+ * @brief 获取函数在区间上的采样折线
+ * @param expression 函数编译后的表达式
+ * @param hash 函数公式的结构哈希
+ * @param xMin 区间左端
+ * @param xMax 区间右端
+ * @param pixelWidth 区间对应的像素宽度
+ * @return 采样点
+ */
+QVector<QPointF> PlotSampler::sample(const QSharedPointer<const MathExpression> &expression, quint64 hash,
+                                     double xMin, double xMax, int pixelWidth)
+{
+    if (!expression || !expression->isValid() || !(xMax > xMin) || pixelWidth <= 0)
+        return QVector<QPointF>();
+
+    PlotSampleKey key;
+    key.hash = hash;
+    key.span = xMax - xMin;
+    key.pixelWidth = pixelWidth;
+    double span = key.span;
+    double pixelsPerUnit = pixelWidth / span;
+    // 每次补采时向外多采四分之一个区间，连续平移时大多数帧不需要求值
+    double margin = span / 4;
+
+    Entry *entry = m_cache.take(key);
+    if (entry && (xMax < entry->lo || xMin > entry->hi))
+    {
+        delete entry;
+        entry = nullptr;
+    }
+    if (!entry)
+    {
+        entry = new Entry;
+        entry->lo = xMin - margin;
+        entry->hi = xMax + margin;
+        entry->points = sampleRange(*expression, entry->lo, entry->hi, (entry->hi - entry->lo) * pixelsPerUnit);
+    }
+    else
+    {
+        // 同一缩放比例下平移：只采样新露出的部分，与已有采样点拼接
+        if (xMin < entry->lo)
+        {
+            double lo = xMin - margin;
+            QVector<QPointF> left = sampleRange(*expression, lo, entry->lo, (entry->lo - lo) * pixelsPerUnit);
+            left.removeLast(); // 与已有的左端点重合
+            entry->points = left + entry->points;
+            entry->lo = lo;
+        }
+        if (xMax > entry->hi)
+        {
+            double hi = xMax + margin;
+            QVector<QPointF> right = sampleRange(*expression, entry->hi, hi, (hi - entry->hi) * pixelsPerUnit);
+            right.removeFirst();
+            entry->points += right;
+            entry->hi = hi;
+        }
+
+        // 只保留当前区间附近的采样点，避免长时间平移后缓存项无限增长
+        double keepLo = xMin - 3 * span;
+        double keepHi = xMax + 3 * span;
+        if (entry->lo < keepLo || entry->hi > keepHi)
+        {
+            auto begin = std::lower_bound(entry->points.constBegin(), entry->points.constEnd(), keepLo, lessX);
+            auto end = std::lower_bound(begin, entry->points.constEnd(), keepHi, lessX);
+            entry->points = QVector<QPointF>(begin, end);
+            if (!entry->points.isEmpty())
+            {
+                entry->lo = entry->points.first().x();
+                entry->hi = entry->points.last().x();
+            }
+        }
+    }
+
+    // 取出区间内的采样点，两侧各多取一个，使折线延伸到区间边界
+    auto begin = std::lower_bound(entry->points.constBegin(), entry->points.constEnd(), xMin, lessX);
+    auto end = std::lower_bound(begin, entry->points.constEnd(), xMax, lessX);
+    if (begin != entry->points.constBegin())
+        --begin;
+    if (end != entry->points.constEnd())
+        ++end;
+    QVector<QPointF> result(begin, end);
+
+    m_cache.insert(key, entry, qMax(1, entry->points.size()));
+    return result;
+}
+
+/**
+ * @brief 设置缓存的采样点预算
+ * @param samples 采样点数
+ */
+void PlotSampler::setSampleBudget(int samples)
+{
+    m_cache.setMaxCost(samples);
+}
+
+/**
+ * @brief 获取累计求值的点数
+ * @return 点数
+ */
+qint64 PlotSampler::evaluatedCount() const
+{
+    return m_evaluated;
+}
+
+/**
+ * @brief 清空缓存
+ */
+void PlotSampler::clear()
+{
+    m_cache.clear();
+}
+
+/**
+ * @brief 对一段区间自适应采样
+ * @param expression 函数编译后的表达式
+ * @param a 区间左端
+ * @param b 区间右端
+ * @param pixels 区间对应的像素数
+ * @return 采样点
+ */
+QVector<QPointF> PlotSampler::sampleRange(const MathExpression &expression, double a, double b, double pixels)
+{
+    // 均匀的初始网格，一次批量求值
+    int count = qMax(2, static_cast<int>(std::ceil(pixels * SAMPLES_PER_PIXEL)) + 1);
+    QVector<double> xs(count);
+    for (int i = 0; i < count; i++)
+        xs[i] = a + (b - a) * i / (count - 1);
+    xs[count - 1] = b;
+    QVector<double> ys;
+    evaluate(expression, xs, &ys);
+
+    QVector<QPointF> points(count);
+    double yMin = std::numeric_limits<double>::infinity();
+    double yMax = -std::numeric_limits<double>::infinity();
+    for (int i = 0; i < count; i++)
+    {
+        points[i] = QPointF(xs.at(i), ys.at(i));
+        if (std::isfinite(ys.at(i)))
+        {
+            yMin = qMin(yMin, ys.at(i));
+            yMax = qMax(yMax, ys.at(i));
+        }
+    }
+
+    // 容差约为半个像素对应的函数值（纵向按与横向相同的像素数估计）
+    double tolerance = yMax > yMin ? (yMax - yMin) / qMax(1.0, pixels) / 2 : 0;
+    if (tolerance <= 0)
+        return points;
+
+    // 初始网格上用相邻三点的二阶差分标记弯曲处的区间
+    QVector<bool> refine(count - 1, false);
+    for (int i = 1; i + 1 < count; i++)
+    {
+        if (needsRefinement(points.at(i - 1), points.at(i), points.at(i + 1), tolerance))
+            refine[i - 1] = refine[i] = true;
+    }
+
+    for (int round = 0; round < MAX_REFINEMENTS; round++)
+    {
+        // 收集本轮所有待细分区间的中点，合并为一次批量求值
+        QVector<double> middles;
+        for (int i = 0; i < refine.size(); i++)
+        {
+            if (refine.at(i))
+                middles.append((points.at(i).x() + points.at(i + 1).x()) / 2);
+        }
+        if (middles.isEmpty() || points.size() + middles.size() > count * MAX_DENSITY)
+            break;
+        QVector<double> values;
+        evaluate(expression, middles, &values);
+
+        QVector<QPointF> merged;
+        QVector<bool> next;
+        merged.reserve(points.size() + middles.size());
+        next.reserve(points.size() + middles.size());
+        int m = 0;
+        for (int i = 0; i < points.size(); i++)
+        {
+            merged.append(points.at(i));
+            if (i < refine.size() && refine.at(i))
+            {
+                QPointF middle(middles.at(m), values.at(m));
+                m++;
+                // 中点仍偏离弦时，两个子区间在下一轮继续细分
+                bool again = needsRefinement(points.at(i), middle, points.at(i + 1), tolerance);
+                merged.append(middle);
+                next.append(again);
+                next.append(again);
+            }
+            else if (i < refine.size())
+            {
+                next.append(false);
+            }
+        }
+        points = merged;
+        refine = next;
+    }
+    return points;
+}
+
+/**
+ * @brief 批量求值
+ * @param expression 函数编译后的表达式
+ * @param xs 自变量值
+ * @param ys 输出：函数值
+ */
+void PlotSampler::evaluate(const MathExpression &expression, const QVector<double> &xs, QVector<double> *ys)
+{
+    ys->resize(xs.size());
+    m_evaluated += xs.size();
+    if (expression.isConstant())
+    {
+        ys->fill(expression.evaluate());
+        return;
+    }
+    if (PlotObject::argument(expression).isEmpty())
+    {
+        ys->fill(std::numeric_limits<double>::quiet_NaN());
+        return;
+    }
+    QVector<const double *> columns;
+    columns.append(xs.constData());
+    expression.evaluate(columns, xs.size(), ys->data());
+}
@@ -0,0 +1,159 @@
+// ============================================================================
+// PreeditItem.cpp
+// 输入法预编辑图形项类的实现文件
+// 在光标处内联显示输入法的组合文本
+// ============================================================================
+
+#include "view/PreeditItem.h"
+#include <QTextCharFormat>
+
+/**
+ * @brief 构造函数
+ * @param parent 图形父项
+ */
+PreeditItem::PreeditItem(QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_preeditLength(0),
+      m_cursorPosition(0),
+      m_cursorVisible(false)
+{
+    // 显示在段落文本之上
+    setZValue(1);
+}
+
+/**
+ * @brief 设置字体
+ * @param font 字体
+ */
+void PreeditItem::setFont(const QFont &font)
+{
+    m_layout.setFont(font);
+}
+
+/**
+ * @brief 设置组合文本
+ * @param preedit 组合文本
+ * @param tail 当前段落中光标之后的文本
+ * @param attributes 输入法属性
+ */
+void PreeditItem::setComposition(const QString &preedit, const QString &tail,
+                                 const QList<QInputMethodEvent::Attribute> &attributes)
+{
+    // 复用已有的缓冲区（truncate/resize不会释放容量）
+    m_text.truncate(0);
+    m_text.append(preedit);
+    m_text.append(tail);
+    m_formats.resize(0);
+
+    m_preeditLength = preedit.length();
+    m_cursorPosition = m_preeditLength;
+    m_cursorVisible = true;
+
+    bool hasTextFormat = false;
+    for (const QInputMethodEvent::Attribute &attribute : attributes)
+    {
+        if (attribute.type == QInputMethodEvent::TextFormat)
+        {
+            QTextCharFormat format = attribute.value.value<QTextFormat>().toCharFormat();
+            if (format.isValid())
+            {
+                QTextLayout::FormatRange range;
+                range.start = attribute.start;
+                range.length = attribute.length;
+                range.format = format;
+                m_formats.append(range);
+                hasTextFormat = true;
+            }
+        }
+        else if (attribute.type == QInputMethodEvent::Cursor)
+        {
+            // length为0表示输入法要求隐藏光标
+            m_cursorPosition = qBound(0, attribute.start, m_preeditLength);
+            m_cursorVisible = attribute.length != 0;
+        }
+    }
+
+    // 输入法未提供格式时，默认给组合文本加下划线
+    if (!hasTextFormat && m_preeditLength > 0)
+    {
+        QTextLayout::FormatRange range;
+        range.start = 0;
+        range.length = m_preeditLength;
+        range.format.setFontUnderline(true);
+        m_formats.append(range);
+    }
+
+    // 只重排这一行
+    m_layout.setText(m_text);
+    m_layout.setFormats(m_formats);
+    m_layout.beginLayout();
+    QTextLine line = m_layout.createLine();
+    if (line.isValid())
+    {
+        line.setNumColumns(m_text.length());
+        line.setPosition(QPointF(0, 0));
+    }
+    m_layout.endLayout();
+
+    prepareGeometryChange();
+    m_rect = line.isValid() ? QRectF(0, 0, line.naturalTextWidth() + 1, line.height()) : QRectF();
+    update();
+}
+
+/**
+ * @brief 清除组合文本
+ */
+void PreeditItem::clear()
+{
+    m_text.truncate(0);
+    m_formats.resize(0);
+    m_preeditLength = 0;
+    m_cursorPosition = 0;
+    m_cursorVisible = false;
+    m_layout.clearLayout();
+
+    prepareGeometryChange();
+    m_rect = QRectF();
+}
+
+/**
+ * @brief 获取预编辑光标的X坐标
+ * @return X坐标
+ */
+qreal PreeditItem::cursorX() const
+{
+    if (m_layout.lineCount() == 0)
+        return 0;
+    return m_layout.lineAt(0).cursorToX(m_cursorPosition);
+}
+
+/**
+ * @brief 获取边界矩形
+ * @return 边界矩形
+ */
+QRectF PreeditItem::boundingRect() const
+{
+    return m_rect;
+}
+
+/**
+ * @brief 绘制组合文本
+ * @param painter 绘图工具
+ * @param option 样式选项
+ * @param widget 部件
+ */
+void PreeditItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    if (m_text.isEmpty())
+        return;
+
+    painter->setPen(Qt::black);
+    m_layout.draw(painter, QPointF(0, 0));
+    if (m_cursorVisible)
+    {
+        m_layout.drawCursor(painter, QPointF(0, 0), m_cursorPosition, 1);
+    }
+}
@@ -0,0 +1,88 @@
+// ============================================================================
+// ReferenceItem.cpp
+// 交叉引用图形项类的实现文件
+// 在段落中绘制对带编号公式的引用，编号在绘制时从公式编号索引中查询
+// ============================================================================
+
+#include "view/ReferenceItem.h"
+#include "core/EquationIndex.h"
+#include <QFontMetricsF>
+
+/**
+ * @brief 构造函数
+ * @param label 所引用公式的标签
+ * @param index 公式编号索引
+ * @param font 字体
+ * @param parent 图形父项
+ */
+ReferenceItem::ReferenceItem(const QString &label, const EquationIndex *index, const QFont &font,
+                             QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_label(label),
+      m_index(index),
+      m_font(font)
+{
+    QFontMetricsF metrics(m_font);
+    m_bounds = QRectF(0, -metrics.ascent(), 0, metrics.height());
+}
+
+/**
+ * @brief 获取所引用公式的标签
+ * @return 标签
+ */
+QString ReferenceItem::label() const
+{
+    return m_label;
+}
+
+/**
+ * @brief 设置预留宽度
+ * @param width 宽度
+ */
+void ReferenceItem::setWidth(qreal width)
+{
+    if (m_bounds.width() != width)
+    {
+        prepareGeometryChange();
+        m_bounds.setWidth(width);
+    }
+}
+
+/**
+ * @brief 获取边界矩形
+ * @return 边界矩形
+ */
+QRectF ReferenceItem::boundingRect() const
+{
+    return m_bounds;
+}
+
+/**
+ * @brief 绘制引用
+ * @param painter 绘图工具
+ * @param option 样式选项
+ * @param widget 部件
+ */
+void ReferenceItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    // 编号是标签所指公式在索引中的次序，每次绘制时查询，O(log n)
+    int number = m_index ? m_index->number(m_label) : 0;
+    painter->save();
+    painter->setFont(m_font);
+    painter->setPen(number > 0 ? Qt::black : Qt::red);
+    painter->drawText(QPointF(0, 0), numberText(number));
+    painter->restore();
+}
+
+/**
+ * @brief 生成编号的显示文本
+ * @param number 编号
+ * @return 显示文本
+ */
+QString ReferenceItem::numberText(int number)
+{
+    return number > 0 ? QStringLiteral("(%1)").arg(number) : QStringLiteral("(?)");
+}
@@ -0,0 +1,157 @@
+// ============================================================================
+// SelectionItem.cpp
+// 选择高亮图形项类的实现文件
+// 在文本下方绘制选择区域的高亮矩形
+// ============================================================================
+
+#include "view/SelectionItem.h"
+#include "view/DocumentView.h"
+#include <QStyleOptionGraphicsItem>
+
+/**
+ * @brief 构造函数
+ * @param view 提供几何信息的文档视图
+ * @param parent 图形父项
+ */
+SelectionItem::SelectionItem(const DocumentView *view, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_view(view),
+      m_start({0, 0}),
+      m_end({0, 0}),
+      m_empty(true)
+{
+    // 需要exposedRect，以便只绘制暴露区域内的行
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    // 位于段落文本下方
+    setZValue(-1);
+}
+
+/**
+ * @brief 设置选择
+ * 只重绘起点或终点发生变化的行，不依赖也不触发文本排版
+ * @param selection 新的选择
+ */
+void SelectionItem::setSelection(const Selection &selection)
+{
+    Selection::Position start = selection.normalizedStart();
+    Selection::Position end = selection.normalizedEnd();
+    bool empty = selection.isEmpty();
+
+    if (empty && m_empty)
+        return;
+
+    if (empty != m_empty)
+    {
+        // 选择出现或消失：重绘旧的或新的选择所在行
+        if (!m_empty)
+            update(rowsRect(m_start.paragraph, m_end.paragraph));
+        if (!empty)
+            update(rowsRect(start.paragraph, end.paragraph));
+    }
+    else
+    {
+        // 只重绘新旧起点之间、新旧终点之间的行
+        if (!(start == m_start))
+            update(rowsRect(qMin(start.paragraph, m_start.paragraph), qMax(start.paragraph, m_start.paragraph)));
+        if (!(end == m_end))
+            update(rowsRect(qMin(end.paragraph, m_end.paragraph), qMax(end.paragraph, m_end.paragraph)));
+    }
+
+    m_start = start;
+    m_end = end;
+    m_empty = empty;
+}
+
+/**
+ * @brief 设置覆盖范围
+ * @param extent 覆盖范围
+ */
+void SelectionItem::setExtent(const QRectF &extent)
+{
+    if (m_extent != extent)
+    {
+        prepareGeometryChange();
+        m_extent = extent;
+    }
+}
+
+/**
+ * @brief 重绘指定段落范围内的高亮
+ * @param first 第一个段落索引
+ * @param last 最后一个段落索引
+ */
+void SelectionItem::updateParagraphs(int first, int last)
+{
+    if (m_empty)
+        return;
+
+    first = qMax(first, m_start.paragraph);
+    last = qMin(last, m_end.paragraph);
+    if (first <= last)
+        update(rowsRect(first, last));
+}
+
+/**
+ * @brief 获取边界矩形
+ * 覆盖范围只在场景矩形变化时改变，拖动选择时不会引起几何变化
+ * @return 边界矩形
+ */
+QRectF SelectionItem::boundingRect() const
+{
+    return m_extent;
+}
+
+/**
+ * @brief 绘制选择高亮
+ * @param painter 绘图工具
+ * @param option 样式选项
+ * @param widget 部件
+ */
+void SelectionItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    if (m_empty || !m_view)
+        return;
+
+    // 只处理与暴露区域相交的行
+    int first = qMax(m_start.paragraph, m_view->paragraphAt(option->exposedRect.top()));
+    int last = qMin(m_end.paragraph, m_view->paragraphAt(option->exposedRect.bottom()));
+
+    QColor highlight(173, 214, 255); // 浅蓝色，文本绘制在其上方
+    for (int i = first; i <= last; i++)
+    {
+        QRectF rect = highlightRect(i);
+        if (!rect.isEmpty())
+            painter->fillRect(rect, highlight);
+    }
+}
+
+/**
+ * @brief 获取若干行所占的矩形
+ * @param first 第一个段落索引
+ * @param last 最后一个段落索引
+ * @return 行矩形
+ */
+QRectF SelectionItem::rowsRect(int first, int last) const
+{
+    QRectF top = m_view->paragraphRect(first);
+    QRectF bottom = m_view->paragraphRect(last);
+    return QRectF(m_extent.left(), top.top(), m_extent.width(), bottom.bottom() - top.top());
+}
+
+/**
+ * @brief 获取某一段落中被选中部分的矩形
+ * @param paragraph 段落索引
+ * @return 高亮矩形
+ */
+QRectF SelectionItem::highlightRect(int paragraph) const
+{
+    QRectF row = m_view->paragraphRect(paragraph);
+
+    // 起点和终点所在段落使用缓存的光标X坐标，中间段落覆盖整行并包含换行符
+    qreal left = paragraph == m_start.paragraph ? m_view->pointFromPosition(m_start).x() : row.left();
+    qreal right = paragraph == m_end.paragraph ? m_view->pointFromPosition(m_end).x()
+                                               : row.right() + PARAGRAPH_END_WIDTH;
+    return QRectF(left, row.top(), right - left, row.height());
+}
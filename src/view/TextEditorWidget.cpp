@@ -14,6 +14,7 @@
 #include <QKeyEvent>
 #include <QInputMethodEvent>
 #include <QMouseEvent>
+#include <QStringList>
 
 /**
  * @brief 构造函数
@@ -67,10 +68,18 @@ TextEditorWidget::TextEditorWidget(QWidget *parent)
     connect(m_documentView, &DocumentView::selectionChanged, 
             this, &TextEditorWidget::onSelectionChanged);
     
-    // 当文档内容改变时，更新视图布局
+    // 当段落发生变化时，视图只标记受影响的段落，布局在下一个事件循环周期合并执行
+    connect(m_documentController, &DocumentController::paragraphsChanged,
+            m_documentView, &DocumentView::applyParagraphChanges);
+    
+    // 当文档内容改变时，更新状态栏
     connect(m_documentController, &DocumentController::documentChanged,
             this, &TextEditorWidget::onDocumentChanged);
     
+    // 在公式中输入命令时，把补全候选显示在状态栏
+    connect(m_inputController, &InputController::completionsChanged,
+            this, &TextEditorWidget::onCompletionsChanged);
+    
     // 注意：此时文档控制器还没有设置具体文档，
     // 需要通过setDocument()方法在外部设置实际的文档对象
 }
@@ -82,15 +91,32 @@ TextEditorWidget::TextEditorWidget(QWidget *parent)
  * 这个槽函数通过信号-槽机制与文档控制器连接。
  * 
  * 主要功能：
- * - 触发文档视图重新计算布局
- * - 更新所有相关组件的显示状态
- * - 确保UI与数据模型保持一致
+ * - 更新状态栏中的光标和字符信息
+ * 
+ * 注意：这里不再直接触发布局。一次编辑可能多次发出documentChanged，
+ * 布局由paragraphsChanged标记脏段落后交给布局调度器，每个事件循环周期只执行一次。
  */
 void TextEditorWidget::onDocumentChanged()
 {
-    // 调用文档视图的布局更新方法
-    // 这会重新计算所有段落和运行的位置、大小等布局信息
-    m_documentView->updateLayout();
+    updateStatusBar();
+}
+
+/**
+ * @brief 命令补全候选变化处理槽函数
+ * @param completions 补全候选
+ *
+ * 候选按常用程度排列，第一个候选可以用Tab接受。
+ */
+void TextEditorWidget::onCompletionsChanged(const QVector<SymbolCompletion> &completions)
+{
+    if (completions.isEmpty()) {
+        m_statusBar->clearMessage();
+        return;
+    }
+    QStringList items;
+    for (const SymbolCompletion &completion : completions)
+        items.append(QStringLiteral("\\%1 %2").arg(completion.name, completion.symbol).trimmed());
+    m_statusBar->showMessage(items.join(QStringLiteral("   ")));
 }
 
 /**
@@ -107,8 +133,9 @@ void TextEditorWidget::onDocumentChanged()
  */
 void TextEditorWidget::onSelectionChanged(const Selection &selection)
 {
-    // 如果选择来自视图，则更新控制器
+    // 如果选择来自视图，则更新控制器（鼠标移动了光标，之后的输入另起一个撤销步骤）
     if (m_selectionController->selection() != selection) {
+        m_documentController->undoStack()->breakCoalescing();
         m_selectionController->setSelection(selection);
     }
     // 如果选择来自控制器，则更新视图
@@ -209,37 +236,35 @@ void TextEditorWidget::paste()
 
 /**
  * @brief 撤销功能
- * 实现撤销操作
+ * 撤销最近一步编辑，光标回到编辑前的位置
  */
 void TextEditorWidget::undo()
 {
-    // 实现撤销功能
-    // 这里可以添加具体的撤销逻辑
+    Selection::Position position = m_documentController->undo();
+    if (position.paragraph >= 0)
+        m_selectionController->setSelection(Selection(position, position));
 }
 
 /**
  * @brief 重做操作
- * 
- * 执行重做功能，重新执行之前被撤销的操作。
- * 
- * 标准重做操作流程：
- * 1. 检查重做栈是否为空
- * 2. 从重做栈中取出操作
- * 3. 重新执行该操作
- * 4. 更新所有相关组件的状态
- * 5. 刷新UI显示
- * 
- * 重做功能通常与撤销功能配合使用。
- * 
- * TODO: 需要实现具体的重做逻辑
+ *
+ * 重新执行最近一步被撤销的编辑，光标移到编辑后的位置。
+ * 撤销和重做只替换该步修改过的段落区间，视图只重新排版这些段落。
  */
 void TextEditorWidget::redo()
 {
-    // TODO: 实现重做功能
-    // 可能的实现步骤：
-    // 1. 调用文档控制器的重做方法
-    // 2. 更新视图显示
-    // 3. 更新光标和选择状态
+    Selection::Position position = m_documentController->redo();
+    if (position.paragraph >= 0)
+        m_selectionController->setSelection(Selection(position, position));
+}
+
+/**
+ * @brief 获取文档控制器
+ * @return 文档控制器
+ */
+DocumentController *TextEditorWidget::documentController() const
+{
+    return m_documentController;
 }
 
 /**
@@ -333,6 +358,9 @@ void TextEditorWidget::updateStatusBar()
  */
 void TextEditorWidget::keyPressEvent(QKeyEvent *event)
 {
+    // 统计本次输入事件触发的布局次数
+    m_documentView->layoutScheduler()->beginInputEvent();
+    
     // 首先尝试用输入控制器处理事件
     if (m_inputController) {
         m_inputController->handleKeyPress(event);
@@ -421,6 +449,9 @@ void TextEditorWidget::mousePressEvent(QMouseEvent *event)
  */
 void TextEditorWidget::inputMethodEvent(QInputMethodEvent *event)
 {
+    // 统计本次输入事件触发的布局次数
+    m_documentView->layoutScheduler()->beginInputEvent();
+    
     if (m_inputController) {
         m_inputController->handleInputMethodEvent(event);
         if (event->isAccepted()) {
@@ -430,6 +461,66 @@ void TextEditorWidget::inputMethodEvent(QInputMethodEvent *event)
     QWidget::inputMethodEvent(event);
 }
 
+/**
+ * @brief 获得焦点事件处理
+ * @param event 焦点事件
+ *
+ * 编辑器获得焦点后恢复光标显示和闪烁。
+ */
+void TextEditorWidget::focusInEvent(QFocusEvent *event)
+{
+    QWidget::focusInEvent(event);
+    m_documentView->cursor()->setSuspended(false);
+}
+
+/**
+ * @brief 失去焦点事件处理
+ * @param event 焦点事件
+ *
+ * 失去焦点时隐藏光标并退出共享闪烁时钟，空闲时不再周期性重绘。
+ */
+void TextEditorWidget::focusOutEvent(QFocusEvent *event)
+{
+    QWidget::focusOutEvent(event);
+    m_documentView->cursor()->setSuspended(true);
+}
+
+/**
+ * @brief 显示事件处理
+ * @param event 显示事件
+ */
+void TextEditorWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    m_documentView->cursor()->setSuspended(!hasFocus());
+}
+
+/**
+ * @brief 隐藏事件处理
+ * @param event 隐藏事件
+ *
+ * 窗口最小化或部件被隐藏时光标不可见，暂停闪烁。
+ */
+void TextEditorWidget::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_documentView->cursor()->setSuspended(true);
+}
+
+/**
+ * @brief 焦点切换处理
+ * @param next 是否切换到下一个部件
+ * @return 是否已切换焦点
+ *
+ * 光标在公式中时不切换焦点，Tab和Shift+Tab作为按键事件交给输入控制器。
+ */
+bool TextEditorWidget::focusNextPrevChild(bool next)
+{
+    if (m_documentView->selection().start().math.isValid())
+        return false;
+    return QWidget::focusNextPrevChild(next);
+}
+
 /**
  * @brief 输入法查询处理
  * @param query 查询类型，指定需要的信息类型
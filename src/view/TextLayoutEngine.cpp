@@ -0,0 +1,272 @@
+// ============================================================================
+// TextLayoutEngine.cpp
+// 文本排版引擎类的实现文件
+// 在后台线程池中对段落进行文本整形，并将结果交回GUI线程提交
+// ============================================================================
+
+#include "view/TextLayoutEngine.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QTextOption>
+#include <QMetaObject>
+#include <QThread>
+#include <QFontMetricsF>
+#include <QTextCharFormat>
+
+/**
+ * @class LayoutTask
+ * @brief 排版任务
+ *
+ * 在工作线程中整形快照中的一段连续段落。
+ * 快照是隐式共享的只读副本，GUI线程随后的编辑不会影响它。
+ */
+class LayoutTask : public QRunnable
+{
+public:
+    LayoutTask(TextLayoutEngine *engine, const QVector<QString> &texts, const QVector<quint64> &stamps,
+               const QVector<QVector<InlineObject>> &objects,
+               const QVector<QVector<QTextLayout::FormatRange>> &formats,
+               const QFont &font, int snapshotFirst, int offset, int count, int version)
+        : m_engine(engine), m_texts(texts), m_stamps(stamps), m_objects(objects), m_formats(formats), m_font(font),
+          m_snapshotFirst(snapshotFirst), m_offset(offset), m_count(count), m_version(version)
+    {
+    }
+
+    void run() override
+    {
+        QVector<ParagraphLayout> layouts;
+        layouts.reserve(m_count);
+        for (int i = 0; i < m_count; i++)
+        {
+            // 版本已变化，说明请求已被取消，放弃剩余工作
+            if (m_engine->m_version.loadAcquire() != m_version)
+                return;
+            ParagraphLayout layout = TextLayoutEngine::shapeParagraph(m_texts.at(m_offset + i), m_font,
+                                                                      m_objects.value(m_offset + i),
+                                                                      m_formats.value(m_offset + i));
+            layout.stamp = m_stamps.at(m_offset + i);
+            layouts.append(layout);
+        }
+
+        // 回到GUI线程提交；引擎析构时会等待线程池，因此指针在此处有效
+        TextLayoutEngine *engine = m_engine;
+        int version = m_version;
+        int first = m_snapshotFirst + m_offset;
+        QMetaObject::invokeMethod(engine, [engine, version, first, layouts]() {
+            engine->commitBatch(version, first, layouts);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    TextLayoutEngine *m_engine;
+    QVector<QString> m_texts;
+    QVector<quint64> m_stamps;
+    QVector<QVector<InlineObject>> m_objects;
+    QVector<QVector<QTextLayout::FormatRange>> m_formats;
+    QFont m_font;
+    int m_snapshotFirst;
+    int m_offset;
+    int m_count;
+    int m_version;
+};
+
+/**
+ * @brief 构造函数
+ * @param parent 父对象
+ */
+TextLayoutEngine::TextLayoutEngine(QObject *parent)
+    : QObject(parent),
+      m_pool(new QThreadPool(this)),
+      m_version(0),
+      m_pendingBatches(0)
+{
+    // 保留一个核心给GUI线程
+    m_pool->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+/**
+ * @brief 析构函数
+ */
+TextLayoutEngine::~TextLayoutEngine()
+{
+    cancel();
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+/**
+ * @brief 请求排版
+ * @param texts 段落文本快照
+ * @param stamps 每个段落快照对应的内容戳
+ * @param objects 每个段落的内联对象
+ * @param formats 每个段落中文本Run的格式区间
+ * @param font 排版字体
+ * @param first 快照中第一个段落的索引
+ * @param priorityParagraph 优先排版的段落索引
+ */
+void TextLayoutEngine::requestLayout(const QVector<QString> &texts, const QVector<quint64> &stamps,
+                                     const QVector<QVector<InlineObject>> &objects,
+                                     const QVector<QVector<QTextLayout::FormatRange>> &formats,
+                                     const QFont &font, int first, int priorityParagraph)
+{
+    // 之前的请求继续进行，其中过期的段落由视图根据内容戳丢弃
+    int version = m_version.loadAcquire();
+    int batchCount = (texts.size() + BATCH_SIZE - 1) / BATCH_SIZE;
+    int priorityBatch = qBound(0, (priorityParagraph - first) / BATCH_SIZE, qMax(0, batchCount - 1));
+    for (int batch = 0; batch < batchCount; batch++)
+    {
+        int offset = batch * BATCH_SIZE;
+        int count = qMin(BATCH_SIZE, texts.size() - offset);
+        // 距离可见区域越近的批次优先级越高
+        int priority = -qAbs(batch - priorityBatch);
+        m_pool->start(new LayoutTask(this, texts, stamps, objects, formats, font, first, offset, count, version),
+                      priority);
+        m_pendingBatches++;
+    }
+
+    if (m_pendingBatches == 0)
+        emit layoutFinished();
+}
+
+/**
+ * @brief 取消尚未提交的排版请求
+ */
+void TextLayoutEngine::cancel()
+{
+    m_version.fetchAndAddOrdered(1);
+    m_pool->clear();
+    m_pendingBatches = 0;
+}
+
+/**
+ * @brief 获取当前版本号
+ * @return 版本号
+ */
+int TextLayoutEngine::version() const
+{
+    return m_version.loadAcquire();
+}
+
+/**
+ * @brief 检查是否还有未提交的批次
+ * @return 是否忙碌
+ */
+bool TextLayoutEngine::isBusy() const
+{
+    return m_pendingBatches > 0;
+}
+
+/**
+ * @brief 同步整形单个段落
+ * @param text 段落文本
+ * @param font 排版字体
+ * @param objects 段落中的内联对象
+ * @param formats 文本Run的格式区间
+ * @return 排版结果
+ */
+ParagraphLayout TextLayoutEngine::shapeParagraph(const QString &text, const QFont &font,
+                                                 const QVector<InlineObject> &objects,
+                                                 const QVector<QTextLayout::FormatRange> &formats)
+{
+    ParagraphLayout result;
+    result.objects = objects;
+
+    QTextLayout textLayout(text, font);
+    QTextOption option;
+    option.setWrapMode(QTextOption::NoWrap);
+    textLayout.setTextOption(option);
+
+    // 文本Run的格式区间与内联对象互不重叠，合并后一起交给QTextLayout；
+    // 用字间距把对象替换字符撑到对象的宽度，光标位置随之正确
+    if (!objects.isEmpty() || !formats.isEmpty())
+    {
+        QVector<QTextLayout::FormatRange> ranges = formats;
+        if (!objects.isEmpty())
+        {
+            qreal advance = QFontMetricsF(font).horizontalAdvance(QChar(0xFFFC));
+            ranges.reserve(formats.size() + objects.size());
+            for (const InlineObject &object : objects)
+            {
+                QTextLayout::FormatRange range;
+                range.start = object.position;
+                range.length = 1;
+                range.format.setFontLetterSpacingType(QFont::AbsoluteSpacing);
+                range.format.setFontLetterSpacing(object.width - advance);
+                ranges.append(range);
+            }
+        }
+        textLayout.setFormats(ranges);
+    }
+
+    // 内联对象（如矩阵等高公式）可能高于文本行，行高需要容纳最高的对象
+    qreal objectAscent = 0;
+    qreal objectDescent = 0;
+    for (const InlineObject &object : objects)
+    {
+        objectAscent = qMax(objectAscent, object.ascent);
+        objectDescent = qMax(objectDescent, object.descent);
+    }
+
+    qreal ascent = 0;
+    textLayout.beginLayout();
+    QTextLine line = textLayout.createLine();
+    if (line.isValid())
+    {
+        // 单行布局：整个段落放在一行中（与原有的逐段落单行显示保持一致）
+        line.setNumColumns(text.length());
+        // 基线下移到最高对象的顶部之下，字形坐标随之下移
+        ascent = qMax(line.ascent(), objectAscent);
+        line.setPosition(QPointF(0, ascent - line.ascent()));
+    }
+    textLayout.endLayout();
+
+    if (objects.isEmpty())
+    {
+        result.glyphRuns = textLayout.glyphRuns();
+    }
+    else
+    {
+        // 只取对象之间的文本字形，对象本身由视图绘制
+        int from = 0;
+        for (const InlineObject &object : objects)
+        {
+            if (object.position > from)
+                result.glyphRuns += textLayout.glyphRuns(from, object.position - from);
+            from = object.position + 1;
+        }
+        if (from < text.length())
+            result.glyphRuns += textLayout.glyphRuns(from, text.length() - from);
+    }
+    if (line.isValid())
+    {
+        result.width = line.naturalTextWidth();
+        result.height = ascent + qMax(line.height() - line.ascent(), objectDescent);
+        result.ascent = ascent;
+
+        // 缓存每个光标位置的X坐标
+        result.caretPositions.resize(text.length() + 1);
+        for (int i = 0; i <= text.length(); i++)
+        {
+            result.caretPositions[i] = line.cursorToX(i);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief 在GUI线程中提交一批结果
+ * @param version 结果对应的版本号
+ * @param first 第一个段落的索引
+ * @param layouts 排版结果
+ */
+void TextLayoutEngine::commitBatch(int version, int first, const QVector<ParagraphLayout> &layouts)
+{
+    // 丢弃已取消版本的结果
+    if (version != m_version.loadAcquire())
+        return;
+
+    emit layoutsReady(first, layouts);
+
+    if (--m_pendingBatches == 0)
+        emit layoutFinished();
+}
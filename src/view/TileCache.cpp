@@ -0,0 +1,285 @@
+// ============================================================================
+// TileCache.cpp
+// 瓦片缓存类的实现文件
+// 将文档内容光栅化为固定大小的瓦片，滚动时直接贴图
+// ============================================================================
+
+#include "view/TileCache.h"
+#include "view/ParagraphItem.h"
+#include <QPainter>
+#include <QtMath>
+
+/**
+ * @brief 构造函数
+ * @param parent 父对象
+ */
+TileCache::TileCache(QObject *parent)
+    : QObject(parent),
+      m_ratio(1.0),
+      m_hits(0),
+      m_misses(0)
+{
+    setByteBudget(DEFAULT_BYTE_BUDGET);
+}
+
+/**
+ * @brief 获取瓦片边长
+ * @return 瓦片边长
+ */
+int TileCache::tileSize() const
+{
+    return TILE_SIZE;
+}
+
+/**
+ * @brief 设置字节预算
+ * @param bytes 最大字节数
+ */
+void TileCache::setByteBudget(qint64 bytes)
+{
+    m_tiles.setMaxCost(static_cast<int>(qMax<qint64>(0, bytes / 1024)));
+}
+
+/**
+ * @brief 获取字节预算
+ * @return 字节预算
+ */
+qint64 TileCache::byteBudget() const
+{
+    return qint64(m_tiles.maxCost()) * 1024;
+}
+
+/**
+ * @brief 获取当前缓存占用的字节数
+ * @return 字节数
+ */
+qint64 TileCache::byteCount() const
+{
+    return qint64(m_tiles.totalCost()) * 1024;
+}
+
+/**
+ * @brief 设置光栅化比例
+ * @param ratio 光栅化比例
+ */
+void TileCache::setDevicePixelRatio(qreal ratio)
+{
+    if (!qFuzzyCompare(m_ratio, ratio))
+    {
+        m_ratio = ratio;
+        clear();
+    }
+}
+
+/**
+ * @brief 获取光栅化比例
+ * @return 光栅化比例
+ */
+qreal TileCache::devicePixelRatio() const
+{
+    return m_ratio;
+}
+
+/**
+ * @brief 获取瓦片的场景矩形
+ * @param tile 瓦片坐标
+ * @return 场景矩形
+ */
+QRectF TileCache::tileRect(const QPoint &tile) const
+{
+    return QRectF(tile.x() * TILE_SIZE, tile.y() * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+}
+
+/**
+ * @brief 获取与矩形相交的瓦片坐标范围
+ * @param rect 场景矩形
+ * @return 瓦片坐标范围
+ */
+QRect TileCache::tileRange(const QRectF &rect) const
+{
+    if (rect.isEmpty())
+        return QRect();
+    int left = qFloor(rect.left() / TILE_SIZE);
+    int top = qFloor(rect.top() / TILE_SIZE);
+    int right = qCeil(rect.right() / TILE_SIZE) - 1;
+    int bottom = qCeil(rect.bottom() / TILE_SIZE) - 1;
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+/**
+ * @brief 获取与矩形相交的所有瓦片
+ * @param rect 场景矩形
+ * @return 瓦片坐标列表
+ */
+QVector<QPoint> TileCache::tilesIntersecting(const QRectF &rect) const
+{
+    QVector<QPoint> tiles;
+    QRect range = tileRange(rect);
+    for (int y = range.top(); y <= range.bottom(); y++)
+    {
+        for (int x = range.left(); x <= range.right(); x++)
+            tiles.append(QPoint(x, y));
+    }
+    return tiles;
+}
+
+/**
+ * @brief 查找瓦片
+ * @param tile 瓦片坐标
+ * @return 瓦片图像，未缓存时返回nullptr
+ */
+const QImage *TileCache::tile(const QPoint &tile)
+{
+    const QImage *image = m_tiles.object(key(tile));
+    if (image)
+        m_hits++;
+    else
+        m_misses++;
+    return image;
+}
+
+/**
+ * @brief 缓存瓦片
+ * @param tile 瓦片坐标
+ * @param image 瓦片图像
+ */
+void TileCache::insert(const QPoint &tile, const QImage &image)
+{
+    int cost = qMax(1, static_cast<int>(image.sizeInBytes() / 1024));
+    m_dirtyTiles.remove(key(tile));
+    m_tiles.insert(key(tile), new QImage(image), cost);
+}
+
+/**
+ * @brief 作废与矩形重叠的瓦片
+ * @param rect 场景矩形
+ */
+void TileCache::invalidate(const QRectF &rect)
+{
+    if (rect.isEmpty())
+        return;
+    // 只遍历已缓存的瓦片，数量受字节预算限制
+    const QList<quint64> keys = m_tiles.keys();
+    for (quint64 k : keys)
+    {
+        if (tileRect(tileFromKey(k)).intersects(rect))
+            invalidateKey(k);
+    }
+}
+
+/**
+ * @brief 作废场景Y坐标以下的所有瓦片
+ * @param y 场景Y坐标
+ */
+void TileCache::invalidateFrom(qreal y)
+{
+    const QList<quint64> keys = m_tiles.keys();
+    for (quint64 k : keys)
+    {
+        if (tileRect(tileFromKey(k)).bottom() > y)
+            invalidateKey(k);
+    }
+}
+
+/**
+ * @brief 清空缓存
+ */
+void TileCache::clear()
+{
+    m_tiles.clear();
+    m_dirtyTiles.clear();
+}
+
+/**
+ * @brief 检查瓦片是否为脏瓦片
+ * @param tile 瓦片坐标
+ * @return 是否为脏瓦片
+ */
+bool TileCache::isDirty(const QPoint &tile) const
+{
+    return m_dirtyTiles.contains(key(tile));
+}
+
+/**
+ * @brief 清除脏瓦片记录
+ */
+void TileCache::clearDirtyTiles()
+{
+    m_dirtyTiles.clear();
+}
+
+/**
+ * @brief 移除缓存的瓦片并记为脏瓦片
+ * @param key 缓存键
+ */
+void TileCache::invalidateKey(quint64 key)
+{
+    m_tiles.remove(key);
+    m_dirtyTiles.insert(key);
+}
+
+/**
+ * @brief 获取命中次数
+ * @return 命中次数
+ */
+int TileCache::hitCount() const
+{
+    return m_hits;
+}
+
+/**
+ * @brief 获取未命中次数
+ * @return 未命中次数
+ */
+int TileCache::missCount() const
+{
+    return m_misses;
+}
+
+/**
+ * @brief 光栅化一个瓦片
+ * @param rect 瓦片的场景矩形
+ * @param ratio 光栅化比例
+ * @param paragraphs 与瓦片相交的段落快照
+ * @return 瓦片图像
+ */
+QImage TileCache::rasterize(const QRectF &rect, qreal ratio, const QVector<TileParagraph> &paragraphs)
+{
+    QImage image(qCeil(rect.width() * ratio), qCeil(rect.height() * ratio),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(ratio);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.translate(-rect.topLeft());
+    for (const TileParagraph &paragraph : paragraphs)
+    {
+        painter.save();
+        painter.translate(paragraph.position);
+        ParagraphItem::drawGlyphRuns(&painter, paragraph.glyphRuns, paragraph.clipWidth, paragraph.height);
+        painter.restore();
+    }
+    return image;
+}
+
+/**
+ * @brief 瓦片坐标转换为缓存键
+ * @param tile 瓦片坐标
+ * @return 缓存键
+ */
+quint64 TileCache::key(const QPoint &tile)
+{
+    return (quint64(quint32(tile.x())) << 32) | quint32(tile.y());
+}
+
+/**
+ * @brief 缓存键转换为瓦片坐标
+ * @param key 缓存键
+ * @return 瓦片坐标
+ */
+QPoint TileCache::tileFromKey(quint64 key)
+{
+    return QPoint(static_cast<qint32>(key >> 32), static_cast<qint32>(key & 0xffffffffu));
+}
@@ -0,0 +1,189 @@
+// ============================================================================
+// TileRenderer.cpp
+// 瓦片渲染器类的实现文件
+// 在后台线程池中并行光栅化瓦片，并将结果交回GUI线程合成
+// ============================================================================
+
+#include "view/TileRenderer.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMetaObject>
+#include <QThread>
+
+/**
+ * @class TileTask
+ * @brief 瓦片光栅化任务
+ *
+ * 在工作线程中把段落快照绘制到一张新的QImage上。
+ * 开始前和完成后各检查一次取消标志，被取消的任务不再提交结果。
+ */
+class TileTask : public QRunnable
+{
+public:
+    TileTask(TileRenderer *renderer, const QPoint &tile, quint64 id, const QRectF &rect, qreal ratio,
+             const QVector<TileParagraph> &paragraphs, const QSharedPointer<QAtomicInt> &cancelled)
+        : m_renderer(renderer), m_tile(tile), m_id(id), m_rect(rect), m_ratio(ratio),
+          m_paragraphs(paragraphs), m_cancelled(cancelled)
+    {
+    }
+
+    void run() override
+    {
+        if (m_cancelled->loadAcquire())
+            return;
+        QImage image = TileCache::rasterize(m_rect, m_ratio, m_paragraphs);
+        if (m_cancelled->loadAcquire())
+            return;
+
+        // 回到GUI线程提交；渲染器析构时会等待线程池，因此指针在此处有效
+        TileRenderer *renderer = m_renderer;
+        QPoint tile = m_tile;
+        quint64 id = m_id;
+        QMetaObject::invokeMethod(renderer, [renderer, tile, id, image]() {
+            renderer->commitTile(tile, id, image);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    TileRenderer *m_renderer;
+    QPoint m_tile;
+    quint64 m_id;
+    QRectF m_rect;
+    qreal m_ratio;
+    QVector<TileParagraph> m_paragraphs;
+    QSharedPointer<QAtomicInt> m_cancelled;
+};
+
+/**
+ * @brief 构造函数
+ * @param parent 父对象
+ */
+TileRenderer::TileRenderer(QObject *parent)
+    : QObject(parent),
+      m_pool(new QThreadPool(this)),
+      m_nextId(0)
+{
+    // 保留一个核心给GUI线程
+    m_pool->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+/**
+ * @brief 析构函数
+ */
+TileRenderer::~TileRenderer()
+{
+    cancelAll();
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+/**
+ * @brief 请求光栅化一个瓦片
+ * @param tile 瓦片坐标
+ * @param rect 瓦片的场景矩形
+ * @param ratio 光栅化比例
+ * @param paragraphs 与瓦片相交的段落快照
+ * @param priority 优先级
+ */
+void TileRenderer::request(const QPoint &tile, const QRectF &rect, qreal ratio,
+                           const QVector<TileParagraph> &paragraphs, int priority)
+{
+    quint64 key = TileCache::key(tile);
+    auto it = m_pending.find(key);
+    if (it != m_pending.end())
+        it->cancelled->storeRelease(1);
+
+    PendingTile pending;
+    pending.id = ++m_nextId;
+    pending.rect = rect;
+    pending.cancelled = QSharedPointer<QAtomicInt>::create(0);
+    m_pending.insert(key, pending);
+
+    m_pool->start(new TileTask(this, tile, pending.id, rect, ratio, paragraphs, pending.cancelled), priority);
+}
+
+/**
+ * @brief 检查瓦片是否正在等待光栅化
+ * @param tile 瓦片坐标
+ * @return 是否等待中
+ */
+bool TileRenderer::isPending(const QPoint &tile) const
+{
+    return m_pending.contains(TileCache::key(tile));
+}
+
+/**
+ * @brief 取消与矩形相交的等待中瓦片
+ * @param rect 场景矩形
+ */
+void TileRenderer::cancelIntersecting(const QRectF &rect)
+{
+    for (auto it = m_pending.begin(); it != m_pending.end();)
+    {
+        if (it->rect.intersects(rect))
+        {
+            it->cancelled->storeRelease(1);
+            it = m_pending.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+/**
+ * @brief 取消不在指定瓦片范围内的等待中瓦片
+ * @param tiles 保留的瓦片坐标范围
+ */
+void TileRenderer::cancelOutside(const QRect &tiles)
+{
+    for (auto it = m_pending.begin(); it != m_pending.end();)
+    {
+        if (!tiles.contains(TileCache::tileFromKey(it.key())))
+        {
+            it->cancelled->storeRelease(1);
+            it = m_pending.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+/**
+ * @brief 取消所有等待中的瓦片
+ */
+void TileRenderer::cancelAll()
+{
+    for (const PendingTile &pending : m_pending)
+        pending.cancelled->storeRelease(1);
+    m_pending.clear();
+}
+
+/**
+ * @brief 获取等待中的瓦片数量
+ * @return 瓦片数量
+ */
+int TileRenderer::pendingCount() const
+{
+    return m_pending.size();
+}
+
+/**
+ * @brief 在GUI线程中提交一个瓦片
+ * @param tile 瓦片坐标
+ * @param id 请求编号
+ * @param image 瓦片图像
+ */
+void TileRenderer::commitTile(const QPoint &tile, quint64 id, const QImage &image)
+{
+    // 已取消或已被新请求取代的结果直接丢弃
+    auto it = m_pending.find(TileCache::key(tile));
+    if (it == m_pending.end() || it->id != id)
+        return;
+    m_pending.erase(it);
+
+    emit tileReady(tile, image);
+}
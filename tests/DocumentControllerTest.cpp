@@ -0,0 +1,223 @@
+// ============================================================================
+// DocumentControllerTest.cpp
+// 文档控制器的单元测试
+// 检查替换文本对反向选择的处理及其撤销重做，以及原处编辑公式的撤销重做
+// ============================================================================
+
+#include "controller/DocumentController.h"
+#include "core/Document.h"
+#include "core/MathNode.h"
+#include "core/MathTokenizer.h"
+#include <QtTest>
+
+/**
+ * @class DocumentControllerTest
+ * @brief 文档控制器的单元测试
+ */
+class DocumentControllerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 替换反向选择（终点在起点之前）的文本：插入到选择的前端，撤销重做恢复光标
+     */
+    void replaceBackwardSelection();
+
+    /**
+     * @brief 删除反向选择的文本并设置格式：撤销后光标回到规范化的末端
+     */
+    void deleteBackwardSelection();
+
+    /**
+     * @brief 直接编辑公式的表达式树：撤销恢复修改前的公式，重做恢复修改后的公式，未修改的节点原处保留
+     */
+    void undoFormulaEdit();
+
+    /**
+     * @brief 公式中的连续输入与文本输入一样按单词合并为一步，撤销后光标回到公式内部
+     */
+    void coalesceFormulaTyping();
+
+    /**
+     * @brief 设置公式的编号和标签：撤销恢复原编号状态和标签，编号索引随之更新
+     */
+    void undoEquationNumbered();
+};
+
+namespace {
+
+/**
+ * @brief 构造只含一个公式的文档，公式为单个符号
+ * @param document 文档
+ * @param text 符号文本
+ * @return 公式对象
+ */
+QSharedPointer<MathObject> addFormulaParagraph(Document *document, const QString &text)
+{
+    MathNode *root = new MathNode(MathNode::Row);
+    root->appendChild(new MathNode(MathNode::Symbol, text));
+    QSharedPointer<MathObject> formula(new MathObject(root));
+    Paragraph paragraph;
+    paragraph.insertFormula(0, formula);
+    document->addParagraph(paragraph);
+    return formula;
+}
+
+/**
+ * @brief 获取公式中的符号文本（按顺序拼接）
+ * @param formula 公式对象
+ * @return 符号文本
+ */
+QString symbols(const MathObject *formula)
+{
+    QString result;
+    for (int i = 0; i < formula->root()->childCount(); i++)
+        result += formula->root()->child(i)->text();
+    return result;
+}
+
+} // namespace
+
+void DocumentControllerTest::replaceBackwardSelection()
+{
+    Document document;
+    Paragraph paragraph;
+    paragraph.insertText(0, QStringLiteral("hello world"));
+    document.addParagraph(paragraph);
+    DocumentController controller;
+    controller.setDocument(&document);
+
+    // 从"world"末尾向左拖动选中"world"
+    Selection selection({0, 11}, {0, 6});
+    controller.replaceText(selection, QStringLiteral("there"));
+    QCOMPARE(document.paragraph(0).text(), QStringLiteral("hello there"));
+
+    Selection::Position before = controller.undo();
+    QCOMPARE(document.paragraph(0).text(), QStringLiteral("hello world"));
+    QCOMPARE(before.paragraph, 0);
+    QCOMPARE(before.position, 11);
+
+    Selection::Position after = controller.redo();
+    QCOMPARE(document.paragraph(0).text(), QStringLiteral("hello there"));
+    QCOMPARE(after.paragraph, 0);
+    QCOMPARE(after.position, 11);
+}
+
+void DocumentControllerTest::deleteBackwardSelection()
+{
+    Document document;
+    Paragraph paragraph;
+    paragraph.insertText(0, QStringLiteral("hello world"));
+    document.addParagraph(paragraph);
+    DocumentController controller;
+    controller.setDocument(&document);
+
+    Selection selection({0, 11}, {0, 6});
+    controller.deleteText(selection);
+    QCOMPARE(document.paragraph(0).text(), QStringLiteral("hello "));
+    Selection::Position before = controller.undo();
+    QCOMPARE(document.paragraph(0).text(), QStringLiteral("hello world"));
+    QCOMPARE(before.position, 11);
+
+    Format bold;
+    bold.setBold(true);
+    controller.applyFormat(selection, bold);
+    QCOMPARE(document.paragraph(0).runCount(), 2);
+    before = controller.undo();
+    QCOMPARE(document.paragraph(0).runCount(), 1);
+    QCOMPARE(before.position, 11);
+}
+
+void DocumentControllerTest::undoFormulaEdit()
+{
+    Document document;
+    QSharedPointer<MathObject> formula = addFormulaParagraph(&document, QStringLiteral("x"));
+    DocumentController controller;
+    controller.setDocument(&document);
+    MathNode *x = formula->root()->child(0);
+
+    // 与公式输入相同：词法分析器原处修改表达式树并记录被替换的节点
+    MathTokenizer tokenizer;
+    QVector<MathEdit> edits;
+    tokenizer.setEditLog(&edits);
+    Selection::Position position = {0, 0, MathPosition(QVector<int>(), 1)};
+    Selection::Position cursor = position;
+    cursor.math = tokenizer.input(formula->root(), position.math, QLatin1Char('y'));
+    controller.updateFormula(position, edits, cursor);
+    QVERIFY(controller.canUndo());
+
+    Selection::Position before = controller.undo();
+    QCOMPARE(symbols(formula.data()), QStringLiteral("x"));
+    QVERIFY(document.paragraph(0).formulaAt(0) == formula);
+    QVERIFY(formula->root()->child(0) == x);
+    QVERIFY(before.math == position.math);
+
+    controller.redo();
+    QCOMPARE(symbols(formula.data()), QStringLiteral("xy"));
+    QVERIFY(formula->root()->child(0) == x);
+    controller.undo();
+    QCOMPARE(symbols(formula.data()), QStringLiteral("x"));
+}
+
+void DocumentControllerTest::coalesceFormulaTyping()
+{
+    Document document;
+    QSharedPointer<MathObject> formula = addFormulaParagraph(&document, QString());
+    DocumentController controller;
+    controller.setDocument(&document);
+
+    MathTokenizer tokenizer;
+    Selection::Position cursor = {0, 0, MathPosition(QVector<int>(), 0)};
+    const QString text = QStringLiteral("ab c");
+    for (QChar character : text)
+    {
+        QVector<MathEdit> edits;
+        tokenizer.setEditLog(&edits);
+        Selection::Position position = cursor;
+        cursor.math = tokenizer.input(formula->root(), position.math, character);
+        controller.updateFormula(position, edits, cursor, QString(character));
+    }
+    QCOMPARE(symbols(formula.data()), QStringLiteral("abc"));
+    // 数学模式中的空格不产生节点，也不产生撤销步骤；"ab"和"c"之间没有空白输入，合并为一步
+    QCOMPARE(controller.undoStack()->count(), 1);
+
+    Selection::Position before = controller.undo();
+    QCOMPARE(symbols(formula.data()), QString());
+    QVERIFY(before.math == MathPosition(QVector<int>(), 0));
+    controller.redo();
+    QCOMPARE(symbols(formula.data()), QStringLiteral("abc"));
+}
+
+void DocumentControllerTest::undoEquationNumbered()
+{
+    Document document;
+    QSharedPointer<MathObject> first = addFormulaParagraph(&document, QStringLiteral("a"));
+    QSharedPointer<MathObject> second = addFormulaParagraph(&document, QStringLiteral("b"));
+    DocumentController controller;
+    controller.setDocument(&document);
+
+    controller.setEquationNumbered({0, 0}, true, QStringLiteral("first"));
+    controller.setEquationNumbered({1, 0}, true, QStringLiteral("old"));
+    controller.setEquationNumbered({1, 0}, true, QStringLiteral("new"));
+    QCOMPARE(document.equationIndex().number(QStringLiteral("new")), 2);
+
+    controller.undo();
+    QCOMPARE(second->label(), QStringLiteral("old"));
+    QCOMPARE(document.equationIndex().number(QStringLiteral("old")), 2);
+    QCOMPARE(document.equationIndex().number(QStringLiteral("new")), 0);
+
+    controller.undo();
+    QVERIFY(!second->isNumbered());
+    QCOMPARE(document.equationIndex().count(), 1);
+    QCOMPARE(document.equationIndex().number(QStringLiteral("old")), 0);
+
+    controller.redo();
+    controller.redo();
+    QCOMPARE(second->label(), QStringLiteral("new"));
+    QCOMPARE(document.equationIndex().number(QStringLiteral("new")), 2);
+    QCOMPARE(document.equationIndex().number(first.data()), 1);
+}
+
+QTEST_MAIN(DocumentControllerTest)
+#include "DocumentControllerTest.moc"
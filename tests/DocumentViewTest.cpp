@@ -0,0 +1,142 @@
+// ============================================================================
+// DocumentViewTest.cpp
+// 文档视图的单元测试
+// 检查段落高度随高公式（矩阵）变化，定位与点击测试使用实际的段落高度
+// ============================================================================
+
+#include "view/DocumentView.h"
+#include "view/FormulaItem.h"
+#include "core/Document.h"
+#include "core/MathNode.h"
+#include <QtTest>
+
+/**
+ * @class DocumentViewTest
+ * @brief 文档视图的单元测试
+ */
+class DocumentViewTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 初始化每个测试：第一段含5×5矩阵，第二段为普通文本
+     */
+    void init();
+
+    /**
+     * @brief 清理每个测试
+     */
+    void cleanup();
+
+    /**
+     * @brief 矩阵所在段落的高度容纳整个矩阵，下一段落位于矩阵下方
+     */
+    void matrixParagraphReservesHeight();
+
+    /**
+     * @brief 点击矩阵下部的单元格落在矩阵所在段落的公式内部，而不是下一段落
+     */
+    void matrixCellHitTest();
+
+private:
+    /**
+     * @brief 获取场景中的矩阵公式子项
+     * @return 矩阵公式子项，排版结果尚未提交时返回nullptr
+     */
+    FormulaItem *matrixItem() const;
+
+    /**
+     * @brief 测试文档
+     */
+    Document *m_document = nullptr;
+
+    /**
+     * @brief 测试视图
+     */
+    DocumentView *m_view = nullptr;
+};
+
+void DocumentViewTest::init()
+{
+    // 5×5矩阵，每个单元格一个符号
+    MathNode *matrix = MathNode::createMatrix(5, 5);
+    for (int i = 0; i < matrix->childCount(); i++)
+        matrix->child(i)->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("x")));
+    MathNode *root = new MathNode(MathNode::Row);
+    root->appendChild(matrix);
+
+    Paragraph first;
+    first.insertText(0, QStringLiteral("A = "));
+    first.insertFormula(4, QSharedPointer<MathObject>(new MathObject(root)));
+    Paragraph second;
+    second.insertText(0, QStringLiteral("next"));
+
+    m_document = new Document();
+    m_document->addParagraph(first);
+    m_document->addParagraph(second);
+    m_view = new DocumentView();
+    m_view->resize(800, 600);
+    m_view->setDocument(m_document);
+}
+
+void DocumentViewTest::cleanup()
+{
+    delete m_view;
+    m_view = nullptr;
+    delete m_document;
+    m_document = nullptr;
+}
+
+FormulaItem *DocumentViewTest::matrixItem() const
+{
+    const QList<QGraphicsItem *> items = m_view->scene()->items();
+    for (QGraphicsItem *item : items)
+    {
+        if (FormulaItem *formula = dynamic_cast<FormulaItem *>(item))
+            return formula;
+    }
+    return nullptr;
+}
+
+void DocumentViewTest::matrixParagraphReservesHeight()
+{
+    // 排版在后台进行，公式子项在结果提交时创建
+    FormulaItem *item = nullptr;
+    QTRY_VERIFY((item = matrixItem()) != nullptr);
+    QRectF formula = item->sceneBoundingRect();
+    QRectF first = m_view->paragraphRect(0);
+    QRectF second = m_view->paragraphRect(1);
+
+    QFontMetricsF metrics(QFont("Microsoft YaHei", 12));
+    QVERIFY(formula.height() > 2 * metrics.height());
+
+    // 矩阵完全位于第一段之内，第二段紧随其后
+    QVERIFY(formula.top() >= first.top() - 0.5);
+    QVERIFY(formula.bottom() <= first.bottom() + 0.5);
+    QCOMPARE(second.top(), first.bottom());
+    QVERIFY(m_view->pointFromPosition({1, 0}).y() >= formula.bottom() - 0.5);
+    QVERIFY(m_view->scene()->sceneRect().height() >= second.bottom());
+}
+
+void DocumentViewTest::matrixCellHitTest()
+{
+    // 排版在后台进行，公式子项在结果提交时创建
+    FormulaItem *item = nullptr;
+    QTRY_VERIFY((item = matrixItem()) != nullptr);
+    QRectF formula = item->sceneBoundingRect();
+
+    // 最后一行单元格：按固定行高定位时这里属于下一段落
+    QPointF point(formula.center().x(), formula.bottom() - 2);
+    QCOMPARE(m_view->paragraphAt(point.y()), 0);
+    Selection::Position position = m_view->positionFromPoint(point);
+    QCOMPARE(position.paragraph, 0);
+    QCOMPARE(position.position, 4);
+    QVERIFY(position.math.isValid());
+
+    // 矩阵之下才是下一段落
+    QCOMPARE(m_view->paragraphAt(m_view->paragraphRect(1).center().y()), 1);
+}
+
+QTEST_MAIN(DocumentViewTest)
+#include "DocumentViewTest.moc"
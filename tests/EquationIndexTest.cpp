@@ -0,0 +1,112 @@
+// ============================================================================
+// EquationIndexTest.cpp
+// 公式编号索引的单元测试
+// 检查公式的标签被就地修改后，索引仍按登记时的标签注销；同一公式出现在多个段落中时各处分别登记
+// ============================================================================
+
+#include "core/EquationIndex.h"
+#include "core/MathObject.h"
+#include <QtTest>
+
+/**
+ * @class EquationIndexTest
+ * @brief 公式编号索引的单元测试
+ */
+class EquationIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 就地修改标签后重新设置段落的公式：旧标签失效，新标签指向该公式
+     */
+    void relabelInPlace();
+
+    /**
+     * @brief 就地修改标签后删除段落：旧标签不会残留在索引中
+     */
+    void removeAfterRelabel();
+
+    /**
+     * @brief 同一公式对象出现在两个段落中：各处按位置编号，删除一个段落后另一处的登记和标签保留
+     */
+    void sharedFormula();
+};
+
+namespace {
+
+/**
+ * @brief 创建带编号和标签的公式
+ * @param label 标签
+ * @return 公式对象
+ */
+MathObject *numberedFormula(const QString &label)
+{
+    MathObject *formula = new MathObject();
+    formula->setNumbered(true);
+    formula->setLabel(label);
+    return formula;
+}
+
+} // namespace
+
+void EquationIndexTest::relabelInPlace()
+{
+    QScopedPointer<MathObject> first(numberedFormula(QStringLiteral("first")));
+    QScopedPointer<MathObject> second(numberedFormula(QStringLiteral("old")));
+    EquationIndex index;
+    index.insertParagraph(0, {first.data()});
+    index.insertParagraph(1, {second.data()});
+    QCOMPARE(index.number(QStringLiteral("old")), 2);
+
+    second->setLabel(QStringLiteral("new"));
+    index.setEquations(1, {second.data()});
+    QCOMPARE(index.equation(QStringLiteral("old")), static_cast<const MathObject *>(nullptr));
+    QCOMPARE(index.equation(QStringLiteral("new")), static_cast<const MathObject *>(second.data()));
+    QCOMPARE(index.number(QStringLiteral("new")), 2);
+    QCOMPARE(index.number(QStringLiteral("first")), 1);
+}
+
+void EquationIndexTest::removeAfterRelabel()
+{
+    QScopedPointer<MathObject> formula(numberedFormula(QStringLiteral("old")));
+    EquationIndex index;
+    index.insertParagraph(0, {formula.data()});
+
+    formula->setLabel(QStringLiteral("new"));
+    index.removeParagraph(0);
+    QCOMPARE(index.count(), 0);
+    QCOMPARE(index.equation(QStringLiteral("old")), static_cast<const MathObject *>(nullptr));
+    QCOMPARE(index.number(formula.data()), 0);
+}
+
+void EquationIndexTest::sharedFormula()
+{
+    QScopedPointer<MathObject> shared(numberedFormula(QStringLiteral("shared")));
+    QScopedPointer<MathObject> last(numberedFormula(QStringLiteral("last")));
+    EquationIndex index;
+    // 复制段落后两个段落引用同一公式对象
+    index.insertParagraph(0, {shared.data()});
+    index.insertParagraph(1, {shared.data()});
+    index.insertParagraph(2, {last.data()});
+    QCOMPARE(index.count(), 3);
+    QCOMPARE(index.numberAt(index.handle(0), 0), 1);
+    QCOMPARE(index.numberAt(index.handle(1), 0), 2);
+    QCOMPARE(index.number(shared.data()), 1);
+    QCOMPARE(index.number(QStringLiteral("last")), 3);
+
+    index.removeParagraph(0);
+    QCOMPARE(index.count(), 2);
+    QCOMPARE(index.numberAt(index.handle(0), 0), 1);
+    QCOMPARE(index.number(shared.data()), 1);
+    QCOMPARE(index.equation(QStringLiteral("shared")), static_cast<const MathObject *>(shared.data()));
+    QCOMPARE(index.number(QStringLiteral("last")), 2);
+
+    index.removeParagraph(0);
+    QCOMPARE(index.number(shared.data()), 0);
+    QCOMPARE(index.equation(QStringLiteral("shared")), static_cast<const MathObject *>(nullptr));
+    QCOMPARE(index.number(QStringLiteral("last")), 1);
+}
+
+QTEST_MAIN(EquationIndexTest)
+#include "EquationIndexTest.moc"
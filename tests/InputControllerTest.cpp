@@ -0,0 +1,111 @@
+// ============================================================================
+// InputControllerTest.cpp
+// 输入控制器的单元测试
+// 检查公式中每次按键记录的撤销增量与公式的大小无关，以及在反向选择上输入后的光标位置
+// ============================================================================
+
+#include "controller/DocumentController.h"
+#include "controller/InputController.h"
+#include "controller/SelectionController.h"
+#include "core/Document.h"
+#include "core/MathNode.h"
+#include <QKeyEvent>
+#include <QtTest>
+
+/**
+ * @class InputControllerTest
+ * @brief 输入控制器的单元测试
+ */
+class InputControllerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 在只有一个符号和有2000个符号的公式末尾各输入同样的字符：撤销栈增加的内存相同
+     */
+    void formulaKeystrokeCost();
+
+    /**
+     * @brief 在反向选择（终点在起点之前）上输入：替换选中的文本，光标停在输入的文本之后
+     */
+    void typeOverBackwardSelection();
+};
+
+namespace {
+
+/**
+ * @brief 在公式末尾逐个输入字符，返回撤销栈在每次按键后增加的内存
+ * @param symbols 公式中已有的符号数
+ * @param text 输入的字符
+ * @return 每次按键后撤销栈增加的字节数
+ */
+QVector<qint64> keystrokeCosts(int symbols, const QString &text)
+{
+    MathNode *root = new MathNode(MathNode::Row);
+    for (int i = 0; i < symbols; i++)
+        root->appendChild(new MathNode(MathNode::Symbol, QStringLiteral("x")));
+    QSharedPointer<MathObject> formula(new MathObject(root));
+    Paragraph paragraph;
+    paragraph.insertFormula(0, formula);
+    Document document;
+    document.addParagraph(paragraph);
+
+    DocumentController documentController;
+    documentController.setDocument(&document);
+    SelectionController selectionController;
+    InputController inputController;
+    inputController.setDocumentController(&documentController);
+    inputController.setSelectionController(&selectionController);
+    Selection::Position cursor = {0, 0, MathPosition(QVector<int>(), symbols)};
+    selectionController.setSelection(Selection(cursor, cursor));
+
+    QVector<qint64> costs;
+    qint64 usage = documentController.undoStack()->memoryUsage();
+    for (QChar character : text)
+    {
+        QKeyEvent event(QEvent::KeyPress, Qt::Key_unknown, Qt::NoModifier, QString(character));
+        inputController.handleKeyPress(&event);
+        qint64 next = documentController.undoStack()->memoryUsage();
+        costs.append(next - usage);
+        usage = next;
+    }
+    return costs;
+}
+
+} // namespace
+
+void InputControllerTest::formulaKeystrokeCost()
+{
+    const QString text = QStringLiteral("y+z");
+    QVector<qint64> shortFormula = keystrokeCosts(1, text);
+    QVector<qint64> longFormula = keystrokeCosts(2000, text);
+    QCOMPARE(longFormula, shortFormula);
+    for (qint64 cost : longFormula)
+        QVERIFY(cost > 0);
+}
+
+void InputControllerTest::typeOverBackwardSelection()
+{
+    Paragraph paragraph;
+    paragraph.insertText(0, QStringLiteral("hello world"));
+    Document document;
+    document.addParagraph(paragraph);
+    DocumentController documentController;
+    documentController.setDocument(&document);
+    SelectionController selectionController;
+    InputController inputController;
+    inputController.setDocumentController(&documentController);
+    inputController.setSelectionController(&selectionController);
+
+    // 从"world"末尾向左拖动选中"world"
+    selectionController.setSelection(Selection({0, 11}, {0, 6}));
+    QKeyEvent event(QEvent::KeyPress, Qt::Key_T, Qt::NoModifier, QStringLiteral("t"));
+    inputController.handleKeyPress(&event);
+    QCOMPARE(document.paragraph(0).text(), QStringLiteral("hello t"));
+    QCOMPARE(selectionController.selection().start().position, 7);
+    QCOMPARE(selectionController.selection().end().position, 7);
+}
+
+QTEST_MAIN(InputControllerTest)
+#include "InputControllerTest.moc"
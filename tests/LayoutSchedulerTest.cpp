@@ -0,0 +1,143 @@
+// ============================================================================
+// LayoutSchedulerTest.cpp
+// 布局调度器的单元测试
+// 检查同一输入事件中的多次布局请求被合并为一次布局
+// ============================================================================
+
+#include "view/LayoutScheduler.h"
+#include <QtTest>
+
+/**
+ * @class LayoutSchedulerTest
+ * @brief 布局调度器的单元测试
+ *
+ * 执行布局的一方与DocumentView相同：收到layoutRequested后调用takeDirtyRange()取出脏范围。
+ */
+class LayoutSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 连续按键：每个输入事件多次标记，每个事件最多布局一次
+     */
+    void keyBurstLaysOutOncePerEvent();
+
+    /**
+     * @brief 同一周期内的多次标记合并为覆盖它们的一个脏范围
+     */
+    void markDirtyMergesRanges();
+
+    /**
+     * @brief 段落增删后挂起的脏范围随之平移
+     */
+    void spliceShiftsDirtyRange();
+
+    /**
+     * @brief flush()立即布局，定时器随后不再重复布局
+     */
+    void flushLaysOutOnce();
+};
+
+namespace {
+
+/**
+ * @brief 把调度器接到一个记录脏范围的布局函数上
+ * @param scheduler 布局调度器
+ * @param ranges 输出：每次布局取出的脏范围
+ */
+void connectLayout(LayoutScheduler *scheduler, QVector<QPair<int, int>> *ranges)
+{
+    QObject::connect(scheduler, &LayoutScheduler::layoutRequested, scheduler, [scheduler, ranges]() {
+        int first = 0;
+        int last = -1;
+        if (scheduler->takeDirtyRange(&first, &last))
+            ranges->append(qMakePair(first, last));
+    });
+}
+
+} // namespace
+
+void LayoutSchedulerTest::keyBurstLaysOutOncePerEvent()
+{
+    LayoutScheduler scheduler;
+    QVector<QPair<int, int>> ranges;
+    connectLayout(&scheduler, &ranges);
+
+    const int events = 50;
+    for (int i = 0; i < events; i++)
+    {
+        // 一次按键：插入文本、选择变化、段落变化各自请求布局
+        scheduler.beginInputEvent();
+        scheduler.markDirty(i, i);
+        scheduler.markDirty(0, -1);
+        scheduler.markDirty(i + 1, i + 1);
+        QVERIFY(scheduler.hasPendingLayout());
+        QTRY_VERIFY(!scheduler.hasPendingLayout());
+        QCOMPARE(scheduler.passesForCurrentInputEvent(), 1);
+    }
+
+    QCOMPARE(scheduler.layoutPassCount(), events);
+    QVERIFY(scheduler.maxPassesPerInputEvent() <= 1);
+    QCOMPARE(ranges.size(), events);
+    QCOMPARE(ranges.last(), qMakePair(events - 1, events));
+}
+
+void LayoutSchedulerTest::markDirtyMergesRanges()
+{
+    LayoutScheduler scheduler;
+    QVector<QPair<int, int>> ranges;
+    connectLayout(&scheduler, &ranges);
+    QSignalSpy requested(&scheduler, &LayoutScheduler::layoutRequested);
+
+    scheduler.beginInputEvent();
+    scheduler.markDirty(10, 12);
+    scheduler.markDirty(3, 4);
+    scheduler.markDirty(7, 7);
+    QTRY_VERIFY(!scheduler.hasPendingLayout());
+
+    QCOMPARE(requested.count(), 1);
+    QCOMPARE(ranges.size(), 1);
+    QCOMPARE(ranges.first(), qMakePair(3, 12));
+}
+
+void LayoutSchedulerTest::spliceShiftsDirtyRange()
+{
+    LayoutScheduler scheduler;
+    scheduler.markDirty(10, 12);
+
+    // 在脏范围之前插入两个段落
+    scheduler.adjustForSplice(2, 0, 2);
+    int first = 0;
+    int last = -1;
+    QVERIFY(scheduler.takeDirtyRange(&first, &last));
+    QCOMPARE(first, 12);
+    QCOMPARE(last, 14);
+
+    // 删除覆盖整个脏范围的段落后只剩布局请求，没有需要整形的段落
+    scheduler.markDirty(5, 6);
+    scheduler.adjustForSplice(4, 4, 0);
+    QVERIFY(scheduler.takeDirtyRange(&first, &last));
+    QVERIFY(last < first);
+}
+
+void LayoutSchedulerTest::flushLaysOutOnce()
+{
+    LayoutScheduler scheduler;
+    QVector<QPair<int, int>> ranges;
+    connectLayout(&scheduler, &ranges);
+
+    scheduler.beginInputEvent();
+    scheduler.markDirty(0, 0);
+    scheduler.flush();
+    QCOMPARE(ranges.size(), 1);
+    QVERIFY(!scheduler.hasPendingLayout());
+
+    // 定时器已停止，之后的事件循环周期不会再布局
+    QTest::qWait(20);
+    QCOMPARE(ranges.size(), 1);
+    QCOMPARE(scheduler.maxPassesPerInputEvent(), 1);
+}
+
+QTEST_MAIN(LayoutSchedulerTest)
+#include "LayoutSchedulerTest.moc"
@@ -0,0 +1,291 @@
+// ============================================================================
+// ParagraphItemTest.cpp
+// 段落图形项的单元测试
+// 检查内联对象子项在段落内容变化后与对象正确对应
+// ============================================================================
+
+#include "view/ParagraphItem.h"
+#include "view/FormulaItem.h"
+#include "view/MathLayoutEngine.h"
+#include "view/ReferenceItem.h"
+#include "view/PlotItem.h"
+#include "view/PlotSampler.h"
+#include <QtTest>
+#include <algorithm>
+
+/**
+ * @class ParagraphItemTest
+ * @brief 段落图形项的单元测试
+ */
+class ParagraphItemTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 在已有公式之前插入公式：新公式被绘制，原有公式的子项被复用
+     */
+    void insertFormulaBeforeFormula();
+
+    /**
+     * @brief 替换段落中的第一个公式：新公式被绘制，后面公式的子项被复用
+     */
+    void replaceFirstFormula();
+
+    /**
+     * @brief 删除中间的公式：只删除它的子项
+     */
+    void removeMiddleFormula();
+
+    /**
+     * @brief 在已有交叉引用之前插入交叉引用：两个引用都被绘制，原有引用的子项被复用
+     */
+    void insertReferenceBeforeReference();
+
+    /**
+     * @brief 在已有函数图像之前插入函数图像：原有图像的子项被复用
+     */
+    void insertPlotBeforePlot();
+};
+
+namespace {
+
+/**
+ * @brief 整形一个段落，文本中的每个'#'替换为一个公式
+ * @param pattern 段落文本
+ * @return 排版结果
+ */
+ParagraphLayout layoutWithFormulas(QString pattern)
+{
+    const QString text = pattern.replace(QLatin1Char('#'), QChar(QChar::ObjectReplacementCharacter));
+    QVector<InlineObject> objects;
+    for (int i = 0; i < text.length(); i++)
+    {
+        if (text.at(i) != QChar::ObjectReplacementCharacter)
+            continue;
+        InlineObject object;
+        object.kind = InlineObject::Formula;
+        object.position = i;
+        object.width = 20;
+        objects.append(object);
+    }
+    return TextLayoutEngine::shapeParagraph(text, QFont(), objects);
+}
+
+/**
+ * @brief 整形一个只含交叉引用的段落，每个引用占一个对象替换字符
+ * @param labels 各引用所指公式的标签
+ * @return 排版结果
+ */
+ParagraphLayout layoutWithReferences(const QStringList &labels)
+{
+    QVector<InlineObject> objects;
+    for (int i = 0; i < labels.size(); i++)
+    {
+        InlineObject object;
+        object.kind = InlineObject::Reference;
+        object.position = i;
+        object.width = 20;
+        object.reference = labels.at(i);
+        objects.append(object);
+    }
+    return TextLayoutEngine::shapeParagraph(QString(labels.size(), QChar::ObjectReplacementCharacter), QFont(), objects);
+}
+
+/**
+ * @brief 按水平位置列出段落项中的交叉引用子项
+ * @param item 段落项
+ * @return 交叉引用子项
+ */
+QVector<ReferenceItem *> referenceItems(const ParagraphItem &item)
+{
+    QVector<ReferenceItem *> items;
+    const QList<QGraphicsItem *> children = item.childItems();
+    for (QGraphicsItem *child : children)
+    {
+        if (ReferenceItem *reference = dynamic_cast<ReferenceItem *>(child))
+            items.append(reference);
+    }
+    std::sort(items.begin(), items.end(), [](ReferenceItem *a, ReferenceItem *b) { return a->x() < b->x(); });
+    return items;
+}
+
+/**
+ * @brief 整形一个只含函数图像的段落，每个图像占一个对象替换字符
+ * @param plots 函数图像对象
+ * @return 排版结果
+ */
+ParagraphLayout layoutWithPlots(const QVector<QSharedPointer<PlotObject>> &plots)
+{
+    QVector<InlineObject> objects;
+    for (int i = 0; i < plots.size(); i++)
+    {
+        InlineObject object;
+        object.kind = InlineObject::Plot;
+        object.position = i;
+        object.width = 100;
+        object.plot = plots.at(i);
+        objects.append(object);
+    }
+    return TextLayoutEngine::shapeParagraph(QString(plots.size(), QChar::ObjectReplacementCharacter), QFont(), objects);
+}
+
+/**
+ * @brief 按水平位置列出段落项中的函数图像子项
+ * @param item 段落项
+ * @return 函数图像子项
+ */
+QVector<PlotItem *> plotItems(const ParagraphItem &item)
+{
+    QVector<PlotItem *> items;
+    const QList<QGraphicsItem *> children = item.childItems();
+    for (QGraphicsItem *child : children)
+    {
+        if (PlotItem *plot = dynamic_cast<PlotItem *>(child))
+            items.append(plot);
+    }
+    std::sort(items.begin(), items.end(), [](PlotItem *a, PlotItem *b) { return a->x() < b->x(); });
+    return items;
+}
+
+/**
+ * @brief 按水平位置列出段落项中的公式子项
+ * @param item 段落项
+ * @return 公式子项
+ */
+QVector<FormulaItem *> formulaItems(const ParagraphItem &item)
+{
+    QVector<FormulaItem *> items;
+    const QList<QGraphicsItem *> children = item.childItems();
+    for (QGraphicsItem *child : children)
+    {
+        if (FormulaItem *formula = dynamic_cast<FormulaItem *>(child))
+            items.append(formula);
+    }
+    std::sort(items.begin(), items.end(), [](FormulaItem *a, FormulaItem *b) { return a->x() < b->x(); });
+    return items;
+}
+
+/**
+ * @brief 检查公式子项依次对应给定公式，且位于各自对象的预留位置
+ * @param item 段落项
+ * @param formulas 期望的公式（按出现顺序）
+ * @return 是否对应
+ */
+bool itemsMatch(const ParagraphItem &item, const QVector<QSharedPointer<MathObject>> &formulas)
+{
+    const QVector<FormulaItem *> items = formulaItems(item);
+    if (items.size() != formulas.size())
+        return false;
+    const ParagraphLayout &layout = item.paragraphLayout();
+    int i = 0;
+    for (const InlineObject &object : layout.objects)
+    {
+        if (items.at(i)->formula() != formulas.at(i))
+            return false;
+        if (!qFuzzyCompare(1 + items.at(i)->x(), 1 + layout.caretPositions.value(object.position)))
+            return false;
+        i++;
+    }
+    return true;
+}
+
+} // namespace
+
+void ParagraphItemTest::insertFormulaBeforeFormula()
+{
+    MathLayoutEngine engine;
+    QSharedPointer<MathObject> a(new MathObject());
+    QSharedPointer<MathObject> b(new MathObject());
+    QSharedPointer<MathObject> c(new MathObject());
+
+    ParagraphItem item;
+    item.setParagraphLayout(layoutWithFormulas(QStringLiteral("x#y#")));
+    item.setFormulas({a, b}, &engine);
+    QVERIFY(itemsMatch(item, {a, b}));
+    FormulaItem *itemA = formulaItems(item).at(0);
+    FormulaItem *itemB = formulaItems(item).at(1);
+
+    // 在b之前插入c
+    item.setParagraphLayout(layoutWithFormulas(QStringLiteral("x#y##")));
+    item.setFormulas({a, c, b}, &engine);
+    QVERIFY(itemsMatch(item, {a, c, b}));
+    QCOMPARE(formulaItems(item).at(0), itemA);
+    QCOMPARE(formulaItems(item).at(2), itemB);
+}
+
+void ParagraphItemTest::replaceFirstFormula()
+{
+    MathLayoutEngine engine;
+    QSharedPointer<MathObject> a(new MathObject());
+    QSharedPointer<MathObject> b(new MathObject());
+    QSharedPointer<MathObject> c(new MathObject());
+
+    ParagraphItem item;
+    item.setParagraphLayout(layoutWithFormulas(QStringLiteral("# #")));
+    item.setFormulas({a, b}, &engine);
+    FormulaItem *itemB = formulaItems(item).at(1);
+
+    item.setFormulas({c, b}, &engine);
+    QVERIFY(itemsMatch(item, {c, b}));
+    QCOMPARE(formulaItems(item).at(1), itemB);
+}
+
+void ParagraphItemTest::removeMiddleFormula()
+{
+    MathLayoutEngine engine;
+    QSharedPointer<MathObject> a(new MathObject());
+    QSharedPointer<MathObject> b(new MathObject());
+    QSharedPointer<MathObject> c(new MathObject());
+
+    ParagraphItem item;
+    item.setParagraphLayout(layoutWithFormulas(QStringLiteral("###")));
+    item.setFormulas({a, b, c}, &engine);
+    FormulaItem *itemA = formulaItems(item).at(0);
+    FormulaItem *itemC = formulaItems(item).at(2);
+
+    item.setParagraphLayout(layoutWithFormulas(QStringLiteral("##")));
+    item.setFormulas({a, c}, &engine);
+    QVERIFY(itemsMatch(item, {a, c}));
+    QCOMPARE(formulaItems(item).at(0), itemA);
+    QCOMPARE(formulaItems(item).at(1), itemC);
+}
+
+void ParagraphItemTest::insertReferenceBeforeReference()
+{
+    ParagraphItem item;
+    item.setParagraphLayout(layoutWithReferences({QStringLiteral("a"), QStringLiteral("b")}));
+    item.setEquationNumbers(nullptr, -1, QFont());
+    ReferenceItem *itemB = referenceItems(item).at(1);
+
+    item.setParagraphLayout(layoutWithReferences({QStringLiteral("c"), QStringLiteral("b")}));
+    item.setEquationNumbers(nullptr, -1, QFont());
+    const QVector<ReferenceItem *> items = referenceItems(item);
+    QCOMPARE(items.size(), 2);
+    QCOMPARE(items.at(0)->label(), QStringLiteral("c"));
+    QCOMPARE(items.at(1), itemB);
+    QCOMPARE(items.at(1)->x(), item.paragraphLayout().caretPositions.value(1));
+}
+
+void ParagraphItemTest::insertPlotBeforePlot()
+{
+    PlotSampler sampler;
+    QSharedPointer<MathObject> function(new MathObject());
+    QSharedPointer<PlotObject> a(new PlotObject(function));
+    QSharedPointer<PlotObject> b(new PlotObject(function));
+
+    ParagraphItem item;
+    item.setParagraphLayout(layoutWithPlots({b}));
+    item.setPlots(&sampler);
+    PlotItem *itemB = plotItems(item).at(0);
+
+    item.setParagraphLayout(layoutWithPlots({a, b}));
+    item.setPlots(&sampler);
+    const QVector<PlotItem *> items = plotItems(item);
+    QCOMPARE(items.size(), 2);
+    QCOMPARE(items.at(0)->plot(), a);
+    QCOMPARE(items.at(1), itemB);
+}
+
+QTEST_MAIN(ParagraphItemTest)
+#include "ParagraphItemTest.moc"
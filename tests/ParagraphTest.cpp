@@ -0,0 +1,164 @@
+// ============================================================================
+// ParagraphTest.cpp
+// 段落类的单元测试
+// 检查拆分与合并段落、删除文本时Run的格式保持不变、相邻同格式Run被合并
+// ============================================================================
+
+#include "core/Paragraph.h"
+#include <QtTest>
+
+/**
+ * @class ParagraphTest
+ * @brief 段落类的单元测试
+ */
+class ParagraphTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 在带格式的Run中间拆分：前后两半都保留该格式
+     */
+    void splitInsideFormattedRun();
+
+    /**
+     * @brief 合并时衔接处的两个Run格式相同：合并为一个Run
+     */
+    void mergeCoalescesSameFormat();
+
+    /**
+     * @brief 合并时衔接处的两个Run格式不同：保持为两个Run
+     */
+    void mergeKeepsDifferentFormats();
+
+    /**
+     * @brief 拆分后再合并：Run与原段落完全相同
+     */
+    void splitMergeRoundTrip();
+
+    /**
+     * @brief 删除两段同格式文本之间的内容：两侧合并为一个Run
+     */
+    void removeCoalescesAcrossDeletion();
+};
+
+namespace {
+
+/**
+ * @brief 获取粗体格式
+ * @return 格式
+ */
+Format boldFormat()
+{
+    Format format;
+    format.setBold(true);
+    return format;
+}
+
+/**
+ * @brief 获取斜体格式
+ * @return 格式
+ */
+Format italicFormat()
+{
+    Format format;
+    format.setItalic(true);
+    return format;
+}
+
+/**
+ * @brief 构造由给定Run组成的段落
+ * @param runs Run列表
+ * @return 段落
+ */
+Paragraph paragraphOf(const QVector<Run> &runs)
+{
+    Paragraph paragraph;
+    for (const Run &run : runs)
+        paragraph.addRun(run);
+    return paragraph;
+}
+
+/**
+ * @brief 检查段落的Run与期望的文本和格式逐一相同
+ * @param paragraph 段落
+ * @param runs 期望的Run
+ * @return 是否相同
+ */
+bool runsEqual(const Paragraph &paragraph, const QVector<Run> &runs)
+{
+    if (paragraph.runCount() != runs.size())
+        return false;
+    for (int i = 0; i < runs.size(); i++)
+    {
+        Run run = paragraph.run(i);
+        if (run.text() != runs.at(i).text() || !(run.format() == runs.at(i).format()))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void ParagraphTest::splitInsideFormattedRun()
+{
+    Paragraph paragraph = paragraphOf({Run(QStringLiteral("plain "), Format()),
+                                       Run(QStringLiteral("bold"), boldFormat())});
+
+    Paragraph tail = paragraph.split(8);
+    QVERIFY(runsEqual(paragraph, {Run(QStringLiteral("plain "), Format()), Run(QStringLiteral("bo"), boldFormat())}));
+    QVERIFY(runsEqual(tail, {Run(QStringLiteral("ld"), boldFormat())}));
+}
+
+void ParagraphTest::mergeCoalescesSameFormat()
+{
+    Paragraph paragraph = paragraphOf({Run(QStringLiteral("a"), Format()), Run(QStringLiteral("bo"), boldFormat())});
+    Paragraph next = paragraphOf({Run(QStringLiteral("ld"), boldFormat()), Run(QStringLiteral("b"), Format())});
+
+    paragraph.merge(next);
+    QVERIFY(runsEqual(paragraph, {Run(QStringLiteral("a"), Format()), Run(QStringLiteral("bold"), boldFormat()),
+                                  Run(QStringLiteral("b"), Format())}));
+}
+
+void ParagraphTest::mergeKeepsDifferentFormats()
+{
+    Paragraph paragraph = paragraphOf({Run(QStringLiteral("bold"), boldFormat())});
+    Paragraph next = paragraphOf({Run(QStringLiteral("italic"), italicFormat())});
+
+    paragraph.merge(next);
+    QVERIFY(runsEqual(paragraph, {Run(QStringLiteral("bold"), boldFormat()),
+                                  Run(QStringLiteral("italic"), italicFormat())}));
+}
+
+void ParagraphTest::splitMergeRoundTrip()
+{
+    const QVector<Run> runs = {Run(QStringLiteral("plain "), Format()), Run(QStringLiteral("bold"), boldFormat()),
+                               Run(QStringLiteral(" italic"), italicFormat())};
+
+    // 每个位置都试一次：Run内部、Run边界和段落两端
+    const int length = paragraphOf(runs).length();
+    for (int position = 0; position <= length; position++)
+    {
+        Paragraph paragraph = paragraphOf(runs);
+        Paragraph tail = paragraph.split(position);
+        QCOMPARE(paragraph.length(), position);
+        paragraph.merge(tail);
+        QVERIFY2(runsEqual(paragraph, runs), qPrintable(QStringLiteral("split at %1").arg(position)));
+    }
+}
+
+void ParagraphTest::removeCoalescesAcrossDeletion()
+{
+    Paragraph paragraph = paragraphOf({Run(QStringLiteral("ab"), boldFormat()), Run(QStringLiteral("x"), Format()),
+                                       Run(QStringLiteral("cd"), boldFormat()), Run(QStringLiteral("e"), italicFormat())});
+
+    paragraph.removeText(2, 1);
+    QVERIFY(runsEqual(paragraph, {Run(QStringLiteral("abcd"), boldFormat()), Run(QStringLiteral("e"), italicFormat())}));
+
+    // 只删除一侧的部分文本时格式不同的Run保持分开
+    paragraph.removeText(3, 1);
+    QVERIFY(runsEqual(paragraph, {Run(QStringLiteral("abc"), boldFormat()), Run(QStringLiteral("e"), italicFormat())}));
+}
+
+QTEST_MAIN(ParagraphTest)
+#include "ParagraphTest.moc"
@@ -0,0 +1,144 @@
+// ============================================================================
+// ParagraphTopsTest.cpp
+// 段落顶部偏移索引的单元测试
+// 检查修改行高、增删段落后顶部偏移和按偏移查找的结果与逐段累加一致
+// ============================================================================
+
+#include "view/ParagraphTops.h"
+#include <QtTest>
+
+/**
+ * @class ParagraphTopsTest
+ * @brief 段落顶部偏移索引的单元测试
+ */
+class ParagraphTopsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 顶部偏移为之前段落高度之和，落在段落边界上的偏移属于下一段落
+     */
+    void topsAndLookup();
+
+    /**
+     * @brief 修改一个段落的高度，其后所有段落的顶部随之移动
+     */
+    void heightChangeShiftsLaterTops();
+
+    /**
+     * @brief 交替增删段落和修改行高，结果始终与逐段累加一致
+     */
+    void splicesMatchPrefixSums();
+};
+
+namespace {
+
+/**
+ * @brief 检查索引与逐段累加的高度表一致
+ * @param tops 段落顶部偏移索引
+ * @param heights 各段落高度
+ * @return 是否一致
+ */
+bool matches(const ParagraphTops &tops, const QVector<qreal> &heights)
+{
+    if (tops.count() != heights.size())
+        return false;
+    qreal top = 0;
+    for (int i = 0; i < heights.size(); i++)
+    {
+        if (tops.top(i) != top || tops.height(i) != heights[i])
+            return false;
+        if (tops.indexAt(top) != i || tops.indexAt(top + heights[i] / 2) != i)
+            return false;
+        top += heights[i];
+    }
+    return tops.total() == top && tops.indexAt(top) == heights.size();
+}
+
+} // namespace
+
+void ParagraphTopsTest::topsAndLookup()
+{
+    ParagraphTops tops;
+    QCOMPARE(tops.total(), 0.0);
+    QCOMPARE(tops.indexAt(5), 0);
+
+    tops.insert(0, 3, 20);
+    tops.setHeight(1, 50);
+    QCOMPARE(tops.top(0), 0.0);
+    QCOMPARE(tops.top(1), 20.0);
+    QCOMPARE(tops.top(2), 70.0);
+    QCOMPARE(tops.total(), 90.0);
+    QCOMPARE(tops.indexAt(-1), 0);
+    QCOMPARE(tops.indexAt(19.5), 0);
+    QCOMPARE(tops.indexAt(20), 1);
+    QCOMPARE(tops.indexAt(69), 1);
+    QCOMPARE(tops.indexAt(70), 2);
+    QCOMPARE(tops.indexAt(90), 3);
+}
+
+void ParagraphTopsTest::heightChangeShiftsLaterTops()
+{
+    const int count = 1000;
+    ParagraphTops tops;
+    tops.insert(0, count, 20);
+    QVector<qreal> heights(count, 20);
+    QVERIFY(matches(tops, heights));
+
+    // 中部一段因高公式变高后又恢复
+    tops.setHeight(500, 120);
+    heights[500] = 120;
+    QVERIFY(matches(tops, heights));
+    QCOMPARE(tops.top(999), 999 * 20.0 + 100);
+    tops.setHeight(500, 20);
+    heights[500] = 20;
+    QVERIFY(matches(tops, heights));
+}
+
+void ParagraphTopsTest::splicesMatchPrefixSums()
+{
+    ParagraphTops tops;
+    QVector<qreal> heights;
+    quint32 seed = 1;
+    auto next = [&seed](int bound) {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<int>((seed >> 16) % bound);
+    };
+
+    for (int step = 0; step < 200; step++)
+    {
+        int index = next(heights.size() + 1);
+        switch (next(3))
+        {
+        case 0: {
+            // 回车或粘贴：插入若干默认行高的段落
+            int count = 1 + next(5);
+            tops.insert(index, count, 20);
+            heights.insert(index, count, 20);
+            break;
+        }
+        case 1: {
+            // 删除跨段落的选择
+            int count = qMin(1 + next(5), heights.size() - index);
+            tops.remove(index, count);
+            if (count > 0)
+                heights.remove(index, count);
+            break;
+        }
+        default:
+            // 排版结果到达，行高变化
+            if (index < heights.size())
+            {
+                qreal height = 20 + 10 * next(5);
+                tops.setHeight(index, height);
+                heights[index] = height;
+            }
+            break;
+        }
+        QVERIFY(matches(tops, heights));
+    }
+}
+
+QTEST_MAIN(ParagraphTopsTest)
+#include "ParagraphTopsTest.moc"
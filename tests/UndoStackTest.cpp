@@ -0,0 +1,111 @@
+// ============================================================================
+// UndoStackTest.cpp
+// 撤销栈的单元测试
+// 检查超出内存预算时步骤溢出到磁盘日志而不是被丢弃，内存统计保持一致；
+// 长段落中的编辑只记录被删除和插入的片段
+// ============================================================================
+
+#include "controller/DocumentController.h"
+#include "core/Document.h"
+#include "core/UndoStack.h"
+#include <QtTest>
+
+/**
+ * @class UndoStackTest
+ * @brief 撤销栈的单元测试
+ */
+class UndoStackTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 最近的步骤合计超出预算：全部步骤保留并可撤销重做，内存用量不超过预算且不为负
+     */
+    void overBudgetKeepsHistory();
+
+    /**
+     * @brief 在长段落中逐字输入并拆分段落：步骤的内存与段落长度无关，撤销重做还原文本和格式
+     */
+    void editInLongParagraph();
+};
+
+void UndoStackTest::overBudgetKeepsHistory()
+{
+    const int steps = 40;
+    Document document;
+    for (int i = 0; i < steps; i++)
+        document.addParagraph(Paragraph());
+    DocumentController controller;
+    controller.setDocument(&document);
+    UndoStack *undoStack = controller.undoStack();
+    // 每步约128KB，最近的16步就超出1MB的预算
+    undoStack->setMemoryBudget(1024 * 1024);
+
+    const QString chunk(64 * 1024, QLatin1Char('x'));
+    for (int i = 0; i < steps; i++)
+    {
+        controller.insertText({i, 0}, chunk);
+        undoStack->breakCoalescing();
+        QVERIFY(undoStack->memoryUsage() >= 0);
+        QVERIFY(undoStack->memoryUsage() <= undoStack->memoryBudget());
+    }
+    QCOMPARE(undoStack->count(), steps);
+    QVERIFY(undoStack->journalSize() > 0);
+
+    for (int i = steps - 1; i >= 0; i--)
+    {
+        QCOMPARE(controller.undo().paragraph, i);
+        QCOMPARE(document.paragraph(i).length(), 0);
+    }
+    QVERIFY(!controller.canUndo());
+    for (int i = 0; i < steps; i++)
+        controller.redo();
+    for (int i = 0; i < steps; i++)
+        QCOMPARE(document.paragraph(i).length(), chunk.length());
+    QVERIFY(undoStack->memoryUsage() >= 0);
+}
+
+void UndoStackTest::editInLongParagraph()
+{
+    const int half = 100000;
+    Paragraph paragraph;
+    paragraph.addRun(Run(QString(half, QLatin1Char('x'))));
+    paragraph.addRun(Run(QStringLiteral("bold"), Format(QFont(QStringLiteral("Arial"), 12, QFont::Bold))));
+    paragraph.addRun(Run(QString(half, QLatin1Char('y'))));
+    const QString original = paragraph.text();
+    Document document;
+    document.addParagraph(paragraph);
+    DocumentController controller;
+    controller.setDocument(&document);
+    UndoStack *undoStack = controller.undoStack();
+
+    const QString word = QStringLiteral("hello ");
+    for (int i = 0; i < word.size(); i++)
+        controller.insertText({0, half / 2 + i}, QString(word.at(i)));
+    QCOMPARE(undoStack->count(), 1);
+    // 整个段落约400KB，步骤只保存输入的几个字符
+    QVERIFY(undoStack->memoryUsage() < 4096);
+
+    controller.splitParagraph({0, half / 2 + word.size()});
+    QCOMPARE(document.paragraphCount(), 2);
+    QCOMPARE(undoStack->count(), 2);
+    QVERIFY(undoStack->memoryUsage() < 8192);
+
+    controller.undo();
+    QCOMPARE(document.paragraphCount(), 1);
+    QCOMPARE(document.paragraph(0).text(), QString(original).insert(half / 2, word));
+    controller.undo();
+    QCOMPARE(document.paragraph(0).text(), original);
+    QCOMPARE(document.paragraph(0).runCount(), 3);
+
+    controller.redo();
+    controller.redo();
+    QCOMPARE(document.paragraphCount(), 2);
+    QCOMPARE(document.paragraph(0).text(), original.left(half / 2) + word);
+    QCOMPARE(document.paragraph(1).text(), original.mid(half / 2));
+    QCOMPARE(document.paragraph(1).runCount(), 3);
+}
+
+QTEST_MAIN(UndoStackTest)
+#include "UndoStackTest.moc"